@@ -7,16 +7,423 @@
  * @date March, 2020
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 // Uses cxxopts from https://github.com/jarro2783/cxxopts under the MIT license
 #include "cxxopts/cxxopts.hxx"
 
+#include "allocator.h"
+#include "checkpoint.h"
+#include "cluster.h"
+#include "delta.h"
+#include "distributed_world.h"
 #include "grid.h"
+#include "hashlife.h"
+#include "infinite_world.h"
+#include "renderer.h"
+#include "snapshot.h"
+#include "soup.h"
+#include "stats.h"
 #include "world.h"
 #include "zoo.h"
 
+/**
+ * Checks if a path ends with the given extension, such as ".rle".
+ */
+static bool has_extension(const std::string &path, const std::string &extension) {
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/**
+ * Loads a pattern file into a grid, picking the format from the extension. An empty path gives an empty grid
+ * and - reads an ascii file from standard input.
+ */
+static Grid load_grid(const std::string &path) {
+    if (path.empty()) {
+        return Grid();
+    }
+    if (path == "-") {
+        return Zoo::load_ascii(std::cin);
+    }
+    if (has_extension(path, ".rle")) {
+        return Zoo::load_rle(path);
+    }
+    if (has_extension(path, ".mc")) {
+        HashWorld plane;
+        Zoo::load_macrocell(path, plane);
+        return plane.to_grid();
+    }
+    return Zoo::load_ascii(path);
+}
+
+/**
+ * Loads a pattern file into an unbounded plane. Rle and macrocell files are streamed straight into the plane,
+ * along with their rule.
+ */
+template<typename Plane>
+static void load_plane(Plane &plane, const std::string &path) {
+    if (has_extension(path, ".rle")) {
+        Zoo::load_rle(path, plane);
+    } else if (has_extension(path, ".mc")) {
+        Zoo::load_macrocell(path, plane);
+    } else {
+        plane = Plane(load_grid(path));
+    }
+}
+
+/**
+ * Saves the bounding box of an unbounded plane, picking the format from the extension.
+ */
+static void save_plane(const std::string &path, const HashWorld &plane) {
+    if (has_extension(path, ".rle")) {
+        Zoo::save_rle(path, plane);
+    } else if (has_extension(path, ".mc")) {
+        Zoo::save_macrocell(path, plane);
+    } else {
+        Zoo::save_ascii(path, plane.to_grid());
+    }
+}
+
+static void save_plane(const std::string &path, const InfiniteWorld &plane) {
+    if (has_extension(path, ".rle")) {
+        Zoo::save_rle(path, plane);
+    } else if (has_extension(path, ".mc")) {
+        HashWorld copy(plane.to_grid());
+        copy.set_rule(plane.get_rule());
+        Zoo::save_macrocell(path, copy);
+    } else {
+        Zoo::save_ascii(path, plane.to_grid());
+    }
+}
+
+/**
+ * Draws the states printed by the simulation, following --glyphs, --viewport and --max-fps.
+ */
+class Display {
+private:
+    Renderer renderer;
+
+    bool has_viewport;
+
+    int x, y, width, height;
+
+    double max_fps;                                  // 0 draws every frame
+
+    bool drawn;
+
+    std::chrono::steady_clock::time_point last_frame;
+
+public:
+    Display() : has_viewport(false), x(0), y(0), width(0), height(0), max_fps(0), drawn(false) {}
+
+    // The viewport is empty or "x,y,width,height"
+    void configure(const Glyphs glyphs, const std::string &viewport, const double max_fps) {
+        if (max_fps < 0) {
+            throw std::runtime_error(std::string("The frame rate cannot be negative!"));
+        }
+        this->renderer.set_glyphs(glyphs);
+        this->max_fps = max_fps;
+        this->has_viewport = !viewport.empty();
+        if (this->has_viewport) {
+            std::istringstream fields(viewport);
+            char a = 0, b = 0, c = 0;
+            if (!(fields >> this->x >> a >> this->y >> b >> this->width >> c >> this->height) ||
+                a != ',' || b != ',' || c != ',' || !fields.eof()) {
+                throw std::runtime_error(std::string("The viewport must be x,y,width,height!"));
+            }
+            this->renderer.set_viewport(this->x, this->y, this->width, this->height);
+        }
+    }
+
+    // Frames due less than 1 / max_fps seconds after the last one drawn are skipped
+    bool frame_due() const {
+        if (this->max_fps <= 0 || !this->drawn) {
+            return true;
+        }
+        const std::chrono::duration<double> since = std::chrono::steady_clock::now() - this->last_frame;
+        return since.count() * this->max_fps >= 1;
+    }
+
+    void draw(const Grid &grid) {
+        const Stats::Timer timer(Stats::Phase::PRINT);
+        this->renderer.draw(std::cout, grid);
+        std::cout << std::endl;
+        this->drawn = true;
+        this->last_frame = std::chrono::steady_clock::now();
+    }
+
+    // Unbounded planes draw the viewport in plane coordinates, or the bounding box of the alive cells
+    template<typename Plane>
+    void draw_plane(const Plane &plane) {
+        if (this->has_viewport) {
+            this->renderer.clear_viewport();
+            this->draw(plane.to_grid(this->x, this->y, static_cast<std::int64_t>(this->x) + this->width,
+                                     static_cast<std::int64_t>(this->y) + this->height));
+            this->renderer.set_viewport(this->x, this->y, this->width, this->height);
+        } else {
+            this->draw(plane.to_grid());
+        }
+    }
+};
+
+/**
+ * Reports the counters and timers of Stats, following --stats, --stats-json and --stats-interval.
+ */
+class StatsReport {
+private:
+    bool summary;
+
+    std::ofstream file;
+
+    std::ostream *json;                              // Standard output, the file, or nullptr for no intervals
+
+    std::uint64_t interval;
+
+    std::uint64_t last_generation;
+
+    Stats::Totals last;
+
+    std::chrono::steady_clock::time_point last_time;
+
+public:
+    StatsReport() : summary(false), json(nullptr), interval(0), last_generation(0), last() {}
+
+    // The json path is empty for no intervals, or - for standard output
+    void configure(const bool summary, const std::string &json_path, const int interval) {
+        if (interval <= 0) {
+            throw std::runtime_error(std::string("The stats interval must be positive!"));
+        }
+        this->summary = summary;
+        this->interval = static_cast<std::uint64_t>(interval);
+        if (json_path == "-") {
+            this->json = &std::cout;
+        } else if (!json_path.empty()) {
+            this->file.open(json_path, std::ios::out | std::ios::binary);
+            if (!this->file) {
+                throw std::runtime_error(std::string("Can't open the file!"));
+            }
+            this->json = &this->file;
+        }
+        if (this->summary || this->json) {
+            Stats::reset();
+            Stats::set_enabled(true);
+            this->last = Stats::read();
+            this->last_time = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Writes an interval once at least --stats-interval generations have passed since the last one
+    void update(const std::uint64_t generation) {
+        if (this->json && generation >= this->last_generation + this->interval) {
+            this->write_interval(generation);
+        }
+    }
+
+    void write_interval(const std::uint64_t generation) {
+        const Stats::Totals now = Stats::read();
+        const std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        Stats::write_json(*this->json, generation, now - this->last,
+                          std::chrono::duration<double>(time - this->last_time).count());
+        this->last = now;
+        this->last_time = time;
+        this->last_generation = generation;
+    }
+
+    // Writes the last, partial, interval and prints the summary
+    void finish(const std::uint64_t generation) {
+        if (this->json && (generation != this->last_generation || generation == 0)) {
+            this->write_interval(generation);
+        }
+        if (this->summary) {
+            Stats::print_summary(std::cerr, Stats::read());
+        }
+    }
+};
+
+/**
+ * Runs the simulation on an unbounded plane, either a HashWorld or an InfiniteWorld.
+ * The state printed and saved is the bounding box of the alive cells.
+ */
+template<typename Plane>
+static int run_unbounded(Plane &plane, const Rule &rule, const int steps, const int every, const std::string &output,
+                         Display &display, StatsReport &stats) {
+    try {
+        plane.set_rule(rule);
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+    std::cout << "Initial state..." << std::endl
+              << "Alive " << plane.get_alive_cells() << std::endl;
+    display.draw_plane(plane);
+
+    // Jump straight to the end unless intermediate states should be printed
+    const int chunk = every > 0 ? every : steps;
+    for (int step = 0; step < steps; step += chunk) {
+        {
+            const Stats::Timer timer(Stats::Phase::STEP);
+            plane.advance(static_cast<std::uint64_t>(std::min(chunk, steps - step)));
+        }
+        Stats::add(Stats::Counter::GENERATIONS, static_cast<std::uint64_t>(std::min(chunk, steps - step)));
+        stats.update(plane.get_generation());
+        if (every > 0 && display.frame_due()) {
+            std::cout << "Step " << plane.get_generation() << " of " << steps << '\n';
+            display.draw_plane(plane);
+        }
+    }
+
+    std::cout << "Final state..." << std::endl
+              << "Alive " << plane.get_alive_cells() << std::endl;
+    display.draw_plane(plane);
+    if (!output.empty()) {
+        try {
+            const Stats::Timer timer(Stats::Phase::SAVE);
+            save_plane(output, plane);
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
+    stats.finish(plane.get_generation());
+    return 0;
+}
+
+/**
+ * Runs the simulation of a board split across a cluster, every node running this alongside the others.
+ * Only rank 0 prints, and the states it prints and saves are gathered onto it from every node. Gathering is
+ * collective, so every node takes the steps, the printing interval and whether to save from rank 0, and a
+ * node given no --output or --every of its own still takes part.
+ */
+static int run_distributed(DistributedWorld &world, Cluster &cluster, const int local_steps, const int local_every,
+                           const bool toroidal, const Rule &rule, const std::string &output, const std::string &shards,
+                           Display &display, StatsReport &stats) {
+    const bool printing = cluster.get_rank() == 0;
+    int steps, every;
+    bool saving;
+    try {
+        steps = static_cast<int>(cluster.sum(printing ? static_cast<std::uint64_t>(std::max(local_steps, 0)) : 0));
+        every = static_cast<int>(cluster.sum(printing ? static_cast<std::uint64_t>(std::max(local_every, 0)) : 0));
+        saving = cluster.sum(printing && !output.empty()) > 0;
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+    const std::uint64_t alive = world.get_alive_cells();
+    if (printing) {
+        std::cout << "Initial state..." << std::endl
+                  << "Alive " << alive << " | Nodes " << cluster.get_size() << " | Halo " << world.get_halo()
+                  << std::endl;
+    }
+
+    // Gathering is collective, so every node stops at the same steps whether or not rank 0 prints the frame
+    const int chunk = every > 0 ? every : steps;
+    try {
+        for (int step = 0; step < steps; step += chunk) {
+            world.advance(std::min(chunk, steps - step), toroidal);
+            stats.update(world.get_generation());
+            if (every > 0) {
+                const Grid board = world.gather();
+                if (printing && display.frame_due()) {
+                    std::cout << "Step " << world.get_generation() << " of " << steps << '\n';
+                    display.draw(board);
+                }
+            }
+        }
+        const std::uint64_t final_alive = world.get_alive_cells();
+        if (printing) {
+            std::cout << "Final state..." << std::endl
+                      << "Alive " << final_alive << std::endl;
+        }
+        if (!shards.empty()) {
+            const Stats::Timer timer(Stats::Phase::SAVE);
+            world.save_shard(shards + "." + std::to_string(cluster.get_rank()) + ".bgol");
+        }
+        if (saving) {
+            const Stats::Timer timer(Stats::Phase::SAVE);
+            const Grid board = world.gather();
+            if (printing && has_extension(output, ".rle")) {
+                Zoo::save_rle(output, board, rule);
+            } else if (printing) {
+                Zoo::save_ascii(output, board);
+            }
+        }
+        // No node exits, closing its connections, until every other one is done with them
+        cluster.barrier();
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+    stats.finish(world.get_generation());
+    return 0;
+}
+
+/**
+ * Writes the last step of a world to --deltas, or a keyframe of its whole state.
+ */
+static void write_deltas(DeltaWriter &deltas, const World &world, const bool keyframe) {
+    try {
+        const Stats::Timer timer(Stats::Phase::SAVE);
+        if (keyframe) {
+            deltas.write_keyframe(world.get_generation(), world.state());
+        } else {
+            deltas.write_step(world);
+        }
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+}
+
+/**
+ * Hands the current state of a world to the checkpoint writer. A failed checkpoint is reported, but does not
+ * stop the run.
+ */
+static void submit_checkpoint(CheckpointWriter &checkpoints, const World &world) {
+    try {
+        const Stats::Timer timer(Stats::Phase::CHECKPOINT);
+        checkpoints.submit(world.state(), world.get_generation(), world.get_rule());
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+    }
+}
+
+/**
+ * Runs a batch of random soups and prints one line per soup, followed by the throughput of the batch.
+ * The soups are run SOUP_BLOCK at a time so their summaries are printed while the rest are still running.
+ */
+static int run_soups(SoupSearch &search, const std::uint64_t first_seed, const std::uint64_t count) {
+    static const std::uint64_t SOUP_BLOCK = 1 << 16;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::uint64_t done = 0; done < count; done += SOUP_BLOCK) {
+        const std::vector<SoupResult> soups = search.run(first_seed + done, std::min(SOUP_BLOCK, count - done));
+        for (const SoupResult &soup : soups) {
+            std::cout << "Soup " << soup.seed << " | Alive " << soup.population << " | Settled "
+                      << soup.generation << " | Period " << soup.period << '\n';
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << count << " soups in " << elapsed.count() << " s | "
+              << (elapsed.count() > 0 ? count / elapsed.count() : 0) << " soups/s" << std::endl;
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
 
 
@@ -25,12 +432,79 @@ int main(int argc, char *argv[]) {
 
     // Declare the valid command line arguments and their types and default values.
     options.add_options()
-            ("f,file", "Load an ascii file from the provided path.", cxxopts::value<std::string>())
-            ("o,output", "Save an ascii file to the provided path.", cxxopts::value<std::string>())
+            ("f,file", "Load a .gol, .rle or .mc file from the provided path, - reads ascii from standard input.",
+             cxxopts::value<std::string>())
+            ("o,output", "Save an ascii .gol, .rle or .mc file to the provided path.", cxxopts::value<std::string>())
             ("s,steps", "The number of steps to simulate the world.", cxxopts::value<int>()->default_value("10"))
             ("e,every", "Print world to the console every N steps. 0 disables printing.",
              cxxopts::value<int>()->default_value("0"))
             ("t,toroidal", "Simulate the Game of Life on a torus.", cxxopts::value<bool>()->default_value("false"))
+            ("rule", "The Life-like rule to simulate as a rulestring, such as B3/S23 or B36/S23.",
+             cxxopts::value<std::string>()->default_value("B3/S23"))
+            ("engine", "The stepping engine to use, reference, byte, simd, bitpacked or sparse.",
+             cxxopts::value<std::string>()->default_value("byte"))
+            ("simd", "The instruction set for the simd engine, auto, scalar, sse2, avx2, avx512 or neon.",
+             cxxopts::value<std::string>()->default_value("auto"))
+            ("threads", "The number of threads to step with. 0 uses every hardware thread.",
+             cxxopts::value<int>()->default_value("1"))
+            ("temporal-depth", "The generations to step a bitpacked board per pass over memory. 1 disables blocking.",
+             cxxopts::value<int>()->default_value("8"))
+            ("huge-pages", "How boards of 2 MiB or more are backed, off, transparent or explicit (MAP_HUGETLB).",
+             cxxopts::value<std::string>()->default_value("transparent"))
+            ("hashlife", "Simulate on an unbounded plane using HashLife. Ignores --toroidal and --engine.",
+             cxxopts::value<bool>()->default_value("false"))
+            ("infinite", "Simulate on an unbounded plane of bit-packed chunks. Ignores --toroidal and --engine.",
+             cxxopts::value<bool>()->default_value("false"))
+            ("glyphs", "How printed states are drawn, ascii, half, quadrant or braille.",
+             cxxopts::value<std::string>()->default_value("ascii"))
+            ("viewport", "Print only the window x,y,width,height of the world.", cxxopts::value<std::string>())
+            ("max-fps", "Skip printing steps that come faster than this many per second. 0 prints every one.",
+             cxxopts::value<double>()->default_value("0"))
+            ("cycles", "Watch for repeating states, off, detect, or skip to jump over whole periods once found.",
+             cxxopts::value<std::string>()->default_value("off"))
+            ("population", "How the alive cells are counted, recount, incremental or validate against a recount.",
+             cxxopts::value<std::string>()->default_value("incremental"))
+            ("checkpoint-every", "Save a checkpoint every N steps in the background. 0 disables checkpoints.",
+             cxxopts::value<int>()->default_value("0"))
+            ("checkpoint", "The path checkpoints are written to as snapshots, each replacing the last.",
+             cxxopts::value<std::string>()->default_value("checkpoint.gols"))
+            ("resume", "Resume from a checkpoint, with its generation and rule, and step until --steps generations.",
+             cxxopts::value<std::string>())
+            ("deltas", "Stream the cells born and killed each generation to the provided path, after a keyframe.",
+             cxxopts::value<std::string>())
+            ("delta-keyframes", "Write the whole state to --deltas every N generations. 0 writes only the first.",
+             cxxopts::value<int>()->default_value("0"))
+            ("replay", "Start from a generation rebuilt from a --deltas stream, see --replay-generation.",
+             cxxopts::value<std::string>())
+            ("replay-generation", "The generation rebuilt by --replay, the last in the stream by default.",
+             cxxopts::value<std::uint64_t>())
+            ("cluster", "Split the board across the nodes listening on these comma separated host:port endpoints.",
+             cxxopts::value<std::string>())
+            ("cluster-rank", "The rank of this node in --cluster, every node loads the same --file. "
+                             "Every node follows the --steps, --every and --output of rank 0.",
+             cxxopts::value<int>()->default_value("0"))
+            ("halo", "The rows each node of --cluster exchanges with its neighbours, once every that many steps.",
+             cxxopts::value<int>()->default_value("1"))
+            ("shards", "Save the rows of each node of --cluster to <path>.<rank>.bgol after the last step.",
+             cxxopts::value<std::string>())
+            ("soups", "Census N random soups instead of one world, stepping each for at most --steps generations.",
+             cxxopts::value<std::uint64_t>()->default_value("0"))
+            ("soup-seed", "The seed of the first soup, the others follow on from it.",
+             cxxopts::value<std::uint64_t>()->default_value("0"))
+            ("soup-size", "The edge length of the random square in the middle of each soup's board.",
+             cxxopts::value<int>()->default_value("16"))
+            ("soup-board", "The edge length of the board each soup is run on.",
+             cxxopts::value<int>()->default_value("256"))
+            ("soup-density", "The chance of each cell of a soup starting alive.",
+             cxxopts::value<double>()->default_value("0.5"))
+            ("lockstep", "Step soups 64 at a time in a bit-sliced batch, fastest for boards of 64x64 or smaller.",
+             cxxopts::value<bool>()->default_value("false"))
+            ("stats", "Print the time spent loading, stepping, printing and saving, and counters, to standard error.",
+             cxxopts::value<bool>()->default_value("false"))
+            ("stats-json", "Write metrics every --stats-interval generations as JSON lines, - for standard output.",
+             cxxopts::value<std::string>())
+            ("stats-interval", "The number of generations covered by each line of --stats-json.",
+             cxxopts::value<int>()->default_value("100"))
             ("h,help", "Print usage.");
 
     // Actually parse the command line arguments
@@ -46,49 +520,281 @@ int main(int argc, char *argv[]) {
     const int steps = result["steps"].as<int>();
     const int every = result["every"].as<int>();
     const bool toroidal = result["toroidal"].as<bool>();
+    Rule rule;
+    try {
+        rule = Rule(result["rule"].as<std::string>());
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
 
-    // Start with an empty grid
-    Grid grid;
+    // Boards are allocated as the huge page mode selects, so it is set before the first one is loaded
+    try {
+        Buffers::set_huge_pages(parse_huge_pages(result["huge-pages"].as<std::string>()));
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+
+    // Printed states are drawn a whole frame at a time
+    Display display;
+    try {
+        display.configure(parse_glyphs(result["glyphs"].as<std::string>()),
+                          result.count("viewport") ? result["viewport"].as<std::string>() : std::string(),
+                          result["max-fps"].as<double>());
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+
+    // Counters and timers are only gathered when they will be reported
+    StatsReport stats;
+    try {
+        stats.configure(result["stats"].as<bool>(),
+                        result.count("stats-json") ? result["stats-json"].as<std::string>() : std::string(),
+                        result["stats-interval"].as<int>());
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+
+    // A soup census runs many small worlds at once, a period of 0 means the soup had not settled
+    if (result["soups"].as<std::uint64_t>() > 0) {
+        std::unique_ptr<SoupSearch> search;
+        try {
+            search.reset(new SoupSearch(result["soup-board"].as<int>(), result["soup-size"].as<int>()));
+            search->set_density(result["soup-density"].as<double>());
+            search->set_max_generations(steps);
+            search->set_toroidal(toroidal);
+            search->set_rule(rule);
+            // Soups default to Engine::BITPACKED rather than the byte engine of a single world
+            if (result.count("engine")) {
+                search->set_engine(parse_engine(result["engine"].as<std::string>()));
+            }
+            search->set_simd_level(parse_simd_level(result["simd"].as<std::string>()));
+            search->set_threads(result["threads"].as<int>());
+            search->set_lockstep(result["lockstep"].as<bool>());
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+        const int status = run_soups(*search, result["soup-seed"].as<std::uint64_t>(),
+                                     result["soups"].as<std::uint64_t>());
+        stats.finish(Stats::read().get(Stats::Counter::GENERATIONS));
+        return status;
+    }
+
+    // The input file, if a path was given
+    const std::string input = result.count("file") ? result["file"].as<std::string>() : std::string();
+
+    // Unbounded planes have no edges and ignore --toroidal
+    if (result["hashlife"].as<bool>() || result["infinite"].as<bool>()) {
+        const std::string output = result.count("output") ? result["output"].as<std::string>() : std::string();
+        HashWorld hash_plane;
+        InfiniteWorld infinite_plane;
+        try {
+            const Stats::Timer timer(Stats::Phase::LOAD);
+            if (result["hashlife"].as<bool>()) {
+                load_plane(hash_plane, input);
+            } else {
+                load_plane(infinite_plane, input);
+            }
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+        // The rule of an rle or macrocell file is kept unless --rule was given
+        if (result["hashlife"].as<bool>()) {
+            return run_unbounded(hash_plane, result.count("rule") ? rule : hash_plane.get_rule(), steps, every,
+                                 output, display, stats);
+        }
+        return run_unbounded(infinite_plane, result.count("rule") ? rule : infinite_plane.get_rule(), steps, every,
+                             output, display, stats);
+    }
 
-    // Attempt to read in and parse the input file as an ascii .gol file if a path was given
-    if (result.count("file")) {
+    // Every node of a cluster loads the whole board and keeps its own strip of rows
+    if (result.count("cluster")) {
+        std::unique_ptr<Cluster> cluster;
+        std::unique_ptr<DistributedWorld> distributed;
         try {
-            grid = Zoo::load_ascii(result["file"].as<std::string>());
+            cluster.reset(new Cluster(result["cluster-rank"].as<int>(),
+                                      Cluster::parse_endpoints(result["cluster"].as<std::string>())));
+            {
+                const Stats::Timer timer(Stats::Phase::LOAD);
+                distributed.reset(new DistributedWorld(*cluster, load_grid(input), result["halo"].as<int>()));
+            }
+            distributed->set_rule(rule);
+            distributed->set_engine(parse_engine(result["engine"].as<std::string>()));
+            distributed->set_simd_level(parse_simd_level(result["simd"].as<std::string>()));
+            distributed->set_threads(result["threads"].as<int>());
+            distributed->set_temporal_depth(result["temporal-depth"].as<int>());
         }
         catch (const std::exception &ex) {
             std::cerr << ex.what() << std::endl;
             std::exit(-1);
         }
+        return run_distributed(*distributed, *cluster, steps, every, toroidal, rule,
+                               result.count("output") ? result["output"].as<std::string>() : std::string(),
+                               result.count("shards") ? result["shards"].as<std::string>() : std::string(),
+                               display, stats);
+    }
+
+    // Attempt to read in and parse the input file if a path was given, or start with an empty grid
+    Grid grid;
+    Snapshot::Info resumed = {Snapshot::VERSION, 0, 0, 0, rule, Snapshot::DEFAULT_CHUNK_SIZE};
+    try {
+        const Stats::Timer timer(Stats::Phase::LOAD);
+        if (result.count("resume")) {
+            resumed = Snapshot::read_info(result["resume"].as<std::string>());
+            grid = Snapshot::load(result["resume"].as<std::string>());
+        } else if (result.count("replay")) {
+            const DeltaReplayer replayer(result["replay"].as<std::string>());
+            resumed.generation = result.count("replay-generation") ? result["replay-generation"].as<std::uint64_t>()
+                                                                   : replayer.get_last_generation();
+            grid = replayer.replay(resumed.generation);
+        } else {
+            grid = load_grid(input);
+        }
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
     }
 
-    // Construct a world from the parsed grid
+    // Construct a world from the parsed grid, a checkpoint keeps its rule unless --rule was given
     World world(grid);
+    world.set_generation(resumed.generation);
+    if (!result.count("rule")) {
+        rule = resumed.rule;
+    }
+    try {
+        world.set_rule(rule);
+        world.set_engine(parse_engine(result["engine"].as<std::string>()));
+        world.set_simd_level(parse_simd_level(result["simd"].as<std::string>()));
+        world.set_threads(result["threads"].as<int>());
+        world.set_temporal_depth(result["temporal-depth"].as<int>());
+        world.set_cycle_mode(parse_cycle_mode(result["cycles"].as<std::string>()));
+        world.set_population_mode(parse_population_mode(result["population"].as<std::string>()));
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
 
     // Print the initial state of the grid
     std::cout << "Initial state..." << std::endl
-              << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells() << std::endl
-              << world.get_state() << std::endl;
+              << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells() << std::endl;
+    display.draw(world.state());
+
+    // Checkpoints are written by a background thread while stepping continues
+    const int checkpoint_every = result["checkpoint-every"].as<int>();
+    std::unique_ptr<CheckpointWriter> checkpoints;
+    if (checkpoint_every > 0) {
+        checkpoints.reset(new CheckpointWriter(result["checkpoint"].as<std::string>()));
+    }
+
+    // Deltas hold only the cells each step changed, with the occasional whole state to replay from
+    const int delta_keyframes = result["delta-keyframes"].as<int>();
+    std::unique_ptr<DeltaWriter> deltas;
+    if (result.count("deltas")) {
+        try {
+            deltas.reset(new DeltaWriter(result["deltas"].as<std::string>(), world.get_width(), world.get_height()));
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+        world.set_change_tracking(true);
+        write_deltas(*deltas, world, true);
+    }
+
+    // Perform the requested number of update steps, a resumed run carries on from its generation
+    const int first_step = static_cast<int>(std::min<std::uint64_t>(world.get_generation(), std::max(steps, 0)));
+    for (int step = first_step; step < steps; step++) {
+        // Unless deltas or Stats see every step, the steps up to the next frame or checkpoint are taken at once
+        int chunk = 1;
+        if (!deltas && !Stats::enabled()) {
+            chunk = steps - step;
+            if (every > 0) {
+                chunk = std::min(chunk, (every - step % every) % every + 1);
+            }
+            if (checkpoints) {
+                const std::uint64_t due = checkpoint_every - world.get_generation() % checkpoint_every;
+                chunk = static_cast<int>(std::min<std::uint64_t>(chunk, due));
+            }
+        }
+        world.advance(chunk, toroidal);
+        step += chunk - 1;
+        if (deltas) {
+            write_deltas(*deltas, world, delta_keyframes > 0 && world.get_generation() % delta_keyframes == 0);
+        }
 
-    // Perform the requested number of update steps
-    for (int step = 0; step < steps; step++) {
-        world.step(toroidal);
+        stats.update(world.get_generation());
+        if (checkpoints && world.get_generation() % checkpoint_every == 0) {
+            submit_checkpoint(*checkpoints, world);
+        }
+
+        // Print the state of the grid every N steps, unless it would exceed --max-fps
+        if ((every > 0) && (step % every == 0) && display.frame_due()) {
+            std::cout << "Step " << (step + 1) << " of " << steps << '\n';
+            display.draw(world.state());
+        }
 
-        // Print the state of the grid every N steps
-        if ((every > 0) && (step % every == 0)) {
-            std::cout << "Step " << (step + 1) << " of " << steps << std::endl
-                      << world.get_state() << std::endl;
+        // Once the world repeats itself, advance jumps straight over the remaining whole periods
+        if (world.get_cycle_mode() == CycleMode::SKIP && world.get_cycle_period() > 0 && step + 1 < steps) {
+            world.advance(steps - step - 1, toroidal);
+            // The generations skipped have no deltas, so the stream carries on from a keyframe
+            if (deltas) {
+                write_deltas(*deltas, world, true);
+            }
+            stats.update(world.get_generation());
+            // The checkpoints due among the generations skipped are replaced by one of the generation jumped to
+            if (checkpoints) {
+                submit_checkpoint(*checkpoints, world);
+            }
+            break;
         }
     }
 
     // Print the final state of the grid
     std::cout << "Final state..." << std::endl
-              << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells() << std::endl
-              << world.get_state() << std::endl;
+              << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells() << std::endl;
+    display.draw(world.state());
+    if (world.get_cycle_period() > 0) {
+        std::cout << "Cycle of period " << world.get_cycle_period() << " from generation "
+                  << world.get_cycle_start() << std::endl;
+    }
+
+    if (checkpoints) {
+        try {
+            const Stats::Timer timer(Stats::Phase::CHECKPOINT);
+            checkpoints->flush();
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+        }
+    }
 
     // Attempt to save to the output directory if a path was given
     if (result.count("output")) {
         try {
-            Zoo::save_ascii(result["output"].as<std::string>(), world.get_state());
+            const Stats::Timer timer(Stats::Phase::SAVE);
+            const std::string output = result["output"].as<std::string>();
+            if (has_extension(output, ".rle")) {
+                Zoo::save_rle(output, world.state(), rule);
+            } else if (has_extension(output, ".mc")) {
+                HashWorld plane(world.state());
+                plane.set_rule(rule);
+                Zoo::save_macrocell(output, plane);
+            } else {
+                Zoo::save_ascii(output, world.state());
+            }
         }
         catch (const std::exception &ex) {
             std::cerr << ex.what() << std::endl;
@@ -96,6 +802,8 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    stats.finish(world.get_generation());
+
     // Destructors handle all the memory deallocation
     return 0;
 }
@@ -0,0 +1,206 @@
+/**
+ * Implements the allocator behind the cell buffers of Grid and BitGrid.
+ *      - Buffers smaller than Buffers::HUGE_PAGE_SIZE come from the heap, aligned to a cache line so vector
+ *        loads of the first row never straddle two lines.
+ *      - Larger buffers are mapped from the kernel directly, starting on a huge page boundary, so the kernel
+ *        can back them with huge pages and a multi-GB board needs a few thousand TLB entries, not millions.
+ *      - Mapped pages are only backed with memory once first written, by whichever thread writes them.
+ *        World relies on this to place the rows each thread steps on that thread's NUMA node.
+ *
+ * Where mmap is unavailable every buffer comes from the heap, aligned by hand.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "allocator.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOL_HAVE_MMAP 1
+#include <stdlib.h>
+#include <sys/mman.h>
+#endif
+
+// The mode selected by Buffers::set_huge_pages
+static std::atomic<HugePages> huge_pages(HugePages::TRANSPARENT);
+
+/**
+ * parse_huge_pages(name)
+ *
+ * Parses the name of a huge page mode, as accepted by the --huge-pages command line option.
+ *
+ * @example
+ *
+ *      Buffers::set_huge_pages(parse_huge_pages("explicit"));
+ *
+ * @param name
+ *      One of "off", "transparent" or "explicit".
+ *
+ * @return
+ *      The named mode.
+ *
+ * @throws
+ *      std::runtime_error if the name does not match a mode.
+ */
+HugePages parse_huge_pages(const std::string &name) {
+    if (name == "off") return HugePages::OFF;
+    if (name == "transparent") return HugePages::TRANSPARENT;
+    if (name == "explicit") return HugePages::EXPLICIT;
+    throw std::runtime_error(std::string("Unknown huge page mode: ") + name);
+}
+
+/**
+ * Buffers::set_huge_pages(mode)
+ *
+ * Select how buffers of Buffers::HUGE_PAGE_SIZE bytes or more are backed. Buffers already allocated are
+ * not affected, so the mode is best selected before the first board is loaded.
+ *
+ * @example
+ *
+ *      // Take boards from the huge pages reserved through /proc/sys/vm/nr_hugepages
+ *      Buffers::set_huge_pages(HugePages::EXPLICIT);
+ *      World world(65536, 65536);
+ *
+ * @param mode
+ *      The huge page mode.
+ */
+void Buffers::set_huge_pages(const HugePages mode) {
+    huge_pages.store(mode, std::memory_order_relaxed);
+}
+
+/**
+ * Buffers::get_huge_pages()
+ *
+ * Gets the huge page mode selected by Buffers::set_huge_pages(mode).
+ *
+ * @return
+ *      The huge page mode.
+ */
+HugePages Buffers::get_huge_pages() {
+    return huge_pages.load(std::memory_order_relaxed);
+}
+
+#ifdef GOL_HAVE_MMAP
+/**
+ * Rounds the size of a mapped buffer up to a whole number of huge pages.
+ */
+static std::size_t mapped_length(const std::size_t bytes) {
+    return (bytes + Buffers::HUGE_PAGE_SIZE - 1) / Buffers::HUGE_PAGE_SIZE * Buffers::HUGE_PAGE_SIZE;
+}
+
+/**
+ * Maps length bytes of fresh memory, a whole number of huge pages, backed as the huge page mode selects.
+ * Returns nullptr if the memory could not be mapped.
+ */
+static void *map_buffer(const std::size_t length, const HugePages mode) {
+#ifdef MAP_HUGETLB
+    if (mode == HugePages::EXPLICIT) {
+        void *address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                               -1, 0);
+        if (address != MAP_FAILED) {
+            return address;
+        }
+    }
+#endif
+    // Map an extra huge page, then trim either end so the buffer starts on a huge page boundary
+    const std::size_t padded = length + Buffers::HUGE_PAGE_SIZE;
+    void *address = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+        return nullptr;
+    }
+    const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(address);
+    const std::uintptr_t aligned = (start + Buffers::HUGE_PAGE_SIZE - 1) & ~(Buffers::HUGE_PAGE_SIZE - 1);
+    if (aligned > start) {
+        ::munmap(address, aligned - start);
+    }
+    if (start + padded > aligned + length) {
+        ::munmap(reinterpret_cast<void *>(aligned + length), start + padded - (aligned + length));
+    }
+    void *buffer = reinterpret_cast<void *>(aligned);
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    ::madvise(buffer, length, mode == HugePages::OFF ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+#endif
+    return buffer;
+}
+#endif
+
+/**
+ * Buffers::allocate(bytes)
+ *
+ * Allocate a buffer aligned to Buffers::ALIGNMENT. Its contents are not written, and buffers of
+ * Buffers::HUGE_PAGE_SIZE bytes or more are not backed with memory until their pages are first written.
+ *
+ * @example
+ *
+ *      void *buffer = Buffers::allocate(1 << 30);
+ *      Buffers::release(buffer, 1 << 30);
+ *
+ * @param bytes
+ *      The size of the buffer, nullptr is returned for 0.
+ *
+ * @return
+ *      The buffer.
+ *
+ * @throws
+ *      std::bad_alloc if the memory could not be allocated.
+ */
+void *Buffers::allocate(const std::size_t bytes) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+#ifdef GOL_HAVE_MMAP
+    if (bytes >= HUGE_PAGE_SIZE) {
+        void *buffer = map_buffer(mapped_length(bytes), get_huge_pages());
+        if (buffer == nullptr) {
+            throw std::bad_alloc();
+        }
+        return buffer;
+    }
+    void *buffer = nullptr;
+    if (::posix_memalign(&buffer, ALIGNMENT, bytes) != 0) {
+        throw std::bad_alloc();
+    }
+    return buffer;
+#else
+    // Over allocate, and keep the address malloc returned just before the aligned buffer
+    void *block = std::malloc(bytes + ALIGNMENT + sizeof(void *));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(block) + sizeof(void *) + ALIGNMENT - 1)
+                                   & ~(ALIGNMENT - 1);
+    reinterpret_cast<void **>(aligned)[-1] = block;
+    return reinterpret_cast<void *>(aligned);
+#endif
+}
+
+/**
+ * Buffers::release(buffer, bytes)
+ *
+ * Release a buffer from Buffers::allocate(bytes). Which way it was allocated only depends on its size,
+ * so the huge page mode may have changed in between.
+ *
+ * @param buffer
+ *      The buffer, nothing happens for nullptr.
+ *
+ * @param bytes
+ *      The size the buffer was allocated with.
+ */
+void Buffers::release(void *buffer, const std::size_t bytes) noexcept {
+    if (buffer == nullptr) {
+        return;
+    }
+#ifdef GOL_HAVE_MMAP
+    if (bytes >= HUGE_PAGE_SIZE) {
+        ::munmap(buffer, mapped_length(bytes));
+        return;
+    }
+    std::free(buffer);
+#else
+    (void) bytes;
+    std::free(reinterpret_cast<void **>(buffer)[-1]);
+#endif
+}
@@ -0,0 +1,105 @@
+/**
+ * Declares the allocator behind the cell buffers of Grid and BitGrid.
+ * Rich documentation for the api and the allocation strategy can be found in allocator.cpp.
+ *
+ * Every buffer starts on a cache line, and buffers of a huge page or more are mapped straight from the kernel,
+ * backed by huge pages where the selected HugePages mode and the platform allow.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * How buffers of at least Buffers::HUGE_PAGE_SIZE bytes are backed.
+ *      - HugePages::OFF maps them with ordinary pages.
+ *      - HugePages::TRANSPARENT asks the kernel to back them with transparent huge pages where it can.
+ *      - HugePages::EXPLICIT takes them from the reserved huge page pool (MAP_HUGETLB), falling back to
+ *        HugePages::TRANSPARENT once the pool runs dry.
+ */
+enum class HugePages {
+    OFF,
+    TRANSPARENT,
+    EXPLICIT
+};
+
+// Parses a huge page mode name such as "off" or "transparent"
+HugePages parse_huge_pages(const std::string &name);
+
+/**
+ * Declare the interface of the Buffers namespace, the raw allocation functions BufferAllocator forwards to.
+ */
+namespace Buffers {
+    const std::size_t ALIGNMENT = 64;                // Every buffer starts on a cache line
+
+    const std::size_t HUGE_PAGE_SIZE = 2 << 20;      // Buffers this large or larger are mapped
+
+    // Selects how mapped buffers are backed from now on, the default is HugePages::TRANSPARENT
+    void set_huge_pages(const HugePages mode);
+
+    HugePages get_huge_pages();
+
+    // Allocates bytes of unwritten memory aligned to ALIGNMENT, throws std::bad_alloc on failure
+    void *allocate(const std::size_t bytes);
+
+    // Releases memory from allocate, bytes must be the size it was allocated with
+    void release(void *buffer, const std::size_t bytes) noexcept;
+}
+
+/**
+ * Declare the structure of the BufferAllocator class, a stateless standard allocator on top of Buffers.
+ *
+ * Unlike std::allocator, default inserted elements are left unwritten, e.g. by std::vector::resize(n).
+ * The pages of a buffer are then first touched by whoever fills it in, which on NUMA machines places them
+ * on the memory node of that thread. Elements inserted with a value are written as usual.
+ */
+template<typename T>
+class BufferAllocator {
+public:
+    typedef T value_type;
+
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    typedef std::true_type is_always_equal;
+
+    BufferAllocator() noexcept {
+    }
+
+    template<typename U>
+    BufferAllocator(const BufferAllocator<U> &) noexcept {
+    }
+
+    T *allocate(const std::size_t n) {
+        return static_cast<T *>(Buffers::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *buffer, const std::size_t n) noexcept {
+        Buffers::release(buffer, n * sizeof(T));
+    }
+
+    template<typename U>
+    void construct(U *element) {
+        ::new(static_cast<void *>(element)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U *element, Args &&... args) {
+        ::new(static_cast<void *>(element)) U(std::forward<Args>(args)...);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const BufferAllocator<T> &, const BufferAllocator<U> &) {
+    return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const BufferAllocator<T> &, const BufferAllocator<U> &) {
+    return false;
+}
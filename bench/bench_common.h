@@ -0,0 +1,57 @@
+/**
+ * Declares the helpers shared by the benchmark suites, such as building random grids of a given density.
+ *
+ * The suites use Google Benchmark (https://github.com/google/benchmark) and report cells per second as
+ * items per second, and bytes per second for file formats.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include "../grid.h"
+#include "../world.h"
+
+/**
+ * Builds a grid with each cell alive with the given chance, in percent. The same arguments always give
+ * the same grid, so every run of a benchmark steps the same pattern.
+ */
+inline Grid random_grid(const int width, const int height, const int density_percent,
+                        const std::uint64_t seed = 2020) {
+    Grid grid(width, height);
+    std::mt19937_64 random(seed);
+    for (int y = 0; y < height; y++) {
+        Cell *row = grid.row(y);
+        for (int x = 0; x < width; x++) {
+            row[x] = static_cast<int>(random() % 100) < density_percent ? Cell::ALIVE : Cell::DEAD;
+        }
+    }
+    return grid;
+}
+
+/**
+ * The engines benchmarked side by side, indexed by the engine argument of a benchmark.
+ */
+static const Engine BENCH_ENGINES[] = {Engine::REFERENCE, Engine::BYTE, Engine::SIMD, Engine::BITPACKED,
+                                       Engine::SPARSE};
+
+static const int BENCH_ENGINE_COUNT = sizeof(BENCH_ENGINES) / sizeof(BENCH_ENGINES[0]);
+
+// The name of an engine, as accepted by --engine
+inline const char *engine_label(const Engine engine) {
+    switch (engine) {
+        case Engine::REFERENCE:
+            return "reference";
+        case Engine::BYTE:
+            return "byte";
+        case Engine::SIMD:
+            return "simd";
+        case Engine::BITPACKED:
+            return "bitpacked";
+        case Engine::SPARSE:
+            return "sparse";
+    }
+    return "unknown";
+}
@@ -0,0 +1,172 @@
+/**
+ * Benchmarks the whole-grid operations of Grid: rotate, transpose, mirror, merge, crop, resize and get_alive_cells,
+ * and the rotations and merges of BitGrid.
+ * Every benchmark reports the cells it touched as items per second and the bytes of cells as bytes per second.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include "bench_common.h"
+#include "../bitgrid.h"
+#include "../grid.h"
+
+/**
+ * Sets the items and bytes processed by a benchmark touching the given number of cells per iteration.
+ */
+static void set_cells_processed(benchmark::State &state, const std::int64_t cells) {
+    state.SetItemsProcessed(state.iterations() * cells);
+    state.SetBytesProcessed(state.iterations() * cells * static_cast<std::int64_t>(sizeof(Cell)));
+}
+
+/**
+ * Grid::rotate by every multiple of 90 degrees.
+ */
+static void BM_GridRotate(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const int rotation = static_cast<int>(state.range(1)) / 90;
+    const Grid grid = random_grid(size, size / 2, 50);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(grid.rotate(rotation));
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size) * (size / 2));
+}
+BENCHMARK(BM_GridRotate)->ArgsProduct({{256, 4096}, {0, 90, 180, 270}})->ArgNames({"size", "rotation"});
+
+/**
+ * Grid::transpose, copied in cache sized blocks.
+ */
+static void BM_GridTranspose(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const Grid grid = random_grid(size, size / 2, 50);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(grid.transpose());
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size) * (size / 2));
+}
+BENCHMARK(BM_GridTranspose)->Arg(256)->Arg(4096)->ArgName("size");
+
+/**
+ * The in place operations, Grid::rotate_180, Grid::mirror_horizontal and Grid::mirror_vertical.
+ */
+static void BM_GridInPlace(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const int operation = static_cast<int>(state.range(1));
+    Grid grid = random_grid(size, size, 50);
+    for (auto _ : state) {
+        if (operation == 0) {
+            grid.rotate_180();
+        } else if (operation == 1) {
+            grid.mirror_horizontal();
+        } else {
+            grid.mirror_vertical();
+        }
+        benchmark::ClobberMemory();
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size) * size);
+}
+BENCHMARK(BM_GridInPlace)->ArgsProduct({{256, 4096}, {0, 1, 2}})->ArgNames({"size", "operation"});
+
+/**
+ * BitGrid::rotate by every multiple of 90 degrees, transposing 64x64 bit blocks.
+ */
+static void BM_BitGridRotate(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const int rotation = static_cast<int>(state.range(1)) / 90;
+    const BitGrid grid(random_grid(size, size / 2, 50));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(grid.rotate(rotation));
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size) * (size / 2));
+}
+BENCHMARK(BM_BitGridRotate)->ArgsProduct({{256, 4096}, {0, 90, 180, 270}})->ArgNames({"size", "rotation"});
+
+/**
+ * Grid::merge of a quarter sized grid into the middle of a board, with and without alive_only.
+ */
+static void BM_GridMerge(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const bool alive_only = state.range(1) != 0;
+    Grid board = random_grid(size, size, 50);
+    const Grid other = random_grid(size / 2, size / 2, 50, 7);
+    for (auto _ : state) {
+        board.merge(other, size / 4, size / 4, alive_only);
+        benchmark::ClobberMemory();
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size / 2) * (size / 2));
+}
+BENCHMARK(BM_GridMerge)->ArgsProduct({{256, 4096}, {0, 1}})->ArgNames({"size", "alive_only"});
+
+/**
+ * Grid::crop of the middle half of a board.
+ */
+static void BM_GridCrop(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const Grid board = random_grid(size, size, 50);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(board.crop(size / 4, size / 4, 3 * size / 4, 3 * size / 4));
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size / 2) * (size / 2));
+}
+BENCHMARK(BM_GridCrop)->RangeMultiplier(4)->Range(64, 4096)->ArgName("size");
+
+/**
+ * Stamping a board with thousands of small patterns, merging views of a pattern without copying them,
+ * and the same with BitGrid::merge at unaligned columns.
+ */
+static void BM_GridStamp(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const bool packed = state.range(1) != 0;
+    const Grid pattern = random_grid(16, 16, 50, 3);
+    Grid board(size, size);
+    BitGrid packed_board(size, size);
+    const BitGrid packed_pattern(pattern);
+    std::int64_t stamps = 0;                         // Stamps per iteration
+    for (int y = 0; y + 16 <= size; y += 23) {
+        stamps += (size - 16) / 21 + 1;
+    }
+    for (auto _ : state) {
+        for (int y = 0; y + 16 <= size; y += 23) {
+            for (int x = 0; x + 16 <= size; x += 21) {
+                if (packed) {
+                    packed_board.merge(packed_pattern, x, y, true);
+                } else {
+                    board.merge(pattern.view(0, 0, 16, 16), x, y, true);
+                }
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    set_cells_processed(state, stamps * 16 * 16);
+}
+BENCHMARK(BM_GridStamp)->ArgsProduct({{256, 4096}, {0, 1}})->ArgNames({"size", "packed"});
+
+/**
+ * Grid::resize back and forth between a board and one with twice the area, keeping the overlap.
+ */
+static void BM_GridResize(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    Grid board = random_grid(size, size, 50);
+    bool grown = false;
+    for (auto _ : state) {
+        board.resize(grown ? size : 2 * size, size);
+        grown = !grown;
+        benchmark::ClobberMemory();
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size) * size);
+}
+BENCHMARK(BM_GridResize)->RangeMultiplier(4)->Range(64, 4096)->ArgName("size");
+
+/**
+ * Grid::get_alive_cells at sparse and dense populations.
+ */
+static void BM_GridAliveCells(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    const Grid board = random_grid(size, size, static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(board.get_alive_cells());
+    }
+    set_cells_processed(state, static_cast<std::int64_t>(size) * size);
+}
+BENCHMARK(BM_GridAliveCells)->ArgsProduct({{256, 4096}, {5, 50}})->ArgNames({"size", "density"});
@@ -0,0 +1,10 @@
+/**
+ * Entry point of the benchmark suites. Run with --help for the Google Benchmark options, such as
+ * --benchmark_filter=BM_WorldStep to run a single suite.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,271 @@
+/**
+ * Benchmarks the stepping engines of World, HashWorld, InfiniteWorld, LockstepBatch and SoupSearch.
+ * Every benchmark reports the cells it updated as items per second, so engines can be compared directly.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+#include "bench_common.h"
+#include "../hashlife.h"
+#include "../infinite_world.h"
+#include "../lockstep.h"
+#include "../soup.h"
+#include "../world.h"
+#include "../zoo.h"
+
+/**
+ * Arguments of the World benchmarks: engine, board size, density in percent and toroidal.
+ * The reference engine allocates for every cell, so it only runs the smaller boards.
+ */
+static void world_arguments(benchmark::internal::Benchmark *benchmark) {
+    for (int engine = 0; engine < BENCH_ENGINE_COUNT; engine++) {
+        for (const int size : {64, 256, 1024, 4096}) {
+            if (BENCH_ENGINES[engine] == Engine::REFERENCE && size > 256) {
+                continue;
+            }
+            for (const int density : {5, 50}) {
+                for (const int toroidal : {0, 1}) {
+                    benchmark->Args({engine, size, density, toroidal});
+                }
+            }
+        }
+    }
+    benchmark->ArgNames({"engine", "size", "density", "toroidal"});
+}
+
+/**
+ * World::step(toroidal) for every engine, board size, density and topology.
+ */
+static void BM_WorldStep(benchmark::State &state) {
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = static_cast<int>(state.range(1));
+    const bool toroidal = state.range(3) != 0;
+    World world(random_grid(size, size, static_cast<int>(state.range(2))));
+    world.set_engine(engine);
+    for (auto _ : state) {
+        world.step(toroidal);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldStep)->Apply(world_arguments);
+
+/**
+ * World::advance(steps, toroidal) of 16 generations a time, including any per call setup of the engine.
+ */
+static void BM_WorldAdvance(benchmark::State &state) {
+    static const int STEPS = 16;
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = static_cast<int>(state.range(1));
+    const bool toroidal = state.range(3) != 0;
+    World world(random_grid(size, size, static_cast<int>(state.range(2))));
+    world.set_engine(engine);
+    for (auto _ : state) {
+        world.advance(STEPS, toroidal);
+    }
+    state.SetItemsProcessed(state.iterations() * STEPS * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldAdvance)->Apply(world_arguments);
+
+/**
+ * World::advance(steps, toroidal) with Engine::BITPACKED on boards larger than the caches, for every temporal
+ * depth. Depth 1 streams the whole board once per generation, the deeper passes once per depth generations.
+ */
+static void BM_WorldAdvanceTemporal(benchmark::State &state) {
+    static const int STEPS = 64;
+    const int size = static_cast<int>(state.range(0));
+    World world(random_grid(size, size, 50));
+    world.set_engine(Engine::BITPACKED);
+    world.set_temporal_depth(static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        world.advance(STEPS, false);
+    }
+    state.SetItemsProcessed(state.iterations() * STEPS * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(Engine::BITPACKED));
+}
+BENCHMARK(BM_WorldAdvanceTemporal)
+        ->ArgsProduct({{4096, 16384}, {1, 2, 4, 8, 16}})
+        ->ArgNames({"size", "depth"})
+        ->Unit(benchmark::kMillisecond);
+
+/**
+ * World::step on a large board with a growing number of threads, to check the bands scale.
+ */
+static void BM_WorldStepThreads(benchmark::State &state) {
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = 4096;
+    World world(random_grid(size, size, 50));
+    world.set_engine(engine);
+    world.set_threads(static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        world.step(false);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldStepThreads)
+        ->ArgsProduct({{1, 2, 3}, {1, 2, 4, 8}})
+        ->ArgNames({"engine", "threads"})
+        ->UseRealTime();
+
+/**
+ * World::step with cycle detection, the cost of hashing every generation on top of stepping.
+ */
+static void BM_WorldStepCycles(benchmark::State &state) {
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = static_cast<int>(state.range(1));
+    World world(random_grid(size, size, 50));
+    world.set_engine(engine);
+    world.set_cycle_mode(CycleMode::DETECT);
+    for (auto _ : state) {
+        world.step(false);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldStepCycles)->ArgsProduct({{1, 3, 4}, {256, 1024}})->ArgNames({"engine", "size"});
+
+/**
+ * World::get_alive_cells recounting every call, through the Grid or the packed state.
+ */
+static void BM_WorldAliveCells(benchmark::State &state) {
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = static_cast<int>(state.range(1));
+    World world(random_grid(size, size, 50));
+    world.set_engine(engine);
+    world.set_population_mode(PopulationMode::RECOUNT);
+    world.step(false);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(world.get_alive_cells());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldAliveCells)->ArgsProduct({{1, 3}, {256, 4096}})->ArgNames({"engine", "size"});
+
+/**
+ * World::step followed by World::get_alive_cells, as a monitor polling every generation would, recounting or
+ * keeping the count up to date.
+ */
+static void BM_WorldStepPopulation(benchmark::State &state) {
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = static_cast<int>(state.range(1));
+    World world(random_grid(size, size, static_cast<int>(state.range(2))));
+    world.set_engine(engine);
+    world.set_population_mode(state.range(3) ? PopulationMode::INCREMENTAL : PopulationMode::RECOUNT);
+    for (auto _ : state) {
+        world.step(false);
+        benchmark::DoNotOptimize(world.get_alive_cells());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldStepPopulation)
+        ->ArgsProduct({{1, 3, 4}, {1024, 4096}, {5, 50}, {0, 1}})
+        ->ArgNames({"engine", "size", "density", "incremental"});
+
+/**
+ * World::step, an edit through each public accessor and World::get_alive_cells after it, as a program placing
+ * patterns between generations would, recounting or keeping the count up to date.
+ */
+static void BM_WorldEditPopulation(benchmark::State &state) {
+    const Engine engine = BENCH_ENGINES[state.range(0)];
+    const int size = static_cast<int>(state.range(1));
+    World world(random_grid(size, size, 50));
+    world.set_engine(engine);
+    world.set_population_mode(state.range(2) ? PopulationMode::INCREMENTAL : PopulationMode::RECOUNT);
+    std::vector<Cell> row(static_cast<std::size_t>(size));
+    int edits = 0;
+    for (auto _ : state) {
+        world.step(false);
+        benchmark::DoNotOptimize(world.get_alive_cells());
+        const int x = edits % size, y = (edits / size) % size;
+        edits++;
+        const Cell flipped = world.state().get(x, y) == Cell::ALIVE ? Cell::DEAD : Cell::ALIVE;
+        switch (edits % 3) {
+            case 0:
+                world.get_state()(x, y) = flipped;
+                break;
+            case 1:
+                world.edit_state().set(x, y, flipped);
+                break;
+            default:
+                world.read_rows(y, 1, row.data());
+                row[x] = flipped;
+                world.write_rows(y, 1, row.data());
+                break;
+        }
+        benchmark::DoNotOptimize(world.get_alive_cells());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetLabel(engine_label(engine));
+}
+BENCHMARK(BM_WorldEditPopulation)
+        ->ArgsProduct({{1, 3, 4}, {256, 1024}, {0, 1}})
+        ->ArgNames({"engine", "size", "incremental"});
+
+/**
+ * HashWorld::advance over 2^k generations of the r-pentomino, reported in generations per second.
+ */
+static void BM_HashWorldAdvance(benchmark::State &state) {
+    const std::uint64_t steps = static_cast<std::uint64_t>(1) << state.range(0);
+    for (auto _ : state) {
+        HashWorld world(Zoo::r_pentomino());
+        world.advance(steps);
+        benchmark::DoNotOptimize(world.get_alive_cells());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(steps));
+}
+BENCHMARK(BM_HashWorldAdvance)->DenseRange(6, 30, 8)->ArgName("log2_steps");
+
+/**
+ * InfiniteWorld::step on a random square of the given size.
+ */
+static void BM_InfiniteWorldStep(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    InfiniteWorld world(random_grid(size, size, 50));
+    for (auto _ : state) {
+        world.step();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+}
+BENCHMARK(BM_InfiniteWorldStep)->RangeMultiplier(4)->Range(64, 4096)->ArgName("size");
+
+/**
+ * LockstepBatch::step of 64 boards of the given size at once.
+ */
+static void BM_LockstepStep(benchmark::State &state) {
+    const int size = static_cast<int>(state.range(0));
+    LockstepBatch batch(size, size);
+    for (int lane = 0; lane < LockstepBatch::LANES; lane++) {
+        batch.load(lane, random_grid(size, size, 50, lane));
+    }
+    for (auto _ : state) {
+        batch.step(false);
+    }
+    state.SetItemsProcessed(state.iterations() * LockstepBatch::LANES * static_cast<std::int64_t>(size) * size);
+}
+BENCHMARK(BM_LockstepStep)->RangeMultiplier(2)->Range(16, 256)->ArgName("size");
+
+/**
+ * SoupSearch::run of 16x16 soups until they settle, reported in soups per second.
+ */
+static void BM_SoupSearch(benchmark::State &state) {
+    static const std::uint64_t SOUPS = 256;
+    SoupSearch search(static_cast<int>(state.range(0)), 16);
+    search.set_lockstep(state.range(1) != 0);
+    search.set_max_generations(5000);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(search.run(0, SOUPS).data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(SOUPS));
+    state.SetLabel(state.range(1) ? "lockstep" : "world");
+}
+BENCHMARK(BM_SoupSearch)
+        ->ArgsProduct({{64, 256}, {0, 1}})
+        ->ArgNames({"board", "lockstep"})
+        ->Unit(benchmark::kMillisecond);
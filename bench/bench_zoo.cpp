@@ -0,0 +1,121 @@
+/**
+ * Benchmarks the Zoo file formats and snapshots, loading and saving boards of growing size.
+ * Every benchmark reports the cells as items per second and the size of the file as bytes per second.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "bench_common.h"
+#include "../grid.h"
+#include "../snapshot.h"
+#include "../zoo.h"
+
+/**
+ * The size of a file in bytes, or 0 if it cannot be opened.
+ */
+static std::int64_t file_size(const std::string &path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    return file.good() ? static_cast<std::int64_t>(file.tellg()) : 0;
+}
+
+/**
+ * The formats benchmarked, indexed by the format argument of a benchmark.
+ */
+enum BenchFormat {
+    ASCII,
+    BINARY,
+    RLE,
+    SNAPSHOT
+};
+
+static const char *const FORMAT_LABELS[] = {"ascii", "binary", "rle", "snapshot"};
+
+static std::string format_path(const int format) {
+    static const char *const extensions[] = {".gol", ".bgol", ".rle", ".snap.bgol"};
+    return std::string("bench_zoo") + extensions[format];
+}
+
+static void save_format(const int format, const std::string &path, const Grid &grid) {
+    switch (format) {
+        case ASCII:
+            Zoo::save_ascii(path, grid);
+            break;
+        case BINARY:
+            Zoo::save_binary(path, grid);
+            break;
+        case RLE:
+            Zoo::save_rle(path, grid);
+            break;
+        case SNAPSHOT:
+            Snapshot::save(path, grid);
+            break;
+    }
+}
+
+static Grid load_format(const int format, const std::string &path) {
+    switch (format) {
+        case ASCII:
+            return Zoo::load_ascii(path);
+        case BINARY:
+            return Zoo::load_binary(path);
+        case RLE:
+            return Zoo::load_rle(path);
+        default:
+            return Snapshot::load(path);
+    }
+}
+
+/**
+ * Arguments of the file benchmarks: format, board size and density in percent.
+ */
+static void file_arguments(benchmark::internal::Benchmark *benchmark) {
+    for (int format = ASCII; format <= SNAPSHOT; format++) {
+        for (const int size : {64, 1024, 4096}) {
+            for (const int density : {5, 50}) {
+                benchmark->Args({format, size, density});
+            }
+        }
+    }
+    benchmark->ArgNames({"format", "size", "density"});
+}
+
+/**
+ * Loading a board from every format, read back from a file written before timing starts.
+ */
+static void BM_ZooLoad(benchmark::State &state) {
+    const int format = static_cast<int>(state.range(0));
+    const int size = static_cast<int>(state.range(1));
+    const std::string path = format_path(format);
+    save_format(format, path, random_grid(size, size, static_cast<int>(state.range(2))));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(load_format(format, path));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetBytesProcessed(state.iterations() * file_size(path));
+    state.SetLabel(FORMAT_LABELS[format]);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_ZooLoad)->Apply(file_arguments);
+
+/**
+ * Saving a board in every format.
+ */
+static void BM_ZooSave(benchmark::State &state) {
+    const int format = static_cast<int>(state.range(0));
+    const int size = static_cast<int>(state.range(1));
+    const std::string path = format_path(format);
+    const Grid grid = random_grid(size, size, static_cast<int>(state.range(2)));
+    for (auto _ : state) {
+        save_format(format, path, grid);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size) * size);
+    state.SetBytesProcessed(state.iterations() * file_size(path));
+    state.SetLabel(FORMAT_LABELS[format]);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_ZooSave)->Apply(file_arguments);
@@ -0,0 +1,579 @@
+/**
+ * Implements a class representing a bit-packed 2d grid of cells.
+ *      - New cells are initialized to Cell::DEAD.
+ *      - Each cell occupies a single bit, rows are padded to a whole number of 64 bit words.
+ *          - Bit (x % 64) of word (x / 64) in a row holds the cell at x.
+ *          - Padding bits past the width of the grid are always kept at 0.
+ *      - BitGrids can be converted to and from a byte-per-cell Grid.
+ *      - BitGrids can return counts of the alive and dead cells using popcount.
+ *      - BitGrids can be serialized directly to an ascii std::ostream, producing the same output as a Grid.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "bitgrid.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Passed by reference to std::min, so it needs a definition of its own
+const int BitGrid::WORD_BITS;
+
+/**
+ * BitGrid::BitGrid()
+ *
+ * Construct an empty bit-packed grid of size 0x0.
+ *
+ * @example
+ *
+ *      // Make a 0x0 empty grid
+ *      BitGrid grid;
+ *
+ */
+BitGrid::BitGrid() : BitGrid(0, 0) {
+}
+
+/**
+ * BitGrid::BitGrid(square_size)
+ *
+ * Construct a bit-packed grid with the desired size filled with dead cells.
+ *
+ * @example
+ *
+ *      // Make a 16x16 grid
+ *      BitGrid x(16);
+ *
+ * @param square_size
+ *      The edge size to use for the width and height of the grid.
+ */
+BitGrid::BitGrid(const int square_size) : BitGrid(square_size, square_size) {
+}
+
+/**
+ * BitGrid::BitGrid(width, height)
+ *
+ * Construct a bit-packed grid with the desired size filled with dead cells.
+ *
+ * @example
+ *
+ *      // Make a 100x9 grid, each row is stored in two words
+ *      BitGrid grid(100, 9);
+ *
+ * @param width
+ *      The width of the grid.
+ *
+ * @param height
+ *      The height of the grid.
+ */
+BitGrid::BitGrid(const int width, const int height) : width(width), height(height),
+                                                      words_per_row((width + WORD_BITS - 1) / WORD_BITS),
+                                                      words(static_cast<size_t>(words_per_row) * height, 0) {
+}
+
+/**
+ * BitGrid::BitGrid(grid)
+ *
+ * Construct a bit-packed grid with the size and contents of an existing Grid.
+ *
+ * @example
+ *
+ *      // Pack a glider
+ *      BitGrid packed(Zoo::glider());
+ *
+ * @param grid
+ *      The byte-per-cell grid to pack.
+ */
+BitGrid::BitGrid(const Grid &grid) : BitGrid(grid.get_width(), grid.get_height()) {
+    this->pack(grid);
+}
+
+/**
+ * BitGrid::untouched(width, height)
+ *
+ * Create a bit-packed grid with the desired size whose words are allocated but not written, as Grid::untouched
+ * does, so the threads that fill its rows in first touch their pages. Every row must be written before it is read.
+ *
+ * @param width
+ *      The width of the grid.
+ *
+ * @param height
+ *      The height of the grid.
+ *
+ * @return
+ *      The unwritten grid.
+ */
+BitGrid BitGrid::untouched(const int width, const int height) {
+    BitGrid grid;
+    grid.width = width;
+    grid.height = height;
+    grid.words_per_row = (width + WORD_BITS - 1) / WORD_BITS;
+    // BufferAllocator leaves default inserted words unwritten
+    grid.words.resize(static_cast<size_t>(grid.words_per_row) * height);
+    return grid;
+}
+
+/**
+ * BitGrid::get_width()
+ *
+ * Gets the current width of the grid.
+ *
+ * @return
+ *      The width of the grid.
+ */
+int BitGrid::get_width() const {
+    return this->width;
+}
+
+/**
+ * BitGrid::get_height()
+ *
+ * Gets the current height of the grid.
+ *
+ * @return
+ *      The height of the grid.
+ */
+int BitGrid::get_height() const {
+    return this->height;
+}
+
+/**
+ * BitGrid::get_words_per_row()
+ *
+ * Gets the number of 64 bit words used to store each row, including the padding.
+ *
+ * @return
+ *      The number of words in a row.
+ */
+int BitGrid::get_words_per_row() const {
+    return this->words_per_row;
+}
+
+/**
+ * BitGrid::get_total_cells()
+ *
+ * Gets the total number of cells in the grid, padding bits are not cells.
+ *
+ * @return
+ *      The number of total cells.
+ */
+int BitGrid::get_total_cells() const {
+    return this->width * this->height;
+}
+
+/**
+ * BitGrid::get_alive_cells()
+ *
+ * Counts how many cells in the grid are alive by summing the popcount of every word.
+ * Padding bits are always 0 so they never contribute to the count.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+int BitGrid::get_alive_cells() const {
+    int sum = 0;
+    for (const std::uint64_t word : this->words) {
+        sum += popcount64(word);
+    }
+    return sum;
+}
+
+/**
+ * BitGrid::get_dead_cells()
+ *
+ * Counts how many cells in the grid are dead.
+ *
+ * @return
+ *      The number of dead cells.
+ */
+int BitGrid::get_dead_cells() const {
+    return (get_total_cells() - get_alive_cells());
+}
+
+/**
+ * BitGrid::resize(square_size)
+ *
+ * Resize the current grid to a new width and height that are equal, preserving the kept region.
+ *
+ * @param square_size
+ *      The new edge size for both the width and height of the grid.
+ */
+void BitGrid::resize(const int square_size) {
+    resize(square_size, square_size);
+}
+
+/**
+ * BitGrid::resize(new_width, new_height)
+ *
+ * Resize the current grid to a new width and height. The content of the grid is preserved
+ * within the kept region and padded with dead cells if new cells are added.
+ *
+ * @param new_width
+ *      The new width for the grid.
+ *
+ * @param new_height
+ *      The new height for the grid.
+ */
+void BitGrid::resize(const int new_width, const int new_height) {
+    BitGrid g(new_width, new_height);
+    const int kept_words = std::min(this->words_per_row, g.words_per_row);
+    const int kept_rows = std::min(this->height, new_height);
+    for (int y = 0; y < kept_rows; y++) {
+        std::copy(this->row(y), this->row(y) + kept_words, g.row(y));
+        // Clear whatever falls past the new width in the last kept word
+        if (kept_words > 0) {
+            g.row(y)[g.words_per_row - 1] &= g.get_row_mask();
+        }
+    }
+    *this = std::move(g);
+}
+
+/**
+ * BitGrid::get_row_mask()
+ *
+ * Private helper function returning the mask of valid cell bits in the last word of each row.
+ *
+ * @return
+ *      A word with a 1 bit for every cell stored in the last word of a row.
+ */
+std::uint64_t BitGrid::get_row_mask() const {
+    const int tail = this->width % WORD_BITS;
+    return tail == 0 ? ~static_cast<std::uint64_t>(0) : ((static_cast<std::uint64_t>(1) << tail) - 1);
+}
+
+/**
+ * BitGrid::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      The value of the desired cell.
+ *
+ * @throws
+ *      std::runtime_error if x,y is not a valid coordinate within the grid.
+ */
+Cell BitGrid::get(const int x, const int y) const {
+    if (x >= this->width || x < 0) throw std::runtime_error(std::string("x is out of bounds!"));
+    if (y >= this->height || y < 0) throw std::runtime_error(std::string("y is out of bounds!"));
+
+    const std::uint64_t word = this->row(y)[x / WORD_BITS];
+    return ((word >> (x % WORD_BITS)) & 1) ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * BitGrid::set(x, y, value)
+ *
+ * Overwrites the value at the desired coordinate.
+ *
+ * @param x
+ *      The x coordinate of the cell to update.
+ *
+ * @param y
+ *      The y coordinate of the cell to update.
+ *
+ * @param value
+ *      The value to be written to the selected cell.
+ *
+ * @throws
+ *      std::runtime_error if x,y is not a valid coordinate within the grid.
+ */
+void BitGrid::set(const int x, const int y, const Cell value) {
+    if (x >= this->width || x < 0) throw std::runtime_error(std::string("x is out of bounds!"));
+    if (y >= this->height || y < 0) throw std::runtime_error(std::string("y is out of bounds!"));
+
+    std::uint64_t &word = this->row(y)[x / WORD_BITS];
+    const std::uint64_t bit = static_cast<std::uint64_t>(1) << (x % WORD_BITS);
+    if (value == Cell::ALIVE) {
+        word |= bit;
+    } else {
+        word &= ~bit;
+    }
+}
+
+/**
+ * BitGrid::row(y)
+ *
+ * Gets a pointer to the first word of a row. No bounds checking is performed, this is intended
+ * for the stepping kernels which already iterate within the grid.
+ *
+ * @param y
+ *      The y coordinate of the row.
+ *
+ * @return
+ *      A pointer to get_words_per_row() consecutive words.
+ */
+std::uint64_t *BitGrid::row(const int y) {
+    return this->words.data() + static_cast<size_t>(y) * this->words_per_row;
+}
+
+const std::uint64_t *BitGrid::row(const int y) const {
+    return this->words.data() + static_cast<size_t>(y) * this->words_per_row;
+}
+
+/**
+ * BitGrid::pack(grid)
+ *
+ * Overwrite the contents of this grid with the cells of a byte-per-cell grid.
+ * The grid is resized first if the dimensions differ.
+ *
+ * @param grid
+ *      The grid to read cells from.
+ */
+void BitGrid::pack(const Grid &grid) {
+    if (grid.get_width() != this->width || grid.get_height() != this->height) {
+        *this = BitGrid(grid.get_width(), grid.get_height());
+    }
+    for (int y = 0; y < this->height; y++) {
+        this->pack_row(y, grid.row(y));
+    }
+}
+
+/**
+ * BitGrid::unpack(grid)
+ *
+ * Overwrite the contents of a byte-per-cell grid with the cells of this grid.
+ * The grid is resized first if the dimensions differ.
+ *
+ * @param grid
+ *      The grid to write cells into.
+ */
+void BitGrid::unpack(Grid &grid) const {
+    if (grid.get_width() != this->width || grid.get_height() != this->height) {
+        grid = Grid(this->width, this->height);
+    }
+    for (int y = 0; y < this->height; y++) {
+        this->unpack_row(y, grid.row(y));
+    }
+}
+
+/**
+ * BitGrid::pack_row(y, cells)
+ *
+ * Overwrite one row of this grid with a row of byte-per-cell cells, leaving the padding bits dead.
+ * No bounds checking is performed.
+ *
+ * @example
+ *
+ *      // Copy the first row of a Grid of the same width
+ *      packed.pack_row(0, grid.row(0));
+ *
+ * @param y
+ *      The y coordinate of the row.
+ *
+ * @param cells
+ *      The get_width() cells to pack.
+ */
+void BitGrid::pack_row(const int y, const Cell *cells) {
+    std::uint64_t *words_row = this->row(y);
+    for (int w = 0; w < this->words_per_row; w++) {
+        const int x0 = w * WORD_BITS;
+        const int x1 = std::min(x0 + WORD_BITS, this->width);
+        std::uint64_t word = 0;
+        for (int x = x0; x < x1; x++) {
+            word |= static_cast<std::uint64_t>(cells[x] == Cell::ALIVE) << (x - x0);
+        }
+        words_row[w] = word;
+    }
+}
+
+/**
+ * BitGrid::unpack_row(y, cells)
+ *
+ * Expand one row of this grid into a row of byte-per-cell cells.
+ * No bounds checking is performed.
+ *
+ * @param y
+ *      The y coordinate of the row.
+ *
+ * @param cells
+ *      Where the get_width() cells are written.
+ */
+void BitGrid::unpack_row(const int y, Cell *cells) const {
+    const std::uint64_t *words_row = this->row(y);
+    for (int x = 0; x < this->width; x++) {
+        cells[x] = ((words_row[x / WORD_BITS] >> (x % WORD_BITS)) & 1) ? Cell::ALIVE : Cell::DEAD;
+    }
+}
+
+/**
+ * BitGrid::to_grid()
+ *
+ * Expand this grid into a new byte-per-cell grid.
+ *
+ * @return
+ *      A Grid of the same size containing the same cells.
+ */
+Grid BitGrid::to_grid() const {
+    Grid grid(this->width, this->height);
+    this->unpack(grid);
+    return grid;
+}
+
+/**
+ * BitGrid::merge(other, x0, y0, alive_only = false)
+ *
+ * Merge another bit-packed grid onto this one with its top left corner at x0, y0, as Grid::merge does.
+ * Each word of the other grid is shifted into place across the two words it straddles, so an unaligned x0
+ * costs two shifts per 64 cells. An overwriting merge masks the covered bits out first, a merge of alive cells
+ * only ORs the words in.
+ *
+ * @example
+ *
+ *      // Stamp a glider into a packed board at an unaligned column
+ *      BitGrid board(4096, 4096);
+ *      board.merge(BitGrid(Zoo::glider()), 1001, 17, true);
+ *
+ * @param other
+ *      The grid to merge into this one.
+ *
+ * @param x0
+ *      The x coordinate of where to place the top left corner of the other grid.
+ *
+ * @param y0
+ *      The y coordinate of where to place the top left corner of the other grid.
+ *
+ * @param alive_only
+ *      Optional parameter. If true then merging only sets alive cells to alive. Defaults to false.
+ *
+ * @throws
+ *      std::runtime_error if the other grid being placed does not fit within the bounds of this grid.
+ */
+void BitGrid::merge(const BitGrid &other, const int x0, const int y0, const bool alive_only) {
+    if (x0 < 0 || y0 < 0 || x0 + other.width > this->width || y0 + other.height > this->height) {
+        throw std::runtime_error(std::string("The other grid doesn't fit within the bounds of the current one!"));
+    }
+    const int first_word = x0 / WORD_BITS, shift = x0 % WORD_BITS;
+    const std::uint64_t last_mask = other.get_row_mask();
+    for (int y = 0; y < other.height; y++) {
+        const std::uint64_t *source = other.row(y);
+        std::uint64_t *target = this->row(y0 + y) + first_word;
+        for (int w = 0; w < other.words_per_row; w++) {
+            const std::uint64_t mask = w == other.words_per_row - 1 ? last_mask : ~static_cast<std::uint64_t>(0);
+            const std::uint64_t bits = source[w];
+            // The low bits land in word w, the high bits spill into word w + 1 unless the offset is aligned
+            if (!alive_only) {
+                target[w] &= ~(mask << shift);
+            }
+            target[w] |= bits << shift;
+            if (shift != 0 && (mask >> (WORD_BITS - shift)) != 0) {
+                if (!alive_only) {
+                    target[w + 1] &= ~(mask >> (WORD_BITS - shift));
+                }
+                target[w + 1] |= bits >> (WORD_BITS - shift);
+            }
+        }
+    }
+}
+
+/**
+ * Transposes a 64x64 bit matrix in place, bit x of word y swapping with bit y of word x.
+ * Swaps the off diagonal 32x32 blocks, then the 16x16 blocks within each quarter, and so on down to single
+ * bits, each round moving 32 pairs of bit groups with a shift and a mask.
+ */
+static void transpose_block(std::uint64_t block[64]) {
+    std::uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int shift = 32; shift != 0; shift >>= 1, mask ^= mask << shift) {
+        for (int k = 0; k < 64; k = ((k | shift) + 1) & ~shift) {
+            const std::uint64_t swap = ((block[k] >> shift) ^ block[k | shift]) & mask;
+            block[k] ^= swap << shift;
+            block[k | shift] ^= swap;
+        }
+    }
+}
+
+/**
+ * BitGrid::transpose()
+ *
+ * Create a copy of the grid with its rows and columns swapped, the cell at (x, y) moving to (y, x).
+ * The grid is split into 64x64 blocks of one word from each of 64 rows, each transposed as a bit matrix
+ * in registers and written out as one word of each of 64 rows of the result.
+ *
+ * @return
+ *      A transposed copy of the grid.
+ */
+BitGrid BitGrid::transpose() const {
+    BitGrid result(this->height, this->width);
+    std::uint64_t block[WORD_BITS];
+    for (int y0 = 0; y0 < this->height; y0 += WORD_BITS) {
+        const int rows = std::min(WORD_BITS, this->height - y0);
+        for (int w = 0; w < this->words_per_row; w++) {
+            // Rows past the bottom of the grid read as dead, so they fill the padding of the result
+            for (int i = 0; i < WORD_BITS; i++) {
+                block[i] = i < rows ? this->row(y0 + i)[w] : 0;
+            }
+            transpose_block(block);
+            const int columns = std::min(WORD_BITS, this->width - w * WORD_BITS);
+            for (int i = 0; i < columns; i++) {
+                result.row(w * WORD_BITS + i)[y0 / WORD_BITS] = block[i];
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * BitGrid::rotate(rotation)
+ *
+ * Create a copy of the grid rotated by a multiple of 90 degrees clockwise, matching Grid::rotate(rotation).
+ * Quarter turns are a transpose with the order of the rows reversed before or after it, which moves whole
+ * words, and a half turn is two quarter turns.
+ *
+ * @param rotation
+ *      A positive or negative number of quarter turns.
+ *
+ * @return
+ *      A rotated copy of the grid.
+ */
+BitGrid BitGrid::rotate(const int rotation) const {
+    const int turns = ((rotation % 4) + 4) % 4;
+    if (turns == 0) {
+        return *this;
+    }
+    if (turns == 2) {
+        return this->rotate(1).rotate(1);
+    }
+    BitGrid source = *this;
+    if (turns == 1) {
+        source.reverse_rows();
+    }
+    BitGrid result = source.transpose();
+    if (turns == 3) {
+        result.reverse_rows();
+    }
+    return result;
+}
+
+/**
+ * BitGrid::reverse_rows()
+ *
+ * Private helper function mirroring the grid top to bottom in place.
+ */
+void BitGrid::reverse_rows() {
+    for (int top = 0, bottom = this->height - 1; top < bottom; top++, bottom--) {
+        std::swap_ranges(this->row(top), this->row(top) + this->words_per_row, this->row(bottom));
+    }
+}
+
+/**
+ * operator<<(output_stream, grid)
+ *
+ * Serializes a bit-packed grid to an ascii output stream, in the same bordered format as a Grid.
+ *
+ * @param os
+ *      An ascii mode output stream such as std::cout.
+ *
+ * @param grid
+ *      A grid object containing cells to be printed.
+ *
+ * @return
+ *      Returns a reference to the output stream to enable operator chaining.
+ */
+std::ostream &operator<<(std::ostream &os, const BitGrid &g) {
+    return os << g.to_grid();
+}
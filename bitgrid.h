@@ -0,0 +1,190 @@
+/**
+ * Declares a class representing a bit-packed 2d grid of cells.
+ * Rich documentation for the api and behaviour the BitGrid class can be found in bitgrid.cpp.
+ *
+ * A BitGrid mirrors the public api of Grid but stores a single bit per cell, with every row
+ * padded up to a whole number of 64 bit words. It is the storage behind Engine::BITPACKED.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "allocator.h"
+#include "grid.h"
+
+/**
+ * Counts the set bits of a 64 bit word, using the compiler intrinsic where one is available.
+ */
+inline int popcount64(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Finds the index of the lowest set bit of a non-zero word.
+ */
+inline int lowest_bit64(const std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!((word >> bit) & 1)) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * Adds three one bit numbers in every bit position of the words at once.
+ */
+inline void full_add(const std::uint64_t a, const std::uint64_t b, const std::uint64_t c,
+                     std::uint64_t &sum, std::uint64_t &carry) {
+    const std::uint64_t partial = a ^ b;
+    sum = partial ^ c;
+    carry = (a & b) | (partial & c);
+}
+
+/**
+ * Adds the cells matching neighbour count n which are alive next to the set bits of next.
+ */
+inline std::uint64_t apply_count_word(const std::uint64_t next, const std::uint64_t match, const std::uint64_t centre,
+                                      const int n, const unsigned birth, const unsigned survive) {
+    const bool born = (birth >> n) & 1, survives = (survive >> n) & 1;
+    if (!born && !survives) {
+        return next;
+    }
+    return next | (born && survives ? match : (born ? match & ~centre : match & centre));
+}
+
+/**
+ * Computes the next state of 64 cells at once, given the word of each of their 8 neighbours and their own.
+ * Bit i of every word belongs to the same cell. The neighbours are summed bit-parallel with full adders
+ * into a binary count (ones, twos, fours, eights), which is matched against the birth and survive masks
+ * of the rule. Called with constant masks, as FixedRule kernels do, the matching folds down to the few
+ * terms the rule needs. For B3/S23 it is the usual:
+ *      - alive next = count is 3, or count is 2 and the cell is alive
+ *                   = !eights & !fours & twos & (ones | alive)
+ */
+inline std::uint64_t life_word(const std::uint64_t nw, const std::uint64_t n, const std::uint64_t ne,
+                               const std::uint64_t w, const std::uint64_t centre, const std::uint64_t e,
+                               const std::uint64_t sw, const std::uint64_t s, const std::uint64_t se,
+                               const unsigned birth, const unsigned survive) {
+    std::uint64_t s0, c0, s1, c1, s2, c2, ones, c3, t, c4, twos, c5;
+    full_add(nw, n, ne, s0, c0);
+    full_add(sw, s, se, s1, c1);
+    full_add(w, e, 0, s2, c2);
+    full_add(s0, s1, s2, ones, c3);
+    full_add(c0, c1, c2, t, c4);
+    full_add(t, c3, 0, twos, c5);
+    const std::uint64_t fours = c4 ^ c5;
+    const std::uint64_t eights = c4 & c5;
+    if (birth == 0x008 && survive == 0x00C) {
+        return ~eights & ~fours & twos & (ones | centre);
+    }
+    const std::uint64_t low = ~eights;
+    std::uint64_t next = 0;
+    next = apply_count_word(next, low & ~fours & ~twos & ~ones, centre, 0, birth, survive);
+    next = apply_count_word(next, low & ~fours & ~twos & ones, centre, 1, birth, survive);
+    next = apply_count_word(next, low & ~fours & twos & ~ones, centre, 2, birth, survive);
+    next = apply_count_word(next, low & ~fours & twos & ones, centre, 3, birth, survive);
+    next = apply_count_word(next, low & fours & ~twos & ~ones, centre, 4, birth, survive);
+    next = apply_count_word(next, low & fours & ~twos & ones, centre, 5, birth, survive);
+    next = apply_count_word(next, low & fours & twos & ~ones, centre, 6, birth, survive);
+    next = apply_count_word(next, low & fours & twos & ones, centre, 7, birth, survive);
+    // Counts never pass 8, so eights alone identifies 8
+    return apply_count_word(next, eights, centre, 8, birth, survive);
+}
+
+/**
+ * Declare the structure of the BitGrid class for representing a bit-packed 2d grid of cells.
+ */
+class BitGrid {
+private:
+    int width, height;
+
+    int words_per_row;                               // Each row is padded to a whole number of words
+
+    std::vector<std::uint64_t, BufferAllocator<std::uint64_t> > words; // Row major, bit x % 64 of word x / 64 is cell x
+
+    std::uint64_t get_row_mask() const;              // Mask of the valid bits in the last word of a row
+
+    void reverse_rows();                             // Mirrors the grid top to bottom
+public:
+    static const int WORD_BITS = 64;
+
+    BitGrid();                                       // Default Constructor with grid size = 0
+
+    explicit BitGrid(const int square_size);         // Overloaded Constructor with grid size = squareSize*squareSize
+
+    BitGrid(const int width, const int height);      // Overloaded Constructor with grid size = width*height
+
+    explicit BitGrid(const Grid &grid);              // Packs an existing byte-per-cell grid
+
+    // A grid whose words are allocated but not yet written, every row must be written before it is read
+    static BitGrid untouched(const int width, const int height);
+
+    friend std::ostream &operator<<(std::ostream &os, const BitGrid &g);
+
+    // Member Functions
+    int get_width() const;
+
+    int get_height() const;
+
+    int get_words_per_row() const;
+
+    int get_total_cells() const;
+
+    int get_alive_cells() const;
+
+    int get_dead_cells() const;
+
+    void resize(const int square_size);
+
+    void resize(const int new_width, const int new_height);
+
+    // Returns the value of the cell at the desired coordinate
+    Cell get(const int x, const int y) const;
+
+    // Updates the value of the cell at the desired coordinate
+    void set(const int x, const int y, const Cell value);
+
+    // Raw access to the words of a row, no bounds checking is performed
+    std::uint64_t *row(const int y);
+
+    const std::uint64_t *row(const int y) const;
+
+    // Repacks the contents of a byte-per-cell grid of the same size into this grid
+    void pack(const Grid &grid);
+
+    // Expands the contents of this grid into a byte-per-cell grid of the same size
+    void unpack(Grid &grid) const;
+
+    // Packs get_width() cells into row y, no bounds checking is performed
+    void pack_row(const int y, const Cell *cells);
+
+    // Expands row y into get_width() cells, no bounds checking is performed
+    void unpack_row(const int y, Cell *cells) const;
+
+    Grid to_grid() const;
+
+    // Merges the other grid into this one w.r.t x0, y0, shifting whole words into place
+    void merge(const BitGrid &other, const int x0, const int y0, const bool alive_only = false);
+
+    // Creates a copy with the rows and columns swapped, 64x64 cells at a time
+    BitGrid transpose() const;
+
+    // Creates a copy rotated by a multiple of 90 degrees clockwise, as Grid::rotate does
+    BitGrid rotate(const int rotation) const;
+};
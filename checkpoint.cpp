@@ -0,0 +1,221 @@
+/**
+ * Implements a class writing snapshots of a long running simulation on a background thread.
+ *      - Each checkpoint is a copy of the state taken when it was submitted, so the simulation keeps stepping
+ *        while it is compressed and written.
+ *      - At most capacity checkpoints wait in the queue. Submitting to a full queue blocks until the worker
+ *        catches up, which bounds the memory used when the disk is slower than the simulation.
+ *      - Checkpoints are written as snapshots, see snapshot.cpp, recording the generation and rule so a run
+ *        can be resumed. Each is written to path.tmp and then renamed over path, so path always holds the latest
+ *        complete checkpoint, even if the process dies while writing. On POSIX systems path.tmp is also synced
+ *        to disk before the rename and its directory after it, so this holds across a power loss too.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "checkpoint.h"
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+#include "snapshot.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOL_HAVE_FSYNC 1
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Waits until a file, or the entries of a directory, are on the disk. Does nothing without fsync.
+ * Filesystems which cannot sync a directory are tolerated, there is nothing more to wait for on those.
+ */
+static void sync_to_disk(const std::string &path, const bool directory) {
+#ifdef GOL_HAVE_FSYNC
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Can't open the file!"));
+    }
+    const int status = fsync(fd);
+    const int reason = errno;
+    close(fd);
+    if (status != 0 && !(directory && reason == EINVAL)) {
+        throw std::runtime_error(std::string("Can't sync the file to disk!"));
+    }
+#else
+    (void) path;
+    (void) directory;
+#endif
+}
+
+/**
+ * The directory holding a path, for syncing its entries after a rename.
+ */
+static std::string parent_directory(const std::string &path) {
+    const std::size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+/**
+ * CheckpointWriter::CheckpointWriter(path, capacity)
+ *
+ * Construct a writer and start its worker thread.
+ *
+ * @example
+ *
+ *      // Save a checkpoint every 1000 generations of a long run
+ *      CheckpointWriter checkpoints("run.gols");
+ *      for (int step = 1; step <= 1000000; step++) {
+ *          world.step();
+ *          if (step % 1000 == 0) {
+ *              checkpoints.submit(world.state(), world.get_generation(), world.get_rule());
+ *          }
+ *      }
+ *      checkpoints.flush();
+ *
+ * @param path
+ *      The std::string path every checkpoint is written to, replacing the previous one.
+ *
+ * @param capacity
+ *      The most checkpoints waiting to be written before submit blocks, values below 1 are treated as 1.
+ */
+CheckpointWriter::CheckpointWriter(const std::string &path, const std::size_t capacity)
+        : path(path), capacity(capacity > 0 ? capacity : 1), writing(false), stopping(false), written(0) {
+    this->worker = std::thread(&CheckpointWriter::worker_loop, this);
+}
+
+/**
+ * CheckpointWriter::~CheckpointWriter()
+ *
+ * Write every queued checkpoint, then stop and join the worker thread. Failures are not reported,
+ * call CheckpointWriter::flush first to see them.
+ */
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    this->worker.join();
+}
+
+/**
+ * CheckpointWriter::worker_loop()
+ *
+ * Private helper function run by the worker thread, writing checkpoints in the order they were submitted.
+ * After a failure the remaining checkpoints are dropped, since later ones would most likely fail too.
+ */
+void CheckpointWriter::worker_loop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    for (;;) {
+        this->changed.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+        if (this->queue.empty()) {
+            return;
+        }
+        Checkpoint checkpoint = std::move(this->queue.front());
+        this->queue.pop_front();
+        this->writing = true;
+        this->changed.notify_all();
+        lock.unlock();
+
+        std::exception_ptr failure;
+        try {
+            const std::string staging = this->path + ".tmp";
+            Snapshot::save(staging, checkpoint.state, checkpoint.generation, checkpoint.rule);
+            // Otherwise the rename may reach the disk before the data, leaving path empty after a power loss
+            sync_to_disk(staging, false);
+            // Renaming over an existing file is atomic on POSIX, elsewhere the old file has to go first
+            if (std::rename(staging.c_str(), this->path.c_str()) != 0) {
+                std::remove(this->path.c_str());
+                if (std::rename(staging.c_str(), this->path.c_str()) != 0) {
+                    throw std::runtime_error(std::string("Can't write the file!"));
+                }
+            }
+            sync_to_disk(parent_directory(this->path), true);
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+
+        lock.lock();
+        this->writing = false;
+        if (failure && !this->error) {
+            this->error = failure;
+        }
+        if (this->error) {
+            this->queue.clear();
+        } else {
+            this->written++;
+        }
+        this->changed.notify_all();
+    }
+}
+
+/**
+ * CheckpointWriter::rethrow()
+ *
+ * Private helper function throwing the first failure of the worker thread, if there was one.
+ * The caller must hold the mutex.
+ */
+void CheckpointWriter::rethrow() {
+    if (this->error) {
+        std::exception_ptr failure = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+/**
+ * CheckpointWriter::submit(state, generation, rule)
+ *
+ * Queue a copy of a state to be written by the worker thread. Blocks while the queue is full.
+ *
+ * @param state
+ *      The state to save, copied before this returns.
+ *
+ * @param generation
+ *      The generation of the state, stored in the checkpoint.
+ *
+ * @param rule
+ *      The rule the state is simulated with, stored in the checkpoint.
+ *
+ * @throws
+ *      The exception thrown while writing an earlier checkpoint, if one failed since the last call.
+ */
+void CheckpointWriter::submit(const Grid &state, const std::uint64_t generation, const Rule &rule) {
+    Checkpoint checkpoint = {state, generation, rule};
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->changed.wait(lock, [this] { return this->error || this->queue.size() < this->capacity; });
+    this->rethrow();
+    this->queue.push_back(std::move(checkpoint));
+    this->changed.notify_all();
+}
+
+/**
+ * CheckpointWriter::flush()
+ *
+ * Wait until every queued checkpoint has been written.
+ *
+ * @throws
+ *      The exception thrown while writing a checkpoint, if one failed since the last call.
+ */
+void CheckpointWriter::flush() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->changed.wait(lock, [this] { return this->error || (this->queue.empty() && !this->writing); });
+    this->rethrow();
+}
+
+/**
+ * CheckpointWriter::get_written()
+ *
+ * Gets the number of checkpoints written successfully so far.
+ *
+ * @return
+ *      The number of checkpoints written.
+ */
+std::uint64_t CheckpointWriter::get_written() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->written;
+}
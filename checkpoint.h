@@ -0,0 +1,78 @@
+/**
+ * Declares a class writing snapshots of a long running simulation on a background thread.
+ * Rich documentation for the api and behaviour the CheckpointWriter class can be found in checkpoint.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the CheckpointWriter class.
+ *
+ * States are copied into a bounded queue and written out by a single worker thread, so stepping only
+ * waits for the disk when the queue is full. CheckpointWriter objects cannot be copied.
+ */
+class CheckpointWriter {
+private:
+    struct Checkpoint {
+        Grid state;
+
+        std::uint64_t generation;
+
+        Rule rule;
+    };
+
+    std::string path;
+
+    std::size_t capacity;                            // The most checkpoints waiting to be written
+
+    std::deque<Checkpoint> queue;
+
+    std::mutex mutex;                                // Guards every field below
+
+    std::condition_variable changed;                 // Signalled when the queue changes or the writer stops
+
+    bool writing;                                    // True while the worker is writing a checkpoint
+
+    bool stopping;
+
+    std::exception_ptr error;                        // The first failure of the worker, rethrown to the caller
+
+    std::uint64_t written;
+
+    std::thread worker;
+
+    void worker_loop();
+
+    void rethrow();                                  // Throws the worker's failure, the mutex must be held
+
+public:
+    explicit CheckpointWriter(const std::string &path, const std::size_t capacity = 2);
+
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    // Member functions
+    // Queues a copy of a state, waiting while the queue is full
+    void submit(const Grid &state, const std::uint64_t generation, const Rule &rule);
+
+    // Waits until every queued checkpoint has been written
+    void flush();
+
+    std::uint64_t get_written();
+};
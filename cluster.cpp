@@ -0,0 +1,564 @@
+/**
+ * Implements a class connecting the processes of a distributed simulation over TCP.
+ *      - Every node listens on the port of its own endpoint, connects to every lower rank and accepts a
+ *        connection from every higher rank. A new connection starts with the 4 byte rank of the connecting node.
+ *      - Integers on the wire, such as the values summed by Cluster::sum, are 8 byte little endian.
+ *        Cells and other buffers are sent as they are.
+ *      - Nodes may be started in any order, connections to a node which is not listening yet are retried
+ *        for about a minute.
+ *
+ * Clusters of more than one node need POSIX sockets, elsewhere only the single node cluster is available.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "cluster.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOL_HAVE_SOCKETS 1
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#ifdef GOL_HAVE_SOCKETS
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;          // A closed peer is reported as an error, not SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+/**
+ * Splits a host:port endpoint at its last colon.
+ */
+static void split_endpoint(const std::string &endpoint, std::string &host, std::string &port) {
+    const std::size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == endpoint.size()) {
+        throw std::runtime_error(std::string("Endpoints must be written host:port: ") + endpoint);
+    }
+    host = endpoint.substr(0, colon);
+    port = endpoint.substr(colon + 1);
+}
+
+/**
+ * Sends latency sensitive messages such as halos straight away rather than batching them.
+ */
+static void set_no_delay(const int fd) {
+    const int enabled = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+#ifdef SO_NOSIGPIPE
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+}
+
+/**
+ * Opens a socket listening for IPv4 connections on a port of every interface.
+ */
+static int open_listener(const std::string &port, const int backlog) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo *addresses = nullptr;
+    if (::getaddrinfo(nullptr, port.c_str(), &hints, &addresses) != 0) {
+        throw std::runtime_error(std::string("Invalid port: ") + port);
+    }
+    int fd = ::socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    const int reuse = 1;
+    if (fd >= 0) {
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (::bind(fd, addresses->ai_addr, addresses->ai_addrlen) != 0 || ::listen(fd, backlog) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(addresses);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Could not listen on port ") + port);
+    }
+    return fd;
+}
+
+/**
+ * Connects to an endpoint, retrying until it is listening or Cluster::CONNECT_ATTEMPTS attempts failed.
+ * Returns -1 if every attempt failed.
+ */
+static int connect_to(const std::string &endpoint, const int attempts) {
+    std::string host, port;
+    split_endpoint(endpoint, host, port);
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    for (int attempt = 0; attempt < attempts; attempt++) {
+        addrinfo *addresses = nullptr;
+        if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) == 0) {
+            for (addrinfo *address = addresses; address != nullptr; address = address->ai_next) {
+                const int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                if (fd < 0) {
+                    continue;
+                }
+                if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+                    ::freeaddrinfo(addresses);
+                    return fd;
+                }
+                ::close(fd);
+            }
+            ::freeaddrinfo(addresses);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return -1;
+}
+
+/**
+ * Writes the whole buffer to a socket.
+ */
+static void write_all(const int fd, const unsigned char *data, std::size_t bytes) {
+    while (bytes > 0) {
+        const ssize_t written = ::send(fd, data, bytes, SEND_FLAGS);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error sending to a node: ") + std::strerror(errno));
+        }
+        data += written;
+        bytes -= static_cast<std::size_t>(written);
+    }
+}
+
+/**
+ * Reads exactly bytes from a socket.
+ */
+static void read_all(const int fd, unsigned char *data, std::size_t bytes) {
+    while (bytes > 0) {
+        const ssize_t read = ::recv(fd, data, bytes, 0);
+        if (read == 0) {
+            throw std::runtime_error(std::string("A node closed its connection!"));
+        }
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error receiving from a node: ") + std::strerror(errno));
+        }
+        data += read;
+        bytes -= static_cast<std::size_t>(read);
+    }
+}
+#endif
+
+/**
+ * Encodes an integer as 8 little endian bytes.
+ */
+static void encode_u64(const std::uint64_t value, unsigned char *bytes) {
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+/**
+ * Decodes an integer from 8 little endian bytes.
+ */
+static std::uint64_t decode_u64(const unsigned char *bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * Cluster::Cluster()
+ *
+ * Construct a cluster of this process alone, with rank 0. Collective functions return straight away.
+ *
+ * @example
+ *
+ *      // Step a distributed world without any other nodes, e.g. to compare against a real cluster
+ *      Cluster alone;
+ *      DistributedWorld world(alone, Zoo::load_ascii("soup.gol"));
+ */
+Cluster::Cluster() : rank(0), sockets(1, -1) {
+}
+
+/**
+ * Cluster::Cluster(rank, endpoints)
+ *
+ * Construct a cluster by connecting to every other node, blocking until they are all connected.
+ * Every node must be given the same endpoints, and its own rank among them.
+ *
+ * @example
+ *
+ *      // On the first of two machines, the second passes rank 1
+ *      Cluster cluster(0, Cluster::parse_endpoints("node0:7700,node1:7700"));
+ *
+ * @param rank
+ *      The rank of this node, its index in endpoints.
+ *
+ * @param endpoints
+ *      The host:port every node listens on, in rank order.
+ *
+ * @throws
+ *      std::runtime_error if the rank is not one of the endpoints, a node could not be reached,
+ *      or there are several nodes on a platform without POSIX sockets.
+ */
+Cluster::Cluster(const int rank, const std::vector<std::string> &endpoints) : rank(rank),
+                                                                              sockets(endpoints.size(), -1) {
+    const int size = static_cast<int>(endpoints.size());
+    if (rank < 0 || rank >= size) {
+        throw std::runtime_error(std::string("The rank of a node must be the index of one of the endpoints!"));
+    }
+    if (size == 1) {
+        return;
+    }
+#ifdef GOL_HAVE_SOCKETS
+    std::string host, port;
+    split_endpoint(endpoints[rank], host, port);
+    const int listener = open_listener(port, size);
+    try {
+        // Lower ranks are already listening, or will be soon, so connecting first cannot deadlock
+        unsigned char introduction[8];
+        encode_u64(static_cast<std::uint64_t>(rank), introduction);
+        for (int peer = 0; peer < rank; peer++) {
+            const int fd = connect_to(endpoints[peer], CONNECT_ATTEMPTS);
+            if (fd < 0) {
+                throw std::runtime_error(std::string("Could not connect to node ") + endpoints[peer]);
+            }
+            this->sockets[peer] = fd;
+            set_no_delay(fd);
+            write_all(fd, introduction, 4);
+        }
+        for (int accepted = rank + 1; accepted < size; accepted++) {
+            const int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                throw std::runtime_error(std::string("Error accepting a node: ") + std::strerror(errno));
+            }
+            unsigned char bytes[8] = {0};
+            try {
+                read_all(fd, bytes, 4);
+            }
+            catch (...) {
+                ::close(fd);
+                throw;
+            }
+            const std::uint64_t peer = decode_u64(bytes);
+            if (peer <= static_cast<std::uint64_t>(rank) || peer >= static_cast<std::uint64_t>(size)
+                || this->sockets[peer] >= 0) {
+                ::close(fd);
+                throw std::runtime_error(std::string("A node introduced itself with an unexpected rank!"));
+            }
+            this->sockets[peer] = fd;
+            set_no_delay(fd);
+        }
+    }
+    catch (...) {
+        ::close(listener);
+        for (const int fd : this->sockets) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        throw;
+    }
+    ::close(listener);
+#else
+    throw std::runtime_error(std::string("Clusters of more than one node need POSIX sockets!"));
+#endif
+}
+
+/**
+ * Cluster::~Cluster()
+ *
+ * Closes the connection to every other node.
+ */
+Cluster::~Cluster() {
+#ifdef GOL_HAVE_SOCKETS
+    for (const int fd : this->sockets) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+/**
+ * Cluster::parse_endpoints(list)
+ *
+ * Splits a comma separated list of host:port endpoints, as accepted by the --cluster command line option.
+ *
+ * @example
+ *
+ *      std::vector<std::string> endpoints = Cluster::parse_endpoints("node0:7700,node1:7700");
+ *
+ * @param list
+ *      The endpoints of the nodes in rank order.
+ *
+ * @return
+ *      The endpoints.
+ *
+ * @throws
+ *      std::runtime_error if an endpoint is empty.
+ */
+std::vector<std::string> Cluster::parse_endpoints(const std::string &list) {
+    std::vector<std::string> endpoints;
+    std::size_t start = 0;
+    while (true) {
+        const std::size_t comma = list.find(',', start);
+        const std::string endpoint = list.substr(start, comma == std::string::npos ? std::string::npos
+                                                                                    : comma - start);
+        if (endpoint.empty()) {
+            throw std::runtime_error(std::string("Empty endpoint in the cluster: ") + list);
+        }
+        endpoints.push_back(endpoint);
+        if (comma == std::string::npos) {
+            return endpoints;
+        }
+        start = comma + 1;
+    }
+}
+
+/**
+ * Cluster::get_rank()
+ *
+ * Gets the rank of this node, from 0 to Cluster::get_size() - 1.
+ *
+ * @return
+ *      The rank.
+ */
+int Cluster::get_rank() const {
+    return this->rank;
+}
+
+/**
+ * Cluster::get_size()
+ *
+ * Gets the number of nodes in the cluster, including this one.
+ *
+ * @return
+ *      The number of nodes.
+ */
+int Cluster::get_size() const {
+    return static_cast<int>(this->sockets.size());
+}
+
+/**
+ * Cluster::send(peer, data, bytes)
+ *
+ * Send a buffer to another node, which must receive the same number of bytes.
+ * Only use this where the peer is known to be receiving, such as gathering onto one node,
+ * otherwise two nodes sending large buffers to each other can wait on each other forever.
+ * Cluster::exchange(transfers) has no such problem.
+ *
+ * @param peer
+ *      The rank of the node to send to.
+ *
+ * @param data
+ *      The buffer to send.
+ *
+ * @param bytes
+ *      The size of the buffer.
+ *
+ * @throws
+ *      std::runtime_error if the peer is not another node, or the data could not be sent.
+ */
+void Cluster::send(const int peer, const void *data, const std::size_t bytes) {
+    if (peer < 0 || peer >= this->get_size() || peer == this->rank) {
+        throw std::runtime_error(std::string("Nodes can only send to another node of the cluster!"));
+    }
+#ifdef GOL_HAVE_SOCKETS
+    write_all(this->sockets[peer], static_cast<const unsigned char *>(data), bytes);
+#else
+    (void) data;
+    (void) bytes;
+#endif
+}
+
+/**
+ * Cluster::receive(peer, data, bytes)
+ *
+ * Receive exactly bytes sent by another node with Cluster::send(peer, data, bytes).
+ *
+ * @param peer
+ *      The rank of the node to receive from.
+ *
+ * @param data
+ *      The buffer to fill.
+ *
+ * @param bytes
+ *      The number of bytes to receive.
+ *
+ * @throws
+ *      std::runtime_error if the peer is not another node, or closed its connection first.
+ */
+void Cluster::receive(const int peer, void *data, const std::size_t bytes) {
+    if (peer < 0 || peer >= this->get_size() || peer == this->rank) {
+        throw std::runtime_error(std::string("Nodes can only receive from another node of the cluster!"));
+    }
+#ifdef GOL_HAVE_SOCKETS
+    read_all(this->sockets[peer], static_cast<unsigned char *>(data), bytes);
+#else
+    (void) data;
+    (void) bytes;
+#endif
+}
+
+/**
+ * Cluster::exchange(transfers)
+ *
+ * Send and receive every transfer at once, polling all of their connections so whichever is ready makes
+ * progress. Two nodes may send each other buffers far larger than the socket buffers without waiting on
+ * each other, which sending before receiving cannot guarantee. A transfer to this node itself copies its
+ * send buffer into its receive buffer.
+ *
+ * @example
+ *
+ *      // Swap a row with both neighbours of a ring
+ *      std::vector<Cluster::Transfer> transfers = {
+ *              {up, top_row, width, top_halo, width},
+ *              {down, bottom_row, width, bottom_halo, width}};
+ *      cluster.exchange(transfers);
+ *
+ * @param transfers
+ *      The transfers, at most one per peer.
+ *
+ * @throws
+ *      std::runtime_error if a peer is not in the cluster, a transfer to this node receives a different
+ *      number of bytes than it sends, or a connection fails.
+ */
+void Cluster::exchange(const std::vector<Transfer> &transfers) {
+    std::vector<std::size_t> sent(transfers.size(), 0), received(transfers.size(), 0);
+    for (std::size_t i = 0; i < transfers.size(); i++) {
+        const Transfer &transfer = transfers[i];
+        if (transfer.peer < 0 || transfer.peer >= this->get_size()) {
+            throw std::runtime_error(std::string("Nodes can only exchange with a node of the cluster!"));
+        }
+        if (transfer.peer == this->rank) {
+            if (transfer.send_bytes != transfer.receive_bytes) {
+                throw std::runtime_error(std::string("A node must receive what it sends itself!"));
+            }
+            if (transfer.send_bytes > 0) {
+                std::memmove(transfer.receive, transfer.send, transfer.send_bytes);
+            }
+            sent[i] = transfer.send_bytes;
+            received[i] = transfer.receive_bytes;
+        }
+    }
+#ifdef GOL_HAVE_SOCKETS
+    std::vector<pollfd> polled;
+    std::vector<std::size_t> polled_transfer;
+    while (true) {
+        polled.clear();
+        polled_transfer.clear();
+        for (std::size_t i = 0; i < transfers.size(); i++) {
+            const short events = static_cast<short>((sent[i] < transfers[i].send_bytes ? POLLOUT : 0)
+                                                    | (received[i] < transfers[i].receive_bytes ? POLLIN : 0));
+            if (events != 0) {
+                pollfd entry;
+                entry.fd = this->sockets[transfers[i].peer];
+                entry.events = events;
+                entry.revents = 0;
+                polled.push_back(entry);
+                polled_transfer.push_back(i);
+            }
+        }
+        if (polled.empty()) {
+            return;
+        }
+        if (::poll(polled.data(), static_cast<nfds_t>(polled.size()), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error polling the nodes: ") + std::strerror(errno));
+        }
+        for (std::size_t p = 0; p < polled.size(); p++) {
+            const std::size_t i = polled_transfer[p];
+            const Transfer &transfer = transfers[i];
+            if ((polled[p].revents & POLLOUT) && sent[i] < transfer.send_bytes) {
+                const unsigned char *data = static_cast<const unsigned char *>(transfer.send) + sent[i];
+                const ssize_t written = ::send(polled[p].fd, data, transfer.send_bytes - sent[i],
+                                               SEND_FLAGS | MSG_DONTWAIT);
+                if (written < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    throw std::runtime_error(std::string("Error sending to a node: ") + std::strerror(errno));
+                }
+                sent[i] += written > 0 ? static_cast<std::size_t>(written) : 0;
+            }
+            // Errors and hang ups surface through recv, as does the data that arrived before them
+            if ((polled[p].revents & (POLLIN | POLLERR | POLLHUP)) && received[i] < transfer.receive_bytes) {
+                unsigned char *data = static_cast<unsigned char *>(transfer.receive) + received[i];
+                const ssize_t read = ::recv(polled[p].fd, data, transfer.receive_bytes - received[i], MSG_DONTWAIT);
+                if (read == 0) {
+                    throw std::runtime_error(std::string("A node closed its connection!"));
+                }
+                if (read < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    throw std::runtime_error(std::string("Error receiving from a node: ") + std::strerror(errno));
+                }
+                received[i] += read > 0 ? static_cast<std::size_t>(read) : 0;
+            } else if ((polled[p].revents & (POLLERR | POLLHUP | POLLNVAL)) && !(polled[p].revents & POLLOUT)) {
+                throw std::runtime_error(std::string("A node closed its connection!"));
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * Cluster::sum(value)
+ *
+ * Add up a value over every node, gathering the values onto rank 0 and sending the total back.
+ * Every node must call this collectively.
+ *
+ * @example
+ *
+ *      // The alive cells of the whole board from the alive cells of each node's rows
+ *      std::uint64_t alive = cluster.sum(local_alive);
+ *
+ * @param value
+ *      The value of this node.
+ *
+ * @return
+ *      The sum over every node, the same on each.
+ */
+std::uint64_t Cluster::sum(const std::uint64_t value) {
+    if (this->get_size() == 1) {
+        return value;
+    }
+    unsigned char bytes[8];
+    if (this->rank == 0) {
+        std::uint64_t total = value;
+        for (int peer = 1; peer < this->get_size(); peer++) {
+            this->receive(peer, bytes, sizeof(bytes));
+            total += decode_u64(bytes);
+        }
+        encode_u64(total, bytes);
+        for (int peer = 1; peer < this->get_size(); peer++) {
+            this->send(peer, bytes, sizeof(bytes));
+        }
+        return total;
+    }
+    encode_u64(value, bytes);
+    this->send(0, bytes, sizeof(bytes));
+    this->receive(0, bytes, sizeof(bytes));
+    return decode_u64(bytes);
+}
+
+/**
+ * Cluster::barrier()
+ *
+ * Wait until every node called Cluster::barrier(), e.g. so that no node moves on until every shard is written.
+ */
+void Cluster::barrier() {
+    this->sum(0);
+}
@@ -0,0 +1,80 @@
+/**
+ * Declares a class connecting the processes of a distributed simulation over TCP.
+ * Rich documentation for the api and the wire protocol can be found in cluster.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Declare the structure of the Cluster class.
+ *
+ * A cluster is a fixed number of processes, its nodes, each knowing its own rank and the host:port endpoint
+ * of every rank. Every node is connected to every other one, so any two can exchange data directly.
+ * Collective functions such as Cluster::sum must be called by every node in the same order.
+ * Cluster objects cannot be copied.
+ */
+class Cluster {
+public:
+    /**
+     * One send to and one receive from a peer, both of which may be empty, progressed together by exchange.
+     */
+    struct Transfer {
+        int peer;
+
+        const void *send;
+
+        std::size_t send_bytes;
+
+        void *receive;
+
+        std::size_t receive_bytes;
+    };
+
+private:
+    int rank;
+
+    std::vector<int> sockets;                        // The connection to every rank, -1 for this one
+
+    static const int CONNECT_ATTEMPTS = 600;         // Peers are retried every 100 ms until they are listening
+
+public:
+    Cluster();                                       // A cluster of this process alone
+
+    Cluster(const int rank, const std::vector<std::string> &endpoints);
+
+    ~Cluster();
+
+    Cluster(const Cluster &) = delete;
+
+    Cluster &operator=(const Cluster &) = delete;
+
+    // Splits a comma separated list of host:port endpoints
+    static std::vector<std::string> parse_endpoints(const std::string &list);
+
+    // Member functions
+    int get_rank() const;
+
+    int get_size() const;
+
+    // Sends a buffer to a peer, blocking until it was handed to the network
+    void send(const int peer, const void *data, const std::size_t bytes);
+
+    // Receives exactly bytes from a peer
+    void receive(const int peer, void *data, const std::size_t bytes);
+
+    // Progresses every transfer at once so no two nodes wait on each other, at most one per peer
+    void exchange(const std::vector<Transfer> &transfers);
+
+    // Collective, the sum of value over every node
+    std::uint64_t sum(const std::uint64_t value);
+
+    // Collective, returns once every node called it
+    void barrier();
+};
@@ -0,0 +1,473 @@
+/**
+ * Implements classes streaming the cells born and killed each generation, and replaying any generation from them.
+ *
+ *      - Delta streams are composed of:
+ *          - A header.
+ *              - The magic number "GOLD".
+ *              - The version, currently 1, the width and the height.
+ *          - Frames, each starting with a one byte tag.
+ *              - 'K' for a keyframe: the generation, the number of alive cells, then the alive cells.
+ *              - 'D' for a delta to the generation after the last frame: the number of cells born, the cells
+ *                born, the number of cells killed, then the cells killed.
+ *          - The first frame is always a keyframe.
+ *
+ *      - Every number is an unsigned variable length integer, 7 bits to a byte with the lowest bits first and
+ *        the top bit set on every byte but the last, so the stream reads the same on any machine and small
+ *        numbers take a single byte.
+ *
+ *      - A cell is the index y * width + x. Lists of cells are in ascending order and store the first index,
+ *        then the gap to each following index less one, so clustered changes mostly take a byte per cell.
+ *
+ *      - A stream can be written to a pipe as it is produced, it is never rewritten or seeked.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "delta.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "stats.h"
+
+static const char MAGIC[4] = {'G', 'O', 'L', 'D'};
+
+static const std::uint64_t VERSION = 1;
+
+static const unsigned char KEYFRAME_TAG = 'K', DELTA_TAG = 'D';
+
+/**
+ * Appends a variable length integer to a buffer.
+ */
+static void put_varint(std::vector<unsigned char> &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+/**
+ * Reads a variable length integer, advancing the position past it.
+ */
+static std::uint64_t get_varint(const std::vector<unsigned char> &data, std::size_t &position) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= data.size()) {
+            throw std::runtime_error(std::string("File Ends unexpectedly!"));
+        }
+        const unsigned char byte = data[position++];
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error(std::string("Corrupted delta file!"));
+}
+
+/**
+ * Appends a list of cells, sorting a copy first if they are not already in ascending order.
+ */
+static void put_cells(std::vector<unsigned char> &out, const std::vector<int> &cells, const int total) {
+    std::vector<int> sorted;
+    const std::vector<int> *list = &cells;
+    if (!std::is_sorted(cells.begin(), cells.end())) {
+        sorted = cells;
+        std::sort(sorted.begin(), sorted.end());
+        list = &sorted;
+    }
+    put_varint(out, list->size());
+    int previous = -1;
+    for (const int cell : *list) {
+        if (cell <= previous || cell >= total) {
+            throw std::runtime_error(std::string("The cells must be distinct and inside the grid!"));
+        }
+        put_varint(out, static_cast<std::uint64_t>(cell - previous - 1));
+        previous = cell;
+    }
+}
+
+/**
+ * Reads a list of cells, calling apply(cell) for each one, and throws if any lies outside the grid.
+ */
+template<typename F>
+static void get_cells(const std::vector<unsigned char> &data, std::size_t &position, const std::uint64_t total,
+                      const F &apply) {
+    const std::uint64_t count = get_varint(data, position);
+    if (count > total) {
+        throw std::runtime_error(std::string("Corrupted delta file!"));
+    }
+    std::uint64_t next = 0;                          // The smallest index the next cell may have
+    for (std::uint64_t i = 0; i < count; i++) {
+        const std::uint64_t gap = get_varint(data, position);
+        if (gap >= total - next) {
+            throw std::runtime_error(std::string("Corrupted delta file!"));
+        }
+        const std::uint64_t cell = next + gap;
+        apply(static_cast<int>(cell));
+        next = cell + 1;
+    }
+}
+
+/**
+ * DeltaWriter::DeltaWriter(path, width, height)
+ *
+ * Construct a writer creating, or truncating, a delta stream at a path and write its header.
+ *
+ * @example
+ *
+ *      // Record 1000 generations of a world
+ *      DeltaWriter deltas("path/to/run.gold", world.get_width(), world.get_height());
+ *      deltas.write_keyframe(world.get_generation(), world.state());
+ *      world.set_change_tracking(true);
+ *      for (int step = 0; step < 1000; step++) {
+ *          world.step();
+ *          deltas.write_step(world);
+ *      }
+ *
+ * @param path
+ *      The path to write to.
+ *
+ * @param width
+ *      The width of every state in the stream.
+ *
+ * @param height
+ *      The height of every state in the stream.
+ *
+ * @throws
+ *      Throws std::runtime_error if the size is negative or the file cannot be opened.
+ */
+DeltaWriter::DeltaWriter(const std::string &path, const int width, const int height)
+        : out(&this->file), width(width), height(height), started(false), last_generation(0), written(0) {
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Width and height of the grid cannot be negative!"));
+    }
+    this->file.open(path, std::ios::out | std::ios::binary);
+    if (!this->file) {
+        throw std::runtime_error(std::string("Can't open the file!"));
+    }
+    this->buffer.assign(MAGIC, MAGIC + sizeof(MAGIC));
+    put_varint(this->buffer, VERSION);
+    put_varint(this->buffer, static_cast<std::uint64_t>(width));
+    put_varint(this->buffer, static_cast<std::uint64_t>(height));
+    this->write_buffer();
+}
+
+/**
+ * DeltaWriter::DeltaWriter(out, width, height)
+ *
+ * Construct a writer streaming to an open stream, such as standard output piped into a visualiser,
+ * and write the header. The stream must outlive the writer.
+ *
+ * @param out
+ *      The stream to write to.
+ *
+ * @param width
+ *      The width of every state in the stream.
+ *
+ * @param height
+ *      The height of every state in the stream.
+ *
+ * @throws
+ *      Throws std::runtime_error if the size is negative.
+ */
+DeltaWriter::DeltaWriter(std::ostream &out, const int width, const int height)
+        : out(&out), width(width), height(height), started(false), last_generation(0), written(0) {
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Width and height of the grid cannot be negative!"));
+    }
+    this->buffer.assign(MAGIC, MAGIC + sizeof(MAGIC));
+    put_varint(this->buffer, VERSION);
+    put_varint(this->buffer, static_cast<std::uint64_t>(width));
+    put_varint(this->buffer, static_cast<std::uint64_t>(height));
+    this->write_buffer();
+}
+
+/**
+ * DeltaWriter::write_buffer()
+ *
+ * Private helper function writing out the frame encoded in the buffer.
+ */
+void DeltaWriter::write_buffer() {
+    this->out->write(reinterpret_cast<const char *>(this->buffer.data()),
+                     static_cast<std::streamsize>(this->buffer.size()));
+    if (!*this->out) {
+        throw std::runtime_error(std::string("Can't write to the file!"));
+    }
+    this->written += this->buffer.size();
+    Stats::add(Stats::Counter::BYTES_WRITTEN, this->buffer.size());
+}
+
+/**
+ * DeltaWriter::write_keyframe(generation, state)
+ *
+ * Write a whole state. The first frame of a stream must be a keyframe, later ones bound how many deltas a
+ * replay has to apply, and are needed after any generations went by without a delta.
+ *
+ * @param generation
+ *      The generation of the state, later than the last frame written.
+ *
+ * @param state
+ *      The state, of the size of the stream.
+ *
+ * @throws
+ *      Throws std::runtime_error if the state is of another size or the generation is not after the last frame.
+ */
+void DeltaWriter::write_keyframe(const std::uint64_t generation, const Grid &state) {
+    if (state.get_width() != this->width || state.get_height() != this->height) {
+        throw std::runtime_error(std::string("The grid does not match the size of the stream!"));
+    }
+    if (this->started && generation <= this->last_generation) {
+        throw std::runtime_error(std::string("The frame does not follow the last frame!"));
+    }
+    std::vector<int> alive;
+    for (int y = 0; y < this->height; y++) {
+        const Cell *row = state.row(y);
+        for (int x = 0; x < this->width; x++) {
+            if (row[x] == Cell::ALIVE) {
+                alive.push_back(y * this->width + x);
+            }
+        }
+    }
+    this->buffer.clear();
+    this->buffer.push_back(KEYFRAME_TAG);
+    put_varint(this->buffer, generation);
+    put_cells(this->buffer, alive, this->width * this->height);
+    this->write_buffer();
+    this->started = true;
+    this->last_generation = generation;
+}
+
+/**
+ * DeltaWriter::write_delta(generation, births, deaths)
+ *
+ * Write the cells which changed on the way from the last frame's generation to the next one.
+ *
+ * @param generation
+ *      The generation reached, one after the last frame written.
+ *
+ * @param births
+ *      The cells born, as indices y * width + x.
+ *
+ * @param deaths
+ *      The cells killed, as indices y * width + x.
+ *
+ * @throws
+ *      Throws std::runtime_error if no keyframe was written yet, the generation does not directly follow the
+ *      last frame, or a cell lies outside the grid.
+ */
+void DeltaWriter::write_delta(const std::uint64_t generation, const std::vector<int> &births,
+                              const std::vector<int> &deaths) {
+    if (!this->started || generation != this->last_generation + 1) {
+        throw std::runtime_error(std::string("The frame does not follow the last frame!"));
+    }
+    this->buffer.clear();
+    this->buffer.push_back(DELTA_TAG);
+    put_cells(this->buffer, births, this->width * this->height);
+    put_cells(this->buffer, deaths, this->width * this->height);
+    this->write_buffer();
+    this->last_generation = generation;
+}
+
+/**
+ * DeltaWriter::write_step(world)
+ *
+ * Write the births and deaths of the last step of a world, which must be tracking its changes.
+ *
+ * @param world
+ *      The world, of the size of the stream.
+ *
+ * @throws
+ *      Throws std::runtime_error if the world is not tracking changes, is of another size, or its generation
+ *      does not directly follow the last frame.
+ */
+void DeltaWriter::write_step(const World &world) {
+    if (!world.get_change_tracking()) {
+        throw std::runtime_error(std::string("The world is not tracking its changes!"));
+    }
+    if (world.get_width() != this->width || world.get_height() != this->height) {
+        throw std::runtime_error(std::string("The grid does not match the size of the stream!"));
+    }
+    this->write_delta(world.get_generation(), world.get_births(), world.get_deaths());
+}
+
+/**
+ * DeltaWriter::flush()
+ *
+ * Flush the frames written so far, so a reader at the other end of a pipe sees them.
+ */
+void DeltaWriter::flush() {
+    this->out->flush();
+}
+
+/**
+ * DeltaWriter::get_bytes_written()
+ *
+ * @return
+ *      The size of the stream so far.
+ */
+std::uint64_t DeltaWriter::get_bytes_written() const {
+    return this->written;
+}
+
+/**
+ * DeltaReplayer::DeltaReplayer(path)
+ *
+ * Construct a replayer from a delta stream saved at a path.
+ *
+ * @example
+ *
+ *      // Rebuild generation 500 of a recorded run
+ *      DeltaReplayer replayer("path/to/run.gold");
+ *      Grid state = replayer.replay(500);
+ *
+ * @param path
+ *      The path of the stream.
+ *
+ * @throws
+ *      Throws std::runtime_error if the file cannot be opened or is not a valid delta stream.
+ */
+DeltaReplayer::DeltaReplayer(const std::string &path) : width(0), height(0) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error(std::string("Can't open the file!"));
+    }
+    this->data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    this->parse();
+}
+
+/**
+ * DeltaReplayer::DeltaReplayer(in)
+ *
+ * Construct a replayer from a delta stream read to its end, such as standard input.
+ *
+ * @param in
+ *      The stream to read.
+ *
+ * @throws
+ *      Throws std::runtime_error if the stream is not a valid delta stream.
+ */
+DeltaReplayer::DeltaReplayer(std::istream &in) : width(0), height(0) {
+    this->data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    this->parse();
+}
+
+/**
+ * DeltaReplayer::parse()
+ *
+ * Private helper function reading the header and indexing every frame, checking every cell is inside the
+ * grid so that a replay cannot fail part way through.
+ */
+void DeltaReplayer::parse() {
+    Stats::add(Stats::Counter::BYTES_READ, this->data.size());
+    if (this->data.size() < sizeof(MAGIC) || !std::equal(MAGIC, MAGIC + sizeof(MAGIC), this->data.begin())) {
+        throw std::runtime_error(std::string("Not a delta file!"));
+    }
+    std::size_t position = sizeof(MAGIC);
+    if (get_varint(this->data, position) != VERSION) {
+        throw std::runtime_error(std::string("Unsupported delta file version!"));
+    }
+    const std::uint64_t width = get_varint(this->data, position), height = get_varint(this->data, position);
+    if (width > 0x7fffffff || height > 0x7fffffff || (width > 0 && height > 0x7fffffff / width)) {
+        throw std::runtime_error(std::string("Corrupted delta file!"));
+    }
+    this->width = static_cast<int>(width);
+    this->height = static_cast<int>(height);
+
+    const std::uint64_t total = width * height;
+    const auto ignore = [](const int) {};
+    std::uint64_t generation = 0;
+    while (position < this->data.size()) {
+        const unsigned char tag = this->data[position++];
+        if (tag == KEYFRAME_TAG) {
+            const std::uint64_t keyframe = get_varint(this->data, position);
+            if (!this->frames.empty() && keyframe <= generation) {
+                throw std::runtime_error(std::string("Corrupted delta file!"));
+            }
+            generation = keyframe;
+            this->frames.push_back({generation, position, true});
+            get_cells(this->data, position, total, ignore);
+        } else if (tag == DELTA_TAG && !this->frames.empty()) {
+            generation++;
+            this->frames.push_back({generation, position, false});
+            get_cells(this->data, position, total, ignore);
+            get_cells(this->data, position, total, ignore);
+        } else {
+            throw std::runtime_error(std::string("Corrupted delta file!"));
+        }
+    }
+}
+
+int DeltaReplayer::get_width() const {
+    return this->width;
+}
+
+int DeltaReplayer::get_height() const {
+    return this->height;
+}
+
+/**
+ * DeltaReplayer::get_first_generation()
+ *
+ * @return
+ *      The generation of the first keyframe, or 0 if the stream has no frames.
+ */
+std::uint64_t DeltaReplayer::get_first_generation() const {
+    return this->frames.empty() ? 0 : this->frames.front().generation;
+}
+
+/**
+ * DeltaReplayer::get_last_generation()
+ *
+ * @return
+ *      The generation of the last frame, or 0 if the stream has no frames.
+ */
+std::uint64_t DeltaReplayer::get_last_generation() const {
+    return this->frames.empty() ? 0 : this->frames.back().generation;
+}
+
+std::size_t DeltaReplayer::get_frame_count() const {
+    return this->frames.size();
+}
+
+/**
+ * DeltaReplayer::replay(generation)
+ *
+ * Rebuild the state at a generation, starting from the last keyframe at or before it and applying
+ * every delta up to it.
+ *
+ * @param generation
+ *      The generation to rebuild.
+ *
+ * @return
+ *      The state at the generation.
+ *
+ * @throws
+ *      Throws std::runtime_error if the stream has no frame for the generation, i.e. it is before the first
+ *      keyframe, after the last frame, or was skipped over between a delta and the next keyframe.
+ */
+Grid DeltaReplayer::replay(const std::uint64_t generation) const {
+    // Frames are in order of generation, find the last at or before the one wanted
+    const auto after = std::upper_bound(this->frames.begin(), this->frames.end(), generation,
+                                        [](const std::uint64_t value, const Frame &frame) {
+                                            return value < frame.generation;
+                                        });
+    if (after == this->frames.begin() || (after - 1)->generation != generation) {
+        throw std::runtime_error(std::string("The generation is not in the delta stream!"));
+    }
+    auto frame = after - 1;
+    while (!frame->keyframe) {
+        frame--;
+    }
+
+    Grid state(this->width, this->height);
+    Cell *cells = state.row(0);
+    const std::uint64_t total = static_cast<std::uint64_t>(this->width) * this->height;
+    std::size_t position = frame->offset;
+    get_cells(this->data, position, total, [cells](const int cell) { cells[cell] = Cell::ALIVE; });
+    for (++frame; frame != after; ++frame) {
+        position = frame->offset;
+        get_cells(this->data, position, total, [cells](const int cell) { cells[cell] = Cell::ALIVE; });
+        get_cells(this->data, position, total, [cells](const int cell) { cells[cell] = Cell::DEAD; });
+    }
+    return state;
+}
@@ -0,0 +1,112 @@
+/**
+ * Declares classes streaming the cells born and killed each generation, and replaying any generation from them.
+ * Rich documentation for the api and the stream format can be found in delta.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "grid.h"
+#include "world.h"
+
+/**
+ * Declare the structure of the DeltaWriter class.
+ *
+ * A delta stream starts with a keyframe holding a whole state, followed by one delta per generation listing
+ * only the cells born and killed. Further keyframes can be written at any point, e.g. every few thousand
+ * generations to bound the work of a replay, or after generations were skipped. DeltaWriter objects cannot be copied.
+ */
+class DeltaWriter {
+private:
+    std::ofstream file;
+
+    std::ostream *out;                               // The file, or the stream the writer was given
+
+    int width, height;
+
+    bool started;                                    // True once the first keyframe was written
+
+    std::uint64_t last_generation;                   // The generation of the last frame written
+
+    std::vector<unsigned char> buffer;               // The frame being encoded
+
+    std::uint64_t written;                           // Bytes written so far, including the header
+
+    void write_buffer();
+
+public:
+    DeltaWriter(const std::string &path, const int width, const int height);
+
+    DeltaWriter(std::ostream &out, const int width, const int height);
+
+    DeltaWriter(const DeltaWriter &) = delete;
+
+    DeltaWriter &operator=(const DeltaWriter &) = delete;
+
+    // Member functions
+    // Writes a whole state, which every later delta builds on
+    void write_keyframe(const std::uint64_t generation, const Grid &state);
+
+    // Writes the cells born and killed on the way to generation, which must follow the last frame written
+    void write_delta(const std::uint64_t generation, const std::vector<int> &births, const std::vector<int> &deaths);
+
+    // Writes the births and deaths of the last step of a world tracking its changes
+    void write_step(const World &world);
+
+    void flush();
+
+    std::uint64_t get_bytes_written() const;
+};
+
+/**
+ * Declare the structure of the DeltaReplayer class.
+ *
+ * The whole stream is read and checked up front, along with the position of every frame, so any generation
+ * it covers is rebuilt from the closest keyframe before it and the deltas in between.
+ */
+class DeltaReplayer {
+private:
+    struct Frame {
+        std::uint64_t generation;
+
+        std::size_t offset;                          // The position of the frame's cell lists in data
+
+        bool keyframe;
+    };
+
+    std::vector<unsigned char> data;
+
+    int width, height;
+
+    std::vector<Frame> frames;
+
+    void parse();                                    // Indexes and checks every frame of data
+
+public:
+    explicit DeltaReplayer(const std::string &path);
+
+    explicit DeltaReplayer(std::istream &in);
+
+    // Member functions
+    int get_width() const;
+
+    int get_height() const;
+
+    // The generation of the first keyframe
+    std::uint64_t get_first_generation() const;
+
+    std::uint64_t get_last_generation() const;
+
+    // The number of keyframes and deltas in the stream
+    std::size_t get_frame_count() const;
+
+    // Rebuilds the state at a generation the stream covers
+    Grid replay(const std::uint64_t generation) const;
+};
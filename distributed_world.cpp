@@ -0,0 +1,480 @@
+/**
+ * Implements a class simulating one board split across the nodes of a Cluster.
+ *      - The board is split into strips of whole rows, node r stepping rows [height * r / n, height * (r + 1) / n)
+ *        of n nodes, so every strip is as wide as the board and the left and right edges wrap locally.
+ *      - Each strip is padded with halo rows from the strips above and below, wrapping from the last node to
+ *        the first on a torus. Every step corrupts one more halo row from its outer edge inwards, so a halo of
+ *        k rows lasts k steps before it has to be exchanged again, trading k times the halo for k times fewer
+ *        exchanges. The edges of a flat board have no halo, the local World treats them as dead.
+ *      - Only the counts are sent for population counts, the whole board only moves for Grid gathers.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "distributed_world.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "zoo.h"
+
+/**
+ * The first row of the strip of a node.
+ */
+static int strip_start(const int height, const int size, const int rank) {
+    return static_cast<int>(static_cast<long long>(height) * rank / size);
+}
+
+/**
+ * Checks a board can be split across the nodes with the halo, so every halo comes from a single neighbour.
+ */
+static void check_layout(const int width, const int height, const int halo, const int size) {
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Width and height of the world cannot be negative!"));
+    }
+    if (halo < 1) {
+        throw std::runtime_error(std::string("The halo must be at least one row!"));
+    }
+    if (height / size < halo) {
+        throw std::runtime_error(std::string("Every node needs at least as many rows of the board as the halo!"));
+    }
+}
+
+/**
+ * DistributedWorld::DistributedWorld(cluster, width, height, halo)
+ *
+ * Construct this node's strip of a board of the desired size filled with dead cells.
+ * Every node of the cluster must construct the world with the same arguments.
+ *
+ * @example
+ *
+ *      // Step a 1Mx1M board on the nodes of the cluster, exchanging 8 rows every 8 steps
+ *      DistributedWorld world(cluster, 1 << 20, 1 << 20, 8);
+ *
+ * @param cluster
+ *      The cluster to step on, which must outlive the world.
+ *
+ * @param width
+ *      The width of the whole board.
+ *
+ * @param height
+ *      The height of the whole board.
+ *
+ * @param halo
+ *      The number of rows exchanged with each neighbour, and so the number of steps between exchanges.
+ *
+ * @throws
+ *      std::runtime_error if the size is negative, the halo is less than 1 or a node would have fewer
+ *      rows than the halo.
+ */
+DistributedWorld::DistributedWorld(Cluster &cluster, const int width, const int height, const int halo)
+        : cluster(cluster), width(width), height(height),
+          first_row(strip_start(height, cluster.get_size(), cluster.get_rank())),
+          rows(strip_start(height, cluster.get_size(), cluster.get_rank() + 1) - first_row), halo(halo),
+          top_halo(0), bottom_halo(0), steps_since_exchange(halo), halo_toroidal(false) {
+    check_layout(width, height, halo, cluster.get_size());
+    const Grid strip(width, this->rows);
+    this->lay_out(strip.view(0, 0, width, this->rows), false);
+}
+
+/**
+ * DistributedWorld::DistributedWorld(cluster, initial_state, halo)
+ *
+ * Construct this node's strip of a board from the whole board. Every node of the cluster must pass the same
+ * board, e.g. by loading the same file, and the same halo.
+ *
+ * @example
+ *
+ *      Cluster cluster(rank, Cluster::parse_endpoints("node0:7700,node1:7700"));
+ *      DistributedWorld world(cluster, Zoo::load_ascii("soup.gol"));
+ *
+ * @param cluster
+ *      The cluster to step on, which must outlive the world.
+ *
+ * @param initial_state
+ *      The whole board.
+ *
+ * @param halo
+ *      The number of rows exchanged with each neighbour, and so the number of steps between exchanges.
+ *
+ * @throws
+ *      std::runtime_error if the halo is less than 1 or a node would have fewer rows than the halo.
+ */
+DistributedWorld::DistributedWorld(Cluster &cluster, const Grid &initial_state, const int halo)
+        : cluster(cluster), width(initial_state.get_width()), height(initial_state.get_height()),
+          first_row(strip_start(height, cluster.get_size(), cluster.get_rank())),
+          rows(strip_start(height, cluster.get_size(), cluster.get_rank() + 1) - first_row), halo(halo),
+          top_halo(0), bottom_halo(0), steps_since_exchange(halo), halo_toroidal(false) {
+    check_layout(this->width, this->height, halo, cluster.get_size());
+    this->lay_out(initial_state.view(0, this->first_row, this->width, this->first_row + this->rows), false);
+}
+
+/**
+ * DistributedWorld::lay_out(strip, toroidal)
+ *
+ * Private helper function replacing the state of the local World with the strip, padded above and below by
+ * the halo rows of the topology. On a torus every strip has both halos, on a flat board the first and last
+ * strips have none past the edge of the board. The halo rows are dead until the next exchange.
+ * The rows are written with World::write_rows, so the local World is only resized, and its state unpacked,
+ * when halo rows come or go, and Engine::SPARSE only recomputes the tiles which actually changed.
+ *
+ * @param strip
+ *      The cells of this node's strip. It must not be a view onto the state of the local World.
+ *
+ * @param toroidal
+ *      The topology to lay the halo rows out for.
+ */
+void DistributedWorld::lay_out(const GridView &strip, const bool toroidal) {
+    const int rank = this->cluster.get_rank();
+    const int size = this->cluster.get_size();
+    const int top = toroidal || rank > 0 ? this->halo : 0;
+    const int bottom = toroidal || rank + 1 < size ? this->halo : 0;
+    if (this->world.get_width() != this->width || this->world.get_height() != top + this->rows + bottom) {
+        this->world.resize(this->width, top + this->rows + bottom);
+    }
+    const std::vector<Cell> dead(static_cast<std::size_t>(this->width) * this->halo, Cell::DEAD);
+    this->world.write_rows(0, top, dead.data());
+    for (int y = 0; y < this->rows; y++) {
+        this->world.write_rows(top + y, 1, strip.row(y));
+    }
+    this->world.write_rows(top + this->rows, bottom, dead.data());
+    this->top_halo = top;
+    this->bottom_halo = bottom;
+    this->halo_toroidal = toroidal;
+    this->steps_since_exchange = this->halo;
+}
+
+/**
+ * DistributedWorld::exchange()
+ *
+ * Private helper function sending the top and bottom halo rows of this node's strip to the neighbours above
+ * and below, and filling its own halo rows with theirs, all at once with Cluster::exchange(transfers).
+ * Only the rows sent and received are copied out of and into the local World, with World::read_rows and
+ * World::write_rows, so an exchange costs O(halo) rows whichever engine steps the strip.
+ */
+void DistributedWorld::exchange() {
+    const int rank = this->cluster.get_rank();
+    const int size = this->cluster.get_size();
+    const int up = this->top_halo > 0 ? (rank + size - 1) % size : -1;
+    const int down = this->bottom_halo > 0 ? (rank + 1) % size : -1;
+    const std::size_t cells = static_cast<std::size_t>(this->width) * this->halo;
+    // The top rows are sent from the front of outgoing and the bottom rows from the back, likewise received
+    this->outgoing.resize(2 * cells);
+    this->incoming.resize(2 * cells);
+    Cell *top_rows = this->outgoing.data();
+    Cell *bottom_rows = this->outgoing.data() + cells;
+    Cell *above = this->incoming.data();
+    Cell *below = this->incoming.data() + cells;
+    if (up >= 0) {
+        this->world.read_rows(this->top_halo, this->halo, top_rows);
+    }
+    if (down >= 0) {
+        this->world.read_rows(this->top_halo + this->rows - this->halo, this->halo, bottom_rows);
+    }
+    std::vector<Cluster::Transfer> transfers;
+    if (up >= 0 && up == down) {
+        // Both nodes send their top rows then their bottom rows, the top rows of the neighbour go below
+        const Cluster::Transfer transfer = {up, top_rows, 2 * cells, this->incoming.data(), 2 * cells};
+        transfers.push_back(transfer);
+        std::swap(above, below);
+    } else {
+        if (up >= 0) {
+            const Cluster::Transfer transfer = {up, top_rows, cells, above, cells};
+            transfers.push_back(transfer);
+        }
+        if (down >= 0) {
+            const Cluster::Transfer transfer = {down, bottom_rows, cells, below, cells};
+            transfers.push_back(transfer);
+        }
+    }
+    this->cluster.exchange(transfers);
+    if (up >= 0) {
+        this->world.write_rows(0, this->halo, above);
+    }
+    if (down >= 0) {
+        this->world.write_rows(this->top_halo + this->rows, this->halo, below);
+    }
+    this->steps_since_exchange = 0;
+}
+
+/**
+ * DistributedWorld::get_width()
+ *
+ * Gets the width of the whole board, which is also the width of every strip.
+ *
+ * @return
+ *      The width of the board.
+ */
+int DistributedWorld::get_width() const {
+    return this->width;
+}
+
+/**
+ * DistributedWorld::get_height()
+ *
+ * Gets the height of the whole board.
+ *
+ * @return
+ *      The height of the board.
+ */
+int DistributedWorld::get_height() const {
+    return this->height;
+}
+
+/**
+ * DistributedWorld::get_first_row()
+ *
+ * Gets the row of the board where the strip of this node starts.
+ *
+ * @return
+ *      The first row of the strip.
+ */
+int DistributedWorld::get_first_row() const {
+    return this->first_row;
+}
+
+/**
+ * DistributedWorld::get_local_height()
+ *
+ * Gets the number of rows of the board in the strip of this node.
+ *
+ * @return
+ *      The height of the strip.
+ */
+int DistributedWorld::get_local_height() const {
+    return this->rows;
+}
+
+/**
+ * DistributedWorld::get_halo()
+ *
+ * Gets the number of rows exchanged with each neighbour, which is also the number of steps between exchanges.
+ *
+ * @return
+ *      The height of the halo.
+ */
+int DistributedWorld::get_halo() const {
+    return this->halo;
+}
+
+/**
+ * DistributedWorld::get_generation()
+ *
+ * Gets the number of steps taken since construction, the same on every node.
+ *
+ * @return
+ *      The generation.
+ */
+std::uint64_t DistributedWorld::get_generation() const {
+    return this->world.get_generation();
+}
+
+/**
+ * DistributedWorld::get_local_state()
+ *
+ * Gets a view of the strip of this node without its halo rows. Row 0 of the view is row
+ * DistributedWorld::get_first_row() of the board. The view is only valid until the next step.
+ *
+ * @example
+ *
+ *      // Count the alive cells of this node alone
+ *      int alive = world.get_local_state().get_alive_cells();
+ *
+ * @return
+ *      A view of the strip.
+ */
+GridView DistributedWorld::get_local_state() const {
+    return this->world.state().view(0, this->top_halo, this->width, this->top_halo + this->rows);
+}
+
+/**
+ * DistributedWorld::get_alive_cells()
+ *
+ * Collective, gets the number of alive cells of the whole board. Each node counts its own strip and only
+ * the counts are summed across the cluster. The local World keeps the count of the strip with its halo rows
+ * as it steps, so only the halo rows are counted again, to leave them out.
+ *
+ * @return
+ *      The number of alive cells, the same on every node.
+ */
+std::uint64_t DistributedWorld::get_alive_cells() {
+    const std::size_t top = static_cast<std::size_t>(this->width) * this->top_halo;
+    const std::size_t bottom = static_cast<std::size_t>(this->width) * this->bottom_halo;
+    this->incoming.resize(top + bottom);
+    this->world.read_rows(0, this->top_halo, this->incoming.data());
+    this->world.read_rows(this->top_halo + this->rows, this->bottom_halo, this->incoming.data() + top);
+    const std::uint64_t halo_alive = std::count(this->incoming.begin(), this->incoming.end(), Cell::ALIVE);
+    return this->cluster.sum(static_cast<std::uint64_t>(this->world.get_alive_cells()) - halo_alive);
+}
+
+/**
+ * DistributedWorld::set_rule(rule)
+ *
+ * Select the rule applied by step and advance, which must be the same on every node.
+ *
+ * @param rule
+ *      The rule.
+ */
+void DistributedWorld::set_rule(const Rule &rule) {
+    this->world.set_rule(rule);
+}
+
+/**
+ * DistributedWorld::set_engine(engine)
+ *
+ * Select the engine each node steps its strip with. Nodes may use different engines.
+ *
+ * @param engine
+ *      The engine.
+ */
+void DistributedWorld::set_engine(const Engine engine) {
+    this->world.set_engine(engine);
+}
+
+/**
+ * DistributedWorld::set_simd_level(level)
+ *
+ * Select the instruction set Engine::SIMD uses on this node.
+ *
+ * @param level
+ *      The instruction set.
+ */
+void DistributedWorld::set_simd_level(const SimdLevel level) {
+    this->world.set_simd_level(level);
+}
+
+/**
+ * DistributedWorld::set_threads(threads)
+ *
+ * Select the number of threads this node steps its strip with, as World::set_threads(threads) does.
+ *
+ * @param threads
+ *      The number of threads, 0 selects one per hardware thread.
+ */
+void DistributedWorld::set_threads(const int threads) {
+    this->world.set_threads(threads);
+}
+
+/**
+ * DistributedWorld::step(toroidal)
+ *
+ * Collective, take one step of the whole board. The halo rows are exchanged first once the last halo was
+ * used up, every DistributedWorld::get_halo() steps. Changing the topology lays the halo rows out again,
+ * which costs an exchange.
+ *
+ * @example
+ *
+ *      // Step the whole torus, every node at once
+ *      world.step(true);
+ *
+ * @param toroidal
+ *      If true then the step will consider the board as a torus, where the left edge
+ *      wraps to the right edge and the top of the first strip to the bottom of the last.
+ */
+void DistributedWorld::step(const bool toroidal) {
+    this->advance(1, toroidal);
+}
+
+/**
+ * DistributedWorld::set_temporal_depth(depth)
+ *
+ * Select how many generations this node steps its strip per pass over memory, as
+ * World::set_temporal_depth(depth) does. Passes never run past the next halo exchange.
+ *
+ * @param depth
+ *      The generations per pass, 1 steps one generation at a time.
+ *
+ * @throws
+ *      std::runtime_error if the depth is not positive.
+ */
+void DistributedWorld::set_temporal_depth(const int depth) {
+    this->world.set_temporal_depth(depth);
+}
+
+/**
+ * DistributedWorld::advance(steps, toroidal)
+ *
+ * Collective, take the desired number of steps of the whole board. Every step the halo rows can spare is
+ * handed to World::advance at once, so a halo of several rows also lets the strip be stepped several
+ * generations per pass over memory.
+ *
+ * @param steps
+ *      The number of steps to take.
+ *
+ * @param toroidal
+ *      If true then the step will consider the board as a torus.
+ */
+void DistributedWorld::advance(const int steps, const bool toroidal) {
+    for (int done = 0; done < steps;) {
+        if (toroidal != this->halo_toroidal) {
+            Grid strip(this->width, this->rows);
+            if (this->width > 0) {
+                this->world.read_rows(this->top_halo, this->rows, strip.row(0));
+            }
+            this->lay_out(strip.view(0, 0, this->width, this->rows), toroidal);
+        }
+        if (this->steps_since_exchange >= this->halo) {
+            this->exchange();
+        }
+        // The local World wraps its own halo rows on a torus, which only corrupts rows the halo can spare
+        const int chunk = std::min(this->halo - this->steps_since_exchange, steps - done);
+        this->world.advance(chunk, toroidal);
+        this->steps_since_exchange += chunk;
+        done += chunk;
+    }
+}
+
+/**
+ * DistributedWorld::gather()
+ *
+ * Collective, copy every strip onto rank 0 to assemble the whole board, e.g. to save it to a single file.
+ * Boards too large for one machine are better saved as shards, see DistributedWorld::save_shard(path).
+ *
+ * @example
+ *
+ *      Grid board = world.gather();
+ *      if (cluster.get_rank() == 0) {
+ *          Zoo::save_binary("board.bgol", board);
+ *      }
+ *
+ * @return
+ *      The whole board on rank 0, an empty 0x0 grid on every other node.
+ */
+Grid DistributedWorld::gather() {
+    const GridView strip = this->get_local_state();
+    const std::size_t row_bytes = static_cast<std::size_t>(this->width) * sizeof(Cell);
+    if (this->cluster.get_rank() != 0) {
+        this->cluster.send(0, strip.row(0), row_bytes * this->rows);
+        return Grid();
+    }
+    Grid board(this->width, this->height);
+    board.merge(strip, 0, 0);
+    const int size = this->cluster.get_size();
+    for (int peer = 1; peer < size; peer++) {
+        const int first = strip_start(this->height, size, peer);
+        const int last = strip_start(this->height, size, peer + 1);
+        this->cluster.receive(peer, board.row(first), row_bytes * (last - first));
+    }
+    return board;
+}
+
+/**
+ * DistributedWorld::save_shard(path)
+ *
+ * Save the strip of this node as a .bgol file, the format of Zoo::save_binary. The shard holds rows
+ * [get_first_row(), get_first_row() + get_local_height()) of the board, so stacking the shards of every
+ * rank in order gives the whole board back.
+ *
+ * @example
+ *
+ *      world.save_shard("board." + std::to_string(cluster.get_rank()) + ".bgol");
+ *
+ * @param path
+ *      The path to write the shard to.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void DistributedWorld::save_shard(const std::string &path) const {
+    Zoo::save_binary(path, this->get_local_state().to_grid());
+}
@@ -0,0 +1,100 @@
+/**
+ * Declares a class simulating one board split across the nodes of a Cluster.
+ * Rich documentation for the api and behaviour the DistributedWorld class can be found in distributed_world.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cluster.h"
+#include "grid.h"
+#include "rule.h"
+#include "world.h"
+
+/**
+ * Declare the structure of the DistributedWorld class.
+ *
+ * Every node holds a strip of whole rows of the board, rank 0 the top one, in a World padded above and
+ * below by halo rows copied from the neighbouring strips. The edges of a flat board have no halo.
+ * Functions marked collective must be called by every node in the same order.
+ * DistributedWorld objects cannot be copied.
+ */
+class DistributedWorld {
+private:
+    Cluster &cluster;
+
+    int width, height;                               // The size of the whole board
+
+    int first_row, rows;                             // The strip of the board this node steps
+
+    int halo;                                        // Rows copied from each neighbour, enough for halo steps
+
+    int top_halo, bottom_halo;                       // The halo rows actually above and below the strip
+
+    World world;                                     // The strip with its halo rows
+
+    int steps_since_exchange;                        // The halo is used up once this reaches halo
+
+    bool halo_toroidal;                              // The topology the halo rows were laid out for
+
+    std::vector<Cell> outgoing, incoming;            // The halo rows sent and received by an exchange
+
+    void lay_out(const GridView &strip, const bool toroidal); // Pads the strip with the halo rows of a topology
+
+    void exchange();                                 // Refills the halo rows from the neighbours
+
+public:
+    DistributedWorld(Cluster &cluster, const int width, const int height, const int halo = 1);
+
+    // Every node passes the whole board, e.g. loaded from the same file, and keeps its own strip
+    DistributedWorld(Cluster &cluster, const Grid &initial_state, const int halo = 1);
+
+    DistributedWorld(const DistributedWorld &) = delete;
+
+    DistributedWorld &operator=(const DistributedWorld &) = delete;
+
+    // Member functions
+    int get_width() const;
+
+    int get_height() const;
+
+    int get_first_row() const;
+
+    int get_local_height() const;
+
+    int get_halo() const;
+
+    std::uint64_t get_generation() const;
+
+    // The strip of this node, without its halo rows
+    GridView get_local_state() const;
+
+    // Collective, the alive cells of the whole board
+    std::uint64_t get_alive_cells();
+
+    void set_rule(const Rule &rule);
+
+    void set_engine(const Engine engine);
+
+    void set_simd_level(const SimdLevel level);
+
+    void set_threads(const int threads);
+
+    void set_temporal_depth(const int depth);
+
+    // Collective, steps the whole board once, exchanging halo rows every halo steps
+    void step(const bool toroidal = false);
+
+    // Collective
+    void advance(const int steps, const bool toroidal = false);
+
+    // Collective, the whole board on rank 0, an empty grid on every other node
+    Grid gather();
+
+    // Saves the strip of this node as a .bgol file, see get_first_row for where it goes
+    void save_shard(const std::string &path) const;
+};
@@ -2,7 +2,7 @@
  * Implements a class representing a 2d grid of cells.
  *      - New cells are initialized to Cell::DEAD.
  *      - Grids can be resized while retaining their contents in the remaining area.
- *      - Grids can be rotated, cropped, and merged together.
+ *      - Grids can be rotated, cropped, and merged together, and viewed through a GridView without a copy.
  *      - Grids can return counts of the alive and dead cells.
  *      - Grids can be serialized directly to an ascii std::ostream.
  *
@@ -16,6 +16,12 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 /**
  * Grid::Grid()
@@ -80,10 +86,106 @@ Grid::Grid(const int width, const int height) : width(width), height(height) {
     if (this->width == 0 && this->height == 0) {
         this->grid.empty();
     } else {
-        this->grid = std::vector<Cell>((width * height), Cell::DEAD);
+        this->grid.assign(static_cast<std::size_t>(width) * height, Cell::DEAD);
     }
 }
 
+/**
+ * Grid::Grid(other)
+ *
+ * Move construct a grid, taking over the cells of the other grid without copying them.
+ * The other grid is left as an empty 0x0 grid, so its size always agrees with its cells.
+ * Moving never throws, which World relies on to swap its states in constant time every step.
+ *
+ * @example
+ *
+ *      // Make a grid and move it into another
+ *      Grid grid(16, 9);
+ *      Grid moved(std::move(grid));
+ *
+ * @param other
+ *      The grid to take the cells of.
+ */
+Grid::Grid(Grid &&other) noexcept : width(other.width), height(other.height), grid(std::move(other.grid)) {
+    other.width = 0;
+    other.height = 0;
+    other.grid.clear();
+}
+
+/**
+ * Grid::operator=(other)
+ *
+ * Move assign a grid, taking over the cells of the other grid without copying them.
+ * The other grid is left as an empty 0x0 grid, as with the move constructor.
+ *
+ * @example
+ *
+ *      // Make two grids and move one into the other
+ *      Grid grid(16, 9);
+ *      Grid moved;
+ *      moved = std::move(grid);
+ *
+ * @param other
+ *      The grid to take the cells of.
+ *
+ * @return
+ *      A reference to this grid.
+ */
+Grid &Grid::operator=(Grid &&other) noexcept {
+    if (this != &other) {
+        this->width = other.width;
+        this->height = other.height;
+        this->grid = std::move(other.grid);
+        other.width = 0;
+        other.height = 0;
+        other.grid.clear();
+    }
+    return *this;
+}
+
+/**
+ * Grid::untouched(width, height)
+ *
+ * Create a grid with the desired size whose cells are allocated but not written, so the pages of a large grid
+ * are first touched by whichever threads fill it in. On NUMA machines each page is then placed on the memory
+ * node of the thread that fills it, see BufferAllocator. Every cell must be written before it is read.
+ *
+ * @example
+ *
+ *      // Make a 4096x4096 grid and fill its two halves from two threads
+ *      Grid grid = Grid::untouched(4096, 4096);
+ *      std::thread top([&grid]() { std::fill_n(grid.row(0), 4096 * 2048, Cell::DEAD); });
+ *      std::fill_n(grid.row(2048), 4096 * 2048, Cell::DEAD);
+ *      top.join();
+ *
+ * @param width
+ *      The width of the grid.
+ *
+ * @param height
+ *      The height of the grid.
+ *
+ * @return
+ *      The unwritten grid.
+ *
+ * @throws
+ *      std::runtime_error if the width or height is negative.
+ */
+Grid Grid::untouched(const int width, const int height) {
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Width and height of the grid cannot be negative!"));
+    }
+    Grid grid;
+    grid.width = width;
+    grid.height = height;
+    // BufferAllocator leaves default inserted cells unwritten
+    grid.grid.resize(static_cast<std::size_t>(width) * height);
+    return grid;
+}
+
+// std::swap of two grids, as every engine does each step, must stay three moves of the cells
+static_assert(std::is_nothrow_move_constructible<Grid>::value && std::is_nothrow_move_assignable<Grid>::value,
+              "Grid must be nothrow movable so swapping two grids never copies their cells");
+
 /**
  * Grid::get_width()
  *
@@ -251,6 +353,10 @@ void Grid::resize(const int square_size) {
  * Resize the current grid to a new width and new_height. The content of the grid
  * should be preserved within the kept region and padded with Grid::DEAD if new cells are added.
  *
+ * The cells are rearranged in place inside the existing buffer. A narrower grid moves its rows towards the
+ * front from the top down, then truncates the buffer, which never reallocates. A wider grid extends the buffer,
+ * reallocating only if it lacks the capacity, then moves its rows towards the back from the bottom up.
+ *
  * @example
  *
  *      // Make a grid
@@ -264,43 +370,44 @@ void Grid::resize(const int square_size) {
  *
  * @param new_height
  *      The new new_height for the grid.
+ *
+ * @throws
+ *      std::runtime_error if the new width or height is negative.
  */
 
 void Grid::resize(const int new_width, const int new_height) {
+    if (new_width < 0 || new_height < 0) {
+        throw std::runtime_error(std::string("Width and height of the grid cannot be negative!"));
+    }
     if (this->width == new_width && this->height == new_height) {
         std::cout << "The new grid size is the same as the old one!";
+        return;
     }
-    //Creating new Grid to store resized data
-    Grid g(new_width, new_height);
-    // If the resized vector is smaller than the original
-    if (new_width * new_height < this->width * this->get_height()) {
-        for (int i = 0; i < new_height; i++) {
-            for (int j = 0; j < new_width; j++) {
-                // Mapping 1D representation of a vector to a 2D one
-                const int idx = j + (i * new_width);
-                const int newX = idx % new_width;
-                const int newY = (idx - j) / new_width;
-                // Cloning values from old vector to a new one w.r.t new coordinates
-                g(newX, newY) = this->get(j, i);
-            }
+    const int old_width = this->width;
+    const int kept_height = std::min(this->height, new_height);
+    const std::size_t cells = static_cast<std::size_t>(new_width) * new_height;
+    if (new_width <= old_width) {
+        // Every row lands at or before where it was, so moving them top down never overwrites an unmoved row
+        for (int i = 1; i < kept_height && new_width != old_width; i++) {
+            std::memmove(this->grid.data() + static_cast<std::size_t>(i) * new_width,
+                         this->grid.data() + static_cast<std::size_t>(i) * old_width, new_width * sizeof(Cell));
         }
-        // Alternatively if the resized vector is larger than the original
+        this->grid.resize(cells, Cell::DEAD);
     } else {
-        for (int i = 0; i < this->height; i++) {
-            for (int j = 0; j < this->width; j++) {
-                // Mapping 1D representation of a vector to a 2D one
-                const int idx = j + (i * new_width);
-                const int newX = idx % new_width;
-                const int newY = (idx - j) / new_width;
-                // Cloning values from old vector to a new one w.r.t new coordinates
-                g(newX, newY) = this->get(j, i);
-            }
+        // Every row lands after where it was, so they are moved bottom up, each padded with dead cells
+        this->grid.resize(cells, Cell::DEAD);
+        for (int i = kept_height - 1; i >= 0; i--) {
+            Cell *moved = this->grid.data() + static_cast<std::size_t>(i) * new_width;
+            std::memmove(moved, this->grid.data() + static_cast<std::size_t>(i) * old_width, old_width * sizeof(Cell));
+            std::fill(moved + old_width, moved + new_width, Cell::DEAD);
         }
     }
+    // Rows past the old height may hold cells moved out of the way, they start dead
+    std::fill(this->grid.begin() + static_cast<std::size_t>(kept_height) * new_width, this->grid.end(), Cell::DEAD);
+
     // Updating fields
     this->width = new_width;
     this->height = new_height;
-    this->grid = g.grid;
 }
 
 /**
@@ -357,7 +464,7 @@ Cell Grid::get(const int x, const int y) const {
     if (x >= this->width || x < 0) throw std::exception();
     if (y >= this->height || y < 0) throw std::exception();
 
-    const Cell value = (*this)(x, y);
+    const Cell value = this->at_unchecked(x, y);
     return value;
 }
 
@@ -392,9 +499,78 @@ Cell Grid::get(const int x, const int y) const {
 void Grid::set(const int x, const int y, const Cell value) {
     if (x >= this->width || x < 0) throw std::exception();
     if (y >= this->height || y < 0) throw std::exception();
-    this->operator()(x, y) = value;
+    this->at_unchecked(x, y) = value;
 }
 
+/**
+ * Grid::row(y)
+ *
+ * Gets a pointer to the first cell of a row, the cells of the row follow contiguously.
+ * No bounds checking is performed, this is intended for loops which already iterate within the grid
+ * such as the World stepping kernels.
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Fill the second row with alive cells
+ *      Cell *cells = grid.row(1);
+ *      std::fill(cells, cells + grid.get_width(), Cell::ALIVE);
+ *
+ * @param y
+ *      The y coordinate of the row, which must be within the grid.
+ *
+ * @return
+ *      A pointer to get_width() consecutive cells.
+ */
+// Grid::row(y) is defined inline in grid.h
+
+/**
+ * Grid::row_view(y)
+ *
+ * Gets a view of the cells of a row which can be iterated with a range based for loop.
+ * Like Grid::row(y), no bounds checking is performed and it is defined inline in grid.h.
+ *
+ * @example
+ *
+ *      // Count the alive cells of the top row
+ *      int alive = 0;
+ *      for (const Cell cell : grid.row_view(0)) {
+ *          alive += cell == Cell::ALIVE;
+ *      }
+ *
+ * @param y
+ *      The y coordinate of the row, which must be within the grid.
+ *
+ * @return
+ *      A RowView of get_width() cells, valid until the grid is resized or destroyed.
+ */
+
+/**
+ * Grid::at_unchecked(x, y)
+ *
+ * Gets the cell at a coordinate without checking it, for loops which already iterate within the grid.
+ * Checked access through Grid::operator()(x, y), Grid::get and Grid::set remains the default for anything
+ * else, an invalid coordinate here is undefined behaviour. Defined inline in grid.h.
+ *
+ * @example
+ *
+ *      // Clear the main diagonal of a square grid
+ *      for (int i = 0; i < grid.get_width(); i++) {
+ *          grid.at_unchecked(i, i) = Cell::DEAD;
+ *      }
+ *
+ * @param x
+ *      The x coordinate of the cell, which must be within the grid.
+ *
+ * @param y
+ *      The y coordinate of the cell, which must be within the grid.
+ *
+ * @return
+ *      A modifiable reference to the cell, or its value for a constant grid.
+ */
+
 /**
  * Grid::operator()(x, y)
  *
@@ -485,7 +661,8 @@ Cell &Grid::operator()(const int x, const int y) const {
  *
  * Extract a sub-grid from a Grid.
  * The cropped grid spans the range [x0, x1) by [y0, y1) in the original grid.
- * The function should be callable from a constant context.
+ * The function should be callable from a constant context, the original grid is left as it is.
+ * The cells are copied a row at a time, use Grid::view(x0, y0, x1, y1) to avoid the copy altogether.
  *
  * @example
  *
@@ -493,7 +670,7 @@ Cell &Grid::operator()(const int x, const int y) const {
  *      Grid y(4, 4);
  *
  *      // Crop the centre 2x2 in y, trimming a 1 cell border off all sides
- *      Grid x = y.crop(x, 1, 1, 3, 3);
+ *      Grid x = y.crop(1, 1, 3, 3);
  *
  * @param x0
  *      Left coordinate of the crop window on x-axis.
@@ -514,37 +691,100 @@ Cell &Grid::operator()(const int x, const int y) const {
  *      std::exception or sub-class if x0,y0 or x1,y1 are not valid coordinates within the grid
  *      or if the crop window has a negative size.
  */
+Grid Grid::crop(const int x0, const int y0, const int x1, const int y1) const {
+    return this->view(x0, y0, x1, y1).to_grid();
+}
 
-Grid Grid::crop(const int x0, const int y0, const int x1, const int y1) {
+/**
+ * Grid::view(x0, y0, x1, y1)
+ *
+ * Make a read-only view of the range [x0, x1) by [y0, y1) of the grid, the range Grid::crop would copy.
+ * No cells are copied, the view reads the cells of this grid, so it must not outlive the grid or a resize of it.
+ *
+ * @example
+ *
+ *      // Stamp the top left 3x3 of a pattern onto a board without copying it
+ *      board.merge(pattern.view(0, 0, 3, 3), 10, 10, true);
+ *
+ * @param x0
+ *      Left coordinate of the window on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the window on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the window on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the window on y-axis (1 greater than the largest index).
+ *
+ * @return
+ *      A view of the window.
+ *
+ * @throws
+ *      std::exception or sub-class if x0,y0 or x1,y1 are not valid coordinates within the grid
+ *      or if the window has a negative size.
+ */
+GridView Grid::view(const int x0, const int y0, const int x1, const int y1) const {
     if (x0 > this->get_width() || x0 < 0 ||
         x1 > this->get_width() || x1 < 0 ||
         y0 > this->get_height() || y0 < 0 ||
         y1 > this->get_height() || y1 < 0) {
         throw std::runtime_error(std::string("One of the arguments is not a valid coordinate!"));
     }
-    // Get the size of the new grid
-    const int cropped_width = x1 - x0;
-    const int cropped_height = y1 - y0;
-    if (cropped_width < 0 || cropped_height < 0) {
+    if (x1 - x0 < 0 || y1 - y0 < 0) {
         throw std::runtime_error(std::string("A window has a negative size!"));
     }
-    Grid g(cropped_width, cropped_height);
-    // j and i represent x and y of the original grid. We start at x0 until x1, at y0 until y1 because this is the part
-    // which should remain in the cropped grid.
-    // new_j and new_i represent x and y of the new grid. We need to fully iterate through it, so we start from 0.
-    for (int i = y0, new_i = 0; i < y1; i++, new_i++) {
-        for (int j = x0, new_j = 0; j < x1; j++, new_j++) {
-            if (this->get(j, i) == Cell::ALIVE) {
-                g(new_j, new_i) = Cell::ALIVE;
-            }
-        }
+    // An empty window never reads its cells, and row(y0) of an empty grid is not a valid pointer
+    if (x1 == x0 || y1 == y0) {
+        return GridView(nullptr, x1 - x0, y1 - y0, this->width);
     }
+    return GridView(this->row(y0) + x0, x1 - x0, y1 - y0, this->width);
+}
 
-    // Updating fields
-    this->width = cropped_width;
-    this->height = cropped_height;
-    this->grid = g.grid;
-    return g;
+/**
+ * GridView::get(x, y)
+ *
+ * Returns the value of the cell at a coordinate of the window, which is (x0 + x, y0 + y) in the grid.
+ *
+ * @throws
+ *      std::runtime_error if x,y is not a valid coordinate within the window.
+ */
+Cell GridView::get(const int x, const int y) const {
+    if (x >= this->width || x < 0) throw std::runtime_error(std::string("x is out of bounds!"));
+    if (y >= this->height || y < 0) throw std::runtime_error(std::string("y is out of bounds!"));
+    return this->row(y)[x];
+}
+
+/**
+ * GridView::get_alive_cells()
+ *
+ * @return
+ *      The number of alive cells in the window.
+ */
+int GridView::get_alive_cells() const {
+    int sum = 0;
+    for (int y = 0; y < this->height; y++) {
+        sum += static_cast<int>(std::count(this->row(y), this->row(y) + this->width, Cell::ALIVE));
+    }
+    return sum;
+}
+
+/**
+ * GridView::to_grid()
+ *
+ * Copies the cells of the window into a new grid of the window's size, a row at a time.
+ *
+ * @return
+ *      A grid holding a copy of the window.
+ */
+Grid GridView::to_grid() const {
+    Grid grid(this->width, this->height);
+    for (int y = 0; y < this->height; y++) {
+        // copy_n, unlike memcpy, is defined for the empty rows of a zero width window
+        std::copy_n(this->row(y), this->width, grid.row(y));
+    }
+    return grid;
 }
 
 
@@ -558,6 +798,8 @@ Grid Grid::crop(const int x0, const int y0, const int x1, const int y1) {
  *      - If a cell is originally dead it can be updated to be alive from the merge.
  *      - If a cell is originally alive it cannot be updated to be dead from the merge.
  *
+ * Both are done a row at a time with no branch per cell, see Grid::merge(view, x0, y0, alive_only).
+ *
  * @example
  *
  *      // Make two grids
@@ -586,49 +828,111 @@ Grid Grid::crop(const int x0, const int y0, const int x1, const int y1) {
  *      std::exception or sub-class if the other grid being placed does not fit within the bounds of the current grid.
  */
 void Grid::merge(const Grid &other, const int x0, const int y0) {
+    this->merge(other, x0, y0, false);
+}
+
+// Overloaded version does not allow alive cells to become dead
+void Grid::merge(const Grid &other, const int x0, const int y0, const bool alive_only) {
+    this->merge(other.view(0, 0, other.get_width(), other.get_height()), x0, y0, alive_only);
+}
+
+/**
+ * Grid::merge(other, x0, y0, alive_only = false)
+ *
+ * Merge a window of another grid, as made by Grid::view, onto the current grid at the desired location.
+ * Merging a view behaves exactly as merging a crop of the other grid would, without copying the crop first.
+ *
+ * A view of this grid itself must not overlap the range it is merged into.
+ *
+ * An overwriting merge copies each row with memmove. A merge of alive cells only ORs each row in, 8 cells to a
+ * word, which works on the cell values themselves, ' ' (0x20) for Cell::DEAD and '#' (0x23) for Cell::ALIVE:
+ *      - DEAD | DEAD is DEAD, while DEAD | ALIVE and ALIVE | ALIVE are both ALIVE.
+ *
+ * @example
+ *
+ *      // Stamp a row of the tails of gliders onto a board
+ *      const Grid glider = Zoo::glider();
+ *      const GridView tail = glider.view(0, 1, 3, 3);
+ *      for (int x = 0; x + 3 <= board.get_width(); x += 4) {
+ *          board.merge(tail, x, 0, true);
+ *      }
+ *
+ * @param other
+ *      The window to merge into the current grid.
+ *
+ * @param x0
+ *      The x coordinate of where to place the top left corner of the window.
+ *
+ * @param y0
+ *      The y coordinate of where to place the top left corner of the window.
+ *
+ * @param alive_only
+ *      Optional parameter. If true then merging only sets alive cells to alive. Defaults to false.
+ *
+ * @throws
+ *      std::exception or sub-class if the window being placed does not fit within the bounds of the current grid.
+ */
+void Grid::merge(const GridView &other, const int x0, const int y0, const bool alive_only) {
     if (other.get_width() > this->get_width() || other.get_height() > this->get_height()) {
         throw std::runtime_error(std::string
         ("The other grid doesn't fit within the bounds of the current one!"));
     }
-    if ((x0 < 0 || x0 > this->get_width()) || y0 < 0 || y0 > this->get_width()) {
+    if ((x0 < 0 || x0 > this->get_width()) || y0 < 0 || y0 > this->get_height()) {
         throw std::runtime_error(std::string("Either x or y is has a non-reasonable value!"));
     }
-    // i and j keep track of indexes in the original grid, new_i and new_j keep track of indexes in the other grid
-    for (int i = y0, new_i = 0; new_i < other.get_height(); i++, new_i++) {
-        for (int j = x0, new_j = 0; new_j < other.get_width(); j++, new_j++) {
-            //Set current cell to alive if matching cell from the other grid is alive
-            if (other.get(new_j, new_i) == Cell::ALIVE) {
-                (*this)(j, i) = Cell::ALIVE;
-            } else {
-                (*this)(j, i) = Cell::DEAD;
+    // The cells are written unchecked, so the whole of the other grid must land inside this one
+    if (x0 + other.get_width() > this->get_width() || y0 + other.get_height() > this->get_height()) {
+        throw std::runtime_error(std::string("The other grid doesn't fit within the bounds of the current one!"));
+    }
+    const int width = other.get_width();
+    if (width == 0) {
+        return;
+    }
+    for (int i = 0; i < other.get_height(); i++) {
+        const Cell *source = other.row(i);
+        Cell *target = this->row(y0 + i) + x0;
+        if (!alive_only) {
+            std::memmove(target, source, static_cast<std::size_t>(width) * sizeof(Cell));
+        } else {
+            // OR 8 cells at a time as a word, then the remainder one by one
+            int j = 0;
+            for (; j + 8 <= width; j += 8) {
+                std::uint64_t cells, others;
+                std::memcpy(&cells, target + j, sizeof(cells));
+                std::memcpy(&others, source + j, sizeof(others));
+                cells |= others;
+                std::memcpy(target + j, &cells, sizeof(cells));
+            }
+            for (; j < width; j++) {
+                target[j] = static_cast<Cell>(target[j] | source[j]);
             }
         }
     }
-
 }
 
-// Overloaded version does not allow alive cells to become dead
-void Grid::merge(const Grid &other, const int x0, const int y0, const bool alive_only) {
-    if (!alive_only) {
-        merge(other, x0, y0);
-    } else {
-        if (other.get_width() > this->get_width() || other.get_height() > this->get_height()) {
-            throw std::runtime_error(std::string
-                                             ("The other grid doesn't fit within the bounds of the current one!"));
-        }
-        if ((x0 < 0 || x0 > this->get_width()) || y0 < 0 || y0 > this->get_width()) {
-            throw std::runtime_error(std::string("Either x or y is has a non-reasonable value!"));
-        }
-        // i and j keep track of indexes in the original grid, new_i and new_j keep track of indexes in the other grid
-        for (int i = y0, new_i = 0; new_i < other.get_height(); i++, new_i++) {
-            for (int j = x0, new_j = 0; new_j < other.get_width(); j++, new_j++) {
-                // if current cell is alive but the other is dead, don't change anything
-                // if current cell is dead but the other is alive, make current alive
-                if ((other.get(new_j, new_i) == Cell::DEAD && this->get(j, i) == Cell::ALIVE) ||
-                    (other.get(new_j, new_i) == Cell::ALIVE && this->get(j, i) == Cell::DEAD)) {
-                    (*this)(j, i) = Cell::ALIVE;
+/**
+ * Copies every cell of a grid into a grid of the swapped size, a quarter turn clockwise for turn = 1,
+ * anticlockwise for turn = -1, or transposed for turn = 0.
+ * The cells are copied a BLOCK_SIZE x BLOCK_SIZE block at a time, so the rows of the block being read and the
+ * rows of the block being written all stay in cache, instead of missing on every cell of a column.
+ */
+static void copy_turned(const Grid &in, Grid &out, const int turn, const int block_size) {
+    const int width = in.get_width(), height = in.get_height();
+    for (int y0 = 0; y0 < height; y0 += block_size) {
+        const int y1 = std::min(y0 + block_size, height);
+        for (int x0 = 0; x0 < width; x0 += block_size) {
+            const int x1 = std::min(x0 + block_size, width);
+            // Column x of the source becomes a row of the result, written in order
+            for (int x = x0; x < x1; x++) {
+                Cell *target = out.row(turn < 0 ? width - 1 - x : x);
+                if (turn > 0) {
+                    for (int y = y0; y < y1; y++) {
+                        target[height - 1 - y] = in.row(y)[x];
+                    }
                 } else {
-                    (*this)(j, i) = Cell::DEAD;
+                    for (int y = y0; y < y1; y++) {
+                        target[y] = in.row(y)[x];
+                    }
                 }
             }
         }
@@ -643,6 +947,9 @@ void Grid::merge(const Grid &other, const int x0, const int y0, const bool alive
  * The function should take the same amount of time to execute for any valid integer input.
  * The function should be callable from a constant context.
  *
+ * Quarter turns are copied in cache sized blocks, see Grid::transpose(), and half turns are the cells
+ * copied in reverse, see Grid::rotate_180().
+ *
  * @example
  *
  *      // Make a 1x3 grid
@@ -658,52 +965,85 @@ void Grid::merge(const Grid &other, const int x0, const int y0, const bool alive
  *      Returns a copy of the grid that has been rotated.
  */
 Grid Grid::rotate(const int rotation) const {
-    // Note: Time Complexity: O(n^2). Access complexity: O(1) in EVERY CASE except when rotation = 0 and multiples.
-    Grid newgrid;
-    int actual_rotation = rotation;
-    // Any rotation can be brought down to 4 cases => 0, 90 ,-90, 180 degrees, so when a user passes e.g 3 (270 degree)
-    // it will be equivalent to -1 (-90 degree) rotation. actual_rotation will get this number and then apply it
-    // for the further calculations.
-    while (!(actual_rotation == 0 || actual_rotation == 1 || actual_rotation == -1 || actual_rotation == 2
-             || actual_rotation == -2)) {
-        if (actual_rotation > 0) {
-            actual_rotation -= 4;
-        } else {
-            actual_rotation += 4;
-        }
-    }
+    // Any rotation is one of 4 quarter turns clockwise, e.g. 3 (270 degree) is the same as -1 (-90 degree)
+    const int turns = ((rotation % 4) + 4) % 4;
 
     // If rotation angle is 360 degrees, create a copy of a current grid and return
-    if (actual_rotation == 0 || abs(actual_rotation) % 4 == 0) {
-        newgrid = *this;
-        return newgrid;
+    if (turns == 0) {
+        return *this;
     }
-    // If rotation angle is a multiple of 180 degrees, the new grid will have the same dimensions as the current one
-    if (abs(actual_rotation) % 2 == 0) {
-        newgrid = Grid(this->width, this->height);
-        for (int i = 0, new_i = this->height - 1; i < this->height; i++, new_i--) {
-            for (int j = 0, new_j = this->width - 1; j < this->width; j++, new_j--) {
-                newgrid(j, i) = (*this)(new_j, new_i);
-            }
-        }
-        // If rotation angle is a multiple of 90 degrees, the new grid will have inverted dimensions
-    } else {
-        newgrid = Grid(this->height, this->width);
-        // new_i keeps track of the correct index during CCW rotation and new_j during CW rotation.
-        for (int i = 0, new_i = this->width - 1; i < newgrid.height; i++, new_i--) {
-            for (int j = 0, new_j = newgrid.width - 1; j < newgrid.width; j++, new_j--) {
-                // If CW apply first formula, if CCW apply another...
-                if (actual_rotation > 0) {
-                    newgrid(j, i) = (*this)(i, new_j);
-                } else {
-                    newgrid(j, i) = (*this)(new_i, j);
-                }
-            }
-        }
+    // If rotation angle is 180 degrees, the new grid will have the same dimensions as the current one
+    if (turns == 2) {
+        Grid newgrid(this->width, this->height);
+        std::reverse_copy(this->grid.begin(), this->grid.end(), newgrid.grid.begin());
+        return newgrid;
     }
+    // If rotation angle is 90 degrees either way, the new grid will have inverted dimensions
+    Grid newgrid(this->height, this->width);
+    copy_turned(*this, newgrid, turns == 1 ? 1 : -1, BLOCK_SIZE);
+    return newgrid;
+}
+
+/**
+ * Grid::transpose()
+ *
+ * Create a copy of the grid with its rows and columns swapped, the cell at (x, y) moving to (y, x).
+ * The cells are copied a BLOCK_SIZE x BLOCK_SIZE block at a time, so reading one grid along its columns
+ * does not miss the cache on every cell.
+ *
+ * @example
+ *
+ *      // Make a 2x5 grid
+ *      Grid x(2, 5);
+ *
+ *      // y is size 5x2
+ *      Grid y = x.transpose();
+ *
+ * @return
+ *      A transposed copy of the grid.
+ */
+Grid Grid::transpose() const {
+    Grid newgrid(this->height, this->width);
+    copy_turned(*this, newgrid, 0, BLOCK_SIZE);
     return newgrid;
+}
+
+/**
+ * Grid::rotate_180()
+ *
+ * Rotate the grid by 180 degrees in place, without allocating.
+ * Rows are stored one after another, so turning the grid half way round is reversing all of its cells.
+ *
+ * @example
+ *
+ *      // Turn an imported pattern upside down before merging it
+ *      pattern.rotate_180();
+ *      board.merge(pattern, 10, 10);
+ */
+void Grid::rotate_180() {
+    std::reverse(this->grid.begin(), this->grid.end());
+}
 
+/**
+ * Grid::mirror_horizontal()
+ *
+ * Mirror the grid in place from left to right, the cell at (x, y) moving to (width - 1 - x, y).
+ */
+void Grid::mirror_horizontal() {
+    for (int y = 0; y < this->height; y++) {
+        std::reverse(this->row(y), this->row(y) + this->width);
+    }
+}
 
+/**
+ * Grid::mirror_vertical()
+ *
+ * Mirror the grid in place from top to bottom, the cell at (x, y) moving to (x, height - 1 - y).
+ */
+void Grid::mirror_vertical() {
+    for (int top = 0, bottom = this->height - 1; top < bottom; top++, bottom--) {
+        std::swap_ranges(this->row(top), this->row(top) + this->width, this->row(bottom));
+    }
 }
 
 /**
@@ -742,30 +1082,19 @@ Grid Grid::rotate(const int rotation) const {
  *      Returns a reference to the output stream to enable operator chaining.
  */
 std::ostream &operator<<(std::ostream &os, const Grid &g) {
-    std::string border;
-    os << "+";
-    border += "+";
-    for (int i = 0; i < g.width; i++) {
-        os << "-";
-        border += "-";
-    }
-    os << "+" << std::endl;
-    border += "+";
-
+    // Build the whole frame first and write it at once, cells are stored as their own characters
+    const std::string border = "+" + std::string(g.width, '-') + "+\n";
+    std::string frame;
+    frame.reserve(border.size() * (g.height + 2));
+    frame += border;
     for (int i = 0; i < g.height; i++) {
-        os << "|";
-        for (int j = 0; j < g.width; j++) {
-            if (g.get(j, i) == Cell::ALIVE) {
-                os << "#";
-            } else {
-                os << " ";
-            }
-        }
-        os << "|" << std::endl;
+        const char *row = reinterpret_cast<const char *>(g.grid.data()) + static_cast<std::size_t>(i) * g.width;
+        frame += '|';
+        frame.append(row, g.width);
+        frame += "|\n";
     }
-
-
-    os << border;
+    frame.append(border, 0, border.size() - 1);
+    os.write(frame.data(), static_cast<std::streamsize>(frame.size()));
     os << std::endl;
     return os;
 }
@@ -10,8 +10,10 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <iostream>
 #include <vector>
+#include "allocator.h"
 
 /**
  * A Cell is a char limited to two named values for Cell::DEAD and Cell::ALIVE.
@@ -21,16 +23,81 @@ enum Cell : char {
     ALIVE = '#'
 };
 
+/**
+ * A view of the contiguous cells of one row, in the manner of std::span. No bounds checking is performed.
+ */
+template<typename T>
+class RowView {
+private:
+    T *first;
+
+    int length;
+
+public:
+    RowView(T *first, const int length) : first(first), length(length) {}
+
+    T *begin() const { return this->first; }
+
+    T *end() const { return this->first + this->length; }
+
+    int size() const { return this->length; }
+
+    T &operator[](const int x) const { return this->first[x]; }
+};
+
+class Grid;
+
+/**
+ * A read-only window onto the cells of a Grid, made by Grid::view without copying any cells.
+ * The view is only valid while the grid it was made from is still alive and has not been resized.
+ */
+class GridView {
+private:
+    const Cell *first;                               // The top left cell of the window
+
+    int width, height;
+
+    int stride;                                      // Cells from one row of the window to the next
+
+public:
+    GridView(const Cell *first, const int width, const int height, const int stride)
+            : first(first), width(width), height(height), stride(stride) {}
+
+    // Member functions
+    int get_width() const { return this->width; }
+
+    int get_height() const { return this->height; }
+
+    int get_alive_cells() const;
+
+    // Returns the value of the cell at the desired coordinate of the window
+    Cell get(const int x, const int y) const;
+
+    // Raw access to the cells of a row of the window, no bounds checking is performed
+    const Cell *row(const int y) const { return this->first + static_cast<std::size_t>(y) * this->stride; }
+
+    RowView<const Cell> row_view(const int y) const { return RowView<const Cell>(this->row(y), this->width); }
+
+    // Copies the cells of the window into a grid of its own
+    Grid to_grid() const;
+};
+
 /**
  * Declare the structure of the Grid class for representing a 2d grid of cells.
+ *
+ * Grid::operator(), Grid::get and Grid::set check their coordinates and are the access for external callers.
+ * Loops which already stay within the grid use the unchecked tier instead, Grid::at_unchecked, Grid::row and
+ * Grid::row_view, which are defined inline so the compiler can hoist and vectorise them.
  */
 class Grid {
 private:
     int width, height;
 
-    std::vector<Cell> grid;                          // 2D Vector for storing the grid
+    std::vector<Cell, BufferAllocator<Cell> > grid;  // 2D Vector for storing the grid, cache line aligned
 
     int get_index(const int x, const int y) const;   // Gets 1D index of a 2D coordinate
+
+    static const int BLOCK_SIZE = 32;                // Edge of the blocks rotate and transpose copy at a time
 public:
     // Public functions
     Grid();                                          // Default Constructor with grid size = 0
@@ -39,6 +106,17 @@ public:
 
     Grid(const int width, const int height);         // Overloaded Constructor with grid size = width*height
 
+    Grid(const Grid &other) = default;
+
+    Grid(Grid &&other) noexcept;                     // Takes the cells over, leaving other an empty 0x0 grid
+
+    Grid &operator=(const Grid &other) = default;
+
+    Grid &operator=(Grid &&other) noexcept;          // Takes the cells over, leaving other an empty 0x0 grid
+
+    // A grid whose cells are allocated but not yet written, every cell must be written before it is read
+    static Grid untouched(const int width, const int height);
+
     Cell &operator()(const int x, const int y);
 
     Cell &operator()(const int x, const int y) const;
@@ -66,8 +144,25 @@ public:
     // Updates the value of the cell at the desired coordinate
     void set(const int x, const int y, const Cell value);
 
+    // Raw access to the cells of a row, no bounds checking is performed
+    Cell *row(const int y) { return this->grid.data() + static_cast<std::size_t>(y) * this->width; }
+
+    const Cell *row(const int y) const { return this->grid.data() + static_cast<std::size_t>(y) * this->width; }
+
+    RowView<Cell> row_view(const int y) { return RowView<Cell>(this->row(y), this->width); }
+
+    RowView<const Cell> row_view(const int y) const { return RowView<const Cell>(this->row(y), this->width); }
+
+    // Access to a cell without bounds checking, x and y must be within the grid
+    Cell &at_unchecked(const int x, const int y) { return this->row(y)[x]; }
+
+    Cell at_unchecked(const int x, const int y) const { return this->row(y)[x]; }
+
     // Crops the grid w.r.t specified range
-    Grid crop(const int x0,const  int y0,const  int x1,const  int y1);
+    Grid crop(const int x0,const  int y0,const  int x1,const  int y1) const;
+
+    // A view of the range a crop would copy, sharing the cells of this grid
+    GridView view(const int x0, const int y0, const int x1, const int y1) const;
 
     // Merges the other grid into the current one w.r.t x0, y0
     void merge(const Grid& other, const int x0, const int y0);
@@ -75,9 +170,24 @@ public:
     // An overloaded variant might not allow alive cells to die
     void merge(const Grid &other, const int x0, const int y0,const  bool alive_only);
 
+    // Merges a window of another grid, e.g. a crop of a Zoo pattern, without copying it first
+    void merge(const GridView &other, const int x0, const int y0, const bool alive_only = false);
+
     // Creates a rotated to a multiple of 90 degrees copy of a grid.
     // Same computation time will apply for any rotation coefficient
     Grid rotate(const int rotation) const;
 
+    // Creates a copy with the rows and columns swapped
+    Grid transpose() const;
+
+    // Rotates the grid by 180 degrees without a copy
+    void rotate_180();
+
+    // Mirrors the grid left to right without a copy
+    void mirror_horizontal();
+
+    // Mirrors the grid top to bottom without a copy
+    void mirror_vertical();
+
 
 };
\ No newline at end of file
@@ -0,0 +1,872 @@
+/**
+ * Implements a class simulating the Game of Life on an unbounded plane using the HashLife algorithm.
+ *      - https://en.wikipedia.org/wiki/Hashlife
+ *
+ *      - The plane is a quadtree. A node of level k is a 2^k by 2^k square made of four level k - 1 children,
+ *        level 0 nodes are single cells.
+ *          - Nodes are hash-consed: HashWorld::join returns the one canonical node for any four children,
+ *            so identical squares are shared no matter where or when they occur.
+ *
+ *      - The result of a level k node is its centre 2^(k-1) square advanced 2^j generations, for any j <= k - 2.
+ *          - The result only depends on the node itself, so it is memoised on the node and reused everywhere
+ *            the same square appears again.
+ *          - It is computed recursively from the nine overlapping level k - 1 sub-squares of the node.
+ *
+ *      - Advancing 2^j generations first surrounds the pattern with enough empty space that nothing can escape
+ *        the centre of the root, then replaces the root with its result.
+ *
+ *      - Unlike World the plane has no edges. A HashWorld built from a Grid gives the same cells as a World
+ *        built from the same Grid for as long as the pattern stays clear of the edges of the World.
+ *
+ *      - Memory use grows with every distinct node ever seen. Nodes unreachable from the current state are
+ *        discarded by HashWorld::collect_garbage, which also runs automatically once the node count doubles.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "hashlife.h"
+#include <algorithm>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Collect garbage automatically when the number of nodes passes this many
+static const std::size_t MIN_GC_NODES = static_cast<std::size_t>(1) << 22;
+
+bool HashWorld::NodeKey::operator==(const NodeKey &other) const {
+    return nw == other.nw && ne == other.ne && sw == other.sw && se == other.se;
+}
+
+std::size_t HashWorld::NodeKeyHash::operator()(const NodeKey &key) const {
+    std::uint64_t hash = reinterpret_cast<std::uintptr_t>(key.nw);
+    hash = hash * 0x9E3779B97F4A7C15ull + reinterpret_cast<std::uintptr_t>(key.ne);
+    hash = hash * 0x9E3779B97F4A7C15ull + reinterpret_cast<std::uintptr_t>(key.sw);
+    hash = hash * 0x9E3779B97F4A7C15ull + reinterpret_cast<std::uintptr_t>(key.se);
+    return static_cast<std::size_t>(hash ^ (hash >> 29));
+}
+
+/**
+ * HashWorld::HashWorld()
+ *
+ * Construct an empty plane at generation 0.
+ *
+ * @example
+ *
+ *      // Make an empty plane and draw a blinker on it
+ *      HashWorld world;
+ *      world.set(0, 0, Cell::ALIVE);
+ *      world.set(1, 0, Cell::ALIVE);
+ *      world.set(2, 0, Cell::ALIVE);
+ *
+ */
+HashWorld::HashWorld() : gc_threshold(MIN_GC_NODES) {
+    this->reset();
+}
+
+/**
+ * HashWorld::HashWorld(initial_state)
+ *
+ * Construct a plane containing the cells of a grid, with cell (x, y) of the grid placed at (x, y) on the plane.
+ *
+ * @example
+ *
+ *      // Jump an r-pentomino a billion generations into the future
+ *      HashWorld world(Zoo::r_pentomino());
+ *      world.advance(1000000000);
+ *
+ * @param initial_state
+ *      The grid to copy the cells from.
+ */
+HashWorld::HashWorld(const Grid &initial_state) : HashWorld() {
+    const int size = std::max(initial_state.get_width(), initial_state.get_height());
+    int level = 3;
+    while ((static_cast<std::int64_t>(1) << (level - 1)) < size) {
+        level++;
+    }
+    const int half = 1 << (level - 1);
+    this->root = this->build(initial_state, -half, -half, level);
+}
+
+/**
+ * HashWorld::HashWorld(other)
+ *
+ * Construct a copy of another plane. Only the nodes reachable from its current state are copied.
+ *
+ * @param other
+ *      The plane to copy.
+ */
+HashWorld::HashWorld(const HashWorld &other) : HashWorld() {
+    *this = other;
+}
+
+/**
+ * HashWorld::operator=(other)
+ *
+ * Replace the state of this plane with a copy of another. Only the nodes reachable from its current
+ * state are copied, memoised results are not.
+ *
+ * @param other
+ *      The plane to copy.
+ *
+ * @return
+ *      A reference to this plane.
+ */
+HashWorld &HashWorld::operator=(const HashWorld &other) {
+    if (this != &other) {
+        this->reset();
+        std::unordered_map<const Node *, Node *> copied;
+        this->root = other.copy_into(other.root, *this, copied);
+        this->generation = other.generation;
+        this->rule = other.rule;
+    }
+    return *this;
+}
+
+/**
+ * HashWorld::reset()
+ *
+ * Private helper function discarding every node and restoring an empty plane at generation 0.
+ */
+void HashWorld::reset() {
+    this->table.clear();
+    this->nodes.clear();
+    this->nodes.push_back(Node{nullptr, nullptr, nullptr, nullptr, nullptr, 0, -1, 0});
+    this->dead = &this->nodes.back();
+    this->nodes.push_back(Node{nullptr, nullptr, nullptr, nullptr, nullptr, 0, -1, 1});
+    this->alive = &this->nodes.back();
+    this->empty_nodes.assign(1, this->dead);
+    this->root = this->empty(3);
+    this->generation = 0;
+}
+
+/**
+ * HashWorld::join(nw, ne, sw, se)
+ *
+ * Private helper function returning the canonical node with the given children, creating it on first use.
+ * All four children must have the same level.
+ *
+ * @return
+ *      The node one level above its children.
+ */
+HashWorld::Node *HashWorld::join(Node *nw, Node *ne, Node *sw, Node *se) {
+    const NodeKey key = {nw, ne, sw, se};
+    const auto found = this->table.find(key);
+    if (found != this->table.end()) {
+        return found->second;
+    }
+    this->nodes.push_back(Node{nw, ne, sw, se, nullptr, nw->level + 1, -1,
+                               nw->population + ne->population + sw->population + se->population});
+    Node *node = &this->nodes.back();
+    this->table.emplace(key, node);
+    return node;
+}
+
+/**
+ * HashWorld::empty(level)
+ *
+ * Private helper function returning the canonical node of a level containing only dead cells.
+ */
+HashWorld::Node *HashWorld::empty(const int level) {
+    while (static_cast<int>(this->empty_nodes.size()) <= level) {
+        Node *below = this->empty_nodes.back();
+        Node *above = this->join(below, below, below, below);
+        this->empty_nodes.push_back(above);
+    }
+    return this->empty_nodes[level];
+}
+
+/**
+ * HashWorld::centre(node)
+ *
+ * Private helper function returning the centre half of a node of level 2 or more, at the same generation.
+ */
+HashWorld::Node *HashWorld::centre(Node *node) {
+    return this->join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+}
+
+/**
+ * HashWorld::step_base(node)
+ *
+ * Private helper function advancing the centre 2x2 of a 4x4 node by a single generation,
+ * by applying the rule to the cells directly. Every memoised result is built from these, so each result
+ * belongs to the rule that was selected when it was computed.
+ */
+HashWorld::Node *HashWorld::step_base(Node *node) {
+    // Unpack the 16 cells, bit (y * 4 + x) is the cell at x, y
+    int cells = 0;
+    Node *quadrants[4] = {node->nw, node->ne, node->sw, node->se};
+    for (int q = 0; q < 4; q++) {
+        const int qx = (q % 2) * 2, qy = (q / 2) * 2;
+        Node *children[4] = {quadrants[q]->nw, quadrants[q]->ne, quadrants[q]->sw, quadrants[q]->se};
+        for (int c = 0; c < 4; c++) {
+            if (children[c]->population) {
+                cells |= 1 << ((qy + c / 2) * 4 + qx + c % 2);
+            }
+        }
+    }
+    Node *next[4];
+    for (int c = 0; c < 4; c++) {
+        const int x = 1 + c % 2, y = 1 + c / 2;
+        int neighbours = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (dx != 0 || dy != 0) {
+                    neighbours += (cells >> ((y + dy) * 4 + x + dx)) & 1;
+                }
+            }
+        }
+        const bool was_alive = (cells >> (y * 4 + x)) & 1;
+        next[c] = this->rule.next(was_alive, neighbours) ? this->alive : this->dead;
+    }
+    return this->join(next[0], next[1], next[2], next[3]);
+}
+
+/**
+ * HashWorld::successor(node, step_log2)
+ *
+ * Private helper function returning the centre half of a node advanced 2^step_log2 generations.
+ * The node must have a level of at least step_log2 + 2, so the light cone of the centre stays within it.
+ *
+ * The node is split into nine overlapping sub-squares of half its size. Each is advanced by half the steps
+ * (or not at all, for smaller steps), recombined into four squares, and those advanced by the remaining steps.
+ * Results are memoised on the node for the step size they were computed with.
+ *
+ * @param node
+ *      The node to advance.
+ *
+ * @param step_log2
+ *      Log2 of the number of generations to advance.
+ *
+ * @return
+ *      A node one level below the given one.
+ */
+HashWorld::Node *HashWorld::successor(Node *node, const int step_log2) {
+    const int level = node->level;
+    if (node->population == 0) {
+        return this->empty(level - 1);
+    }
+    if (node->result != nullptr && node->result_log2 == step_log2) {
+        return node->result;
+    }
+
+    Node *result;
+    if (level == 2) {
+        result = this->step_base(node);
+    } else {
+        Node *nw = node->nw, *ne = node->ne, *sw = node->sw, *se = node->se;
+        Node *squares[9] = {
+                nw, this->join(nw->ne, ne->nw, nw->se, ne->sw), ne,
+                this->join(nw->sw, nw->se, sw->nw, sw->ne), this->centre(node), this->join(ne->sw, ne->se, se->nw, se->ne),
+                sw, this->join(sw->ne, se->nw, sw->se, se->sw), se
+        };
+        // At full speed both halves advance, otherwise only the second one does
+        const bool full_speed = step_log2 == level - 2;
+        const int second_log2 = full_speed ? step_log2 - 1 : step_log2;
+        Node *r[9];
+        for (int i = 0; i < 9; i++) {
+            r[i] = full_speed ? this->successor(squares[i], step_log2 - 1) : this->centre(squares[i]);
+        }
+        result = this->join(this->successor(this->join(r[0], r[1], r[3], r[4]), second_log2),
+                            this->successor(this->join(r[1], r[2], r[4], r[5]), second_log2),
+                            this->successor(this->join(r[3], r[4], r[6], r[7]), second_log2),
+                            this->successor(this->join(r[4], r[5], r[7], r[8]), second_log2));
+    }
+    node->result = result;
+    node->result_log2 = step_log2;
+    return result;
+}
+
+/**
+ * HashWorld::expand(node)
+ *
+ * Private helper function returning a node twice the size of the given one, with the given node in its centre.
+ */
+HashWorld::Node *HashWorld::expand(Node *node) {
+    Node *border = this->empty(node->level - 1);
+    return this->join(this->join(border, border, border, node->nw),
+                      this->join(border, border, node->ne, border),
+                      this->join(border, node->sw, border, border),
+                      this->join(node->se, border, border, border));
+}
+
+/**
+ * HashWorld::is_padded(node)
+ *
+ * Private helper function checking if every alive cell of a node lies within its inner quarter,
+ * the 2^(level-2) square in its centre. Nodes below level 3 are never considered padded.
+ */
+bool HashWorld::is_padded(const Node *node) const {
+    if (node->level < 3) {
+        return false;
+    }
+    return node->population == node->nw->se->se->population + node->ne->sw->sw->population +
+                               node->sw->ne->ne->population + node->se->nw->nw->population;
+}
+
+/**
+ * HashWorld::build(grid, x0, y0, level)
+ *
+ * Private helper function building the node for the 2^level square with its top left corner at x0, y0
+ * in the coordinates of a grid. Cells outside the grid are dead.
+ */
+HashWorld::Node *HashWorld::build(const Grid &grid, const int x0, const int y0, const int level) {
+    const std::int64_t size = static_cast<std::int64_t>(1) << level;
+    if (x0 >= grid.get_width() || y0 >= grid.get_height() || x0 + size <= 0 || y0 + size <= 0) {
+        return this->empty(level);
+    }
+    if (level == 0) {
+        return grid.at_unchecked(x0, y0) == Cell::ALIVE ? this->alive : this->dead;
+    }
+    const int half = static_cast<int>(size / 2);
+    return this->join(this->build(grid, x0, y0, level - 1), this->build(grid, x0 + half, y0, level - 1),
+                      this->build(grid, x0, y0 + half, level - 1),
+                      this->build(grid, x0 + half, y0 + half, level - 1));
+}
+
+/**
+ * HashWorld::set_cell(node, x, y, value)
+ *
+ * Private helper function returning a copy of a node with the cell at x, y relative to its top left corner
+ * replaced. Only the nodes along the path to the cell are rebuilt.
+ */
+HashWorld::Node *HashWorld::set_cell(Node *node, const std::int64_t x, const std::int64_t y, const bool value) {
+    if (node->level == 0) {
+        return value ? this->alive : this->dead;
+    }
+    const std::int64_t half = static_cast<std::int64_t>(1) << (node->level - 1);
+    Node *nw = node->nw, *ne = node->ne, *sw = node->sw, *se = node->se;
+    if (y < half) {
+        if (x < half) nw = this->set_cell(nw, x, y, value);
+        else ne = this->set_cell(ne, x - half, y, value);
+    } else {
+        if (x < half) sw = this->set_cell(sw, x, y - half, value);
+        else se = this->set_cell(se, x - half, y - half, value);
+    }
+    return this->join(nw, ne, sw, se);
+}
+
+/**
+ * HashWorld::copy_into(node, other, copied)
+ *
+ * Private helper function re-creating a node of this plane, and everything below it, in another plane.
+ * Nodes shared within the tree are copied once, tracked by the copied map.
+ */
+HashWorld::Node *HashWorld::copy_into(const Node *node, HashWorld &other,
+                                      std::unordered_map<const Node *, Node *> &copied) const {
+    if (node->level == 0) {
+        return node->population ? other.alive : other.dead;
+    }
+    const auto found = copied.find(node);
+    if (found != copied.end()) {
+        return found->second;
+    }
+    Node *copy = other.join(this->copy_into(node->nw, other, copied), this->copy_into(node->ne, other, copied),
+                            this->copy_into(node->sw, other, copied), this->copy_into(node->se, other, copied));
+    copied.emplace(node, copy);
+    return copy;
+}
+
+/**
+ * HashWorld::get_alive_cells()
+ *
+ * Counts how many cells on the plane are alive, in constant time.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+std::uint64_t HashWorld::get_alive_cells() const {
+    return this->root->population;
+}
+
+/**
+ * HashWorld::get_generation()
+ *
+ * Gets the number of generations the plane has been advanced since it was constructed.
+ *
+ * @return
+ *      The current generation.
+ */
+std::uint64_t HashWorld::get_generation() const {
+    return this->generation;
+}
+
+/**
+ * HashWorld::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate. Every coordinate is valid on the unbounded plane.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      The value of the desired cell.
+ */
+Cell HashWorld::get(const std::int64_t x, const std::int64_t y) const {
+    const std::int64_t half = static_cast<std::int64_t>(1) << (this->root->level - 1);
+    if (x < -half || x >= half || y < -half || y >= half) {
+        return Cell::DEAD;
+    }
+    const Node *node = this->root;
+    std::int64_t rx = x + half, ry = y + half;
+    while (node->level > 0 && node->population > 0) {
+        const std::int64_t quarter = static_cast<std::int64_t>(1) << (node->level - 1);
+        const bool east = rx >= quarter, south = ry >= quarter;
+        node = south ? (east ? node->se : node->sw) : (east ? node->ne : node->nw);
+        rx -= east ? quarter : 0;
+        ry -= south ? quarter : 0;
+    }
+    return node->population ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * HashWorld::set(x, y, value)
+ *
+ * Overwrites the value at the desired coordinate, growing the plane's root if needed.
+ *
+ * @param x
+ *      The x coordinate of the cell to update.
+ *
+ * @param y
+ *      The y coordinate of the cell to update.
+ *
+ * @param value
+ *      The value to be written to the selected cell.
+ *
+ * @throws
+ *      std::runtime_error if the coordinate is too far from the origin to be represented.
+ */
+void HashWorld::set(const std::int64_t x, const std::int64_t y, const Cell value) {
+    for (;;) {
+        const std::int64_t half = static_cast<std::int64_t>(1) << (this->root->level - 1);
+        if (x >= -half && x < half && y >= -half && y < half) {
+            this->root = this->set_cell(this->root, x + half, y + half, value == Cell::ALIVE);
+            return;
+        }
+        if (this->root->level >= MAX_LEVEL) {
+            throw std::runtime_error(std::string("The coordinate is too far from the origin!"));
+        }
+        this->root = this->expand(this->root);
+    }
+}
+
+/**
+ * Finds the smallest offset of an alive cell along one axis of a node, or -1 if the node is empty.
+ * The near children are the west ones (or north ones) and the far children the east (or south) ones.
+ */
+static std::int64_t nearest_alive(const HashWorld::Node *node, const bool horizontal, const bool reverse,
+                                  std::unordered_map<const HashWorld::Node *, std::int64_t> &memo) {
+    if (node->population == 0) {
+        return -1;
+    }
+    if (node->level == 0) {
+        return 0;
+    }
+    const auto found = memo.find(node);
+    if (found != memo.end()) {
+        return found->second;
+    }
+    const std::int64_t half = static_cast<std::int64_t>(1) << (node->level - 1);
+    // Searching horizontally the west children are near, vertically the north ones are
+    const HashWorld::Node *near_a = node->nw, *far_b = node->se;
+    const HashWorld::Node *near_b = horizontal ? node->sw : node->ne;
+    const HashWorld::Node *far_a = horizontal ? node->ne : node->sw;
+    if (reverse) {
+        std::swap(near_a, far_a);
+        std::swap(near_b, far_b);
+    }
+    std::int64_t best = -1;
+    for (const HashWorld::Node *child : {near_a, near_b}) {
+        const std::int64_t offset = nearest_alive(child, horizontal, reverse, memo);
+        if (offset >= 0 && (best < 0 || offset < best)) best = offset;
+    }
+    if (best < 0) {
+        for (const HashWorld::Node *child : {far_a, far_b}) {
+            const std::int64_t offset = nearest_alive(child, horizontal, reverse, memo);
+            if (offset >= 0 && (best < 0 || offset + half < best)) best = offset + half;
+        }
+    }
+    memo.emplace(node, best);
+    return best;
+}
+
+/**
+ * HashWorld::get_bounds(x0, y0, x1, y1)
+ *
+ * Finds the bounding box of the alive cells, spanning [x0, x1) by [y0, y1).
+ * Each edge is found by searching the quadtree from that side, so the cost depends on the number of
+ * distinct nodes rather than on the area of the pattern.
+ *
+ * @example
+ *
+ *      std::int64_t x0, y0, x1, y1;
+ *      if (world.get_bounds(x0, y0, x1, y1)) {
+ *          std::cout << (x1 - x0) << "x" << (y1 - y0) << std::endl;
+ *      }
+ *
+ * @return
+ *      False if there are no alive cells, in which case the bounds are not written.
+ */
+bool HashWorld::get_bounds(std::int64_t &x0, std::int64_t &y0, std::int64_t &x1, std::int64_t &y1) const {
+    if (this->root->population == 0) {
+        return false;
+    }
+    const std::int64_t size = static_cast<std::int64_t>(1) << this->root->level;
+    const std::int64_t half = size / 2;
+    std::unordered_map<const Node *, std::int64_t> memo;
+    x0 = nearest_alive(this->root, true, false, memo) - half;
+    memo.clear();
+    x1 = half - nearest_alive(this->root, true, true, memo);
+    memo.clear();
+    y0 = nearest_alive(this->root, false, false, memo) - half;
+    memo.clear();
+    y1 = half - nearest_alive(this->root, false, true, memo);
+    return true;
+}
+
+/**
+ * Copies the alive cells of a node whose top left corner is at ox, oy into the window of a grid at x0, y0.
+ */
+static void fill_grid(const HashWorld::Node *node, const std::int64_t ox, const std::int64_t oy,
+                      Grid &grid, const std::int64_t x0, const std::int64_t y0) {
+    const std::int64_t size = static_cast<std::int64_t>(1) << node->level;
+    if (node->population == 0 || ox >= x0 + grid.get_width() || oy >= y0 + grid.get_height() ||
+        ox + size <= x0 || oy + size <= y0) {
+        return;
+    }
+    if (node->level == 0) {
+        grid.at_unchecked(static_cast<int>(ox - x0), static_cast<int>(oy - y0)) = Cell::ALIVE;
+        return;
+    }
+    const std::int64_t half = size / 2;
+    fill_grid(node->nw, ox, oy, grid, x0, y0);
+    fill_grid(node->ne, ox + half, oy, grid, x0, y0);
+    fill_grid(node->sw, ox, oy + half, grid, x0, y0);
+    fill_grid(node->se, ox + half, oy + half, grid, x0, y0);
+}
+
+/**
+ * HashWorld::to_grid(x0, y0, x1, y1)
+ *
+ * Copies a window of the plane into a grid, so it can be printed, saved with Zoo or stepped with World.
+ * Cell (x0, y0) of the plane becomes cell (0, 0) of the grid.
+ *
+ * @example
+ *
+ *      // Look at the 32x32 square around the origin
+ *      Grid grid = world.to_grid(-16, -16, 16, 16);
+ *
+ * @return
+ *      A grid of size (x1 - x0) by (y1 - y0).
+ *
+ * @throws
+ *      std::runtime_error if the window has a negative size or is too large for a Grid.
+ */
+Grid HashWorld::to_grid(const std::int64_t x0, const std::int64_t y0, const std::int64_t x1,
+                        const std::int64_t y1) const {
+    if (x1 < x0 || y1 < y0) {
+        throw std::runtime_error(std::string("A window has a negative size!"));
+    }
+    if (x1 - x0 > std::numeric_limits<int>::max() || y1 - y0 > std::numeric_limits<int>::max() ||
+        (x1 - x0) * (y1 - y0) > std::numeric_limits<int>::max()) {
+        throw std::runtime_error(std::string("The window is too large for a Grid!"));
+    }
+    Grid grid(static_cast<int>(x1 - x0), static_cast<int>(y1 - y0));
+    const std::int64_t half = static_cast<std::int64_t>(1) << (this->root->level - 1);
+    fill_grid(this->root, -half, -half, grid, x0, y0);
+    return grid;
+}
+
+/**
+ * HashWorld::to_grid()
+ *
+ * Copies the bounding box of the alive cells into a grid.
+ *
+ * @return
+ *      A grid the size of the bounding box, or an empty 0x0 grid if there are no alive cells.
+ *
+ * @throws
+ *      std::runtime_error if the bounding box is too large for a Grid.
+ */
+Grid HashWorld::to_grid() const {
+    std::int64_t x0, y0, x1, y1;
+    if (!this->get_bounds(x0, y0, x1, y1)) {
+        return Grid();
+    }
+    return this->to_grid(x0, y0, x1, y1);
+}
+
+/**
+ * HashWorld::step_pow2(step_log2)
+ *
+ * Advance the plane 2^step_log2 generations in a single call.
+ *
+ * The root is expanded with empty space until the pattern sits in its inner quarter and the root is large
+ * enough for the step, plus once more so nothing can travel out of its centre, and is then replaced by
+ * its memoised successor. Finally the root is shrunk back while the pattern allows.
+ *
+ * @example
+ *
+ *      // Advance a glider 2^20 generations
+ *      HashWorld world(Zoo::glider());
+ *      world.step_pow2(20);
+ *
+ * @param step_log2
+ *      Log2 of the number of generations to advance.
+ *
+ * @throws
+ *      std::runtime_error if step_log2 is negative or the plane would grow too large to represent.
+ */
+void HashWorld::step_pow2(const int step_log2) {
+    if (step_log2 < 0 || step_log2 > MAX_LEVEL - 3) {
+        throw std::runtime_error(std::string("The step size is out of range!"));
+    }
+    while (this->root->level < step_log2 + 2 || !this->is_padded(this->root)) {
+        this->root = this->expand(this->root);
+    }
+    this->root = this->expand(this->root);
+    if (this->root->level > MAX_LEVEL) {
+        throw std::runtime_error(std::string("The pattern has grown too large to represent!"));
+    }
+    this->root = this->successor(this->root, step_log2);
+    this->generation += static_cast<std::uint64_t>(1) << step_log2;
+
+    while (this->root->level > 3 && this->is_padded(this->root)) {
+        this->root = this->centre(this->root);
+    }
+    if (this->nodes.size() > this->gc_threshold) {
+        this->collect_garbage();
+        this->gc_threshold = std::max(MIN_GC_NODES, 2 * this->nodes.size());
+    }
+}
+
+/**
+ * HashWorld::advance(steps)
+ *
+ * Advance any number of generations by stepping once for every set bit of steps.
+ *
+ * @example
+ *
+ *      HashWorld world(Zoo::r_pentomino());
+ *      world.advance(1103);
+ *      std::cout << world.get_alive_cells() << std::endl; // 116, the r-pentomino has stabilised
+ *
+ * @param steps
+ *      The number of generations to advance.
+ */
+void HashWorld::advance(const std::uint64_t steps) {
+    for (int bit = 0; bit < 64; bit++) {
+        if ((steps >> bit) & 1) {
+            this->step_pow2(bit);
+        }
+    }
+}
+
+/**
+ * HashWorld::step()
+ *
+ * Advance a single generation.
+ */
+void HashWorld::step() {
+    this->step_pow2(0);
+}
+
+/**
+ * HashWorld::get_node_count()
+ *
+ * Gets the number of nodes currently stored, a measure of the memory used by the plane.
+ *
+ * @return
+ *      The number of nodes.
+ */
+std::size_t HashWorld::get_node_count() const {
+    return this->nodes.size();
+}
+
+/**
+ * HashWorld::set_rule(rule)
+ *
+ * Select the rule applied by HashWorld::step and HashWorld::advance. The current state is kept, but every
+ * memoised result was computed under the old rule and is forgotten.
+ *
+ * @example
+ *
+ *      // Watch a HighLife replicator copy itself
+ *      HashWorld world(Zoo::load_ascii("replicator.gol"));
+ *      world.set_rule(Rule("B36/S23"));
+ *      world.advance(1 << 20);
+ *
+ * @param rule
+ *      The rule to step with.
+ *
+ * @throws
+ *      std::runtime_error if the rule contains B0, which would fill the whole plane.
+ */
+void HashWorld::set_rule(const Rule &rule) {
+    if (rule.births_from_nothing()) {
+        throw std::runtime_error(std::string("Rules with B0 cannot be simulated on an unbounded plane!"));
+    }
+    if (rule != this->rule) {
+        this->rule = rule;
+        for (Node &node : this->nodes) {
+            node.result = nullptr;
+            node.result_log2 = -1;
+        }
+    }
+}
+
+/**
+ * HashWorld::get_rule()
+ *
+ * Gets the rule applied by HashWorld::step and HashWorld::advance.
+ *
+ * @return
+ *      The selected rule.
+ */
+const Rule &HashWorld::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * HashWorld::collect_garbage()
+ *
+ * Discard every node not reachable from the current state, along with all memoised results.
+ * The reachable nodes are copied into a fresh table, which then replaces the old one.
+ */
+void HashWorld::collect_garbage() {
+    HashWorld fresh;
+    std::unordered_map<const Node *, Node *> copied;
+    fresh.root = this->copy_into(this->root, fresh, copied);
+    fresh.generation = this->generation;
+    // Moving the containers keeps the addresses of their nodes valid
+    this->nodes = std::move(fresh.nodes);
+    this->table = std::move(fresh.table);
+    this->empty_nodes = std::move(fresh.empty_nodes);
+    this->dead = fresh.dead;
+    this->alive = fresh.alive;
+    this->root = fresh.root;
+    fresh.reset();
+}
+
+/**
+ * HashWorld::get_root()
+ *
+ * Gets the root of the quadtree, centred on the origin. Writers of quadtree formats walk down from it.
+ *
+ * @return
+ *      The root node, of level 3 or more.
+ */
+const HashWorld::Node *HashWorld::get_root() const {
+    return this->root;
+}
+
+/**
+ * HashWorld::make_cell(alive)
+ *
+ * Gets the canonical level 0 node of a cell.
+ *
+ * @param alive
+ *      The state of the cell.
+ *
+ * @return
+ *      The node of the alive or the dead cell.
+ */
+HashWorld::Node *HashWorld::make_cell(const bool alive) {
+    return alive ? this->alive : this->dead;
+}
+
+/**
+ * HashWorld::make_node(nw, ne, sw, se)
+ *
+ * Gets the canonical node with the given children, so loaders can build a tree from the bottom up.
+ * The nodes only stay valid until the next step, which may collect every node not reachable from the root.
+ *
+ * @example
+ *
+ *      // A 2x2 block in the centre of the plane
+ *      HashWorld world;
+ *      HashWorld::Node *cell = world.make_cell(true);
+ *      HashWorld::Node *empty = world.make_empty(1);
+ *      HashWorld::Node *block = world.make_node(world.make_node(empty, empty, empty, cell),
+ *                                               world.make_node(empty, empty, cell, empty),
+ *                                               world.make_node(empty, cell, empty, empty),
+ *                                               world.make_node(cell, empty, empty, empty));
+ *      world.set_root(block);
+ *
+ * @return
+ *      The node one level above its children.
+ *
+ * @throws
+ *      std::runtime_error if the children do not all have the same level, or the node would be too large.
+ */
+HashWorld::Node *HashWorld::make_node(Node *nw, Node *ne, Node *sw, Node *se) {
+    const int level = nw->level;
+    if (ne->level != level || sw->level != level || se->level != level || level >= MAX_LEVEL) {
+        throw std::runtime_error(std::string("The children of a node must have the same level!"));
+    }
+    return this->join(nw, ne, sw, se);
+}
+
+/**
+ * HashWorld::make_empty(level)
+ *
+ * Gets the canonical node of a level holding only dead cells.
+ *
+ * @throws
+ *      std::runtime_error if the level is negative or larger than HashWorld::MAX_LEVEL.
+ */
+HashWorld::Node *HashWorld::make_empty(const int level) {
+    if (level < 0 || level > MAX_LEVEL) {
+        throw std::runtime_error(std::string("The level is out of range!"));
+    }
+    return this->empty(level);
+}
+
+/**
+ * HashWorld::set_root(root, generation)
+ *
+ * Replace the state of the plane with a tree built through HashWorld::make_node. The root is centred on the
+ * origin, so a level k root spans [-2^(k-1), 2^(k-1)) on both axes. Smaller roots are padded up to level 3.
+ *
+ * @param root
+ *      A node created by this plane.
+ *
+ * @param generation
+ *      The generation the state belongs to.
+ *
+ * @throws
+ *      std::runtime_error if the root is a single cell, which cannot be centred on the origin.
+ */
+void HashWorld::set_root(Node *root, const std::uint64_t generation) {
+    if (root->level < 1) {
+        throw std::runtime_error(std::string("The root must be at least level 1!"));
+    }
+    while (root->level < 3) {
+        root = this->expand(root);
+    }
+    this->root = root;
+    this->generation = generation;
+}
+
+/**
+ * operator<<(output_stream, world)
+ *
+ * Serializes the bounding box of the alive cells of a plane to an ascii output stream,
+ * in the same bordered format as a Grid.
+ *
+ * @param os
+ *      An ascii mode output stream such as std::cout.
+ *
+ * @param world
+ *      The plane to print.
+ *
+ * @return
+ *      Returns a reference to the output stream to enable operator chaining.
+ */
+std::ostream &operator<<(std::ostream &os, const HashWorld &world) {
+    return os << world.to_grid();
+}
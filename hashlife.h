@@ -0,0 +1,152 @@
+/**
+ * Declares a class simulating the Game of Life on an unbounded plane with Bill Gosper's HashLife algorithm.
+ * Rich documentation for the api and behaviour the HashWorld class can be found in hashlife.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the HashWorld class.
+ *
+ * The plane is a quadtree of canonical nodes. Identical sub-squares anywhere in space or time are stored once,
+ * and the future of every node is memoised, so repetitive patterns can be advanced 2^k generations at once.
+ */
+class HashWorld {
+public:
+    /**
+     * A square of 2^level by 2^level cells. Level 0 nodes are single cells and have no children.
+     * Nodes never change once created, apart from their memoised result, and are only created by HashWorld::join.
+     */
+    struct Node {
+        Node *nw, *ne, *sw, *se;
+
+        Node *result;                                // Memoised centre of the node, result_log2 steps ahead
+
+        int level;
+
+        int result_log2;                             // Log2 of the steps result was advanced, -1 if unset
+
+        std::uint64_t population;
+    };
+
+private:
+    struct NodeKey {
+        const Node *nw, *ne, *sw, *se;
+
+        bool operator==(const NodeKey &other) const;
+    };
+
+    struct NodeKeyHash {
+        std::size_t operator()(const NodeKey &key) const;
+    };
+
+    std::deque<Node> nodes;                          // Stable storage for every node, deque never moves them
+
+    std::unordered_map<NodeKey, Node *, NodeKeyHash> table; // The canonical node for every set of children
+
+    std::vector<Node *> empty_nodes;                 // The canonical empty node of every level
+
+    Node *dead, *alive;                              // The two canonical level 0 nodes
+
+    Node *root;                                      // Centred on the origin, spanning [-2^(level-1), 2^(level-1))
+
+    std::uint64_t generation;
+
+    Rule rule;
+
+    std::size_t gc_threshold;                        // Garbage is collected once there are more nodes than this
+
+    Node *join(Node *nw, Node *ne, Node *sw, Node *se);
+
+    Node *empty(const int level);
+
+    Node *centre(Node *node);                        // The centre half of a node, without advancing time
+
+    Node *successor(Node *node, const int step_log2);
+
+    Node *step_base(Node *node);                     // Advances the centre of a 4x4 node by 1 generation
+
+    Node *expand(Node *node);                        // Surrounds a node with empty space, doubling its size
+
+    bool is_padded(const Node *node) const;          // True if all alive cells are in the inner quarter
+
+    Node *build(const Grid &grid, const int x0, const int y0, const int level);
+
+    Node *set_cell(Node *node, const std::int64_t x, const std::int64_t y, const bool value);
+
+    Node *copy_into(const Node *node, HashWorld &other, std::unordered_map<const Node *, Node *> &copied) const;
+
+    void reset();
+
+public:
+    static const int MAX_LEVEL = 62;                 // The largest universe whose coordinates fit in 64 bits
+
+    HashWorld();
+
+    explicit HashWorld(const Grid &initial_state);   // Cell (x, y) of the grid is placed at (x, y)
+
+    HashWorld(const HashWorld &other);
+
+    HashWorld &operator=(const HashWorld &other);
+
+    friend std::ostream &operator<<(std::ostream &os, const HashWorld &world);
+
+    // Member functions
+    std::uint64_t get_alive_cells() const;
+
+    std::uint64_t get_generation() const;
+
+    Cell get(const std::int64_t x, const std::int64_t y) const;
+
+    void set(const std::int64_t x, const std::int64_t y, const Cell value);
+
+    // Finds the bounding box [x0, x1) by [y0, y1) of the alive cells, false if there are none
+    bool get_bounds(std::int64_t &x0, std::int64_t &y0, std::int64_t &x1, std::int64_t &y1) const;
+
+    // Copies the bounding box of the alive cells into a grid
+    Grid to_grid() const;
+
+    // Copies the window [x0, x1) by [y0, y1) of the plane into a grid
+    Grid to_grid(const std::int64_t x0, const std::int64_t y0, const std::int64_t x1, const std::int64_t y1) const;
+
+    // Advance 2^step_log2 generations in a single call
+    void step_pow2(const int step_log2);
+
+    // Advance any number of generations, as a sum of powers of two
+    void advance(const std::uint64_t steps);
+
+    void step();
+
+    std::size_t get_node_count() const;
+
+    // Selects the rule applied by step and advance, B3/S23 by default
+    void set_rule(const Rule &rule);
+
+    const Rule &get_rule() const;
+
+    // Discards every node and memoised result not reachable from the current state
+    void collect_garbage();
+
+    // Building blocks for loaders of quadtree formats such as macrocell, the nodes belong to this plane
+    const Node *get_root() const;
+
+    Node *make_cell(const bool alive);
+
+    Node *make_node(Node *nw, Node *ne, Node *sw, Node *se); // Throws if the children differ in level
+
+    Node *make_empty(const int level);
+
+    // Replaces the state with a root node of this plane, spanning [-2^(level-1), 2^(level-1)) on both axes
+    void set_root(Node *root, const std::uint64_t generation = 0);
+};
@@ -0,0 +1,562 @@
+/**
+ * Implements a class simulating the Game of Life on an unbounded plane made of bit-packed chunks.
+ *
+ *      - The plane is split into CHUNK_SIZE by CHUNK_SIZE chunks. Chunk (cx, cy) holds the cells
+ *        [cx * CHUNK_SIZE, (cx + 1) * CHUNK_SIZE) by [cy * CHUNK_SIZE, (cy + 1) * CHUNK_SIZE).
+ *          - Only chunks with at least one alive cell are stored, in a hash map keyed by chunk coordinate,
+ *            so memory follows the pattern rather than the area it has ever covered.
+ *          - Each row of a chunk is a single 64 bit word, stepped 64 cells at a time with life_word(...)
+ *            exactly like Engine::BITPACKED.
+ *
+ *      - A step recomputes every stored chunk, plus the empty neighbours an alive edge or corner cell could
+ *        cause a birth in. Chunks left without alive cells are dropped, so the storage shrinks again.
+ *
+ *      - Unlike World the plane has no edges. An InfiniteWorld built from a Grid gives the same cells as a World
+ *        built from the same Grid for as long as the pattern stays clear of the edges of the World.
+ *
+ *      - HashWorld is far faster on large or repetitive patterns advanced many generations at once. InfiniteWorld
+ *        does the same work every generation, but with a fixed cost per alive chunk and no memoisation.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "infinite_world.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bitgrid.h"
+
+// All chunks missing from the map read as this one
+static const InfiniteWorld::Chunk EMPTY_CHUNK = {{0}};
+
+bool InfiniteWorld::ChunkKey::operator==(const ChunkKey &other) const {
+    return x == other.x && y == other.y;
+}
+
+std::size_t InfiniteWorld::ChunkKeyHash::operator()(const ChunkKey &key) const {
+    std::uint64_t hash = static_cast<std::uint64_t>(key.x) * 0x9E3779B97F4A7C15ull;
+    hash = (hash ^ (hash >> 32)) + static_cast<std::uint64_t>(key.y) * 0xC2B2AE3D27D4EB4Full;
+    return static_cast<std::size_t>(hash ^ (hash >> 29));
+}
+
+/**
+ * Splits a cell coordinate into the coordinate of its chunk and its offset within the chunk,
+ * rounding towards negative infinity so negative coordinates land in the right chunk.
+ */
+static void split_coordinate(const std::int64_t value, std::int64_t &chunk, int &offset) {
+    const std::int64_t size = InfiniteWorld::CHUNK_SIZE;
+    chunk = value >= 0 ? value / size : -((-(value + 1)) / size) - 1;
+    offset = static_cast<int>(value - chunk * size);
+}
+
+/**
+ * Finds the index of the lowest and highest set bits of a non-zero word.
+ */
+static void bit_range(const std::uint64_t word, int &lowest, int &highest) {
+#if defined(__GNUC__) || defined(__clang__)
+    lowest = __builtin_ctzll(word);
+    highest = 63 - __builtin_clzll(word);
+#else
+    lowest = 0;
+    while (!((word >> lowest) & 1)) {
+        lowest++;
+    }
+    highest = 63;
+    while (!((word >> highest) & 1)) {
+        highest--;
+    }
+#endif
+}
+
+/**
+ * InfiniteWorld::InfiniteWorld()
+ *
+ * Construct an empty plane at generation 0.
+ *
+ * @example
+ *
+ *      // Make an empty plane and draw a blinker on it
+ *      InfiniteWorld world;
+ *      world.set(0, 0, Cell::ALIVE);
+ *      world.set(1, 0, Cell::ALIVE);
+ *      world.set(2, 0, Cell::ALIVE);
+ */
+InfiniteWorld::InfiniteWorld() : generation(0) {
+}
+
+/**
+ * InfiniteWorld::InfiniteWorld(initial_state)
+ *
+ * Construct a plane holding the alive cells of a grid, with cell (x, y) of the grid at (x, y) on the plane.
+ *
+ * @example
+ *
+ *      // Load a pattern and let it run off in every direction
+ *      InfiniteWorld world(Zoo::load_ascii("glider.gol"));
+ *      world.advance(1000);
+ *
+ * @param initial_state
+ *      The state of the constructed plane.
+ */
+InfiniteWorld::InfiniteWorld(const Grid &initial_state) : InfiniteWorld() {
+    for (int y = 0; y < initial_state.get_height(); y++) {
+        const Cell *row = initial_state.row(y);
+        for (int x = 0; x < initial_state.get_width(); x++) {
+            if (row[x] == Cell::ALIVE) {
+                this->set(x, y, Cell::ALIVE);
+            }
+        }
+    }
+}
+
+/**
+ * InfiniteWorld::get_alive_cells()
+ *
+ * Counts the number of alive cells on the plane.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+std::uint64_t InfiniteWorld::get_alive_cells() const {
+    std::uint64_t count = 0;
+    for (ChunkMap::const_iterator it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            count += popcount64(it->second.rows[y]);
+        }
+    }
+    return count;
+}
+
+/**
+ * InfiniteWorld::get_generation()
+ *
+ * Gets the number of generations the plane has been advanced since it was constructed.
+ *
+ * @return
+ *      The current generation.
+ */
+std::uint64_t InfiniteWorld::get_generation() const {
+    return this->generation;
+}
+
+/**
+ * InfiniteWorld::get_chunk_count()
+ *
+ * Gets the number of chunks currently stored. Every stored chunk holds at least one alive cell,
+ * so the memory used is roughly this many times sizeof(InfiniteWorld::Chunk).
+ *
+ * @return
+ *      The number of stored chunks.
+ */
+std::size_t InfiniteWorld::get_chunk_count() const {
+    return this->chunks.size();
+}
+
+/**
+ * InfiniteWorld::set_rule(rule)
+ *
+ * Select the rule applied by InfiniteWorld::step and InfiniteWorld::advance. The current state is kept.
+ *
+ * @param rule
+ *      The rule to step with.
+ *
+ * @throws
+ *      std::runtime_error if the rule contains B0, which would fill the whole plane.
+ */
+void InfiniteWorld::set_rule(const Rule &rule) {
+    if (rule.births_from_nothing()) {
+        throw std::runtime_error(std::string("Rules with B0 cannot be simulated on an unbounded plane!"));
+    }
+    this->rule = rule;
+}
+
+/**
+ * InfiniteWorld::get_rule()
+ *
+ * Gets the rule applied by InfiniteWorld::step and InfiniteWorld::advance.
+ *
+ * @return
+ *      The selected rule.
+ */
+const Rule &InfiniteWorld::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * InfiniteWorld::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate. Every coordinate is valid on the unbounded plane.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      The value of the desired cell.
+ */
+Cell InfiniteWorld::get(const std::int64_t x, const std::int64_t y) const {
+    ChunkKey key;
+    int ox, oy;
+    split_coordinate(x, key.x, ox);
+    split_coordinate(y, key.y, oy);
+    const Chunk *chunk = this->find(key.x, key.y);
+    return (chunk->rows[oy] >> ox) & 1 ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * InfiniteWorld::set(x, y, value)
+ *
+ * Overwrites the value at the desired coordinate, adding or dropping its chunk as needed.
+ *
+ * @param x
+ *      The x coordinate of the cell to update.
+ *
+ * @param y
+ *      The y coordinate of the cell to update.
+ *
+ * @param value
+ *      The value to be written to the selected cell.
+ */
+void InfiniteWorld::set(const std::int64_t x, const std::int64_t y, const Cell value) {
+    ChunkKey key;
+    int ox, oy;
+    split_coordinate(x, key.x, ox);
+    split_coordinate(y, key.y, oy);
+    const std::uint64_t bit = static_cast<std::uint64_t>(1) << ox;
+    if (value == Cell::ALIVE) {
+        ChunkMap::iterator it = this->chunks.find(key);
+        if (it == this->chunks.end()) {
+            it = this->chunks.insert(std::make_pair(key, EMPTY_CHUNK)).first;
+        }
+        it->second.rows[oy] |= bit;
+        return;
+    }
+    ChunkMap::iterator it = this->chunks.find(key);
+    if (it == this->chunks.end()) {
+        return;
+    }
+    it->second.rows[oy] &= ~bit;
+    for (int row = 0; row < CHUNK_SIZE; row++) {
+        if (it->second.rows[row]) {
+            return;
+        }
+    }
+    this->chunks.erase(it);
+}
+
+/**
+ * InfiniteWorld::fill_row(x0, x1, y)
+ *
+ * Sets a run of cells in a row alive, touching each chunk along the run once. Loaders of run length
+ * encoded patterns use this instead of setting every cell.
+ *
+ * @example
+ *
+ *      // A row of a million alive cells
+ *      InfiniteWorld world;
+ *      world.fill_row(0, 1000000, 0);
+ *
+ * @param x0
+ *      The x coordinate of the first cell of the run.
+ *
+ * @param x1
+ *      The x coordinate one past the last cell of the run, nothing is set unless it is larger than x0.
+ *
+ * @param y
+ *      The y coordinate of the row.
+ */
+void InfiniteWorld::fill_row(const std::int64_t x0, const std::int64_t x1, const std::int64_t y) {
+    if (x1 <= x0) {
+        return;
+    }
+    ChunkKey key;
+    int oy, first, last;
+    std::int64_t last_chunk;
+    split_coordinate(y, key.y, oy);
+    split_coordinate(x0, key.x, first);
+    split_coordinate(x1 - 1, last_chunk, last);
+    for (; key.x <= last_chunk; key.x++) {
+        const int high = key.x == last_chunk ? last : CHUNK_SIZE - 1;
+        // Bits first to high inclusive
+        const std::uint64_t mask = (~static_cast<std::uint64_t>(0) >> (CHUNK_SIZE - 1 - high)) &
+                                   (~static_cast<std::uint64_t>(0) << first);
+        ChunkMap::iterator it = this->chunks.find(key);
+        if (it == this->chunks.end()) {
+            it = this->chunks.insert(std::make_pair(key, EMPTY_CHUNK)).first;
+        }
+        it->second.rows[oy] |= mask;
+        first = 0;
+    }
+}
+
+/**
+ * InfiniteWorld::get_bounds(x0, y0, x1, y1)
+ *
+ * Finds the smallest rectangle [x0, x1) by [y0, y1) holding every alive cell.
+ *
+ * @return
+ *      True and the bounds through the parameters, or false and the parameters untouched if there are no alive cells.
+ */
+bool InfiniteWorld::get_bounds(std::int64_t &x0, std::int64_t &y0, std::int64_t &x1, std::int64_t &y1) const {
+    if (this->chunks.empty()) {
+        return false;
+    }
+    std::int64_t min_x = std::numeric_limits<std::int64_t>::max(), min_y = min_x;
+    std::int64_t max_x = std::numeric_limits<std::int64_t>::min(), max_y = max_x;
+    for (ChunkMap::const_iterator it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+        const std::int64_t base_x = it->first.x * CHUNK_SIZE, base_y = it->first.y * CHUNK_SIZE;
+        std::uint64_t columns = 0;
+        int first_row = -1, last_row = -1;
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            if (it->second.rows[y]) {
+                columns |= it->second.rows[y];
+                first_row = first_row < 0 ? y : first_row;
+                last_row = y;
+            }
+        }
+        int first_column, last_column;
+        bit_range(columns, first_column, last_column);
+        min_x = std::min(min_x, base_x + first_column);
+        max_x = std::max(max_x, base_x + last_column);
+        min_y = std::min(min_y, base_y + first_row);
+        max_y = std::max(max_y, base_y + last_row);
+    }
+    x0 = min_x;
+    y0 = min_y;
+    x1 = max_x + 1;
+    y1 = max_y + 1;
+    return true;
+}
+
+/**
+ * InfiniteWorld::to_grid(x0, y0, x1, y1)
+ *
+ * Copies a window of the plane into a grid, so it can be printed, saved with Zoo or stepped with World.
+ * Cell (x0, y0) of the plane becomes cell (0, 0) of the grid.
+ *
+ * @example
+ *
+ *      // Look at the 32x32 square around the origin
+ *      Grid grid = world.to_grid(-16, -16, 16, 16);
+ *
+ * @return
+ *      A grid of size (x1 - x0) by (y1 - y0).
+ *
+ * @throws
+ *      std::runtime_error if the window has a negative size or is too large for a Grid.
+ */
+Grid InfiniteWorld::to_grid(const std::int64_t x0, const std::int64_t y0, const std::int64_t x1,
+                            const std::int64_t y1) const {
+    if (x1 < x0 || y1 < y0) {
+        throw std::runtime_error(std::string("A window has a negative size!"));
+    }
+    if (x1 - x0 > std::numeric_limits<int>::max() || y1 - y0 > std::numeric_limits<int>::max() ||
+        (x1 - x0) * (y1 - y0) > std::numeric_limits<int>::max()) {
+        throw std::runtime_error(std::string("The window is too large for a Grid!"));
+    }
+    Grid grid(static_cast<int>(x1 - x0), static_cast<int>(y1 - y0));
+    for (ChunkMap::const_iterator it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+        const std::int64_t base_x = it->first.x * CHUNK_SIZE, base_y = it->first.y * CHUNK_SIZE;
+        if (base_x >= x1 || base_x + CHUNK_SIZE <= x0 || base_y >= y1 || base_y + CHUNK_SIZE <= y0) {
+            continue;
+        }
+        const int row_begin = static_cast<int>(std::max<std::int64_t>(0, y0 - base_y));
+        const int row_end = static_cast<int>(std::min<std::int64_t>(CHUNK_SIZE, y1 - base_y));
+        for (int y = row_begin; y < row_end; y++) {
+            Cell *out = grid.row(static_cast<int>(base_y + y - y0));
+            for (std::uint64_t word = it->second.rows[y]; word; word &= word - 1) {
+                int x, unused;
+                bit_range(word, x, unused);
+                if (base_x + x >= x0 && base_x + x < x1) {
+                    out[base_x + x - x0] = Cell::ALIVE;
+                }
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * InfiniteWorld::to_grid()
+ *
+ * Copies the bounding box of the alive cells into a grid.
+ * The chunks spanned by the alive cells are copied out whole, then trimmed to the bounding box with Grid::crop.
+ *
+ * @return
+ *      A grid the size of the bounding box, or an empty 0x0 grid if there are no alive cells.
+ *
+ * @throws
+ *      std::runtime_error if the bounding box is too large for a Grid.
+ */
+Grid InfiniteWorld::to_grid() const {
+    std::int64_t x0, y0, x1, y1;
+    if (!this->get_bounds(x0, y0, x1, y1)) {
+        return Grid();
+    }
+    std::int64_t chunk_x0, chunk_y0, chunk_x1, chunk_y1;
+    int unused;
+    split_coordinate(x0, chunk_x0, unused);
+    split_coordinate(y0, chunk_y0, unused);
+    split_coordinate(x1 - 1, chunk_x1, unused);
+    split_coordinate(y1 - 1, chunk_y1, unused);
+    const std::int64_t origin_x = chunk_x0 * CHUNK_SIZE, origin_y = chunk_y0 * CHUNK_SIZE;
+    Grid snapshot = this->to_grid(origin_x, origin_y, (chunk_x1 + 1) * CHUNK_SIZE, (chunk_y1 + 1) * CHUNK_SIZE);
+    return snapshot.crop(static_cast<int>(x0 - origin_x), static_cast<int>(y0 - origin_y),
+                         static_cast<int>(x1 - origin_x), static_cast<int>(y1 - origin_y));
+}
+
+/**
+ * Looks up a chunk by chunk coordinate, so missing chunks can be read like any other.
+ */
+const InfiniteWorld::Chunk *InfiniteWorld::find(const std::int64_t x, const std::int64_t y) const {
+    ChunkKey key;
+    key.x = x;
+    key.y = y;
+    const ChunkMap::const_iterator it = this->chunks.find(key);
+    return it == this->chunks.end() ? &EMPTY_CHUNK : &it->second;
+}
+
+/**
+ * Computes the next generation of one chunk from its own cells and the edges of its 8 neighbours, under rule R.
+ * Row r of the west, centre and east words below is row r - 1 of the chunk, so rows 0 and CHUNK_SIZE + 1
+ * come from the chunks to the north and south.
+ */
+template<class R>
+void InfiniteWorld::step_chunk(const ChunkKey &key, Chunk &out) const {
+    const unsigned birth = R::birth(this->rule), survive = R::survive(this->rule);
+    const Chunk *around[3][3];
+    for (int dy = 0; dy < 3; dy++) {
+        for (int dx = 0; dx < 3; dx++) {
+            around[dy][dx] = this->find(key.x + dx - 1, key.y + dy - 1);
+        }
+    }
+    std::uint64_t west[CHUNK_SIZE + 2], centre[CHUNK_SIZE + 2], east[CHUNK_SIZE + 2];
+    for (int r = 0; r < CHUNK_SIZE + 2; r++) {
+        const int band = r == 0 ? 0 : (r == CHUNK_SIZE + 1 ? 2 : 1);
+        const int y = r == 0 ? CHUNK_SIZE - 1 : (r == CHUNK_SIZE + 1 ? 0 : r - 1);
+        const std::uint64_t word = around[band][1]->rows[y];
+        centre[r] = word;
+        west[r] = (word << 1) | (around[band][0]->rows[y] >> (CHUNK_SIZE - 1));
+        east[r] = (word >> 1) | (around[band][2]->rows[y] << (CHUNK_SIZE - 1));
+    }
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        out.rows[y] = life_word(west[y], centre[y], east[y],
+                                west[y + 1], centre[y + 1], east[y + 1],
+                                west[y + 2], centre[y + 2], east[y + 2], birth, survive);
+    }
+}
+
+/**
+ * InfiniteWorld::step()
+ *
+ * Advance the plane by a single generation.
+ *
+ *      - Every stored chunk is recomputed.
+ *      - An empty neighbour is only recomputed if the cells of a stored chunk along the shared edge or corner are
+ *        not all dead, since without B0 a birth needs an alive neighbour and nothing else can reach into an
+ *        empty chunk.
+ *      - Chunks without any alive cells afterwards are not kept.
+ */
+void InfiniteWorld::step() {
+    switch (this->rule.get_kind()) {
+        case RuleKind::CONWAY:
+            this->step_rule<ConwayRule>();
+            break;
+        case RuleKind::HIGHLIFE:
+            this->step_rule<HighLifeRule>();
+            break;
+        case RuleKind::SEEDS:
+            this->step_rule<SeedsRule>();
+            break;
+        case RuleKind::DAY_AND_NIGHT:
+            this->step_rule<DayAndNightRule>();
+            break;
+        case RuleKind::TABLE:
+            this->step_rule<TableRule>();
+            break;
+    }
+}
+
+/**
+ * Private helper function taking one step with the chunk kernel instantiated for rule R.
+ */
+template<class R>
+void InfiniteWorld::step_rule() {
+    std::vector<ChunkKey> candidates;
+    candidates.reserve(this->chunks.size() * 2);
+    for (ChunkMap::const_iterator it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+        const Chunk &chunk = it->second;
+        std::uint64_t columns = 0;
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            columns |= chunk.rows[y];
+        }
+        const std::uint64_t west_column = static_cast<std::uint64_t>(1);
+        const std::uint64_t east_column = static_cast<std::uint64_t>(1) << (CHUNK_SIZE - 1);
+        const std::uint64_t north = chunk.rows[0], south = chunk.rows[CHUNK_SIZE - 1];
+        // reaches[dy][dx] is true when the alive cells touch the neighbour at offset (dx - 1, dy - 1)
+        const bool reaches[3][3] = {
+                {(north & west_column) != 0, north != 0, (north & east_column) != 0},
+                {(columns & west_column) != 0, true, (columns & east_column) != 0},
+                {(south & west_column) != 0, south != 0, (south & east_column) != 0}
+        };
+        for (int dy = 0; dy < 3; dy++) {
+            for (int dx = 0; dx < 3; dx++) {
+                ChunkKey key;
+                key.x = it->first.x + dx - 1;
+                key.y = it->first.y + dy - 1;
+                if (reaches[dy][dx] && (key == it->first || !this->chunks.count(key))) {
+                    candidates.push_back(key);
+                }
+            }
+        }
+    }
+
+    // An empty chunk can be reached from several stored neighbours, but only needs computing once
+    std::sort(candidates.begin(), candidates.end(), [](const ChunkKey &a, const ChunkKey &b) {
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+    });
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    this->next_chunks.clear();
+    this->next_chunks.reserve(candidates.size());
+    Chunk out;
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        this->step_chunk<R>(candidates[i], out);
+        std::uint64_t any = 0;
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            any |= out.rows[y];
+        }
+        if (any) {
+            this->next_chunks.insert(std::make_pair(candidates[i], out));
+        }
+    }
+    this->chunks.swap(this->next_chunks);
+    this->generation++;
+}
+
+/**
+ * InfiniteWorld::advance(steps)
+ *
+ * Advance the plane by a number of generations, one at a time.
+ *
+ * @param steps
+ *      The number of generations to advance.
+ */
+void InfiniteWorld::advance(const std::uint64_t steps) {
+    for (std::uint64_t i = 0; i < steps; i++) {
+        this->step();
+    }
+}
+
+/**
+ * operator<<(os, world)
+ *
+ * Prints the bounding box of the alive cells, in the same way a Grid is printed.
+ */
+std::ostream &operator<<(std::ostream &os, const InfiniteWorld &world) {
+    return os << world.to_grid();
+}
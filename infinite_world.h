@@ -0,0 +1,102 @@
+/**
+ * Declares a class simulating the Game of Life on an unbounded plane stored as a sparse set of bit-packed chunks.
+ * Rich documentation for the api and behaviour the InfiniteWorld class can be found in infinite_world.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the InfiniteWorld class.
+ *
+ * Only the chunks holding alive cells are stored, so the storage grows and shrinks with the pattern
+ * instead of being sized up front.
+ */
+class InfiniteWorld {
+public:
+    static const int CHUNK_SIZE = 64;                // Chunks are CHUNK_SIZE by CHUNK_SIZE cells, one word per row
+
+    /**
+     * A square of cells, bit x of rows[y] is cell (x, y) of the chunk.
+     */
+    struct Chunk {
+        std::uint64_t rows[CHUNK_SIZE];
+    };
+
+private:
+    struct ChunkKey {
+        std::int64_t x, y;                           // Chunk coordinates, cell coordinates divided by CHUNK_SIZE
+
+        bool operator==(const ChunkKey &other) const;
+    };
+
+    struct ChunkKeyHash {
+        std::size_t operator()(const ChunkKey &key) const;
+    };
+
+    typedef std::unordered_map<ChunkKey, Chunk, ChunkKeyHash> ChunkMap;
+
+    ChunkMap chunks;                                 // Every chunk with at least one alive cell
+
+    ChunkMap next_chunks;                            // Scratch map for the next generation, kept to reuse its buckets
+
+    std::uint64_t generation;
+
+    Rule rule;
+
+    const Chunk *find(const std::int64_t x, const std::int64_t y) const; // The chunk at (x, y), or an empty one
+
+    template<class R>
+    void step_chunk(const ChunkKey &key, Chunk &out) const; // Instantiated per rule in infinite_world.cpp
+
+    template<class R>
+    void step_rule();
+
+public:
+    InfiniteWorld();
+
+    explicit InfiniteWorld(const Grid &initial_state); // Cell (x, y) of the grid is placed at (x, y)
+
+    friend std::ostream &operator<<(std::ostream &os, const InfiniteWorld &world);
+
+    // Member functions
+    std::uint64_t get_alive_cells() const;
+
+    std::uint64_t get_generation() const;
+
+    std::size_t get_chunk_count() const;
+
+    // Selects the rule applied by step and advance, B3/S23 by default
+    void set_rule(const Rule &rule);
+
+    const Rule &get_rule() const;
+
+    Cell get(const std::int64_t x, const std::int64_t y) const;
+
+    void set(const std::int64_t x, const std::int64_t y, const Cell value);
+
+    // Sets the cells [x0, x1) of row y alive, a word at a time
+    void fill_row(const std::int64_t x0, const std::int64_t x1, const std::int64_t y);
+
+    // Finds the bounding box [x0, x1) by [y0, y1) of the alive cells, false if there are none
+    bool get_bounds(std::int64_t &x0, std::int64_t &y0, std::int64_t &x1, std::int64_t &y1) const;
+
+    // Copies the bounding box of the alive cells into a grid
+    Grid to_grid() const;
+
+    // Copies the window [x0, x1) by [y0, y1) of the plane into a grid
+    Grid to_grid(const std::int64_t x0, const std::int64_t y0, const std::int64_t x1, const std::int64_t y1) const;
+
+    void step();
+
+    // Advance any number of generations
+    void advance(const std::uint64_t steps);
+};
@@ -0,0 +1,431 @@
+/**
+ * Implements a class stepping 64 boards in lock step with a bit-sliced kernel.
+ *      - Cell (x, y) of all 64 boards shares one word, so the full adders of life_word(...) count the
+ *        neighbours of 64 boards per instruction. The boards never interact, each bit position is a lane.
+ *      - Small boards fill the words of Engine::BITPACKED poorly, or not at all once they are under 64 cells
+ *        wide, but every word of a batch is full whatever the board size.
+ *      - Every step also records which lanes changed, so still lifes and period 2 oscillators are found
+ *        without hashing any lane.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "lockstep.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "bitgrid.h"
+
+/**
+ * LockstepBatch::LockstepBatch()
+ *
+ * Default constructor of an empty batch of 0 x 0 boards.
+ */
+LockstepBatch::LockstepBatch() : LockstepBatch(0, 0) {}
+
+/**
+ * LockstepBatch::LockstepBatch(width, height)
+ *
+ * Construct a batch of LANES boards of the given size, every cell of every lane dead.
+ *
+ * @example
+ *
+ *      // Step 64 soups of 32x32 cells together
+ *      LockstepBatch batch(32, 32);
+ *      for (int lane = 0; lane < LockstepBatch::LANES; lane++) {
+ *          batch.load(lane, soups[lane]);
+ *      }
+ *      batch.advance(100, false);
+ *
+ * @param width
+ *      The width of every board.
+ *
+ * @param height
+ *      The height of every board.
+ *
+ * @throws
+ *      std::runtime_error if the width or height is negative.
+ */
+LockstepBatch::LockstepBatch(const int width, const int height)
+        : width(width), height(height), changed(0), changed_twice(0), has_previous(0), has_history(0) {
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Wrong width or height"));
+    }
+    const std::size_t words = static_cast<std::size_t>(width + 2) * (height + 2);
+    this->current.assign(words, 0);
+    this->previous.assign(words, 0);
+    this->next.assign(words, 0);
+}
+
+/**
+ * LockstepBatch::get_index(x, y)
+ *
+ * Private helper function giving the index of cell (x, y) in the bordered buffers.
+ */
+int LockstepBatch::get_index(const int x, const int y) const {
+    return (y + 1) * (this->width + 2) + (x + 1);
+}
+
+/**
+ * LockstepBatch::check_lane(lane)
+ *
+ * Private helper function throwing std::runtime_error if a lane is out of range.
+ */
+void LockstepBatch::check_lane(const int lane) const {
+    if (lane < 0 || lane >= LANES) {
+        throw std::runtime_error(std::string("The lane is out of range!"));
+    }
+}
+
+/**
+ * LockstepBatch::get_width()
+ *
+ * @return
+ *      The width of every board.
+ */
+int LockstepBatch::get_width() const {
+    return this->width;
+}
+
+/**
+ * LockstepBatch::get_height()
+ *
+ * @return
+ *      The height of every board.
+ */
+int LockstepBatch::get_height() const {
+    return this->height;
+}
+
+/**
+ * LockstepBatch::set_rule(rule)
+ *
+ * Select the rule applied to every lane by LockstepBatch::step. The lanes keep their state.
+ *
+ * @param rule
+ *      The rule to step with.
+ */
+void LockstepBatch::set_rule(const Rule &rule) {
+    this->rule = rule;
+}
+
+/**
+ * LockstepBatch::get_rule()
+ *
+ * @return
+ *      The rule applied to every lane, B3/S23 unless another was selected.
+ */
+const Rule &LockstepBatch::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * LockstepBatch::get(lane, x, y)
+ *
+ * @param lane
+ *      The board to read, between 0 and LANES - 1.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      The cell of the board.
+ *
+ * @throws
+ *      std::runtime_error if the lane or the coordinate is out of range.
+ */
+Cell LockstepBatch::get(const int lane, const int x, const int y) const {
+    this->check_lane(lane);
+    if (x < 0 || y < 0 || x >= this->width || y >= this->height) {
+        throw std::runtime_error(std::string("The values are out of range!"));
+    }
+    return (this->current[this->get_index(x, y)] >> lane) & 1 ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * LockstepBatch::set(lane, x, y, value)
+ *
+ * Overwrite one cell of one board. The history of the lane is kept, set a lane through
+ * LockstepBatch::load or LockstepBatch::clear to start it afresh.
+ *
+ * @param lane
+ *      The board to write, between 0 and LANES - 1.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @param value
+ *      The new value of the cell.
+ *
+ * @throws
+ *      std::runtime_error if the lane or the coordinate is out of range.
+ */
+void LockstepBatch::set(const int lane, const int x, const int y, const Cell value) {
+    this->check_lane(lane);
+    if (x < 0 || y < 0 || x >= this->width || y >= this->height) {
+        throw std::runtime_error(std::string("The values are out of range!"));
+    }
+    const std::uint64_t bit = static_cast<std::uint64_t>(1) << lane;
+    std::uint64_t &word = this->current[this->get_index(x, y)];
+    word = value == Cell::ALIVE ? word | bit : word & ~bit;
+}
+
+/**
+ * LockstepBatch::clear(lane)
+ *
+ * Kill every cell of a board, ready for a new pattern to be set. The lane is reported by neither
+ * LockstepBatch::get_still_lanes nor LockstepBatch::get_period_two_lanes until it has been stepped again.
+ *
+ * @param lane
+ *      The board to clear, between 0 and LANES - 1.
+ *
+ * @throws
+ *      std::runtime_error if the lane is out of range.
+ */
+void LockstepBatch::clear(const int lane) {
+    this->check_lane(lane);
+    const std::uint64_t keep = ~(static_cast<std::uint64_t>(1) << lane);
+    for (std::uint64_t &word : this->current) {
+        word &= keep;
+    }
+    this->has_previous &= keep;
+    this->has_history &= keep;
+}
+
+/**
+ * LockstepBatch::load(lane, grid)
+ *
+ * Replace a board with the contents of a grid, forgetting the history of the lane.
+ *
+ * @param lane
+ *      The board to replace, between 0 and LANES - 1.
+ *
+ * @param grid
+ *      A grid the size of the batch.
+ *
+ * @throws
+ *      std::runtime_error if the lane is out of range or the grid is not the size of the batch.
+ */
+void LockstepBatch::load(const int lane, const Grid &grid) {
+    this->check_lane(lane);
+    if (grid.get_width() != this->width || grid.get_height() != this->height) {
+        throw std::runtime_error(std::string("The grid does not match the size of the batch!"));
+    }
+    this->clear(lane);
+    const std::uint64_t bit = static_cast<std::uint64_t>(1) << lane;
+    for (int y = 0; y < this->height; y++) {
+        const Cell *row = grid.row(y);
+        std::uint64_t *words = &this->current[this->get_index(0, y)];
+        for (int x = 0; x < this->width; x++) {
+            if (row[x] == Cell::ALIVE) {
+                words[x] |= bit;
+            }
+        }
+    }
+}
+
+/**
+ * LockstepBatch::extract(lane)
+ *
+ * Copy one board out of the batch.
+ *
+ * @param lane
+ *      The board to copy, between 0 and LANES - 1.
+ *
+ * @return
+ *      A grid the size of the batch holding the board.
+ *
+ * @throws
+ *      std::runtime_error if the lane is out of range.
+ */
+Grid LockstepBatch::extract(const int lane) const {
+    this->check_lane(lane);
+    Grid grid(this->width, this->height);
+    for (int y = 0; y < this->height; y++) {
+        Cell *row = grid.row(y);
+        const std::uint64_t *words = &this->current[this->get_index(0, y)];
+        for (int x = 0; x < this->width; x++) {
+            row[x] = (words[x] >> lane) & 1 ? Cell::ALIVE : Cell::DEAD;
+        }
+    }
+    return grid;
+}
+
+/**
+ * LockstepBatch::get_alive_cells(lane)
+ *
+ * Counts how many cells of one board are alive.
+ *
+ * @param lane
+ *      The board to count, between 0 and LANES - 1.
+ *
+ * @return
+ *      The number of alive cells.
+ *
+ * @throws
+ *      std::runtime_error if the lane is out of range.
+ */
+int LockstepBatch::get_alive_cells(const int lane) const {
+    this->check_lane(lane);
+    int count = 0;
+    for (int y = 0; y < this->height; y++) {
+        const std::uint64_t *words = &this->current[this->get_index(0, y)];
+        for (int x = 0; x < this->width; x++) {
+            count += static_cast<int>((words[x] >> lane) & 1);
+        }
+    }
+    return count;
+}
+
+/**
+ * LockstepBatch::fill_border()
+ *
+ * Private helper function writing the border of the current state. On a torus the border holds the
+ * opposite edge of every board, otherwise it is dead.
+ *
+ * @param toroidal
+ *      If true then the boards are stepped as tori.
+ */
+void LockstepBatch::fill_border(const bool toroidal) {
+    const int stride = this->width + 2;
+    std::uint64_t *words = this->current.data();
+    if (!toroidal || this->width == 0 || this->height == 0) {
+        std::fill(words, words + stride, 0);
+        std::fill(words + (this->height + 1) * stride, words + (this->height + 2) * stride, 0);
+        for (int y = 1; y <= this->height; y++) {
+            words[y * stride] = 0;
+            words[y * stride + this->width + 1] = 0;
+        }
+        return;
+    }
+    for (int y = 1; y <= this->height; y++) {
+        words[y * stride] = words[y * stride + this->width];
+        words[y * stride + this->width + 1] = words[y * stride + 1];
+    }
+    // The corners come along with the rows, which already wrap left to right
+    std::copy(words + this->height * stride, words + (this->height + 1) * stride, words);
+    std::copy(words + stride, words + 2 * stride, words + (this->height + 1) * stride);
+}
+
+/**
+ * LockstepBatch::step(toroidal)
+ *
+ * Take one step on every board of the batch, applying the rule to all 64 lanes at once.
+ * Lanes which are empty stay empty, unless the rule gives births from nothing.
+ *
+ * @param toroidal
+ *      If true then every board is stepped as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+void LockstepBatch::step(const bool toroidal) {
+    this->fill_border(toroidal);
+    switch (this->rule.get_kind()) {
+        case RuleKind::CONWAY:
+            this->step_rule<ConwayRule>();
+            break;
+        case RuleKind::HIGHLIFE:
+            this->step_rule<HighLifeRule>();
+            break;
+        case RuleKind::SEEDS:
+            this->step_rule<SeedsRule>();
+            break;
+        case RuleKind::DAY_AND_NIGHT:
+            this->step_rule<DayAndNightRule>();
+            break;
+        case RuleKind::TABLE:
+            this->step_rule<TableRule>();
+            break;
+    }
+    std::swap(this->previous, this->current);
+    std::swap(this->current, this->next);
+    this->has_history = this->has_previous;
+    this->has_previous = ~static_cast<std::uint64_t>(0);
+}
+
+/**
+ * LockstepBatch::step_rule<R>()
+ *
+ * Private helper function writing every board of the next state from the bordered current state,
+ * applying the rule R, a FixedRule or TableRule. The lanes which changed, and which differ from their
+ * state two steps ago, are gathered on the way.
+ */
+template<class R>
+void LockstepBatch::step_rule() {
+    const unsigned birth = R::birth(this->rule), survive = R::survive(this->rule);
+    const int stride = this->width + 2;
+    std::uint64_t changed = 0, changed_twice = 0;
+    for (int y = 1; y <= this->height; y++) {
+        const std::uint64_t *up = &this->current[(y - 1) * stride];
+        const std::uint64_t *mid = &this->current[y * stride];
+        const std::uint64_t *down = &this->current[(y + 1) * stride];
+        const std::uint64_t *before = &this->previous[y * stride];
+        std::uint64_t *out = &this->next[y * stride];
+        for (int x = 1; x <= this->width; x++) {
+            const std::uint64_t cell = life_word(up[x - 1], up[x], up[x + 1], mid[x - 1], mid[x], mid[x + 1],
+                                                 down[x - 1], down[x], down[x + 1], birth, survive);
+            changed |= cell ^ mid[x];
+            changed_twice |= cell ^ before[x];
+            out[x] = cell;
+        }
+    }
+    this->changed = changed;
+    this->changed_twice = changed_twice;
+}
+
+/**
+ * LockstepBatch::advance(steps, toroidal)
+ *
+ * Take any number of steps on every board of the batch.
+ *
+ * @param steps
+ *      The number of steps.
+ *
+ * @param toroidal
+ *      If true then every board is stepped as a torus.
+ */
+void LockstepBatch::advance(const int steps, const bool toroidal) {
+    for (int step = 0; step < steps; step++) {
+        this->step(toroidal);
+    }
+}
+
+/**
+ * LockstepBatch::get_still_lanes()
+ *
+ * Find the boards which the last step did not change. Lanes cleared or loaded since then are not included.
+ *
+ * @example
+ *
+ *      batch.step(false);
+ *      const std::uint64_t still = batch.get_still_lanes();
+ *      for (int lane = 0; lane < LockstepBatch::LANES; lane++) {
+ *          if ((still >> lane) & 1) {
+ *              std::cout << "Lane " << lane << " is a still life" << std::endl;
+ *          }
+ *      }
+ *
+ * @return
+ *      A mask with bit b set if lane b is a still life.
+ */
+std::uint64_t LockstepBatch::get_still_lanes() const {
+    return ~this->changed & this->has_previous;
+}
+
+/**
+ * LockstepBatch::get_period_two_lanes()
+ *
+ * Find the boards which the last two steps brought back to where they started. Still lifes are included,
+ * lanes cleared or loaded less than two steps ago are not.
+ *
+ * @return
+ *      A mask with bit b set if lane b repeats every 1 or 2 steps.
+ */
+std::uint64_t LockstepBatch::get_period_two_lanes() const {
+    return ~this->changed_twice & this->has_history;
+}
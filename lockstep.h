@@ -0,0 +1,92 @@
+/**
+ * Declares a class stepping 64 equally sized boards at once, one board per bit of every word.
+ * Rich documentation for the api and behaviour the LockstepBatch class can be found in lockstep.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the LockstepBatch class.
+ *
+ * Word (x, y) holds cell (x, y) of every board, bit b belonging to board b, or lane b. Stepping applies the
+ * bit-sliced rule of Engine::BITPACKED to whole words, so all 64 boards advance in one pass over the cells.
+ * The words are stored with a one cell border, refreshed before every step, so the kernel never checks bounds.
+ */
+class LockstepBatch {
+public:
+    static const int LANES = 64;                     // Boards in a batch, one per bit of a word
+
+private:
+    int width, height;
+
+    std::vector<std::uint64_t> current;              // (width + 2) x (height + 2) words including the border
+
+    std::vector<std::uint64_t> previous;             // The state before the last step
+
+    std::vector<std::uint64_t> next;                 // Scratch buffer for the next state
+
+    Rule rule;
+
+    std::uint64_t changed;                           // Lanes which changed in the last step
+
+    std::uint64_t changed_twice;                     // Lanes which differ from their state two steps ago
+
+    std::uint64_t has_previous;                      // Lanes whose previous state is valid
+
+    std::uint64_t has_history;                       // Lanes with a valid state two steps ago
+
+    int get_index(const int x, const int y) const;   // Index of a cell inside the border
+
+    void check_lane(const int lane) const;
+
+    void fill_border(const bool toroidal);           // Copies the opposite edges into the border, or clears it
+
+    template<class R>
+    void step_rule();                                // Instantiated per rule in lockstep.cpp
+
+public:
+    LockstepBatch();
+
+    LockstepBatch(const int width, const int height);
+
+    // Member functions
+    int get_width() const;
+
+    int get_height() const;
+
+    // Selects the rule applied to every lane, B3/S23 by default
+    void set_rule(const Rule &rule);
+
+    const Rule &get_rule() const;
+
+    Cell get(const int lane, const int x, const int y) const;
+
+    void set(const int lane, const int x, const int y, const Cell value);
+
+    // Kills every cell of a lane and forgets its history
+    void clear(const int lane);
+
+    // Replaces a lane with a grid of the batch size and forgets its history
+    void load(const int lane, const Grid &grid);
+
+    Grid extract(const int lane) const;
+
+    int get_alive_cells(const int lane) const;
+
+    void step(const bool toroidal);
+
+    void advance(const int steps, const bool toroidal);
+
+    // Mask of the lanes the last step left unchanged, each of them is a still life
+    std::uint64_t get_still_lanes() const;
+
+    // Mask of the lanes back in the state they had two steps ago, each of them a still life or period 2
+    std::uint64_t get_period_two_lanes() const;
+};
@@ -0,0 +1,104 @@
+/**
+ * Implements a class giving read only access to the whole contents of a file.
+ *      - On POSIX systems the file is memory mapped, so nothing is read until it is touched and the pages
+ *        come straight from the page cache without being copied into the process.
+ *      - Elsewhere, or if mapping fails, the file is read into a buffer in one call.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "mapped_file.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOL_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * MappedFile::MappedFile(path)
+ *
+ * Open a file and make its contents available through MappedFile::data().
+ *
+ * @example
+ *
+ *      MappedFile file("path/to/file.bgol");
+ *      std::cout << file.size() << " bytes" << std::endl;
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be opened.
+ */
+MappedFile::MappedFile(const std::string &path) : bytes(nullptr), length(0), mapping(nullptr) {
+#ifdef GOL_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Error Opening file"));
+    }
+    struct stat status;
+    if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+        this->length = static_cast<std::size_t>(status.st_size);
+        if (this->length == 0) {
+            ::close(fd);
+            return;
+        }
+        void *address = ::mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, this->length, MADV_SEQUENTIAL);
+            this->mapping = address;
+            this->bytes = static_cast<const unsigned char *>(address);
+            ::close(fd);
+            return;
+        }
+    }
+    ::close(fd);
+#endif
+    // Not mappable, read the whole file instead
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.good()) {
+        throw std::runtime_error(std::string("Error Opening file"));
+    }
+    this->buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    this->bytes = this->buffer.data();
+    this->length = this->buffer.size();
+}
+
+/**
+ * MappedFile::~MappedFile()
+ *
+ * Unmap the file, any pointers returned by MappedFile::data() become invalid.
+ */
+MappedFile::~MappedFile() {
+#ifdef GOL_HAVE_MMAP
+    if (this->mapping != nullptr) {
+        ::munmap(this->mapping, this->length);
+    }
+#endif
+}
+
+/**
+ * MappedFile::data()
+ *
+ * @return
+ *      A pointer to the first byte of the file, or nullptr if the file is empty.
+ */
+const unsigned char *MappedFile::data() const {
+    return this->bytes;
+}
+
+/**
+ * MappedFile::size()
+ *
+ * @return
+ *      The size of the file in bytes.
+ */
+std::size_t MappedFile::size() const {
+    return this->length;
+}
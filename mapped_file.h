@@ -0,0 +1,42 @@
+/**
+ * Declares a class giving read only access to the whole contents of a file, memory mapped where the platform allows.
+ * Rich documentation for the api and behaviour the MappedFile class can be found in mapped_file.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Declare the structure of the MappedFile class.
+ *
+ * The contents stay valid for the lifetime of the object. MappedFile objects cannot be copied.
+ */
+class MappedFile {
+private:
+    const unsigned char *bytes;
+
+    std::size_t length;
+
+    void *mapping;                                   // The address returned by mmap, nullptr if not mapped
+
+    std::vector<unsigned char> buffer;               // Holds the contents when the file could not be mapped
+
+public:
+    explicit MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Member functions
+    const unsigned char *data() const;
+
+    std::size_t size() const;
+};
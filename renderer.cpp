@@ -0,0 +1,263 @@
+/**
+ * Implements a class drawing grids to the console a whole frame at a time.
+ *      - Frames have the same border of + - and | as operator<< on a Grid.
+ *      - Each frame is built into one buffer, reused from frame to frame, and written with a single call,
+ *        instead of streaming every cell and flushing every line.
+ *      - Large grids can be downsampled with Unicode block or braille glyphs showing up to 2x4 cells per
+ *        character, and a viewport restricts drawing to a window of the grid.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "renderer.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+// UTF-8 encodings of the quadrant blocks, bit 0 top left, bit 1 top right, bit 2 bottom left, bit 3 bottom right
+static const char *const QUADRANT_GLYPHS[16] = {
+        " ", "\xe2\x96\x98", "\xe2\x96\x9d", "\xe2\x96\x80", "\xe2\x96\x96", "\xe2\x96\x8c", "\xe2\x96\x9e",
+        "\xe2\x96\x9b", "\xe2\x96\x97", "\xe2\x96\x9a", "\xe2\x96\x90", "\xe2\x96\x9c", "\xe2\x96\x84",
+        "\xe2\x96\x99", "\xe2\x96\x9f", "\xe2\x96\x88"
+};
+
+// Braille dot of each cell in a 2x4 block, indexed by [y][x]
+static const unsigned BRAILLE_DOTS[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+// Largest number of bytes in the UTF-8 encoding of a glyph
+static const std::size_t MAX_GLYPH_BYTES = 3;
+
+/**
+ * parse_glyphs(name)
+ *
+ * Parses the name of a glyph set, as accepted by the --glyphs command line option.
+ *
+ * @example
+ *
+ *      Renderer renderer(parse_glyphs("braille"));
+ *
+ * @param name
+ *      One of "ascii", "half", "quadrant" or "braille".
+ *
+ * @return
+ *      The named glyph set.
+ *
+ * @throws
+ *      std::runtime_error if the name does not match a glyph set.
+ */
+Glyphs parse_glyphs(const std::string &name) {
+    if (name == "ascii") return Glyphs::ASCII;
+    if (name == "half") return Glyphs::HALF;
+    if (name == "quadrant") return Glyphs::QUADRANT;
+    if (name == "braille") return Glyphs::BRAILLE;
+    throw std::runtime_error(std::string("Unknown glyphs: ") + name);
+}
+
+/**
+ * Renderer::Renderer()
+ *
+ * Construct a renderer drawing whole grids with one ascii character per cell.
+ */
+Renderer::Renderer() : Renderer(Glyphs::ASCII) {
+}
+
+/**
+ * Renderer::Renderer(glyphs)
+ *
+ * Construct a renderer drawing whole grids with the given glyph set.
+ *
+ * @example
+ *
+ *      // Show a 400x400 grid in 200x100 characters
+ *      Renderer renderer(Glyphs::BRAILLE);
+ *      renderer.draw(std::cout, grid);
+ *
+ * @param glyphs
+ *      How many cells each character shows.
+ */
+Renderer::Renderer(const Glyphs glyphs) : glyphs(glyphs), has_viewport(false), view_x(0), view_y(0),
+                                          view_width(0), view_height(0) {
+}
+
+/**
+ * Renderer::get_glyphs()
+ *
+ * @return
+ *      The glyph set frames are drawn with.
+ */
+Glyphs Renderer::get_glyphs() const {
+    return this->glyphs;
+}
+
+/**
+ * Renderer::set_glyphs(glyphs)
+ *
+ * Select the glyph set later frames are drawn with.
+ *
+ * @param glyphs
+ *      How many cells each character shows.
+ */
+void Renderer::set_glyphs(const Glyphs glyphs) {
+    this->glyphs = glyphs;
+}
+
+/**
+ * Renderer::set_viewport(x, y, width, height)
+ *
+ * Restrict later frames to a window of the grid, so only part of a huge grid is drawn.
+ * The window may extend past the grid, cells outside it are drawn as dead.
+ *
+ * @example
+ *
+ *      // Follow the top left 80x40 cells of a large world
+ *      Renderer renderer;
+ *      renderer.set_viewport(0, 0, 80, 40);
+ *      renderer.draw(std::cout, world.state());
+ *
+ * @param x
+ *      The x coordinate of the left edge of the window.
+ *
+ * @param y
+ *      The y coordinate of the top edge of the window.
+ *
+ * @param width
+ *      The width of the window in cells.
+ *
+ * @param height
+ *      The height of the window in cells.
+ *
+ * @throws
+ *      std::runtime_error if the width or height is negative.
+ */
+void Renderer::set_viewport(const int x, const int y, const int width, const int height) {
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("A window has a negative size!"));
+    }
+    this->has_viewport = true;
+    this->view_x = x;
+    this->view_y = y;
+    this->view_width = width;
+    this->view_height = height;
+}
+
+/**
+ * Renderer::clear_viewport()
+ *
+ * Draw whole grids again in later frames.
+ */
+void Renderer::clear_viewport() {
+    this->has_viewport = false;
+}
+
+/**
+ * Renderer::render(grid)
+ *
+ * Build the frame of a grid into the buffer of the renderer, without writing it anywhere.
+ * Glyphs at the right and bottom edges of the window are padded with dead cells.
+ *
+ * @param grid
+ *      The grid to draw.
+ *
+ * @return
+ *      The frame, valid until the next call to render or draw.
+ */
+const std::string &Renderer::render(const Grid &grid) {
+    const int x0 = this->has_viewport ? this->view_x : 0;
+    const int y0 = this->has_viewport ? this->view_y : 0;
+    const int width = this->has_viewport ? this->view_width : grid.get_width();
+    const int height = this->has_viewport ? this->view_height : grid.get_height();
+
+    int cell_width = 1, cell_height = 1;
+    if (this->glyphs == Glyphs::HALF) {
+        cell_height = 2;
+    } else if (this->glyphs == Glyphs::QUADRANT) {
+        cell_width = 2;
+        cell_height = 2;
+    } else if (this->glyphs == Glyphs::BRAILLE) {
+        cell_width = 2;
+        cell_height = 4;
+    }
+    const int columns = (width + cell_width - 1) / cell_width;
+    const int rows = (height + cell_height - 1) / cell_height;
+
+    this->frame.clear();
+    this->frame.reserve((static_cast<std::size_t>(columns) * MAX_GLYPH_BYTES + 3) * (rows + 2));
+    const std::string border = "+" + std::string(columns, '-') + "+\n";
+    this->frame += border;
+
+    // The rows of the grid under one line of glyphs, nullptr where the window leaves the grid
+    const Cell *lines[4];
+    for (int row = 0; row < rows; row++) {
+        for (int dy = 0; dy < cell_height; dy++) {
+            const int y = y0 + row * cell_height + dy;
+            const bool inside = y < y0 + height && y >= 0 && y < grid.get_height();
+            lines[dy] = inside ? grid.row(y) : nullptr;
+        }
+        this->frame += '|';
+        if (this->glyphs == Glyphs::ASCII) {
+            // Cells are stored as their own characters, so the part inside the grid is copied as it is
+            const int first = std::max(x0, 0), last = std::min(x0 + width, grid.get_width());
+            if (lines[0] == nullptr || first >= last) {
+                this->frame.append(width, ' ');
+            } else {
+                this->frame.append(first - x0, ' ');
+                this->frame.append(reinterpret_cast<const char *>(lines[0]) + first, last - first);
+                this->frame.append(x0 + width - last, ' ');
+            }
+        } else {
+            for (int column = 0; column < columns; column++) {
+                unsigned mask = 0;
+                for (int dy = 0; dy < cell_height; dy++) {
+                    if (lines[dy] == nullptr) {
+                        continue;
+                    }
+                    for (int dx = 0; dx < cell_width; dx++) {
+                        const int x = x0 + column * cell_width + dx;
+                        if (x < x0 + width && x >= 0 && x < grid.get_width() && lines[dy][x] == Cell::ALIVE) {
+                            mask |= this->glyphs == Glyphs::BRAILLE ? BRAILLE_DOTS[dy][dx] : 1u << (dy * 2 + dx);
+                        }
+                    }
+                }
+                if (this->glyphs == Glyphs::BRAILLE) {
+                    // U+2800 plus the dots, encoded as three bytes of UTF-8
+                    this->frame += '\xe2';
+                    this->frame += static_cast<char>(0xa0 | (mask >> 6));
+                    this->frame += static_cast<char>(0x80 | (mask & 0x3f));
+                } else {
+                    // Half blocks are the quadrants with both cells of a row equal
+                    const unsigned quadrant = this->glyphs == Glyphs::HALF ? (mask & 1) * 3 + ((mask >> 2) & 1) * 12
+                                                                            : mask;
+                    this->frame += QUADRANT_GLYPHS[quadrant];
+                }
+            }
+        }
+        this->frame += "|\n";
+    }
+    this->frame += border;
+    return this->frame;
+}
+
+/**
+ * Renderer::draw(os, grid)
+ *
+ * Build the frame of a grid and write it to a stream with a single write, followed by a flush.
+ *
+ * @example
+ *
+ *      Renderer renderer(Glyphs::HALF);
+ *      for (int step = 0; step < 100; step++) {
+ *          world.step();
+ *          renderer.draw(std::cout, world.state());
+ *      }
+ *
+ * @param os
+ *      The stream to write to, such as std::cout.
+ *
+ * @param grid
+ *      The grid to draw.
+ */
+void Renderer::draw(std::ostream &os, const Grid &grid) {
+    const std::string &frame = this->render(grid);
+    os.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+    os.flush();
+}
@@ -0,0 +1,60 @@
+/**
+ * Declares a class drawing grids to the console a whole frame at a time.
+ * Rich documentation for the api and behaviour the Renderer class can be found in renderer.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <iostream>
+#include <string>
+#include "grid.h"
+
+/**
+ * How many cells each character of a frame shows.
+ */
+enum class Glyphs {
+    ASCII,                                           // One cell per character, # and space as in operator<<
+    HALF,                                            // 1x2 cells per character with Unicode half blocks
+    QUADRANT,                                        // 2x2 cells per character with Unicode quadrant blocks
+    BRAILLE                                          // 2x4 cells per character with Unicode braille patterns
+};
+
+// Parses a glyph set name such as "ascii" or "braille"
+Glyphs parse_glyphs(const std::string &name);
+
+/**
+ * Declare the structure of the Renderer class.
+ *
+ * A frame is built into a buffer kept between frames, then written to the stream with a single write.
+ */
+class Renderer {
+private:
+    Glyphs glyphs;
+
+    bool has_viewport;
+
+    int view_x, view_y, view_width, view_height;     // The window of the grid drawn, if has_viewport
+
+    std::string frame;                               // Reused for every frame, so it is only allocated once
+
+public:
+    Renderer();
+
+    explicit Renderer(const Glyphs glyphs);
+
+    // Member functions
+    Glyphs get_glyphs() const;
+
+    void set_glyphs(const Glyphs glyphs);
+
+    // Draws only the window [x, x + width) by [y, y + height), cells outside the grid are dead
+    void set_viewport(const int x, const int y, const int width, const int height);
+
+    void clear_viewport();                           // Draws whole grids again
+
+    const std::string &render(const Grid &grid);     // Builds a frame without writing it
+
+    void draw(std::ostream &os, const Grid &grid);   // Builds a frame and writes it out in one go
+};
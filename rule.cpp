@@ -0,0 +1,201 @@
+/**
+ * Implements a class representing a Life-like cellular automaton rule.
+ *      - https://conwaylife.com/wiki/Rulestring
+ *
+ *      - A rule decides the next state of a cell from its own state and its number of alive neighbours.
+ *          - Rules are written in B/S notation: "B3/S23" is born with 3, survives with 2 or 3.
+ *          - Either part may be empty, as in Seeds "B2/S", and the parts may come in either order.
+ *          - The older S/B notation without letters, "23/3", is also accepted.
+ *
+ *      - Conway's Life, HighLife, Seeds and Day & Night have their own RuleKind, which the engines instantiate
+ *        FixedRule kernels for. Every other rule is stepped from its tables by TableRule kernels.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "rule.h"
+#include <cctype>
+#include <stdexcept>
+
+/**
+ * Parses the digits of one part of a rulestring into a mask of neighbour counts.
+ */
+static unsigned parse_counts(const std::string &digits, const std::string &rulestring) {
+    unsigned mask = 0;
+    for (const char digit : digits) {
+        if (digit < '0' || digit > '8' || (mask >> (digit - '0')) & 1) {
+            throw std::runtime_error(std::string("Invalid rulestring: ") + rulestring);
+        }
+        mask |= 1u << (digit - '0');
+    }
+    return mask;
+}
+
+/**
+ * Rule::Rule()
+ *
+ * Construct the rule of Conway's Game of Life, B3/S23.
+ */
+Rule::Rule() : Rule(0x008, 0x00C) {
+}
+
+/**
+ * Rule::Rule(birth, survive)
+ *
+ * Construct a rule from its birth and survive masks.
+ *
+ * @example
+ *
+ *      // HighLife, born with 3 or 6 and surviving with 2 or 3
+ *      Rule highlife((1 << 3) | (1 << 6), (1 << 2) | (1 << 3));
+ *
+ * @param birth
+ *      Bit n is set if a dead cell with n alive neighbours is born.
+ *
+ * @param survive
+ *      Bit n is set if an alive cell with n alive neighbours survives.
+ *
+ * @throws
+ *      std::runtime_error if either mask has bits above neighbour count 8.
+ */
+Rule::Rule(const unsigned birth, const unsigned survive) : birth(birth), survive(survive) {
+    if ((birth | survive) & ~ALL_COUNTS) {
+        throw std::runtime_error(std::string("A rule can only use neighbour counts 0 to 8!"));
+    }
+}
+
+/**
+ * Rule::Rule(rulestring)
+ *
+ * Construct a rule by parsing a rulestring. Letters are case insensitive.
+ *
+ * @example
+ *
+ *      Rule seeds("B2/S");
+ *      Rule day_and_night("B3678/S34678");
+ *      Rule life("23/3");
+ *
+ * @param rulestring
+ *      The rule in B/S or S/B notation.
+ *
+ * @throws
+ *      std::runtime_error if the rulestring cannot be parsed.
+ */
+Rule::Rule(const std::string &rulestring) : birth(0), survive(0) {
+    const std::string::size_type slash = rulestring.find('/');
+    if (slash == std::string::npos || rulestring.find('/', slash + 1) != std::string::npos) {
+        throw std::runtime_error(std::string("Invalid rulestring: ") + rulestring);
+    }
+    std::string parts[2] = {rulestring.substr(0, slash), rulestring.substr(slash + 1)};
+    const char first = parts[0].empty() ? '\0' : static_cast<char>(std::toupper(parts[0][0]));
+    const char second = parts[1].empty() ? '\0' : static_cast<char>(std::toupper(parts[1][0]));
+    if ((first == 'B' && second == 'S') || (first == 'S' && second == 'B')) {
+        const unsigned counts[2] = {parse_counts(parts[0].substr(1), rulestring),
+                                    parse_counts(parts[1].substr(1), rulestring)};
+        this->birth = first == 'B' ? counts[0] : counts[1];
+        this->survive = first == 'B' ? counts[1] : counts[0];
+    } else {
+        // S/B notation, survival comes first
+        this->survive = parse_counts(parts[0], rulestring);
+        this->birth = parse_counts(parts[1], rulestring);
+    }
+}
+
+bool Rule::operator==(const Rule &other) const {
+    return this->birth == other.birth && this->survive == other.survive;
+}
+
+bool Rule::operator!=(const Rule &other) const {
+    return !(*this == other);
+}
+
+/**
+ * Rule::get_birth()
+ *
+ * @return
+ *      The birth mask, bit n is set if a dead cell with n alive neighbours is born.
+ */
+unsigned Rule::get_birth() const {
+    return this->birth;
+}
+
+/**
+ * Rule::get_survive()
+ *
+ * @return
+ *      The survive mask, bit n is set if an alive cell with n alive neighbours survives.
+ */
+unsigned Rule::get_survive() const {
+    return this->survive;
+}
+
+/**
+ * Rule::next(alive, neighbours)
+ *
+ * Applies the rule to a single cell.
+ *
+ * @param alive
+ *      True if the cell is currently alive.
+ *
+ * @param neighbours
+ *      The number of alive neighbours of the cell, 0 to 8.
+ *
+ * @return
+ *      True if the cell is alive in the next generation.
+ */
+bool Rule::next(const bool alive, const int neighbours) const {
+    return ((alive ? this->survive : this->birth) >> neighbours) & 1;
+}
+
+/**
+ * Rule::get_kind()
+ *
+ * Finds which of the specialised rules this rule is, if any.
+ *
+ * @return
+ *      The matching RuleKind, or RuleKind::TABLE for any other rule.
+ */
+RuleKind Rule::get_kind() const {
+    if (*this == Rule(0x008, 0x00C)) return RuleKind::CONWAY;
+    if (*this == Rule(0x048, 0x00C)) return RuleKind::HIGHLIFE;
+    if (*this == Rule(0x004, 0x000)) return RuleKind::SEEDS;
+    if (*this == Rule(0x1C8, 0x1D8)) return RuleKind::DAY_AND_NIGHT;
+    return RuleKind::TABLE;
+}
+
+/**
+ * Rule::births_from_nothing()
+ *
+ * Checks if the rule contains B0. Under such rules empty space comes alive, so they cannot be simulated
+ * on an unbounded plane, which relies on empty space staying empty.
+ *
+ * @return
+ *      True if a dead cell with no alive neighbours is born.
+ */
+bool Rule::births_from_nothing() const {
+    return this->birth & 1;
+}
+
+/**
+ * Rule::to_string()
+ *
+ * Formats the rule in B/S notation, the inverse of Rule::Rule(rulestring).
+ *
+ * @return
+ *      A rulestring such as "B3/S23".
+ */
+std::string Rule::to_string() const {
+    std::string text = "B";
+    for (int n = 0; n <= 8; n++) {
+        if ((this->birth >> n) & 1) {
+            text += static_cast<char>('0' + n);
+        }
+    }
+    text += "/S";
+    for (int n = 0; n <= 8; n++) {
+        if ((this->survive >> n) & 1) {
+            text += static_cast<char>('0' + n);
+        }
+    }
+    return text;
+}
@@ -0,0 +1,88 @@
+/**
+ * Declares a class representing a Life-like rule, such as B3/S23, and the compile-time rules kernels are built for.
+ * Rich documentation for the api and behaviour the Rule class can be found in rule.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <string>
+
+/**
+ * The rules every engine has a kernel specialised for. Any other rule is RuleKind::TABLE.
+ */
+enum class RuleKind {
+    CONWAY,                                          // B3/S23
+    HIGHLIFE,                                        // B36/S23
+    SEEDS,                                           // B2/S
+    DAY_AND_NIGHT,                                   // B3678/S34678
+    TABLE
+};
+
+/**
+ * Declare the structure of the Rule class.
+ *
+ * A rule is two 9 entry tables stored as bit masks: bit n of the birth mask is set if a dead cell with
+ * n alive neighbours is born, and bit n of the survive mask is set if an alive cell with n alive neighbours lives on.
+ */
+class Rule {
+private:
+    unsigned birth;
+
+    unsigned survive;
+
+public:
+    static const unsigned ALL_COUNTS = 0x1FF;        // Mask of the neighbour counts 0 to 8
+
+    Rule();                                          // Default Constructor with Conway's B3/S23
+
+    Rule(const unsigned birth, const unsigned survive);
+
+    explicit Rule(const std::string &rulestring);    // Parses a rulestring such as "B36/S23"
+
+    bool operator==(const Rule &other) const;
+
+    bool operator!=(const Rule &other) const;
+
+    // Member functions
+    unsigned get_birth() const;
+
+    unsigned get_survive() const;
+
+    // Applies the rule to a cell with the given number of alive neighbours
+    bool next(const bool alive, const int neighbours) const;
+
+    RuleKind get_kind() const;
+
+    // True if dead cells with no alive neighbours are born, so empty space does not stay empty
+    bool births_from_nothing() const;
+
+    // Formats the rule as a rulestring in B/S notation
+    std::string to_string() const;
+};
+
+/**
+ * A rule known at compile time. Kernels instantiated with a FixedRule see its masks as constants, so the
+ * neighbour count reduces to the next state with no lookups and no branching on the rule.
+ */
+template<unsigned BIRTH, unsigned SURVIVE>
+struct FixedRule {
+    static unsigned birth(const Rule &) { return BIRTH; }
+
+    static unsigned survive(const Rule &) { return SURVIVE; }
+};
+
+/**
+ * Any other rule, read from the birth and survive tables of a Rule at run time.
+ */
+struct TableRule {
+    static unsigned birth(const Rule &rule) { return rule.get_birth(); }
+
+    static unsigned survive(const Rule &rule) { return rule.get_survive(); }
+};
+
+typedef FixedRule<0x008, 0x00C> ConwayRule;          // B3/S23
+typedef FixedRule<0x048, 0x00C> HighLifeRule;        // B36/S23
+typedef FixedRule<0x004, 0x000> SeedsRule;           // B2/S
+typedef FixedRule<0x1C8, 0x1D8> DayAndNightRule;     // B3678/S34678
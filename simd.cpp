@@ -0,0 +1,480 @@
+/**
+ * Implements the vectorised row kernels used by Engine::SIMD.
+ *      - Every kernel computes the same next state as the scalar kernel used by Engine::BYTE, 16 (SSE2, NEON),
+ *        32 (AVX2) or 64 (AVX-512) cells per instruction.
+ *          - The 9 cells of each neighbourhood are loaded as shifted rows of bytes and compared with
+ *            Cell::ALIVE, giving 0xFF for alive and 0x00 for dead cells.
+ *          - Summing the 8 neighbour masks gives minus the number of alive neighbours in every byte.
+ *          - The rule turns the counts into the next state with one compare per neighbour count it uses.
+ *          - Any columns left over at the end of the row are finished by the scalar kernel.
+ *      - Every kernel is a template over the rule, so the specialised rules compile to just the compares
+ *        they need while any other rule reads its masks at run time.
+ *      - The x86 kernels are built with per-function target attributes so the rest of the program does not
+ *        need to be compiled for AVX2 or AVX-512. The CPU is checked before a kernel is handed out.
+ *      - NEON is part of the baseline on AArch64 so no runtime check is needed there.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "simd.h"
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GOL_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define GOL_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * The scalar kernel, used by Engine::BYTE and to finish the tail of every vectorised row.
+ */
+template<class R>
+static void row_kernel_scalar(const Cell *up, const Cell *mid, const Cell *down, Cell *out,
+                              const int x0, const int x1, const Rule &rule) {
+    const unsigned birth = R::birth(rule), survive = R::survive(rule);
+    for (int x = x0; x < x1; x++) {
+        const int neighbours = (up[x - 1] == Cell::ALIVE) + (up[x] == Cell::ALIVE) + (up[x + 1] == Cell::ALIVE) +
+                               (mid[x - 1] == Cell::ALIVE) + (mid[x + 1] == Cell::ALIVE) +
+                               (down[x - 1] == Cell::ALIVE) + (down[x] == Cell::ALIVE) + (down[x + 1] == Cell::ALIVE);
+        const bool alive = (((mid[x] == Cell::ALIVE) ? survive : birth) >> neighbours) & 1;
+        out[x] = alive ? Cell::ALIVE : Cell::DEAD;
+    }
+}
+
+#ifdef GOL_SIMD_X86
+
+__attribute__((target("sse2")))
+static inline __m128i load_alive_sse2(const Cell *cells, const __m128i alive) {
+    return _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cells)), alive);
+}
+
+/**
+ * Adds the cells with n alive neighbours which are alive next to the 0xFF lanes of next. Counts in both masks
+ * only need a compare, counts in one mask are also masked by the centre cell.
+ */
+__attribute__((target("sse2")))
+static inline __m128i apply_count_sse2(const __m128i next, const __m128i count, const __m128i centre, const int n,
+                                       const unsigned birth, const unsigned survive) {
+    const bool born = (birth >> n) & 1, survives = (survive >> n) & 1;
+    if (!born && !survives) {
+        return next;
+    }
+    const __m128i match = _mm_cmpeq_epi8(count, _mm_set1_epi8(static_cast<char>(n)));
+    return _mm_or_si128(next, born && survives ? match
+                                               : (born ? _mm_andnot_si128(centre, match) : _mm_and_si128(centre, match)));
+}
+
+/**
+ * Applies a rule to 16 neighbour counts, giving 0xFF where the cell is alive next. The counts are written out
+ * rather than looped over so that, for a FixedRule, only the compares the rule needs are left.
+ */
+__attribute__((target("sse2")))
+static inline __m128i apply_rule_sse2(const __m128i count, const __m128i centre,
+                                      const unsigned birth, const unsigned survive) {
+    __m128i next = _mm_setzero_si128();
+    next = apply_count_sse2(next, count, centre, 0, birth, survive);
+    next = apply_count_sse2(next, count, centre, 1, birth, survive);
+    next = apply_count_sse2(next, count, centre, 2, birth, survive);
+    next = apply_count_sse2(next, count, centre, 3, birth, survive);
+    next = apply_count_sse2(next, count, centre, 4, birth, survive);
+    next = apply_count_sse2(next, count, centre, 5, birth, survive);
+    next = apply_count_sse2(next, count, centre, 6, birth, survive);
+    next = apply_count_sse2(next, count, centre, 7, birth, survive);
+    return apply_count_sse2(next, count, centre, 8, birth, survive);
+}
+
+template<class R>
+__attribute__((target("sse2")))
+static void row_kernel_sse2(const Cell *up, const Cell *mid, const Cell *down, Cell *out,
+                            const int x0, const int x1, const Rule &rule) {
+    const unsigned birth = R::birth(rule), survive = R::survive(rule);
+    const __m128i alive = _mm_set1_epi8(Cell::ALIVE);
+    const __m128i dead = _mm_set1_epi8(Cell::DEAD);
+    const __m128i flip = _mm_set1_epi8(Cell::ALIVE ^ Cell::DEAD);
+    int x = x0;
+    for (; x + 16 <= x1; x += 16) {
+        __m128i sum = _mm_add_epi8(load_alive_sse2(up + x - 1, alive), load_alive_sse2(up + x, alive));
+        sum = _mm_add_epi8(sum, load_alive_sse2(up + x + 1, alive));
+        sum = _mm_add_epi8(sum, load_alive_sse2(mid + x - 1, alive));
+        sum = _mm_add_epi8(sum, load_alive_sse2(mid + x + 1, alive));
+        sum = _mm_add_epi8(sum, load_alive_sse2(down + x - 1, alive));
+        sum = _mm_add_epi8(sum, load_alive_sse2(down + x, alive));
+        sum = _mm_add_epi8(sum, load_alive_sse2(down + x + 1, alive));
+        const __m128i count = _mm_sub_epi8(_mm_setzero_si128(), sum);
+        const __m128i centre = load_alive_sse2(mid + x, alive);
+        const __m128i born = apply_rule_sse2(count, centre, birth, survive);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_xor_si128(dead, _mm_and_si128(born, flip)));
+    }
+    row_kernel_scalar<R>(up, mid, down, out, x, x1, rule);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load_alive_avx2(const Cell *cells, const __m256i alive) {
+    return _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells)), alive);
+}
+
+// The AVX2 versions of apply_count_sse2 and apply_rule_sse2
+__attribute__((target("avx2")))
+static inline __m256i apply_count_avx2(const __m256i next, const __m256i count, const __m256i centre, const int n,
+                                       const unsigned birth, const unsigned survive) {
+    const bool born = (birth >> n) & 1, survives = (survive >> n) & 1;
+    if (!born && !survives) {
+        return next;
+    }
+    const __m256i match = _mm256_cmpeq_epi8(count, _mm256_set1_epi8(static_cast<char>(n)));
+    return _mm256_or_si256(next, born && survives ? match
+                                                  : (born ? _mm256_andnot_si256(centre, match)
+                                                          : _mm256_and_si256(centre, match)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i apply_rule_avx2(const __m256i count, const __m256i centre,
+                                      const unsigned birth, const unsigned survive) {
+    __m256i next = _mm256_setzero_si256();
+    next = apply_count_avx2(next, count, centre, 0, birth, survive);
+    next = apply_count_avx2(next, count, centre, 1, birth, survive);
+    next = apply_count_avx2(next, count, centre, 2, birth, survive);
+    next = apply_count_avx2(next, count, centre, 3, birth, survive);
+    next = apply_count_avx2(next, count, centre, 4, birth, survive);
+    next = apply_count_avx2(next, count, centre, 5, birth, survive);
+    next = apply_count_avx2(next, count, centre, 6, birth, survive);
+    next = apply_count_avx2(next, count, centre, 7, birth, survive);
+    return apply_count_avx2(next, count, centre, 8, birth, survive);
+}
+
+template<class R>
+__attribute__((target("avx2")))
+static void row_kernel_avx2(const Cell *up, const Cell *mid, const Cell *down, Cell *out,
+                            const int x0, const int x1, const Rule &rule) {
+    const unsigned birth = R::birth(rule), survive = R::survive(rule);
+    const __m256i alive = _mm256_set1_epi8(Cell::ALIVE);
+    const __m256i dead = _mm256_set1_epi8(Cell::DEAD);
+    const __m256i flip = _mm256_set1_epi8(Cell::ALIVE ^ Cell::DEAD);
+    int x = x0;
+    for (; x + 32 <= x1; x += 32) {
+        __m256i sum = _mm256_add_epi8(load_alive_avx2(up + x - 1, alive), load_alive_avx2(up + x, alive));
+        sum = _mm256_add_epi8(sum, load_alive_avx2(up + x + 1, alive));
+        sum = _mm256_add_epi8(sum, load_alive_avx2(mid + x - 1, alive));
+        sum = _mm256_add_epi8(sum, load_alive_avx2(mid + x + 1, alive));
+        sum = _mm256_add_epi8(sum, load_alive_avx2(down + x - 1, alive));
+        sum = _mm256_add_epi8(sum, load_alive_avx2(down + x, alive));
+        sum = _mm256_add_epi8(sum, load_alive_avx2(down + x + 1, alive));
+        const __m256i count = _mm256_sub_epi8(_mm256_setzero_si256(), sum);
+        const __m256i centre = load_alive_avx2(mid + x, alive);
+        const __m256i born = apply_rule_avx2(count, centre, birth, survive);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x),
+                            _mm256_xor_si256(dead, _mm256_and_si256(born, flip)));
+    }
+    row_kernel_scalar<R>(up, mid, down, out, x, x1, rule);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i load_alive_avx512(const Cell *cells, const __m512i alive, const __m512i one) {
+    const __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(cells), alive);
+    return _mm512_maskz_mov_epi8(mask, one);
+}
+
+// The AVX-512 versions of apply_count_sse2 and apply_rule_sse2, working on mask registers
+__attribute__((target("avx512f,avx512bw")))
+static inline __mmask64 apply_count_avx512(const __mmask64 next, const __m512i count, const __mmask64 centre,
+                                           const int n, const unsigned birth, const unsigned survive) {
+    const bool born = (birth >> n) & 1, survives = (survive >> n) & 1;
+    if (!born && !survives) {
+        return next;
+    }
+    const __mmask64 match = _mm512_cmpeq_epi8_mask(count, _mm512_set1_epi8(static_cast<char>(n)));
+    return next | (born && survives ? match : (born ? ~centre & match : centre & match));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __mmask64 apply_rule_avx512(const __m512i count, const __mmask64 centre,
+                                          const unsigned birth, const unsigned survive) {
+    __mmask64 next = 0;
+    next = apply_count_avx512(next, count, centre, 0, birth, survive);
+    next = apply_count_avx512(next, count, centre, 1, birth, survive);
+    next = apply_count_avx512(next, count, centre, 2, birth, survive);
+    next = apply_count_avx512(next, count, centre, 3, birth, survive);
+    next = apply_count_avx512(next, count, centre, 4, birth, survive);
+    next = apply_count_avx512(next, count, centre, 5, birth, survive);
+    next = apply_count_avx512(next, count, centre, 6, birth, survive);
+    next = apply_count_avx512(next, count, centre, 7, birth, survive);
+    return apply_count_avx512(next, count, centre, 8, birth, survive);
+}
+
+template<class R>
+__attribute__((target("avx512f,avx512bw")))
+static void row_kernel_avx512(const Cell *up, const Cell *mid, const Cell *down, Cell *out,
+                              const int x0, const int x1, const Rule &rule) {
+    const unsigned birth = R::birth(rule), survive = R::survive(rule);
+    const __m512i alive = _mm512_set1_epi8(Cell::ALIVE);
+    const __m512i dead = _mm512_set1_epi8(Cell::DEAD);
+    const __m512i one = _mm512_set1_epi8(1);
+    int x = x0;
+    for (; x + 64 <= x1; x += 64) {
+        __m512i count = _mm512_add_epi8(load_alive_avx512(up + x - 1, alive, one),
+                                        load_alive_avx512(up + x, alive, one));
+        count = _mm512_add_epi8(count, load_alive_avx512(up + x + 1, alive, one));
+        count = _mm512_add_epi8(count, load_alive_avx512(mid + x - 1, alive, one));
+        count = _mm512_add_epi8(count, load_alive_avx512(mid + x + 1, alive, one));
+        count = _mm512_add_epi8(count, load_alive_avx512(down + x - 1, alive, one));
+        count = _mm512_add_epi8(count, load_alive_avx512(down + x, alive, one));
+        count = _mm512_add_epi8(count, load_alive_avx512(down + x + 1, alive, one));
+        const __mmask64 centre = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(mid + x), alive);
+        const __mmask64 born = apply_rule_avx512(count, centre, birth, survive);
+        _mm512_storeu_si512(out + x, _mm512_mask_blend_epi8(born, dead, alive));
+    }
+    row_kernel_scalar<R>(up, mid, down, out, x, x1, rule);
+}
+
+#endif
+
+#ifdef GOL_SIMD_NEON
+
+static inline uint8x16_t load_alive_neon(const Cell *cells, const uint8x16_t alive, const uint8x16_t one) {
+    return vandq_u8(vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(cells)), alive), one);
+}
+
+// The NEON versions of apply_count_sse2 and apply_rule_sse2
+static inline uint8x16_t apply_count_neon(const uint8x16_t next, const uint8x16_t count, const uint8x16_t centre,
+                                          const int n, const unsigned birth, const unsigned survive) {
+    const bool born = (birth >> n) & 1, survives = (survive >> n) & 1;
+    if (!born && !survives) {
+        return next;
+    }
+    const uint8x16_t match = vceqq_u8(count, vdupq_n_u8(static_cast<uint8_t>(n)));
+    return vorrq_u8(next, born && survives ? match : (born ? vbicq_u8(match, centre) : vandq_u8(centre, match)));
+}
+
+static inline uint8x16_t apply_rule_neon(const uint8x16_t count, const uint8x16_t centre,
+                                         const unsigned birth, const unsigned survive) {
+    uint8x16_t next = vdupq_n_u8(0);
+    next = apply_count_neon(next, count, centre, 0, birth, survive);
+    next = apply_count_neon(next, count, centre, 1, birth, survive);
+    next = apply_count_neon(next, count, centre, 2, birth, survive);
+    next = apply_count_neon(next, count, centre, 3, birth, survive);
+    next = apply_count_neon(next, count, centre, 4, birth, survive);
+    next = apply_count_neon(next, count, centre, 5, birth, survive);
+    next = apply_count_neon(next, count, centre, 6, birth, survive);
+    next = apply_count_neon(next, count, centre, 7, birth, survive);
+    return apply_count_neon(next, count, centre, 8, birth, survive);
+}
+
+template<class R>
+static void row_kernel_neon(const Cell *up, const Cell *mid, const Cell *down, Cell *out,
+                            const int x0, const int x1, const Rule &rule) {
+    const unsigned birth = R::birth(rule), survive = R::survive(rule);
+    const uint8x16_t alive = vdupq_n_u8(static_cast<uint8_t>(Cell::ALIVE));
+    const uint8x16_t dead = vdupq_n_u8(static_cast<uint8_t>(Cell::DEAD));
+    const uint8x16_t one = vdupq_n_u8(1);
+    int x = x0;
+    for (; x + 16 <= x1; x += 16) {
+        uint8x16_t count = vaddq_u8(load_alive_neon(up + x - 1, alive, one), load_alive_neon(up + x, alive, one));
+        count = vaddq_u8(count, load_alive_neon(up + x + 1, alive, one));
+        count = vaddq_u8(count, load_alive_neon(mid + x - 1, alive, one));
+        count = vaddq_u8(count, load_alive_neon(mid + x + 1, alive, one));
+        count = vaddq_u8(count, load_alive_neon(down + x - 1, alive, one));
+        count = vaddq_u8(count, load_alive_neon(down + x, alive, one));
+        count = vaddq_u8(count, load_alive_neon(down + x + 1, alive, one));
+        const uint8x16_t centre = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mid + x)), alive);
+        const uint8x16_t born = apply_rule_neon(count, centre, birth, survive);
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + x), vbslq_u8(born, alive, dead));
+    }
+    row_kernel_scalar<R>(up, mid, down, out, x, x1, rule);
+}
+
+#endif
+
+/**
+ * Picks the kernel for an instruction set, instantiated for one rule.
+ */
+template<class R>
+static RowKernel select_row_kernel(const SimdLevel level) {
+    switch (level) {
+#ifdef GOL_SIMD_X86
+        case SimdLevel::SSE2:
+            return row_kernel_sse2<R>;
+        case SimdLevel::AVX2:
+            return row_kernel_avx2<R>;
+        case SimdLevel::AVX512:
+            return row_kernel_avx512<R>;
+#endif
+#ifdef GOL_SIMD_NEON
+        case SimdLevel::NEON:
+            return row_kernel_neon<R>;
+#endif
+        default:
+            return row_kernel_scalar<R>;
+    }
+}
+
+/**
+ * simd_level_supported(level)
+ *
+ * Checks if the running CPU, and the compiler this program was built with, can execute the kernel for
+ * an instruction set. SimdLevel::AUTO and SimdLevel::SCALAR are always supported.
+ *
+ * @param level
+ *      The instruction set to check.
+ *
+ * @return
+ *      True if get_row_kernel(level) will succeed.
+ */
+bool simd_level_supported(const SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AUTO:
+        case SimdLevel::SCALAR:
+            return true;
+#ifdef GOL_SIMD_X86
+        case SimdLevel::SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case SimdLevel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        case SimdLevel::AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+#ifdef GOL_SIMD_NEON
+        case SimdLevel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * detect_simd_level()
+ *
+ * Finds the widest instruction set the running CPU supports.
+ *
+ * @return
+ *      The widest supported level, SimdLevel::SCALAR if no vector kernel can run.
+ */
+SimdLevel detect_simd_level() {
+    const SimdLevel widest_first[] = {SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSE2, SimdLevel::NEON};
+    for (const SimdLevel level : widest_first) {
+        if (simd_level_supported(level)) {
+            return level;
+        }
+    }
+    return SimdLevel::SCALAR;
+}
+
+/**
+ * resolve_simd_level(level)
+ *
+ * Resolves SimdLevel::AUTO to the widest supported instruction set.
+ *
+ * @param level
+ *      The requested instruction set.
+ *
+ * @return
+ *      The detected level for SimdLevel::AUTO, otherwise level itself.
+ */
+SimdLevel resolve_simd_level(const SimdLevel level) {
+    return level == SimdLevel::AUTO ? detect_simd_level() : level;
+}
+
+/**
+ * get_row_kernel(level, rule)
+ *
+ * Gets the row kernel built for an instruction set and rule. The specialised rules get kernels with the rule
+ * compiled in, any other rule gets a kernel reading the rule passed to it.
+ *
+ * @example
+ *
+ *      // Step the interior of a row with the widest kernel the CPU supports
+ *      const Rule rule("B36/S23");
+ *      RowKernel kernel = get_row_kernel(SimdLevel::AUTO, rule);
+ *      kernel(up, mid, down, out, 1, width - 1, rule);
+ *
+ * @param level
+ *      The instruction set, SimdLevel::AUTO picks the widest supported one.
+ *
+ * @param rule
+ *      The rule the kernel will be called with.
+ *
+ * @return
+ *      A pointer to the kernel.
+ *
+ * @throws
+ *      std::runtime_error if the running CPU or this build does not support the instruction set.
+ */
+RowKernel get_row_kernel(const SimdLevel level, const Rule &rule) {
+    const SimdLevel resolved = resolve_simd_level(level);
+    if (!simd_level_supported(resolved)) {
+        throw std::runtime_error(std::string("The CPU does not support ") + simd_level_name(resolved) + "!");
+    }
+    switch (rule.get_kind()) {
+        case RuleKind::CONWAY:
+            return select_row_kernel<ConwayRule>(resolved);
+        case RuleKind::HIGHLIFE:
+            return select_row_kernel<HighLifeRule>(resolved);
+        case RuleKind::SEEDS:
+            return select_row_kernel<SeedsRule>(resolved);
+        case RuleKind::DAY_AND_NIGHT:
+            return select_row_kernel<DayAndNightRule>(resolved);
+        default:
+            return select_row_kernel<TableRule>(resolved);
+    }
+}
+
+/**
+ * parse_simd_level(name)
+ *
+ * Parses the name of an instruction set, as accepted by the --simd command line option.
+ *
+ * @param name
+ *      One of "auto", "scalar", "sse2", "avx2", "avx512" or "neon".
+ *
+ * @return
+ *      The named instruction set.
+ *
+ * @throws
+ *      std::runtime_error if the name does not match an instruction set.
+ */
+SimdLevel parse_simd_level(const std::string &name) {
+    const SimdLevel levels[] = {SimdLevel::AUTO, SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2,
+                                SimdLevel::AVX512, SimdLevel::NEON};
+    for (const SimdLevel level : levels) {
+        if (simd_level_name(level) == name) {
+            return level;
+        }
+    }
+    throw std::runtime_error(std::string("Unknown instruction set: ") + name);
+}
+
+/**
+ * simd_level_name(level)
+ *
+ * Gets the name of an instruction set, the inverse of parse_simd_level(name).
+ *
+ * @param level
+ *      The instruction set.
+ *
+ * @return
+ *      The lower case name of the instruction set.
+ */
+std::string simd_level_name(const SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AUTO:
+            return "auto";
+        case SimdLevel::SCALAR:
+            return "scalar";
+        case SimdLevel::SSE2:
+            return "sse2";
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::AVX512:
+            return "avx512";
+        case SimdLevel::NEON:
+            return "neon";
+    }
+    return "unknown";
+}
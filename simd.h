@@ -0,0 +1,49 @@
+/**
+ * Declares the vectorised row kernels used by Engine::SIMD to step the interior of a byte-per-cell Grid.
+ * Rich documentation for the api and behaviour of the kernels can be found in simd.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <string>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * The instruction sets a row kernel can be built for. SimdLevel::AUTO picks the widest one the CPU supports.
+ */
+enum class SimdLevel {
+    AUTO,
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512,
+    NEON
+};
+
+/**
+ * A row kernel writes out[x] for every x in [x0, x1) from the rows above, at and below the row.
+ * The caller guarantees that x0 - 1 and x1 are valid columns, so the kernel never needs to check bounds.
+ * The rule must be the one the kernel was requested for.
+ */
+typedef void (*RowKernel)(const Cell *up, const Cell *mid, const Cell *down, Cell *out, int x0, int x1,
+                          const Rule &rule);
+
+// Returns the widest instruction set supported by the running CPU
+SimdLevel detect_simd_level();
+
+// Checks if the running CPU can execute kernels built for an instruction set
+bool simd_level_supported(const SimdLevel level);
+
+// Resolves SimdLevel::AUTO to the detected level, other levels are returned unchanged
+SimdLevel resolve_simd_level(const SimdLevel level);
+
+// Returns the row kernel for an instruction set and rule, throwing if the CPU cannot run it
+RowKernel get_row_kernel(const SimdLevel level, const Rule &rule);
+
+// Parses an instruction set name such as "auto", "scalar", "sse2", "avx2", "avx512" or "neon"
+SimdLevel parse_simd_level(const std::string &name);
+
+std::string simd_level_name(const SimdLevel level);
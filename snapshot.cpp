@@ -0,0 +1,461 @@
+/**
+ * Implements a Snapshot namespace for saving and loading grids in a versioned, chunked and compressed format.
+ *
+ *      - Snapshot files are composed of:
+ *          - A 48 byte header.
+ *              - The magic number "GOLS".
+ *              - A 2 byte order marker 0x0102 and a 2 byte version, currently 1.
+ *              - A 4 byte int width and a 4 byte int height.
+ *              - An 8 byte generation number.
+ *              - The 4 byte birth and 4 byte survive masks of the rule, see Rule.
+ *              - A 4 byte chunk size and a 4 byte number of chunks.
+ *              - The 8 byte offset of the index.
+ *          - The chunks. The grid is split into chunk size x chunk size squares, in row major order, smaller
+ *            along the right and bottom edges. Each holds its cells as bits, row by row and bit 0 first,
+ *            padded to a whole byte, with 1 for Cell::ALIVE. The bits are then stored as they are, or run-length
+ *            encoded, whichever is smaller. Chunks with no alive cells store nothing at all.
+ *          - The index, one 16 byte entry per chunk: an 8 byte offset, a 4 byte stored size and
+ *            a 4 byte Compression.
+ *
+ *      - Every number is written in the byte order of the machine that wrote it, which the marker records.
+ *        Readers on a machine of the other byte order swap the numbers as they read them.
+ *
+ *      - Since chunks are compressed independently and located through the index, a window of the grid can
+ *        be loaded by decoding only the chunks overlapping it.
+ *
+ *      - Run-length encoding works on bytes. A control byte c below 128 is followed by c + 1 literal bytes,
+ *        a control byte c of 128 or more is followed by one byte repeated c - 126 times.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "mapped_file.h"
+#include "stats.h"
+
+static const char MAGIC[4] = {'G', 'O', 'L', 'S'};
+
+static const std::uint16_t ORDER_MARKER = 0x0102;
+
+static const std::size_t HEADER_BYTES = 48;
+
+static const std::size_t INDEX_ENTRY_BYTES = 16;
+
+static const std::size_t MAX_LITERAL = 128, MAX_RUN = 129;
+
+/**
+ * Appends a number to a buffer in the byte order of this machine.
+ */
+template<typename T>
+static void put(std::vector<unsigned char> &out, const T value) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * Run-length encodes a buffer of bytes, as described at the top of this file.
+ */
+static void rle_encode(const std::vector<unsigned char> &in, std::vector<unsigned char> &out) {
+    out.clear();
+    std::size_t i = 0;
+    while (i < in.size()) {
+        std::size_t run = 1;
+        while (i + run < in.size() && run < MAX_RUN && in[i + run] == in[i]) {
+            run++;
+        }
+        if (run >= 2) {
+            out.push_back(static_cast<unsigned char>(126 + run));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        // Gather literals up to the start of the next run
+        std::size_t literal = 1;
+        while (i + literal < in.size() && literal < MAX_LITERAL &&
+               !(i + literal + 1 < in.size() && in[i + literal] == in[i + literal + 1])) {
+            literal++;
+        }
+        out.push_back(static_cast<unsigned char>(literal - 1));
+        out.insert(out.end(), in.begin() + i, in.begin() + i + literal);
+        i += literal;
+    }
+}
+
+/**
+ * Decodes run-length encoded bytes, throwing unless they decode to exactly out.size() bytes.
+ */
+static void rle_decode(const unsigned char *in, const std::size_t size, std::vector<unsigned char> &out) {
+    std::size_t used = 0, i = 0;
+    while (i < size) {
+        const unsigned control = in[i++];
+        if (control < 128) {
+            const std::size_t literal = control + 1;
+            if (i + literal > size || used + literal > out.size()) {
+                throw std::runtime_error(std::string("Corrupted snapshot file!"));
+            }
+            std::memcpy(out.data() + used, in + i, literal);
+            used += literal;
+            i += literal;
+        } else {
+            const std::size_t run = control - 126;
+            if (i >= size || used + run > out.size()) {
+                throw std::runtime_error(std::string("Corrupted snapshot file!"));
+            }
+            std::memset(out.data() + used, in[i++], run);
+            used += run;
+        }
+    }
+    if (used != out.size()) {
+        throw std::runtime_error(std::string("Corrupted snapshot file!"));
+    }
+}
+
+/**
+ * A snapshot mapped into memory, with its header parsed and numbers swapped to the byte order of this machine.
+ */
+class SnapshotReader {
+private:
+    MappedFile file;
+
+    bool swapped;                                    // True if the file was written with the other byte order
+
+    std::uint64_t index_offset;
+
+    template<typename T>
+    T get(const std::size_t offset) const {
+        if (offset + sizeof(T) > this->file.size()) {
+            throw std::runtime_error(std::string("File Ends unexpectedly!"));
+        }
+        T value;
+        std::memcpy(&value, this->file.data() + offset, sizeof(T));
+        if (this->swapped) {
+            unsigned char *bytes = reinterpret_cast<unsigned char *>(&value);
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        return value;
+    }
+
+public:
+    Snapshot::Info info;
+
+    int chunks_x, chunks_y;
+
+    explicit SnapshotReader(const std::string &path) : file(path), swapped(false), chunks_x(0), chunks_y(0) {
+        if (!Snapshot::is_snapshot(this->file.data(), this->file.size())) {
+            throw std::runtime_error(std::string("Not a snapshot file!"));
+        }
+        if (this->file.size() < HEADER_BYTES) {
+            throw std::runtime_error(std::string("File Ends unexpectedly!"));
+        }
+        const std::uint16_t order = this->get<std::uint16_t>(4);
+        if (order != ORDER_MARKER) {
+            this->swapped = true;
+            if (this->get<std::uint16_t>(4) != ORDER_MARKER) {
+                throw std::runtime_error(std::string("Corrupted snapshot file!"));
+            }
+        }
+        this->info.version = this->get<std::uint16_t>(6);
+        if (this->info.version == 0 || this->info.version > Snapshot::VERSION) {
+            throw std::runtime_error(std::string("Unsupported snapshot version!"));
+        }
+        this->info.width = this->get<std::int32_t>(8);
+        this->info.height = this->get<std::int32_t>(12);
+        this->info.generation = this->get<std::uint64_t>(16);
+        this->info.rule = Rule(this->get<std::uint32_t>(24), this->get<std::uint32_t>(28));
+        this->info.chunk_size = static_cast<int>(this->get<std::uint32_t>(32));
+        const std::uint32_t chunks = this->get<std::uint32_t>(36);
+        this->index_offset = this->get<std::uint64_t>(40);
+        if (this->info.width < 0 || this->info.height < 0 || this->info.chunk_size <= 0) {
+            throw std::runtime_error(std::string("Wrong width or height"));
+        }
+        const int size = this->info.chunk_size;
+        this->chunks_x = this->info.width / size + (this->info.width % size != 0);
+        this->chunks_y = this->info.height / size + (this->info.height % size != 0);
+        if (static_cast<std::uint64_t>(this->chunks_x) * this->chunks_y != chunks) {
+            throw std::runtime_error(std::string("Corrupted snapshot file!"));
+        }
+        if (this->index_offset > this->file.size() ||
+            (this->file.size() - this->index_offset) / INDEX_ENTRY_BYTES < chunks) {
+            throw std::runtime_error(std::string("File Ends unexpectedly!"));
+        }
+    }
+
+    /**
+     * Decodes the cells of a chunk and ORs the alive ones inside the window [x0, x1) by [y0, y1) into a grid,
+     * with (x0, y0) at (0, 0) of the grid.
+     */
+    void decode_chunk(const int chunk, Grid &grid, const int x0, const int y0, const int x1, const int y1,
+                      std::vector<unsigned char> &bits) const {
+        const std::size_t entry = static_cast<std::size_t>(this->index_offset) + chunk * INDEX_ENTRY_BYTES;
+        const std::uint64_t offset = this->get<std::uint64_t>(entry);
+        const std::uint32_t stored = this->get<std::uint32_t>(entry + 8);
+        const std::uint32_t compression = this->get<std::uint32_t>(entry + 12);
+        if (stored == 0) {
+            return;
+        }
+        Stats::add(Stats::Counter::BYTES_READ, stored);
+        if (offset > this->file.size() || this->file.size() - offset < stored) {
+            throw std::runtime_error(std::string("File Ends unexpectedly!"));
+        }
+        const int size = this->info.chunk_size;
+        const int cx0 = (chunk % this->chunks_x) * size, cy0 = (chunk / this->chunks_x) * size;
+        const int chunk_width = std::min(size, this->info.width - cx0);
+        const int chunk_height = std::min(size, this->info.height - cy0);
+        const std::size_t row_bytes = (static_cast<std::size_t>(chunk_width) + 7) / 8;
+        bits.assign(row_bytes * chunk_height, 0);
+
+        const unsigned char *data = this->file.data() + offset;
+        switch (static_cast<Snapshot::Compression>(compression)) {
+            case Snapshot::Compression::NONE:
+                if (stored != bits.size()) {
+                    throw std::runtime_error(std::string("Corrupted snapshot file!"));
+                }
+                std::memcpy(bits.data(), data, bits.size());
+                break;
+            case Snapshot::Compression::RLE:
+                rle_decode(data, stored, bits);
+                break;
+            default:
+                throw std::runtime_error(std::string("Unsupported snapshot compression!"));
+        }
+
+        const int row_begin = std::max(y0, cy0), row_end = std::min(y1, cy0 + chunk_height);
+        const int column_begin = std::max(x0, cx0), column_end = std::min(x1, cx0 + chunk_width);
+        for (int y = row_begin; y < row_end; y++) {
+            const unsigned char *row = bits.data() + (y - cy0) * row_bytes;
+            Cell *out = grid.row(y - y0);
+            for (int x = column_begin; x < column_end; x++) {
+                if ((row[(x - cx0) / 8] >> ((x - cx0) % 8)) & 1) {
+                    out[x - x0] = Cell::ALIVE;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Decodes the window [x0, x1) by [y0, y1) of an open snapshot, touching only the chunks overlapping it.
+ */
+static Grid load_window(const SnapshotReader &reader, const int x0, const int y0, const int x1, const int y1) {
+    const Snapshot::Info &info = reader.info;
+    if (x0 < 0 || y0 < 0 || x1 > info.width || y1 > info.height) {
+        throw std::runtime_error(std::string("One of the arguments is not a valid coordinate!"));
+    }
+    if (x1 < x0 || y1 < y0) {
+        throw std::runtime_error(std::string("A window has a negative size!"));
+    }
+    Grid grid(x1 - x0, y1 - y0);
+    if (x0 == x1 || y0 == y1) {
+        return grid;
+    }
+    std::vector<unsigned char> bits;
+    const int size = info.chunk_size;
+    for (int cy = y0 / size; cy <= (y1 - 1) / size; cy++) {
+        for (int cx = x0 / size; cx <= (x1 - 1) / size; cx++) {
+            reader.decode_chunk(cy * reader.chunks_x + cx, grid, x0, y0, x1, y1, bits);
+        }
+    }
+    return grid;
+}
+
+/**
+ * Snapshot::is_snapshot(data, size)
+ *
+ * Checks the magic number at the start of a file, so loaders can tell snapshots from the older .bgol format.
+ *
+ * @param data
+ *      The first bytes of the file.
+ *
+ * @param size
+ *      The number of bytes available at data.
+ *
+ * @return
+ *      True if the bytes start with the snapshot magic number.
+ */
+bool Snapshot::is_snapshot(const unsigned char *data, const std::size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/**
+ * Snapshot::save(path, grid, generation, rule, chunk_size)
+ *
+ * Save a grid as a snapshot. Each chunk is encoded and written as soon as it is packed, so only one chunk
+ * is held in memory at a time besides the index.
+ *
+ * @example
+ *
+ *      // Checkpoint a world along with how far it was simulated
+ *      Snapshot::save("path/to/checkpoint.gols", world.state(), 1000, Rule("B36/S23"));
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param grid
+ *      The grid to be written out to file.
+ *
+ * @param generation
+ *      Optional parameter. The generation the grid holds, defaults to 0.
+ *
+ * @param rule
+ *      Optional parameter. The rule the grid is simulated with, defaults to B3/S23.
+ *
+ * @param chunk_size
+ *      Optional parameter. The edge length of the chunks, defaults to DEFAULT_CHUNK_SIZE. Smaller chunks make
+ *      loading small regions cheaper at the cost of a larger index.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the chunk size is not positive or the file cannot be written.
+ */
+void Snapshot::save(const std::string &path, const Grid &grid, const std::uint64_t generation, const Rule &rule,
+                    const int chunk_size) {
+    if (chunk_size <= 0) {
+        throw std::runtime_error(std::string("The chunk size must be positive!"));
+    }
+    std::ofstream file;
+    file.open(path, std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error(std::string("Can't open the file!"));
+    }
+    const int width = grid.get_width();
+    const int height = grid.get_height();
+    const int chunks_x = width / chunk_size + (width % chunk_size != 0);
+    const int chunks_y = height / chunk_size + (height % chunk_size != 0);
+    const std::uint32_t chunks = static_cast<std::uint32_t>(chunks_x) * static_cast<std::uint32_t>(chunks_y);
+
+    // The index offset is only known once every chunk is written, it is patched in at the end
+    std::vector<unsigned char> header;
+    header.insert(header.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    put<std::uint16_t>(header, ORDER_MARKER);
+    put<std::uint16_t>(header, VERSION);
+    put<std::int32_t>(header, width);
+    put<std::int32_t>(header, height);
+    put<std::uint64_t>(header, generation);
+    put<std::uint32_t>(header, rule.get_birth());
+    put<std::uint32_t>(header, rule.get_survive());
+    put<std::uint32_t>(header, static_cast<std::uint32_t>(chunk_size));
+    put<std::uint32_t>(header, chunks);
+    put<std::uint64_t>(header, 0);
+    file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+
+    std::vector<unsigned char> index, bits, encoded;
+    std::uint64_t offset = HEADER_BYTES;
+    for (int cy = 0; cy < chunks_y; cy++) {
+        for (int cx = 0; cx < chunks_x; cx++) {
+            const int x0 = cx * chunk_size, y0 = cy * chunk_size;
+            const int chunk_width = std::min(chunk_size, width - x0);
+            const int chunk_height = std::min(chunk_size, height - y0);
+            const std::size_t row_bytes = (static_cast<std::size_t>(chunk_width) + 7) / 8;
+            bits.assign(row_bytes * chunk_height, 0);
+            bool any = false;
+            for (int y = 0; y < chunk_height; y++) {
+                const Cell *row = grid.row(y0 + y) + x0;
+                unsigned char *out = bits.data() + y * row_bytes;
+                for (int x = 0; x < chunk_width; x++) {
+                    if (row[x] == Cell::ALIVE) {
+                        out[x / 8] |= static_cast<unsigned char>(1 << (x % 8));
+                        any = true;
+                    }
+                }
+            }
+
+            Compression compression = Compression::NONE;
+            const std::vector<unsigned char> *stored = &bits;
+            if (!any) {
+                bits.clear();
+            } else {
+                rle_encode(bits, encoded);
+                if (encoded.size() < bits.size()) {
+                    compression = Compression::RLE;
+                    stored = &encoded;
+                }
+            }
+            file.write(reinterpret_cast<const char *>(stored->data()), static_cast<std::streamsize>(stored->size()));
+            put<std::uint64_t>(index, offset);
+            put<std::uint32_t>(index, static_cast<std::uint32_t>(stored->size()));
+            put<std::uint32_t>(index, static_cast<std::uint32_t>(compression));
+            offset += stored->size();
+        }
+    }
+    file.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(index.size()));
+    file.seekp(40);
+    file.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+    if (!file) {
+        throw std::runtime_error(std::string("Can't write the file!"));
+    }
+    file.close();
+    Stats::add(Stats::Counter::BYTES_WRITTEN, offset + index.size());
+}
+
+/**
+ * Snapshot::read_info(path)
+ *
+ * Read the header of a snapshot without decoding any cells.
+ *
+ * @example
+ *
+ *      // Resume a simulation with the rule it was saved with
+ *      Snapshot::Info info = Snapshot::read_info("path/to/checkpoint.gols");
+ *      World world(Snapshot::load("path/to/checkpoint.gols"));
+ *      world.set_rule(info.rule);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      The fields of the header.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened, is not a snapshot,
+ *      is of a newer version, or is truncated.
+ */
+Snapshot::Info Snapshot::read_info(const std::string &path) {
+    return SnapshotReader(path).info;
+}
+
+/**
+ * Snapshot::load(path)
+ *
+ * Load a whole snapshot as a grid.
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened, is not a snapshot,
+ *      is of a newer version, uses a compression this build does not support, is truncated or is corrupted.
+ */
+Grid Snapshot::load(const std::string &path) {
+    const SnapshotReader reader(path);
+    return load_window(reader, 0, 0, reader.info.width, reader.info.height);
+}
+
+/**
+ * Snapshot::load_region(path, x0, y0, x1, y1)
+ *
+ * Load the window [x0, x1) by [y0, y1) of a snapshot, decoding only the chunks that overlap it.
+ * Cell (x0, y0) of the snapshot becomes cell (0, 0) of the grid.
+ *
+ * @example
+ *
+ *      // Look at the top left corner of a huge checkpoint
+ *      Grid corner = Snapshot::load_region("path/to/checkpoint.gols", 0, 0, 512, 512);
+ *
+ * @return
+ *      A grid of size (x1 - x0) by (y1 - y0).
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the window does not lie within the grid, or for any of the
+ *      reasons Snapshot::load(path) throws.
+ */
+Grid Snapshot::load_region(const std::string &path, const int x0, const int y0, const int x1, const int y1) {
+    const SnapshotReader reader(path);
+    return load_window(reader, x0, y0, x1, y1);
+}
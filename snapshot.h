@@ -0,0 +1,63 @@
+/**
+ * Declares a Snapshot namespace for saving and loading grids in a versioned, chunked and compressed binary format.
+ * Rich documentation for the api and the file format can be found in snapshot.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the interface of the Snapshot namespace.
+ */
+namespace Snapshot {
+    static const std::uint16_t VERSION = 1;          // The newest version this build reads and writes
+
+    static const int DEFAULT_CHUNK_SIZE = 256;       // Chunks are DEFAULT_CHUNK_SIZE x DEFAULT_CHUNK_SIZE cells
+
+    /**
+     * How the bits of a chunk are stored. ZSTD and LZ4 are reserved, this build cannot read or write them.
+     */
+    enum class Compression : std::uint32_t {
+        NONE = 0,
+        RLE = 1,
+        ZSTD = 2,
+        LZ4 = 3
+    };
+
+    /**
+     * Everything stored in the header of a snapshot, besides the layout of the file itself.
+     */
+    struct Info {
+        std::uint16_t version;
+
+        int width, height;
+
+        std::uint64_t generation;
+
+        Rule rule;
+
+        int chunk_size;
+    };
+
+    // Checks if the first bytes of a file are the magic number of a snapshot
+    bool is_snapshot(const unsigned char *data, const std::size_t size);
+
+    // Saves a grid, with the rule and generation it was simulated to
+    void save(const std::string &path, const Grid &grid, const std::uint64_t generation = 0,
+              const Rule &rule = Rule(), const int chunk_size = DEFAULT_CHUNK_SIZE);
+
+    // Reads the header of a snapshot without decoding any cells
+    Info read_info(const std::string &path);
+
+    Grid load(const std::string &path);
+
+    // Decodes only the chunks overlapping the window [x0, x1) by [y0, y1)
+    Grid load_region(const std::string &path, const int x0, const int y0, const int x1, const int y1);
+};
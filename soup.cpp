@@ -0,0 +1,591 @@
+/**
+ * Implements a class running batches of independent random soups in parallel.
+ *      - Workers claim small batches of soups from a shared counter, so a worker stuck on a long lived soup
+ *        never holds up the soups queued behind it.
+ *      - Each worker steps every soup it claims on the same World, so the Grid and tile buffers are
+ *        allocated once per worker rather than once per soup.
+ *      - A soup is stepped with CycleMode::DETECT until its first state recurs.
+ *      - In lock step mode a worker fills the 64 lanes of a LockstepBatch with soups and steps them together.
+ *        A lane which settles into a still life or period 2 oscillator, as nearly every soup does, is
+ *        reported and refilled with the next soup straight away. A lane still running at the generation
+ *        limit is run again on the worker's World, so longer periods are reported exactly as without lock step.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "soup.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ * SoupSearch::SoupSearch(board_size, soup_size)
+ *
+ * Construct a search running soups on square boards.
+ *
+ * @example
+ *
+ *      // Census a thousand 16x16 soups on 256x256 boards
+ *      SoupSearch search(256, 16);
+ *      search.set_max_generations(10000);
+ *      for (const SoupResult &soup : search.run(0, 1000)) {
+ *          std::cout << soup.seed << " " << soup.period << std::endl;
+ *      }
+ *
+ * @param board_size
+ *      The edge length of the board every soup is run on.
+ *
+ * @param soup_size
+ *      The edge length of the random square placed in the middle of the board.
+ *
+ * @throws
+ *      std::runtime_error if the soup does not fit on the board.
+ */
+SoupSearch::SoupSearch(const int board_size, const int soup_size) : SoupSearch(board_size, board_size, soup_size) {}
+
+/**
+ * SoupSearch::SoupSearch(board_width, board_height, soup_size)
+ *
+ * Construct a search running soups on rectangular boards.
+ *
+ * @param board_width
+ *      The width of the board every soup is run on.
+ *
+ * @param board_height
+ *      The height of the board every soup is run on.
+ *
+ * @param soup_size
+ *      The edge length of the random square placed in the middle of the board.
+ *
+ * @throws
+ *      std::runtime_error if the soup does not fit on the board.
+ */
+SoupSearch::SoupSearch(const int board_width, const int board_height, const int soup_size)
+        : board_width(board_width), board_height(board_height), soup_size(soup_size), density(0.5),
+          max_generations(10000), toroidal(false), engine(Engine::BITPACKED), simd_level(SimdLevel::AUTO),
+          threads(1), lockstep(false) {
+    if (soup_size < 0 || soup_size > board_width || soup_size > board_height) {
+        throw std::runtime_error(std::string("The soup does not fit on the board!"));
+    }
+}
+
+/**
+ * SoupSearch::set_density(density)
+ *
+ * Select the chance of each cell of a soup starting alive.
+ *
+ * @param density
+ *      A chance between 0 and 1, 0.5 by default.
+ *
+ * @throws
+ *      std::runtime_error if the density is not between 0 and 1.
+ */
+void SoupSearch::set_density(const double density) {
+    if (!(density >= 0 && density <= 1)) {
+        throw std::runtime_error(std::string("The density must be between 0 and 1!"));
+    }
+    this->density = density;
+}
+
+/**
+ * SoupSearch::get_density()
+ *
+ * @return
+ *      The chance of each cell of a soup starting alive.
+ */
+double SoupSearch::get_density() const {
+    return this->density;
+}
+
+/**
+ * SoupSearch::set_max_generations(generations)
+ *
+ * Select how long a soup is stepped for before it is given up on.
+ *
+ * @param generations
+ *      The most generations a soup is stepped for, 10000 by default.
+ *
+ * @throws
+ *      std::runtime_error if the number of generations is negative.
+ */
+void SoupSearch::set_max_generations(const int generations) {
+    if (generations < 0) {
+        throw std::runtime_error(std::string("The number of generations cannot be negative!"));
+    }
+    this->max_generations = generations;
+}
+
+/**
+ * SoupSearch::get_max_generations()
+ *
+ * @return
+ *      The most generations a soup is stepped for.
+ */
+int SoupSearch::get_max_generations() const {
+    return this->max_generations;
+}
+
+/**
+ * SoupSearch::set_toroidal(toroidal)
+ *
+ * Select whether the boards wrap around at their edges. Bounded boards by default.
+ *
+ * @param toroidal
+ *      True to step the soups on a torus.
+ */
+void SoupSearch::set_toroidal(const bool toroidal) {
+    this->toroidal = toroidal;
+}
+
+/**
+ * SoupSearch::get_toroidal()
+ *
+ * @return
+ *      True if the soups are stepped on a torus.
+ */
+bool SoupSearch::get_toroidal() const {
+    return this->toroidal;
+}
+
+/**
+ * SoupSearch::set_rule(rule)
+ *
+ * Select the rule every soup is stepped with, B3/S23 by default.
+ *
+ * @param rule
+ *      The rule to step with.
+ */
+void SoupSearch::set_rule(const Rule &rule) {
+    this->rule = rule;
+}
+
+/**
+ * SoupSearch::get_rule()
+ *
+ * @return
+ *      The rule every soup is stepped with.
+ */
+const Rule &SoupSearch::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * SoupSearch::set_engine(engine)
+ *
+ * Select the engine every soup is stepped with. Engine::BITPACKED is the default, a 256x256 board is only
+ * 8 KB packed and hashing it for cycle detection costs a word per 64 cells.
+ *
+ * @param engine
+ *      The engine to step with.
+ */
+void SoupSearch::set_engine(const Engine engine) {
+    this->engine = engine;
+}
+
+/**
+ * SoupSearch::get_engine()
+ *
+ * @return
+ *      The engine every soup is stepped with.
+ */
+Engine SoupSearch::get_engine() const {
+    return this->engine;
+}
+
+/**
+ * SoupSearch::set_simd_level(level)
+ *
+ * Select the instruction set used by the Engine::SIMD and Engine::SPARSE row kernels.
+ *
+ * @param level
+ *      The instruction set, SimdLevel::AUTO picks the widest one the CPU supports.
+ *
+ * @throws
+ *      std::runtime_error if the CPU does not support the instruction set.
+ */
+void SoupSearch::set_simd_level(const SimdLevel level) {
+    if (!simd_level_supported(level)) {
+        throw std::runtime_error(std::string("The CPU does not support ") + simd_level_name(level) + "!");
+    }
+    this->simd_level = level;
+}
+
+/**
+ * SoupSearch::get_simd_level()
+ *
+ * @return
+ *      The selected instruction set, which may be SimdLevel::AUTO.
+ */
+SimdLevel SoupSearch::get_simd_level() const {
+    return this->simd_level;
+}
+
+/**
+ * SoupSearch::set_threads(threads)
+ *
+ * Select the number of soups run at once. Each soup is stepped serially, small boards gain nothing from
+ * splitting a step into bands.
+ *
+ * @param threads
+ *      The number of threads, 0 selects one per hardware thread.
+ */
+void SoupSearch::set_threads(const int threads) {
+    int count = threads;
+    if (count <= 0) {
+        count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    if (count != this->threads) {
+        this->threads = count;
+        this->pool.reset();
+    }
+}
+
+/**
+ * SoupSearch::get_threads()
+ *
+ * @return
+ *      The number of soups run at once.
+ */
+int SoupSearch::get_threads() const {
+    return this->threads;
+}
+
+/**
+ * SoupSearch::set_lockstep(lockstep)
+ *
+ * Select whether each worker steps a LockstepBatch of soups at once rather than one World at a time.
+ * The summaries are identical either way, the engine is ignored in lock step mode.
+ *
+ * @example
+ *
+ *      // Census small soups 64 at a time per worker
+ *      SoupSearch search(64, 16);
+ *      search.set_lockstep(true);
+ *      const std::vector<SoupResult> soups = search.run(0, 100000);
+ *
+ * @param lockstep
+ *      True to step soups in lock step.
+ */
+void SoupSearch::set_lockstep(const bool lockstep) {
+    this->lockstep = lockstep;
+}
+
+/**
+ * SoupSearch::get_lockstep()
+ *
+ * @return
+ *      True if soups are stepped in lock step.
+ */
+bool SoupSearch::get_lockstep() const {
+    return this->lockstep;
+}
+
+/**
+ * SoupSearch::get_pool()
+ *
+ * Private helper function returning the thread pool, starting it with the selected number of threads
+ * the first time it is needed.
+ *
+ * @return
+ *      The pool shared by every run.
+ */
+ThreadPool &SoupSearch::get_pool() {
+    if (!this->pool || this->pool->get_thread_count() != this->threads) {
+        this->pool = std::make_shared<ThreadPool>(this->threads);
+    }
+    return *this->pool;
+}
+
+/**
+ * SoupSearch::configure(world)
+ *
+ * Private helper function applying the selected rule and engine to a world.
+ *
+ * @param world
+ *      The world soups will be run on.
+ */
+void SoupSearch::configure(World &world) const {
+    world.set_rule(this->rule);
+    world.set_engine(this->engine);
+    world.set_simd_level(this->simd_level);
+    world.set_threads(1);
+}
+
+/**
+ * Draws the next cell of a soup. The top 53 bits of each draw are compared against the density, which is
+ * exact for every double between 0 and 1.
+ */
+static inline Cell draw_cell(std::mt19937_64 &random, const double density) {
+    return static_cast<double>(random() >> 11) < density * 9007199254740992.0 ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * SoupSearch::seed_soup(world, seed)
+ *
+ * Private helper function clearing the board and placing the soup of a seed in its middle.
+ * The same seed always gives the same soup, whichever thread runs it.
+ *
+ * @param world
+ *      The world to reuse, of the board size.
+ *
+ * @param seed
+ *      The seed of the soup.
+ */
+void SoupSearch::seed_soup(World &world, const std::uint64_t seed) const {
+    Grid &state = world.edit_state();
+    for (int y = 0; y < state.get_height(); y++) {
+        Cell *row = state.row(y);
+        std::fill(row, row + state.get_width(), Cell::DEAD);
+    }
+
+    std::mt19937_64 random(seed);
+    const int x0 = (this->board_width - this->soup_size) / 2;
+    const int y0 = (this->board_height - this->soup_size) / 2;
+    for (int y = 0; y < this->soup_size; y++) {
+        Cell *row = state.row(y0 + y) + x0;
+        for (int x = 0; x < this->soup_size; x++) {
+            row[x] = draw_cell(random, this->density);
+        }
+    }
+
+    // The edited state starts a new history
+    world.set_generation(0);
+    world.set_cycle_mode(CycleMode::DETECT);
+}
+
+/**
+ * SoupSearch::run_soup(world, seed)
+ *
+ * Private helper function stepping the soup of a seed until a state recurs or it runs out of generations.
+ *
+ * @param world
+ *      The world to reuse, of the board size.
+ *
+ * @param seed
+ *      The seed of the soup.
+ *
+ * @return
+ *      The summary of the soup.
+ */
+SoupResult SoupSearch::run_soup(World &world, const std::uint64_t seed) const {
+    this->seed_soup(world, seed);
+    const std::uint64_t limit = static_cast<std::uint64_t>(this->max_generations);
+    while (world.get_cycle_period() == 0 && world.get_generation() < limit) {
+        world.step(this->toroidal);
+    }
+
+    SoupResult result;
+    result.seed = seed;
+    result.population = world.get_alive_cells();
+    result.period = world.get_cycle_period();
+    result.generation = result.period > 0 ? world.get_cycle_start() : world.get_generation();
+    return result;
+}
+
+/**
+ * SoupSearch::seed_lane(batch, lane, seed)
+ *
+ * Private helper function clearing a lane of a batch and placing the soup of a seed in its middle,
+ * cell for cell the soup SoupSearch::seed_soup places on a World.
+ *
+ * @param batch
+ *      The batch to reuse, of the board size.
+ *
+ * @param lane
+ *      The lane to fill.
+ *
+ * @param seed
+ *      The seed of the soup.
+ */
+void SoupSearch::seed_lane(LockstepBatch &batch, const int lane, const std::uint64_t seed) const {
+    batch.clear(lane);
+    std::mt19937_64 random(seed);
+    const int x0 = (this->board_width - this->soup_size) / 2;
+    const int y0 = (this->board_height - this->soup_size) / 2;
+    for (int y = 0; y < this->soup_size; y++) {
+        for (int x = 0; x < this->soup_size; x++) {
+            if (draw_cell(random, this->density) == Cell::ALIVE) {
+                batch.set(lane, x0 + x, y0 + y, Cell::ALIVE);
+            }
+        }
+    }
+}
+
+/**
+ * SoupSearch::run_lanes(batch, world, first_seed, count, next_soup, results)
+ *
+ * Private helper function running soups in lock step. Every lane is given a soup claimed from next_soup,
+ * and each time a lane settles its summary is written and the lane takes the next soup. The settled lanes
+ * are found from LockstepBatch::get_still_lanes and LockstepBatch::get_period_two_lanes, and the stabilisation
+ * generation is the first generation of the cycle, as CycleMode::DETECT reports it.
+ *
+ * @param batch
+ *      The batch of the worker, of the board size.
+ *
+ * @param world
+ *      The world of the worker, used for soups which reach the generation limit.
+ *
+ * @param first_seed
+ *      The seed of soup 0 of the run.
+ *
+ * @param count
+ *      The number of soups in the run.
+ *
+ * @param next_soup
+ *      The counter soups are claimed from, shared by every worker.
+ *
+ * @param results
+ *      The summaries of the run, indexed by soup.
+ */
+void SoupSearch::run_lanes(LockstepBatch &batch, World &world, const std::uint64_t first_seed,
+                           const std::uint64_t count, std::atomic<std::uint64_t> &next_soup,
+                           std::vector<SoupResult> &results) const {
+    const std::uint64_t limit = static_cast<std::uint64_t>(this->max_generations);
+    std::uint64_t soups[LockstepBatch::LANES], ages[LockstepBatch::LANES];
+    std::uint64_t active = 0;
+
+    // Gives a lane the next soup, or leaves it empty once every soup is claimed
+    const auto claim = [&](const int lane) {
+        const std::uint64_t soup = next_soup.fetch_add(1);
+        if (soup >= count) {
+            batch.clear(lane);
+            return;
+        }
+        this->seed_lane(batch, lane, first_seed + soup);
+        soups[lane] = soup;
+        ages[lane] = 0;
+        active |= static_cast<std::uint64_t>(1) << lane;
+    };
+    for (int lane = 0; lane < LockstepBatch::LANES; lane++) {
+        claim(lane);
+    }
+
+    while (active != 0) {
+        batch.step(this->toroidal);
+        const std::uint64_t still = batch.get_still_lanes();
+        const std::uint64_t period_two = batch.get_period_two_lanes();
+        for (int lane = 0; lane < LockstepBatch::LANES; lane++) {
+            const std::uint64_t bit = static_cast<std::uint64_t>(1) << lane;
+            if (!(active & bit)) {
+                continue;
+            }
+            ages[lane]++;
+            SoupResult &result = results[soups[lane]];
+            if (still & bit) {
+                result.period = 1;
+                result.generation = ages[lane] - 1;
+            } else if (period_two & bit) {
+                result.period = 2;
+                result.generation = ages[lane] - 2;
+            } else if (ages[lane] >= limit) {
+                // Longer periods recur without ever matching the last two states, only hashing finds them
+                result = this->run_soup(world, first_seed + soups[lane]);
+                active &= ~bit;
+                claim(lane);
+                continue;
+            } else {
+                continue;
+            }
+            result.seed = first_seed + soups[lane];
+            result.population = batch.get_alive_cells(lane);
+            active &= ~bit;
+            claim(lane);
+        }
+    }
+}
+
+/**
+ * SoupSearch::run(first_seed, count)
+ *
+ * Run a batch of soups across the thread pool. The soups are claimed BATCH_SOUPS at a time by whichever
+ * worker is free, or one at a time into a free lane in lock step mode, so the batch is balanced however
+ * long individual soups take to settle.
+ *
+ * @example
+ *
+ *      // Run the soups on every core and count the still lifes
+ *      SoupSearch search(256, 16);
+ *      search.set_threads(0);
+ *      const std::vector<SoupResult> soups = search.run(0, 100000);
+ *      const long still = std::count_if(soups.begin(), soups.end(),
+ *                                       [](const SoupResult &soup) { return soup.period == 1; });
+ *
+ * @param first_seed
+ *      The seed of the first soup.
+ *
+ * @param count
+ *      The number of soups, seeded first_seed to first_seed + count - 1.
+ *
+ * @return
+ *      The summary of every soup, in the order of their seeds.
+ */
+std::vector<SoupResult> SoupSearch::run(const std::uint64_t first_seed, const std::uint64_t count) {
+    std::vector<SoupResult> results(count);
+    if (count == 0) {
+        return results;
+    }
+    ThreadPool &pool = this->get_pool();
+
+    // A limit of 0 generations leaves nothing to step in lock step
+    const bool lanes = this->lockstep && this->max_generations > 0;
+    const std::uint64_t claimed = lanes ? static_cast<std::uint64_t>(LockstepBatch::LANES) : BATCH_SOUPS;
+
+    // Task i of a run always steps on worlds[i], and no two threads run the same task at once
+    const int tasks = static_cast<int>(std::min<std::uint64_t>(pool.get_thread_count(),
+                                                               (count + claimed - 1) / claimed));
+    while (static_cast<int>(this->worlds.size()) < tasks) {
+        this->worlds.emplace_back(new World(this->board_width, this->board_height));
+    }
+    for (int task = 0; task < tasks; task++) {
+        this->configure(*this->worlds[task]);
+    }
+
+    if (lanes) {
+        while (static_cast<int>(this->batches.size()) < tasks) {
+            this->batches.emplace_back(new LockstepBatch(this->board_width, this->board_height));
+        }
+        for (int task = 0; task < tasks; task++) {
+            this->batches[task]->set_rule(this->rule);
+        }
+    }
+
+    std::atomic<std::uint64_t> next_soup(0);
+    pool.run(tasks, [&](const int task) {
+        World &world = *this->worlds[task];
+        if (lanes) {
+            this->run_lanes(*this->batches[task], world, first_seed, count, next_soup, results);
+            return;
+        }
+        for (;;) {
+            const std::uint64_t first = next_soup.fetch_add(BATCH_SOUPS);
+            if (first >= count) {
+                return;
+            }
+            const std::uint64_t last = std::min<std::uint64_t>(count, first + BATCH_SOUPS);
+            for (std::uint64_t soup = first; soup < last; soup++) {
+                results[soup] = this->run_soup(world, first_seed + soup);
+            }
+        }
+    });
+    return results;
+}
+
+/**
+ * SoupSearch::run(seed)
+ *
+ * Run a single soup on the calling thread, e.g. to look again at an interesting result of a batch.
+ *
+ * @param seed
+ *      The seed of the soup.
+ *
+ * @return
+ *      The summary of the soup, identical to the one reported by a batch.
+ */
+SoupResult SoupSearch::run(const std::uint64_t seed) const {
+    World world(this->board_width, this->board_height);
+    this->configure(world);
+    return this->run_soup(world, seed);
+}
@@ -0,0 +1,136 @@
+/**
+ * Declares a class running batches of small random soups across a thread pool to census what they settle into.
+ * Rich documentation for the api and behaviour the SoupSearch class can be found in soup.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "lockstep.h"
+#include "rule.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "world.h"
+
+/**
+ * The summary of one soup once it settled, or ran out of generations.
+ */
+struct SoupResult {
+    std::uint64_t seed;                              // The soup is a function of its seed alone
+
+    int population;                                  // Alive cells in the final state
+
+    std::uint64_t generation;                        // The generation the final cycle started at
+
+    std::uint64_t period;                            // 1 for a still life, 0 if the soup never settled
+};
+
+/**
+ * Declare the structure of the SoupSearch class.
+ *
+ * Every soup is a soup_size x soup_size square of random cells placed in the middle of an otherwise empty
+ * board, stepped with cycle detection until a state recurs. Each worker keeps one World and reuses its
+ * buffers for every soup it runs. In lock step mode each worker instead steps LockstepBatch::LANES soups
+ * at once, one per lane of a LockstepBatch. SoupSearch objects cannot be copied.
+ */
+class SoupSearch {
+private:
+    int board_width, board_height;
+
+    int soup_size;
+
+    double density;                                  // The chance of each cell of the soup being alive
+
+    int max_generations;
+
+    bool toroidal;
+
+    Rule rule;
+
+    Engine engine;
+
+    SimdLevel simd_level;
+
+    int threads;
+
+    bool lockstep;
+
+    std::shared_ptr<ThreadPool> pool;                // Started on the first run
+
+    std::vector<std::unique_ptr<World>> worlds;      // One per task of a run, kept between runs
+
+    std::vector<std::unique_ptr<LockstepBatch>> batches; // One per task of a lock step run
+
+    static const int BATCH_SOUPS = 16;               // Soups claimed by a worker at a time
+
+    ThreadPool &get_pool();                          // Starts the pool on first use
+
+    void configure(World &world) const;
+
+    void seed_soup(World &world, const std::uint64_t seed) const;
+
+    SoupResult run_soup(World &world, const std::uint64_t seed) const;
+
+    void seed_lane(LockstepBatch &batch, const int lane, const std::uint64_t seed) const;
+
+    // Runs soups claimed from next_soup on the lanes of a batch until there are none left
+    void run_lanes(LockstepBatch &batch, World &world, const std::uint64_t first_seed, const std::uint64_t count,
+                   std::atomic<std::uint64_t> &next_soup, std::vector<SoupResult> &results) const;
+
+public:
+    explicit SoupSearch(const int board_size = 256, const int soup_size = 16);
+
+    SoupSearch(const int board_width, const int board_height, const int soup_size);
+
+    SoupSearch(const SoupSearch &) = delete;
+
+    SoupSearch &operator=(const SoupSearch &) = delete;
+
+    // Member functions
+    void set_density(const double density);
+
+    double get_density() const;
+
+    // Soups which have not settled after this many generations are reported with a period of 0
+    void set_max_generations(const int generations);
+
+    int get_max_generations() const;
+
+    void set_toroidal(const bool toroidal);
+
+    bool get_toroidal() const;
+
+    void set_rule(const Rule &rule);
+
+    const Rule &get_rule() const;
+
+    // Selects the engine every soup is stepped with, Engine::BITPACKED by default
+    void set_engine(const Engine engine);
+
+    Engine get_engine() const;
+
+    void set_simd_level(const SimdLevel level);
+
+    SimdLevel get_simd_level() const;
+
+    // Selects the number of soups run at once, 0 uses every hardware thread
+    void set_threads(const int threads);
+
+    int get_threads() const;
+
+    // Selects whether soups are stepped LockstepBatch::LANES at a time, best for boards of 64x64 or smaller
+    void set_lockstep(const bool lockstep);
+
+    bool get_lockstep() const;
+
+    // Runs the soups seeded first_seed, first_seed + 1, ..., results are in the order of their seeds
+    std::vector<SoupResult> run(const std::uint64_t first_seed, const std::uint64_t count);
+
+    // Runs a single soup on the calling thread
+    SoupResult run(const std::uint64_t seed) const;
+};
@@ -0,0 +1,238 @@
+/**
+ * Implements process wide counters and phase timers.
+ *      - The counters are relaxed atomics, so worlds stepped on several threads, as SoupSearch does, can
+ *        all feed them. Nothing orders them against each other, the totals are for reporting only.
+ *      - Stats::Timer only reads the clock while enabled, so timing a phase costs one load of a flag otherwise.
+ *      - Counters are fed at the end of each step or file, never per cell.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "stats.h"
+
+namespace Stats {
+    std::atomic<bool> enabled_flag(false);
+
+    std::atomic<std::uint64_t> counters[COUNTER_COUNT];
+
+    std::atomic<std::uint64_t> nanoseconds[PHASE_COUNT];
+}
+
+/**
+ * Stats::set_enabled(enabled)
+ *
+ * Turn the counters and timers on or off. The totals gathered so far are kept.
+ *
+ * @example
+ *
+ *      // Time a run and print where the time went
+ *      Stats::set_enabled(true);
+ *      world.advance(1000);
+ *      Stats::print_summary(std::cerr, Stats::read());
+ *
+ * @param enabled
+ *      True to start counting.
+ */
+void Stats::set_enabled(const bool enabled) {
+    enabled_flag.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * Stats::add_time(phase, elapsed)
+ *
+ * Add wall clock time to a phase, as Stats::Timer does when it goes out of scope.
+ *
+ * @param phase
+ *      The phase the time was spent in.
+ *
+ * @param elapsed
+ *      The time spent.
+ */
+void Stats::add_time(const Phase phase, const std::chrono::steady_clock::duration elapsed) {
+    if (enabled()) {
+        const auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        nanoseconds[static_cast<int>(phase)].fetch_add(static_cast<std::uint64_t>(count), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Stats::reset()
+ *
+ * Zero every counter and timer.
+ */
+void Stats::reset() {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        nanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Stats::read()
+ *
+ * @return
+ *      A copy of every counter and timer.
+ */
+Stats::Totals Stats::read() {
+    Totals totals;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        totals.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        totals.nanoseconds[i] = nanoseconds[i].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+/**
+ * Stats::Totals::operator-(earlier)
+ *
+ * @example
+ *
+ *      // The births of the last interval only
+ *      const Stats::Totals now = Stats::read();
+ *      std::cout << (now - last).get(Stats::Counter::BIRTHS) << std::endl;
+ *
+ * @param earlier
+ *      A copy read before this one.
+ *
+ * @return
+ *      How much every counter and timer grew between the two copies.
+ */
+Stats::Totals Stats::Totals::operator-(const Totals &earlier) const {
+    Totals change;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        change.counters[i] = this->counters[i] - earlier.counters[i];
+    }
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        change.nanoseconds[i] = this->nanoseconds[i] - earlier.nanoseconds[i];
+    }
+    return change;
+}
+
+/**
+ * Stats::counter_name(counter)
+ *
+ * @return
+ *      The name of a counter, as used for the keys of Stats::write_json.
+ */
+const char *Stats::counter_name(const Counter counter) {
+    switch (counter) {
+        case Counter::GENERATIONS:
+            return "generations";
+        case Counter::CELLS_UPDATED:
+            return "cells_updated";
+        case Counter::BIRTHS:
+            return "births";
+        case Counter::DEATHS:
+            return "deaths";
+        case Counter::ACTIVE_TILES:
+            return "active_tiles";
+        case Counter::BYTES_READ:
+            return "bytes_read";
+        case Counter::BYTES_WRITTEN:
+            return "bytes_written";
+    }
+    return "unknown";
+}
+
+/**
+ * Stats::phase_name(phase)
+ *
+ * @return
+ *      The name of a phase, as used for the keys of Stats::write_json.
+ */
+const char *Stats::phase_name(const Phase phase) {
+    switch (phase) {
+        case Phase::LOAD:
+            return "load";
+        case Phase::STEP:
+            return "step";
+        case Phase::PRINT:
+            return "print";
+        case Phase::SAVE:
+            return "save";
+        case Phase::CHECKPOINT:
+            return "checkpoint";
+    }
+    return "unknown";
+}
+
+/**
+ * A count per second, or 0 if no time was spent.
+ */
+static double per_second(const std::uint64_t count, const double seconds) {
+    return seconds > 0 ? count / seconds : 0;
+}
+
+/**
+ * Stats::print_summary(out, totals)
+ *
+ * Print a human readable summary of a run: the time spent in each phase, then every counter.
+ * Generations and cells updated are also given per second of stepping.
+ *
+ * @param out
+ *      The stream to print to.
+ *
+ * @param totals
+ *      The totals of the run.
+ */
+void Stats::print_summary(std::ostream &out, const Totals &totals) {
+    out << "Stats..." << '\n';
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const Phase phase = static_cast<Phase>(i);
+        out << (i > 0 ? " | " : "") << phase_name(phase) << " " << totals.seconds(phase) << " s";
+    }
+    const double stepping = totals.seconds(Phase::STEP);
+    out << '\n'
+        << "Generations " << totals.get(Counter::GENERATIONS) << " | "
+        << per_second(totals.get(Counter::GENERATIONS), stepping) << " generations/s" << '\n'
+        << "Cells updated " << totals.get(Counter::CELLS_UPDATED) << " | "
+        << per_second(totals.get(Counter::CELLS_UPDATED), stepping) << " cells/s" << '\n'
+        << "Births " << totals.get(Counter::BIRTHS) << " | Deaths " << totals.get(Counter::DEATHS) << '\n'
+        << "Active tiles " << totals.get(Counter::ACTIVE_TILES) << '\n'
+        << "Bytes read " << totals.get(Counter::BYTES_READ) << " | Bytes written "
+        << totals.get(Counter::BYTES_WRITTEN) << std::endl;
+}
+
+/**
+ * Stats::write_json(out, generation, interval, interval_seconds)
+ *
+ * Write the metrics of one interval as a JSON object on a line of its own, so a run produces JSON lines
+ * a dashboard can ingest as they are written.
+ *
+ * @example
+ *
+ *      {"generation":1000,"seconds":0.52,"generations_per_second":192.3,"cells_updated_per_second":...,
+ *       "generations":100,"cells_updated":...,"births":...,...,"load_seconds":0,"step_seconds":0.51,...}
+ *
+ * @param out
+ *      The stream to write to, flushed after the line.
+ *
+ * @param generation
+ *      The generation the interval ended at.
+ *
+ * @param interval
+ *      The change in the totals over the interval.
+ *
+ * @param interval_seconds
+ *      The wall clock length of the interval.
+ */
+void Stats::write_json(std::ostream &out, const std::uint64_t generation, const Totals &interval,
+                       const double interval_seconds) {
+    const std::streamsize precision = out.precision(9);
+    out << "{\"generation\":" << generation << ",\"seconds\":" << interval_seconds
+        << ",\"generations_per_second\":" << per_second(interval.get(Counter::GENERATIONS), interval_seconds)
+        << ",\"cells_updated_per_second\":" << per_second(interval.get(Counter::CELLS_UPDATED), interval_seconds);
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        out << ",\"" << counter_name(static_cast<Counter>(i)) << "\":" << interval.counters[i];
+    }
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const Phase phase = static_cast<Phase>(i);
+        out << ",\"" << phase_name(phase) << "_seconds\":" << interval.seconds(phase);
+    }
+    out << "}" << std::endl;
+    out.precision(precision);
+}
@@ -0,0 +1,130 @@
+/**
+ * Declares a Stats namespace of process wide counters and phase timers fed by World, Zoo and Snapshot.
+ * Rich documentation for the api and the metrics can be found in stats.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+/**
+ * Declare the interface of the Stats namespace.
+ *
+ * Everything is off until Stats::set_enabled(true). While off, feeding a counter is one relaxed load of
+ * a flag, and World skips the extra work of counting births and deaths altogether.
+ */
+namespace Stats {
+    /**
+     * The counters, each a running total since the last Stats::reset.
+     */
+    enum class Counter : int {
+        GENERATIONS,                                 // Steps taken by every World
+        CELLS_UPDATED,                               // Cells recomputed, only the active tiles for Engine::SPARSE
+        BIRTHS,
+        DEATHS,
+        ACTIVE_TILES,                                // Tiles recomputed by Engine::SPARSE
+        BYTES_READ,                                  // Bytes of pattern files and snapshots read
+        BYTES_WRITTEN                                // Bytes of pattern files and snapshots written
+    };
+
+    static const int COUNTER_COUNT = 7;
+
+    /**
+     * The phases of a run, each timed in nanoseconds of wall clock time.
+     */
+    enum class Phase : int {
+        LOAD,
+        STEP,
+        PRINT,
+        SAVE,
+        CHECKPOINT
+    };
+
+    static const int PHASE_COUNT = 5;
+
+    /**
+     * A copy of every counter and timer at one moment.
+     */
+    struct Totals {
+        std::uint64_t counters[COUNTER_COUNT];
+
+        std::uint64_t nanoseconds[PHASE_COUNT];
+
+        std::uint64_t get(const Counter counter) const { return this->counters[static_cast<int>(counter)]; }
+
+        double seconds(const Phase phase) const { return this->nanoseconds[static_cast<int>(phase)] * 1e-9; }
+
+        Totals operator-(const Totals &earlier) const; // The change since an earlier copy
+    };
+
+    extern std::atomic<bool> enabled_flag;           // Read through Stats::enabled
+
+    extern std::atomic<std::uint64_t> counters[COUNTER_COUNT];
+
+    extern std::atomic<std::uint64_t> nanoseconds[PHASE_COUNT];
+
+    inline bool enabled() {
+        return enabled_flag.load(std::memory_order_relaxed);
+    }
+
+    void set_enabled(const bool enabled);
+
+    inline void add(const Counter counter, const std::uint64_t amount) {
+        if (enabled()) {
+            counters[static_cast<int>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds wall clock time to a phase
+    void add_time(const Phase phase, const std::chrono::steady_clock::duration elapsed);
+
+    // Zeroes every counter and timer
+    void reset();
+
+    Totals read();
+
+    const char *counter_name(const Counter counter);
+
+    const char *phase_name(const Phase phase);
+
+    // Prints the totals of a run, with rates over the time spent stepping
+    void print_summary(std::ostream &out, const Totals &totals);
+
+    // Writes the metrics of one interval as a single line JSON object
+    void write_json(std::ostream &out, const std::uint64_t generation, const Totals &interval,
+                    const double interval_seconds);
+
+    /**
+     * Adds the time between its construction and destruction to a phase. Nothing is timed while disabled.
+     */
+    class Timer {
+    private:
+        Phase phase;
+
+        bool running;
+
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit Timer(const Phase phase) : phase(phase), running(enabled()) {
+            if (this->running) {
+                this->start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Timer() {
+            if (this->running) {
+                add_time(this->phase, std::chrono::steady_clock::now() - this->start);
+            }
+        }
+
+        Timer(const Timer &) = delete;
+
+        Timer &operator=(const Timer &) = delete;
+    };
+};
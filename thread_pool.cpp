@@ -0,0 +1,135 @@
+/**
+ * Implements a persistent pool of worker threads.
+ *      - The worker threads are started by the constructor and joined by the destructor,
+ *        so no threads are spawned per run.
+ *      - A run hands out task indices from a shared atomic counter, the calling thread takes part too.
+ *      - Tasks must not throw, they are expected to be self contained pieces of a computation
+ *        such as a band of rows in World::step.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#include "thread_pool.h"
+
+/**
+ * ThreadPool::ThreadPool(threads)
+ *
+ * Construct a pool where runs are split across the desired number of threads.
+ * The calling thread counts as one of them, so threads - 1 worker threads are started.
+ *
+ * @example
+ *
+ *      // Use every core of the machine
+ *      ThreadPool pool(std::thread::hardware_concurrency());
+ *
+ * @param threads
+ *      The number of threads to use, values below 1 are treated as 1.
+ */
+ThreadPool::ThreadPool(const int threads) : task(nullptr), task_count(0), next_task(0), busy_workers(0),
+                                            generation(0), stopping(false) {
+    for (int i = 1; i < threads; i++) {
+        this->workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+/**
+ * ThreadPool::~ThreadPool()
+ *
+ * Stop and join every worker thread.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (std::thread &worker : this->workers) {
+        worker.join();
+    }
+}
+
+/**
+ * ThreadPool::get_thread_count()
+ *
+ * Gets the number of threads taking part in a run, including the calling thread.
+ *
+ * @return
+ *      The number of threads.
+ */
+int ThreadPool::get_thread_count() const {
+    return static_cast<int>(this->workers.size()) + 1;
+}
+
+/**
+ * ThreadPool::run(tasks, task)
+ *
+ * Run task(i) for every i in [0, tasks) and block until all of them have completed.
+ * Tasks are handed out dynamically, so uneven tasks still balance across the threads.
+ *
+ * @example
+ *
+ *      // Clear the rows of a grid in 4 bands
+ *      pool.run(4, [&](int band) {
+ *          for (int y = band * height / 4; y < (band + 1) * height / 4; y++) { ... }
+ *      });
+ *
+ * @param tasks
+ *      The number of tasks to run.
+ *
+ * @param task
+ *      The function to invoke with each task index.
+ */
+void ThreadPool::run(const int tasks, const std::function<void(int)> &task) {
+    std::lock_guard<std::mutex> run_lock(this->run_mutex);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = &task;
+        this->task_count = tasks;
+        this->next_task = 0;
+        this->busy_workers = static_cast<int>(this->workers.size());
+        this->generation++;
+    }
+    this->wake.notify_all();
+    this->drain();
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->finished.wait(lock, [this] { return this->busy_workers == 0; });
+    this->task = nullptr;
+}
+
+/**
+ * ThreadPool::drain()
+ *
+ * Private helper function which keeps claiming and running tasks of the current run until none are left.
+ */
+void ThreadPool::drain() {
+    for (int i = this->next_task++; i < this->task_count; i = this->next_task++) {
+        (*this->task)(i);
+    }
+}
+
+/**
+ * ThreadPool::worker_loop()
+ *
+ * Private helper function run by every worker thread. Sleeps until a run starts, helps drain it,
+ * then reports back and sleeps again until the next run or until the pool is stopped.
+ */
+void ThreadPool::worker_loop() {
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [this, seen] { return this->stopping || this->generation != seen; });
+            if (this->stopping) {
+                return;
+            }
+            seen = this->generation;
+        }
+        this->drain();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->busy_workers--;
+        }
+        this->finished.notify_one();
+    }
+}
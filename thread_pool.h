@@ -0,0 +1,61 @@
+/**
+ * Declares a persistent pool of worker threads used to split work such as World::step into parallel tasks.
+ * Rich documentation for the api and behaviour the ThreadPool class can be found in thread_pool.cpp.
+ *
+ * @author 965217
+ * @date March, 2020
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Declare the structure of the ThreadPool class. The threads are started once and reused for every run.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;                                // Guards every field below
+
+    std::condition_variable wake;                    // Signalled when a new run starts or the pool stops
+
+    std::condition_variable finished;                // Signalled when a worker has no tasks left
+
+    std::mutex run_mutex;                            // Serialises concurrent callers of run
+
+    const std::function<void(int)> *task;
+
+    int task_count;
+
+    std::atomic<int> next_task;
+
+    int busy_workers;
+
+    unsigned long generation;                        // Incremented for every run
+
+    bool stopping;
+
+    void worker_loop();
+
+    void drain();                                    // Runs tasks until there are none left
+public:
+    explicit ThreadPool(const int threads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // The number of threads taking part in a run, including the caller
+    int get_thread_count() const;
+
+    // Runs task(i) for every i in [0, tasks) across the pool and waits for them all to finish
+    void run(const int tasks, const std::function<void(int)> &task);
+};
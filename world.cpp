@@ -10,6 +10,7 @@
  *
  *      - Stepping a world forward in time applies the rules of Conway's Game of Life.
  *          - https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *          - Any other Life-like rule can be selected with World::set_rule(rule), see rule.cpp.
  *
  *      - Worlds have a private helper function used to count the number of alive cells in a 3x3 neighbours
  *        around a given cell.
@@ -18,11 +19,39 @@
  *          - Moving off the left edge you appear on the right edge and vice versa.
  *          - Moving off the top edge you appear on the bottom edge and vice versa.
  *
+ *      - Worlds can step using different engines, selected with World::set_engine(engine).
+ *          - Engine::REFERENCE is the original implementation built on World::count_alive_neighbours.
+ *          - Engine::BYTE updates the byte-per-cell Grid directly off its row buffers, without allocating.
+ *          - Engine::SIMD is Engine::BYTE with the interior of each row vectorised, using the instruction set
+ *            selected with World::set_simd_level(level) or the widest one detected at runtime.
+ *          - Engine::BITPACKED updates a bit-packed copy of the state 64 cells at a time using
+ *            bitwise full-adder logic. The Grid state is only rebuilt when it is requested.
+ *          - Engine::SPARSE splits the board into tiles and only recomputes the active ones: tiles which changed
+ *            during the previous step and the tiles around them. Every other tile is stable, and since the
+ *            next state buffer still holds the previous generation, which for a stable tile is identical,
+ *            stable tiles cost nothing at all. Step cost scales with activity rather than board area.
+ *
+ *      - Worlds can step using several threads, selected with World::set_threads(threads).
+ *          - The board is split into horizontal bands of rows which are stepped by a persistent ThreadPool.
+ *          - Reads only touch the current state and each band writes its own rows of the next state,
+ *            so the bands need no synchronisation beyond waiting for the step to finish.
+ *          - Boards too small to benefit fall back to the serial path.
+ *
  * @author 965217
  * @date March, 2020
  */
 #include "world.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "stats.h"
+
+// Passed by reference to std::min, so it needs a definition of its own
+const int World::TILE_SIZE;
 
 /**
  * World::World()
@@ -75,7 +104,16 @@ World::World(const int square_size) : World(square_size, square_size) {
  * @param height
  *      The height of the world.
  */
-World::World(const int width, const int height) : current(Grid(width, height)), next(Grid(width, height)) {
+World::World(const int width, const int height) : current(Grid(width, height)), next(Grid(width, height)),
+                                                  engine(Engine::BYTE), simd_level(SimdLevel::AUTO), generation(0),
+                                                  packed_is_current(false), threads(1), temporal_depth(8),
+                                                  grids_placed(false), packed_placed(false),
+                                                  tiles_valid(false), tiles_toroidal(false), active_tiles(0),
+                                                  cycle_mode(CycleMode::OFF),
+                                    hashes_valid(false), state_hash(0), cycle_toroidal(false),
+                                    cycle_start(0), cycle_period(0), track_changes(false),
+                                    population_mode(PopulationMode::INCREMENTAL), population(0),
+                                    population_valid(false), tile_population_valid(false) {
 }
 
 /**
@@ -98,8 +136,43 @@ World::World(const int width, const int height) : current(Grid(width, height)),
  *      The state of the constructed world.
  */
 World::World(const Grid &initial_state) : current(initial_state),
-                                    next(initial_state.get_width(), initial_state.get_height()) {
+                                    next(initial_state.get_width(), initial_state.get_height()),
+                                    engine(Engine::BYTE), simd_level(SimdLevel::AUTO), generation(0),
+                                    packed_is_current(false), threads(1), temporal_depth(8),
+                                    grids_placed(false), packed_placed(false), tiles_valid(false),
+                                    tiles_toroidal(false), active_tiles(0), cycle_mode(CycleMode::OFF),
+                                    hashes_valid(false), state_hash(0), cycle_toroidal(false),
+                                    cycle_start(0), cycle_period(0), track_changes(false),
+                                    population_mode(PopulationMode::INCREMENTAL), population(0),
+                                    population_valid(false), tile_population_valid(false) {
+
+}
 
+/**
+ * World::World(initial_state)
+ *
+ * Construct a world from a bit-packed state, stepping with Engine::BITPACKED. The Grid state is only
+ * filled in from the packed words if it is requested, e.g. by World::state().
+ *
+ * @example
+ *
+ *      // Load a huge binary file and step it without decoding it to a byte per cell
+ *      World world(Zoo::load_binary_packed("path/to/file.bgol"));
+ *      world.advance(100);
+ *
+ * @param initial_state
+ *      The state of the constructed world. Pass it with std::move to hand the words over without a copy.
+ */
+World::World(BitGrid initial_state) : current(initial_state.get_width(), initial_state.get_height()),
+                                      packed_current(std::move(initial_state)),
+                                      engine(Engine::BITPACKED), simd_level(SimdLevel::AUTO), generation(0),
+                                      packed_is_current(true), threads(1), temporal_depth(8),
+                                      grids_placed(false), packed_placed(false), tiles_valid(false),
+                                      tiles_toroidal(false), active_tiles(0), cycle_mode(CycleMode::OFF),
+                                    hashes_valid(false), state_hash(0), cycle_toroidal(false),
+                                    cycle_start(0), cycle_period(0), track_changes(false),
+                                    population_mode(PopulationMode::INCREMENTAL), population(0),
+                                    population_valid(false), tile_population_valid(false) {
 }
 
 /**
@@ -190,6 +263,11 @@ int World::get_total_cells() const {
  * Counts how many cells in the world are alive.
  * The function should be callable from a constant context.
  *
+ * Unless PopulationMode::RECOUNT was selected, the state is only counted by the first call. Every step after
+ * keeps the count up to date, so later calls are O(1): the dense engines count the rows they write while they
+ * are still in cache, and Engine::SPARSE only recounts the tiles which changed. Editing the state through
+ * World::edit_state or resizing the world makes the next call count it again.
+ *
  * @example
  *
  *      // Make a world
@@ -208,7 +286,32 @@ int World::get_total_cells() const {
  *      The number of alive cells.
  */
 int World::get_alive_cells() const {
-    return this->current.get_alive_cells();
+    if (this->population_mode == PopulationMode::RECOUNT) {
+        return static_cast<int>(this->count_population());
+    }
+    World *self = const_cast<World *>(this);
+    if (!this->population_valid) {
+        self->population = this->count_population();
+        self->population_valid = true;
+    } else if (this->population_mode == PopulationMode::VALIDATE && this->population != this->count_population()) {
+        throw std::runtime_error(std::string("The population kept by the steps does not match a recount!"));
+    }
+    return static_cast<int>(this->population);
+}
+
+/**
+ * World::count_population()
+ *
+ * Private helper function counting every alive cell of whichever copy of the state is authoritative.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+std::uint64_t World::count_population() const {
+    if (this->packed_is_current) {
+        return static_cast<std::uint64_t>(this->packed_current.get_alive_cells());
+    }
+    return static_cast<std::uint64_t>(this->current.get_alive_cells());
 }
 
 /**
@@ -239,11 +342,14 @@ int World::get_dead_cells() const {
 }
 
 /**
- * World::get_state()
+ * World::state()
  *
- * Return a read-only reference to the current state
+ * Return a read-only reference to the current state, for drawing, saving or checkpointing it.
  * The function should be callable from a constant context.
  * The function should not invoke a copy the current state.
+ * If the world is stepping with Engine::BITPACKED the Grid is first rebuilt from the packed state.
+ * Reading the state does not disturb anything the engines keep between steps, such as the tiles of
+ * Engine::SPARSE or the population count, so it is safe to call after every step.
  *
  * @example
  *
@@ -251,20 +357,201 @@ int World::get_dead_cells() const {
  *      World world(4, 4);
  *
  *      // Print the current state of the world to the console without copy
- *      std::cout << world.get_state() << std::endl;
+ *      std::cout << world.state() << std::endl;
  *
  *      // Should also be callable in a constant context
  *      const World &read_only_world = world;
  *
  *      // Print the current state of the world to the console without copy
- *      std::cout << read_only_world.get_state() << std::endl;
+ *      std::cout << read_only_world.state() << std::endl;
+ *
+ * @return
+ *      A reference to the current state, valid until the world is next stepped or modified.
+ */
+const Grid &World::state() const {
+    // Rebuilding the Grid from the packed state changes no cell, so it is allowed from a constant context
+    const_cast<World *>(this)->unpack_state();
+    return this->current;
+}
+
+/**
+ * World::get_state()
+ *
+ * Return a reference to the current state, which the caller may modify. Like World::edit_state it throws
+ * away everything the engines keep about the state, as any cell may be written through the reference.
+ * Callers which only read the state should use World::state(), which keeps it.
+ *
+ * @example
+ *
+ *      // Bring a cell to life
+ *      World world(4, 4);
+ *      world.get_state()(1, 2) = Cell::ALIVE;
  *
  * @return
  *      A reference to the current state.
  */
 Grid &World::get_state() const {
-    const Grid &res = this->current;
-    return const_cast<Grid &>(res);
+    return const_cast<World *>(this)->edit_state();
+}
+
+/**
+ * World::edit_state()
+ *
+ * Return a reference to the current state to modify it in place, e.g. to place a pattern.
+ * Everything the engines keep about the state is thrown away: the tiles of Engine::SPARSE, the tile hashes
+ * of cycle detection and the population counts, which are all rebuilt on the next step or query. The states
+ * seen by cycle detection and any cycle found are forgotten too, the edited state starts a new history.
+ *
+ * The reference is only for edits made before the world is next used. Stepping, counting or reading the
+ * world again may rebuild what was thrown away from the edited state, so later edits must call edit_state
+ * again rather than keep the reference.
+ *
+ * @example
+ *
+ *      // Bring a cell to life
+ *      World world(4, 4);
+ *      world.edit_state().set(1, 2, Cell::ALIVE);
+ *
+ * @return
+ *      A reference to the current state.
+ */
+Grid &World::edit_state() {
+    this->unpack_state();
+    this->tiles_valid = false;
+    this->hashes_valid = false;
+    this->population_valid = false;
+    this->tile_population_valid = false;
+    // The edits are only made once this returns, so the edited state is first recorded by the next step
+    if (this->cycle_mode != CycleMode::OFF) {
+        this->forget_cycle();
+    }
+    return this->current;
+}
+
+/**
+ * World::read_rows(y0, count, cells)
+ *
+ * Copy some whole rows of the current state out, from whichever copy of it is authoritative: the Grid or
+ * the packed buffers. Only the rows are unpacked, so it costs O(count) rows however large the board, and
+ * nothing the engines keep about the state is changed.
+ *
+ * @example
+ *
+ *      // Copy the top two rows of the world
+ *      std::vector<Cell> rows(2 * world.get_width());
+ *      world.read_rows(0, 2, rows.data());
+ *
+ * @param y0
+ *      The first row to copy.
+ *
+ * @param count
+ *      The number of rows to copy.
+ *
+ * @param cells
+ *      Where count * get_width() cells are written, row by row.
+ *
+ * @throws
+ *      std::runtime_error if the rows are not all within the world.
+ */
+void World::read_rows(const int y0, const int count, Cell *cells) const {
+    if (y0 < 0 || count < 0 || y0 + count > this->get_height()) {
+        throw std::runtime_error(std::string("The rows are out of bounds!"));
+    }
+    const int width = this->get_width();
+    if (this->packed_is_current) {
+        for (int r = 0; r < count; r++) {
+            this->packed_current.unpack_row(y0 + r, cells + static_cast<std::size_t>(r) * width);
+        }
+        return;
+    }
+    std::copy_n(this->current.row(y0), static_cast<std::size_t>(count) * width, cells);
+}
+
+/**
+ * World::write_rows(y0, count, cells)
+ *
+ * Overwrite some whole rows of the current state, in whichever copy of it is authoritative. Unlike
+ * World::edit_state it keeps what the engines know about the rest of the state: Engine::SPARSE only
+ * recomputes the tiles around the rows' changed tiles, and the population counts are corrected by the
+ * cells the rows gained or lost. If any cell changed, cycle detection starts a new history from the edited
+ * state, as the cycle found so far no longer holds.
+ *
+ * @example
+ *
+ *      // Fill the halo row above a strip with the bottom row of the strip above it
+ *      world.write_rows(0, 1, from_above.data());
+ *
+ * @param y0
+ *      The first row to overwrite.
+ *
+ * @param count
+ *      The number of rows to overwrite.
+ *
+ * @param cells
+ *      The count * get_width() cells to write, row by row.
+ *
+ * @throws
+ *      std::runtime_error if the rows are not all within the world.
+ */
+void World::write_rows(const int y0, const int count, const Cell *cells) {
+    if (y0 < 0 || count < 0 || y0 + count > this->get_height()) {
+        throw std::runtime_error(std::string("The rows are out of bounds!"));
+    }
+    const int width = this->get_width();
+    bool edited = false;
+    // Each tile column is one word of a packed row, as TILE_SIZE == BitGrid::WORD_BITS
+    const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const std::size_t first_new = this->changed_tiles.size();
+    std::vector<std::uint64_t> old_words(this->packed_is_current ? this->packed_current.get_words_per_row() : 0);
+    for (int r = 0; r < count; r++) {
+        const int y = y0 + r;
+        const Cell *row = cells + static_cast<std::size_t>(r) * width;
+        const std::uint64_t *packed_row = nullptr;
+        if (this->packed_is_current) {
+            packed_row = this->packed_current.row(y);
+            std::copy(packed_row, packed_row + old_words.size(), old_words.begin());
+            this->packed_current.pack_row(y, row);
+        }
+        for (int tx = 0; tx < tiles_x; tx++) {
+            const int x0 = tx * TILE_SIZE, x1 = std::min(x0 + TILE_SIZE, width);
+            bool changed;
+            int gained;
+            if (this->packed_is_current) {
+                changed = packed_row[tx] != old_words[tx];
+                gained = popcount64(packed_row[tx]) - popcount64(old_words[tx]);
+            } else {
+                Cell *state = this->current.row(y);
+                changed = !std::equal(row + x0, row + x1, state + x0);
+                gained = static_cast<int>(std::count(row + x0, row + x1, Cell::ALIVE)
+                                          - std::count(state + x0, state + x1, Cell::ALIVE));
+                std::copy(row + x0, row + x1, state + x0);
+            }
+            if (!changed) {
+                continue;
+            }
+            edited = true;
+            const int tile = (y / TILE_SIZE) * tiles_x + tx;
+            if (this->tiles_valid) {
+                this->changed_tiles.push_back(tile);
+            }
+            if (this->population_valid) {
+                this->population += gained;
+            }
+            if (this->tile_population_valid) {
+                this->tile_population[tile] += gained;
+            }
+        }
+    }
+    // A tile spanning several of the rows is activated once by the next sparse step
+    std::sort(this->changed_tiles.begin() + first_new, this->changed_tiles.end());
+    this->changed_tiles.erase(std::unique(this->changed_tiles.begin() + first_new, this->changed_tiles.end()),
+                              this->changed_tiles.end());
+    if (edited) {
+        this->hashes_valid = false;
+        if (this->cycle_mode != CycleMode::OFF) {
+            this->reset_cycle();
+        }
+    }
 }
 
 /**
@@ -274,6 +561,7 @@ Grid &World::get_state() const {
  *
  * The content of the current state grid should be preserved within the kept region.
  * The values in the next state grid do not need to be preserved, allowing an easy optimization.
+ * Both grids are resized in place, so resizing back and forth reuses their buffers rather than reallocating.
  *
  * @example
  *
@@ -297,6 +585,7 @@ void World::resize(int square_size) {
  *
  * The content of the current state grid should be preserved within the kept region.
  * The values in the next state grid do not need to be preserved, allowing an easy optimization.
+ * Both grids are resized in place, so resizing back and forth reuses their buffers rather than reallocating.
  *
  * @example
  *
@@ -313,8 +602,18 @@ void World::resize(int square_size) {
  *      The new height for the grid.
  */
 void World::resize(int new_width, int new_height) {
+    this->unpack_state();
+    this->tiles_valid = false;
+    this->hashes_valid = false;
+    this->population_valid = false;
+    this->tile_population_valid = false;
+    // The next state is resized by the engine on the next step, reusing its buffer
     this->current.resize(new_width, new_height);
-    this->next = Grid(new_width, new_height);
+    this->grids_placed = false;
+    this->packed_placed = false;
+    if (this->cycle_mode != CycleMode::OFF) {
+        this->reset_cycle();
+    }
 }
 
 /**
@@ -351,7 +650,7 @@ void World::resize(int new_width, int new_height) {
 int World::count_alive_neighbours(int x, int y, bool toroidal) {
     Grid neighbours = Grid(3);
     // Center cell should be dead because it can't be its own neighbour
-    neighbours(1, 1) = Cell::DEAD;
+    neighbours.at_unchecked(1, 1) = Cell::DEAD;
     // Try to assign a proper value, if the index doesn't exist assign it to a dead cell / find a value w.r.t
     // toroidal method. new_i and new_j is difference in coordinates between center and current cell
     for (int i = 0, new_i = -1; i < neighbours.get_height(); i++, new_i++) {
@@ -361,7 +660,7 @@ int World::count_alive_neighbours(int x, int y, bool toroidal) {
                 if ((x + new_j >= this->current.get_width() || x + new_j < 0) ||
                     (y + new_i >= this->current.get_height() || y + new_i < 0)) {
                     if (!toroidal) {
-                        neighbours(j, i) = Cell::DEAD;
+                        neighbours.at_unchecked(j, i) = Cell::DEAD;
                     } else {
                         // Treat the grid as a torus using the formula
                         // These are going to be mapped coordinates w.r.t toroidal representation
@@ -384,11 +683,11 @@ int World::count_alive_neighbours(int x, int y, bool toroidal) {
                         toroidal_i = (y + new_i + get_height() * offset) % get_height();
 
 
-                        neighbours(j, i) = this->current(toroidal_j, toroidal_i);
+                        neighbours.at_unchecked(j, i) = this->current.at_unchecked(toroidal_j, toroidal_i);
                     }
                 } else {
                     // Coordinates are inside the bounds
-                    neighbours(j, i) = this->current(x + new_j, y + new_i);
+                    neighbours.at_unchecked(j, i) = this->current.at_unchecked(x + new_j, y + new_i);
                 }
             }
         }
@@ -399,67 +698,1684 @@ int World::count_alive_neighbours(int x, int y, bool toroidal) {
 /**
  * World::step(toroidal)
  *
- * Take one step in Conway's Game of Life.
+ * Take one step in Conway's Game of Life, or the Life-like rule selected with World::set_rule(rule).
 
  *
  * Reads from the current state grid and writes to the next state grid. Then swaps the grids.
- * Should be implemented by invoking World::count_neighbours(x, y, toroidal).
+ * The work is delegated to the selected engine, each of which produces the same next state.
  * Swapping the grids should be done in O(1) constant time, and should not invoke a copy.
- * Try and boil the logic down to the fewest and most simple conditional statements.
  *
  * Rules: https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
  *      - Any live cell with fewer than two live neighbours dies, as if by underpopulation.
  *      - Any live cell with two or three live neighbours lives on to the next generation.
  *      - Any live cell with more than three live neighbours dies, as if by overpopulation.
  *      - Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
+ * Other rules replace the neighbour counts for survival and birth, e.g. HighLife (B36/S23) is also born with 6.
  *
  * @param toroidal
  *      Optional parameter. If true then the step will consider the grid as a torus, where the left edge
  *      wraps to the right edge and the top to the bottom. Defaults to false.
  */
 void World::step(bool toroidal) {
-    this->next = this->current;
+    const Stats::Timer timer(Stats::Phase::STEP);
+    switch (this->engine) {
+        case Engine::REFERENCE:
+            this->step_reference(toroidal);
+            break;
+        case Engine::BYTE:
+            this->step_byte(toroidal, get_row_kernel(SimdLevel::SCALAR, this->rule));
+            break;
+        case Engine::SIMD:
+            this->step_byte(toroidal, get_row_kernel(this->simd_level, this->rule));
+            break;
+        case Engine::BITPACKED:
+            this->step_bitpacked(toroidal);
+            break;
+        case Engine::SPARSE:
+            this->step_sparse(toroidal);
+            break;
+    }
+    // Only counted once the engine stepped, an engine which throws leaves the state and generation as they were
+    this->generation++;
+    // Every other engine writes the whole board, so the tiles the sparse engine tracked are out of date
+    if (this->engine != Engine::SPARSE) {
+        this->tiles_valid = false;
+        this->tile_population_valid = false;
+    }
+    if (this->cycle_mode != CycleMode::OFF && this->cycle_period > 0 && toroidal != this->cycle_toroidal) {
+        // A cycle found on the other topology says nothing about this one, the search starts over from here
+        this->cycle_toroidal = toroidal;
+        this->forget_cycle();
+    }
+    if (this->cycle_mode != CycleMode::OFF && this->cycle_period == 0) {
+        this->record_state(toroidal);
+    }
+    if (this->track_changes) {
+        this->collect_changes();
+    }
+    if (Stats::enabled()) {
+        this->count_step();
+    }
+}
+
+/**
+ * World::steps_observed()
+ *
+ * Private helper function telling whether something reads every state a step produces, and the one it was
+ * stepped from: cycle detection still looking for a cycle, change tracking or Stats. Otherwise only the
+ * state World::advance ends on is ever seen, so it is free to skip over the states in between.
+ *
+ * @return
+ *      True if every step has to be taken on its own.
+ */
+bool World::steps_observed() const {
+    return (this->cycle_mode != CycleMode::OFF && this->cycle_period == 0) || this->track_changes ||
+           Stats::enabled();
+}
+
+/**
+ * Counts the cells of a row born and killed since the row it was stepped from.
+ */
+static inline void count_row_changes(const Cell *now, const Cell *before, const int count, std::uint64_t &births,
+                                     std::uint64_t &deaths) {
+    std::uint64_t born = 0, died = 0;
+    for (int x = 0; x < count; x++) {
+        const int alive = now[x] == Cell::ALIVE, was_alive = before[x] == Cell::ALIVE;
+        born += alive & !was_alive;
+        died += was_alive & !alive;
+    }
+    births += born;
+    deaths += died;
+}
+
+/**
+ * World::count_step()
+ *
+ * Private helper function feeding the last step to Stats: the generation, the cells recomputed, the tiles
+ * recomputed by Engine::SPARSE, and the births and deaths. Every engine leaves the state it stepped from in
+ * the other buffer, so the births and deaths are found by comparing the two, a word at a time when packed.
+ * Only called while Stats is enabled.
+ */
+void World::count_step() const {
+    std::uint64_t births = 0, deaths = 0;
+    std::uint64_t cells = static_cast<std::uint64_t>(this->get_width()) * this->get_height();
+    if (this->packed_is_current) {
+        const int words = this->packed_current.get_words_per_row();
+        for (int y = 0; y < this->packed_current.get_height(); y++) {
+            const std::uint64_t *now = this->packed_current.row(y), *before = this->packed_next.row(y);
+            for (int w = 0; w < words; w++) {
+                births += popcount64(now[w] & ~before[w]);
+                deaths += popcount64(before[w] & ~now[w]);
+            }
+        }
+    } else if (this->engine == Engine::SPARSE) {
+        // Only the changed tiles differ, and only the active tiles were recomputed
+        const int width = this->get_width(), height = this->get_height();
+        const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+        cells = 0;
+        for (const int tile : this->active_list) {
+            const int x0 = (tile % tiles_x) * TILE_SIZE, y0 = (tile / tiles_x) * TILE_SIZE;
+            cells += static_cast<std::uint64_t>(std::min(TILE_SIZE, width - x0)) * std::min(TILE_SIZE, height - y0);
+        }
+        for (const int tile : this->changed_tiles) {
+            const int x0 = (tile % tiles_x) * TILE_SIZE, y0 = (tile / tiles_x) * TILE_SIZE;
+            const int x1 = std::min(x0 + TILE_SIZE, width), y1 = std::min(y0 + TILE_SIZE, height);
+            for (int y = y0; y < y1; y++) {
+                count_row_changes(this->current.row(y) + x0, this->next.row(y) + x0, x1 - x0, births, deaths);
+            }
+        }
+        Stats::add(Stats::Counter::ACTIVE_TILES, static_cast<std::uint64_t>(this->active_tiles));
+    } else {
+        for (int y = 0; y < this->get_height(); y++) {
+            count_row_changes(this->current.row(y), this->next.row(y), this->get_width(), births, deaths);
+        }
+    }
+    Stats::add(Stats::Counter::GENERATIONS, 1);
+    Stats::add(Stats::Counter::CELLS_UPDATED, cells);
+    Stats::add(Stats::Counter::BIRTHS, births);
+    Stats::add(Stats::Counter::DEATHS, deaths);
+}
+
+/**
+ * Appends the cells of a row born and killed since the row it was stepped from, skipping unchanged rows whole.
+ */
+static void collect_row_changes(const Cell *now, const Cell *before, const int count, const int first_index,
+                                std::vector<int> &births, std::vector<int> &deaths) {
+    if (std::memcmp(now, before, count) == 0) {
+        return;
+    }
+    for (int x = 0; x < count; x++) {
+        if (now[x] != before[x]) {
+            (now[x] == Cell::ALIVE ? births : deaths).push_back(first_index + x);
+        }
+    }
+}
+
+/**
+ * World::collect_changes()
+ *
+ * Private helper function filling the births and deaths of the last step, by comparing the state with the
+ * state it was stepped from in the other buffer, as World::count_step does. Packed states are compared a word
+ * at a time and only the changed tiles are compared after a step with Engine::SPARSE, so a quiet board costs
+ * little more than the scan of its words or its changed tiles.
+ */
+void World::collect_changes() {
+    this->births.clear();
+    this->deaths.clear();
+    const int width = this->get_width(), height = this->get_height();
+    if (this->packed_is_current) {
+        const int words = this->packed_current.get_words_per_row();
+        for (int y = 0; y < height; y++) {
+            const std::uint64_t *now = this->packed_current.row(y), *before = this->packed_next.row(y);
+            for (int w = 0; w < words; w++) {
+                std::uint64_t changed = now[w] ^ before[w];
+                while (changed) {
+                    const int x = w * 64 + lowest_bit64(changed);
+                    ((now[w] >> (x & 63)) & 1 ? this->births : this->deaths).push_back(y * width + x);
+                    changed &= changed - 1;
+                }
+            }
+        }
+    } else if (this->engine == Engine::SPARSE) {
+        const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+        for (const int tile : this->changed_tiles) {
+            const int x0 = (tile % tiles_x) * TILE_SIZE, y0 = (tile / tiles_x) * TILE_SIZE;
+            const int x1 = std::min(x0 + TILE_SIZE, width), y1 = std::min(y0 + TILE_SIZE, height);
+            for (int y = y0; y < y1; y++) {
+                collect_row_changes(this->current.row(y) + x0, this->next.row(y) + x0, x1 - x0, y * width + x0,
+                                    this->births, this->deaths);
+            }
+        }
+        // The tiles changed in no particular order
+        std::sort(this->births.begin(), this->births.end());
+        std::sort(this->deaths.begin(), this->deaths.end());
+    } else {
+        for (int y = 0; y < height; y++) {
+            collect_row_changes(this->current.row(y), this->next.row(y), width, y * width, this->births,
+                                this->deaths);
+        }
+    }
+}
+
+/**
+ * World::step_reference(toroidal)
+ *
+ * Private helper function taking one step using the reference engine.
+ * Implemented by invoking World::count_neighbours(x, y, toroidal) for every cell, it is slow but
+ * simple enough to serve as the specification the other engines are compared against.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+void World::step_reference(const bool toroidal) {
+    this->unpack_state();
+    // Every cell of next is written below, so it only needs the right size rather than a copy of the state
+    if (this->next.get_width() != this->get_width() || this->next.get_height() != this->get_height()) {
+        this->next.resize(this->get_width(), this->get_height());
+    }
+    // The cells of next are counted as they are written, keeping the population without a recount
+    std::uint64_t population = 0;
     for (int i = 0; i < this->get_height(); i++) {
         for (int j = 0; j < this->get_width(); j++) {
-            if (this->current(j, i) == Cell::DEAD) {
-                // A dead cell with 3 neighbours becomes alive
-                if (count_alive_neighbours(j, i, toroidal) == 3) {
-                    this->next(j, i) = Cell::ALIVE;
+            const bool alive = this->current.at_unchecked(j, i) == Cell::ALIVE;
+            // A dead cell with a birth count of neighbours becomes alive, 3 for Conway's rule
+            // An alive cell without a survival count of neighbours becomes dead, 2 or 3 for Conway's rule
+            const bool next_alive = this->rule.next(alive, count_alive_neighbours(j, i, toroidal));
+            this->next.at_unchecked(j, i) = next_alive ? Cell::ALIVE : Cell::DEAD;
+            population += next_alive;
+        }
+    }
+    std::swap(this->current, this->next);
+    if (this->population_valid) {
+        this->population = population;
+    }
+}
+
+/**
+ * Applies a rule to a cell given its number of alive neighbours.
+ */
+static inline Cell next_cell(const Cell cell, const int neighbours, const Rule &rule) {
+    return rule.next(cell == Cell::ALIVE, neighbours) ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * Counts a cell as 0 or 1.
+ */
+static inline int is_alive(const Cell cell) {
+    return cell == Cell::ALIVE;
+}
+
+/**
+ * World::step_byte(toroidal, interior)
+ *
+ * Private helper function taking one step using the byte or SIMD engine, which only differ in the row kernel.
+ * Every cell of the next state is written, so no copy of the current state is needed first.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ *
+ * @param interior
+ *      The row kernel used for the interior columns of each row.
+ */
+void World::step_byte(const bool toroidal, const RowKernel interior) {
+    this->unpack_state();
+    if (!this->grids_placed || this->next.get_width() != this->get_width()
+        || this->next.get_height() != this->get_height()) {
+        this->place_grids();
+    }
+    const int width = this->get_width();
+    if (!this->population_valid) {
+        this->run_bands([this, width, toroidal, interior](const int y0, const int y1) {
+            this->step_byte_block(0, width, y0, y1, toroidal, interior);
+        });
+        std::swap(this->current, this->next);
+        return;
+    }
+    // The rows are counted a few at a time, while they are still in cache
+    std::atomic<std::uint64_t> alive(0);
+    this->run_bands([this, width, toroidal, interior, &alive](const int y0, const int y1) {
+        std::uint64_t band = 0;
+        for (int y = y0; y < y1; y += COUNT_ROWS) {
+            const int end = std::min(y + COUNT_ROWS, y1);
+            this->step_byte_block(0, width, y, end, toroidal, interior);
+            for (int r = y; r < end; r++) {
+                band += static_cast<std::uint64_t>(std::count(this->next.row(r), this->next.row(r) + width,
+                                                              Cell::ALIVE));
+            }
+        }
+        alive += band;
+    });
+    std::swap(this->current, this->next);
+    this->population = alive;
+}
+
+/**
+ * World::step_byte_block(x0, x1, y0, y1, toroidal, interior)
+ *
+ * Private helper function writing the block [x0, x1) by [y0, y1) of the next state from the current state.
+ *
+ * Neighbours are counted straight off the row buffers of the current state, each count is evaluated once
+ * and no memory is allocated. The interior of the grid, where all 8 neighbours exist, is handled by a row
+ * kernel with no bounds checks or branches, either the scalar one or one of the vectorised ones in simd.cpp.
+ * The outermost rows and columns are handled separately by World::next_border_cell(x, y, toroidal),
+ * which knows how to treat the edges.
+ *
+ * @param x0
+ *      The first column to write.
+ *
+ * @param x1
+ *      One past the last column to write.
+ *
+ * @param y0
+ *      The first row to write.
+ *
+ * @param y1
+ *      One past the last row to write.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ *
+ * @param interior
+ *      The row kernel used for the interior columns of each row.
+ */
+void World::step_byte_block(const int x0, const int x1, const int y0, const int y1, const bool toroidal,
+                            const RowKernel interior) {
+    const int width = this->get_width();
+    const int height = this->get_height();
+    const int inner_x0 = std::max(x0, 1);
+    const int inner_x1 = std::min(x1, width - 1);
+    for (int y = y0; y < y1; y++) {
+        Cell *out = this->next.row(y);
+        // Rows without a row above and below, and grids too narrow to have an interior, are all border
+        if (y == 0 || y == height - 1 || width < 3) {
+            for (int x = x0; x < x1; x++) {
+                out[x] = this->next_border_cell(x, y, toroidal);
+            }
+            continue;
+        }
+        const Cell *up = this->current.row(y - 1);
+        const Cell *mid = this->current.row(y);
+        const Cell *down = this->current.row(y + 1);
+
+        if (x0 == 0) {
+            out[0] = this->next_border_cell(0, y, toroidal);
+        }
+        if (inner_x0 < inner_x1) {
+            interior(up, mid, down, out, inner_x0, inner_x1, this->rule);
+        }
+        if (x1 == width) {
+            out[width - 1] = this->next_border_cell(width - 1, y, toroidal);
+        }
+    }
+}
+
+/**
+ * World::step_sparse(toroidal)
+ *
+ * Private helper function taking one step using the sparse engine.
+ *
+ * A tile can only change if it, or one of the 8 tiles around it, changed during the previous step. Those
+ * active tiles are recomputed and every other tile is left alone: the next state buffer holds the generation
+ * before the current one, and a tile which did not change between them already holds the right cells.
+ *
+ * Whenever the state was changed by anything else (another engine, World::edit_state, World::resize)
+ * or the topology changed, every tile is treated as active for one step to rebuild that guarantee.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+void World::step_sparse(const bool toroidal) {
+    this->unpack_state();
+    const int width = this->get_width();
+    const int height = this->get_height();
+    if (this->next.get_width() != width || this->next.get_height() != height) {
+        this->next.resize(width, height);
+        this->tiles_valid = false;
+    }
+    const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    const int tiles = tiles_x * tiles_y;
+
+    this->active_list.clear();
+    if (!this->tiles_valid || this->tiles_toroidal != toroidal ||
+        static_cast<int>(this->tile_active.size()) != tiles) {
+        this->tile_active.assign(tiles, 0);
+        for (int tile = 0; tile < tiles; tile++) {
+            this->active_list.push_back(tile);
+        }
+        this->tiles_valid = true;
+        this->tiles_toroidal = toroidal;
+    } else {
+        // Activate every tile which changed along with its neighbours, each one only once
+        for (const int tile : this->changed_tiles) {
+            const int tx = tile % tiles_x, ty = tile / tiles_x;
+            for (int dy = -1; dy <= 1; dy++) {
+                int ny = ty + dy;
+                if (ny < 0 || ny >= tiles_y) {
+                    if (!toroidal) continue;
+                    ny = (ny + tiles_y) % tiles_y;
                 }
-            } else {
-                //If less a number of neighbours is <2 or >3 and the cell is alive, it becomes dead
-                if (count_alive_neighbours(j, i, toroidal) < 2 || count_alive_neighbours(j, i, toroidal) > 3) {
-                    this->next(j, i) = Cell::DEAD;
+                for (int dx = -1; dx <= 1; dx++) {
+                    int nx = tx + dx;
+                    if (nx < 0 || nx >= tiles_x) {
+                        if (!toroidal) continue;
+                        nx = (nx + tiles_x) % tiles_x;
+                    }
+                    const int neighbour = ny * tiles_x + nx;
+                    if (!this->tile_active[neighbour]) {
+                        this->tile_active[neighbour] = 1;
+                        this->active_list.push_back(neighbour);
+                    }
                 }
             }
         }
     }
-    std::swap(this->current, this->next);
-}
 
-void World::step() {
-    this->step(false);
+    // The tile counts are kept from here on, so only the tiles which change need counting again
+    if (this->population_valid && !this->tile_population_valid) {
+        this->count_tiles();
+    }
+
+    const int count = static_cast<int>(this->active_list.size());
+    this->tile_changed.assign(count, 0);
+    const RowKernel interior = get_row_kernel(this->simd_level, this->rule);
+    const int chunks = std::min(this->threads, count);
+    if (chunks < 2 || static_cast<long long>(count) * TILE_SIZE * TILE_SIZE < MIN_PARALLEL_CELLS) {
+        for (int i = 0; i < count; i++) {
+            this->tile_changed[i] = this->step_tile(this->active_list[i], toroidal, interior);
+        }
+    } else {
+        // Each tile writes its own cells of next and its own change flag, so the chunks never overlap
+        this->get_pool().run(chunks, [this, count, chunks, toroidal, interior](const int chunk) {
+            for (int i = count * chunk / chunks; i < count * (chunk + 1) / chunks; i++) {
+                this->tile_changed[i] = this->step_tile(this->active_list[i], toroidal, interior);
+            }
+        });
+    }
+
+    this->changed_tiles.clear();
+    for (int i = 0; i < count; i++) {
+        this->tile_active[this->active_list[i]] = 0;
+        if (this->tile_changed[i]) {
+            this->changed_tiles.push_back(this->active_list[i]);
+        }
+    }
+    this->active_tiles = count;
+    if (this->tile_population_valid) {
+        for (const int tile : this->changed_tiles) {
+            const int x0 = (tile % tiles_x) * TILE_SIZE, y0 = (tile / tiles_x) * TILE_SIZE;
+            const int x1 = std::min(x0 + TILE_SIZE, width), y1 = std::min(y0 + TILE_SIZE, height);
+            int alive = 0;
+            for (int y = y0; y < y1; y++) {
+                alive += static_cast<int>(std::count(this->next.row(y) + x0, this->next.row(y) + x1, Cell::ALIVE));
+            }
+            // The difference is the births less the deaths of the tile
+            this->population += alive;
+            this->population -= this->tile_population[tile];
+            this->tile_population[tile] = alive;
+        }
+    }
+    std::swap(this->current, this->next);
 }
 
 /**
- * World::advance(steps, toroidal)
+ * World::step_tile(tile, toroidal, interior)
  *
- * Advance multiple steps in the Game of Life.
- * Should be implemented by invoking World::step(toroidal).
+ * Private helper function writing one tile of the next state from the current state.
  *
- * @param steps
- *      The number of steps to advance the world forward.
+ * @param tile
+ *      The index of the tile, in row major order.
  *
  * @param toroidal
- *      Optional parameter. If true then the step will consider the grid as a torus, where the left edge
- *      wraps to the right edge and the top to the bottom. Defaults to false.
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ *
+ * @param interior
+ *      The row kernel used for the interior columns of each row.
+ *
+ * @return
+ *      True if any cell of the tile changed.
  */
-void World::advance(int steps, bool toroidal) {
-    for (int i = 0; i < steps; i++) {
-        this->step(toroidal);
+bool World::step_tile(const int tile, const bool toroidal, const RowKernel interior) {
+    const int width = this->get_width();
+    const int height = this->get_height();
+    const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int x0 = (tile % tiles_x) * TILE_SIZE, y0 = (tile / tiles_x) * TILE_SIZE;
+    const int x1 = std::min(x0 + TILE_SIZE, width), y1 = std::min(y0 + TILE_SIZE, height);
+    this->step_byte_block(x0, x1, y0, y1, toroidal, interior);
+    for (int y = y0; y < y1; y++) {
+        if (!std::equal(this->next.row(y) + x0, this->next.row(y) + x1, this->current.row(y) + x0)) {
+            return true;
+        }
     }
+    return false;
 }
 
-void World::advance(int steps) {
-    this->advance(steps, false);
+/**
+ * World::next_border_cell(x, y, toroidal)
+ *
+ * Private helper function computing the next state of a cell on the outermost rows or columns of the grid.
+ * Neighbours outside the grid are dead, or wrapped to the opposite side if toroidal, which matches
+ * World::count_alive_neighbours(x, y, toroidal) for any grid size.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ *
+ * @return
+ *      The value of the cell in the next state.
+ */
+Cell World::next_border_cell(const int x, const int y, const bool toroidal) const {
+    const int width = this->get_width();
+    const int height = this->get_height();
+    int neighbours = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        int ny = y + dy;
+        if (ny < 0 || ny >= height) {
+            if (!toroidal) continue;
+            ny = (ny + height) % height;
+        }
+        const Cell *cells = this->current.row(ny);
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx;
+            if (dx == 0 && dy == 0) continue;
+            if (nx < 0 || nx >= width) {
+                if (!toroidal) continue;
+                nx = (nx + width) % width;
+            }
+            neighbours += is_alive(cells[nx]);
+        }
+    }
+    return next_cell(this->current.row(y)[x], neighbours, this->rule);
+}
+
+void World::step() {
+    this->step(false);
+}
+
+/**
+ * World::advance(steps, toroidal)
+ *
+ * Advance multiple steps in the Game of Life.
+ * Should be implemented by invoking World::step(toroidal).
+ *
+ * With Engine::BITPACKED, and nothing reading the states in between, up to World::get_temporal_depth()
+ * generations are instead taken in a single pass over the board by World::advance_bitpacked, ending on
+ * the same state as stepping them one at a time.
+ *
+ * @param steps
+ *      The number of steps to advance the world forward.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom. Defaults to false.
+ */
+void World::advance(int steps, bool toroidal) {
+    if (this->cycle_mode != CycleMode::OFF && this->cycle_period > 0 && toroidal != this->cycle_toroidal) {
+        // Dropped before any steps are blocked together, those would skip the check World::step makes
+        this->cycle_toroidal = toroidal;
+        this->forget_cycle();
+    }
+    for (int done = 0; done < steps; done++) {
+        // Once a cycle is known the state repeats every period steps, so only the remainder is simulated
+        if (this->cycle_mode == CycleMode::SKIP && this->cycle_period > 0 && this->cycle_toroidal == toroidal) {
+            const std::uint64_t remaining = static_cast<std::uint64_t>(steps - done);
+            const std::uint64_t skipped = remaining - remaining % this->cycle_period;
+            this->generation += skipped;
+            done += static_cast<int>(skipped);
+            if (done >= steps) {
+                return;
+            }
+        }
+        const int block = std::min(this->temporal_depth, steps - done);
+        if (block > 1 && this->engine == Engine::BITPACKED && !this->steps_observed()) {
+            this->advance_bitpacked(block, toroidal);
+            done += block - 1;
+            continue;
+        }
+        this->step(toroidal);
+    }
+}
+
+void World::advance(int steps) {
+    this->advance(steps, false);
+}
+
+/**
+ * World::set_engine(engine)
+ *
+ * Select the engine used by World::step and World::advance. The current state is kept.
+ *
+ * @example
+ *
+ *      // Step a large world 64 cells at a time
+ *      World world(4096, 4096);
+ *      world.set_engine(Engine::BITPACKED);
+ *      world.advance(100);
+ *
+ * @param engine
+ *      The engine to step with.
+ */
+void World::set_engine(const Engine engine) {
+    this->engine = engine;
+}
+
+/**
+ * World::get_engine()
+ *
+ * Gets the engine used by World::step and World::advance.
+ *
+ * @return
+ *      The selected engine.
+ */
+Engine World::get_engine() const {
+    return this->engine;
+}
+
+/**
+ * World::set_simd_level(level)
+ *
+ * Select the instruction set used by Engine::SIMD. Every level produces the same results.
+ *
+ * @example
+ *
+ *      // Compare AVX2 against SSE2
+ *      World world(4096, 4096);
+ *      world.set_engine(Engine::SIMD);
+ *      world.set_simd_level(SimdLevel::AVX2);
+ *
+ * @param level
+ *      The instruction set, SimdLevel::AUTO picks the widest one the CPU supports.
+ *
+ * @throws
+ *      std::runtime_error if the CPU does not support the instruction set.
+ */
+void World::set_simd_level(const SimdLevel level) {
+    if (!simd_level_supported(level)) {
+        throw std::runtime_error(std::string("The CPU does not support ") + simd_level_name(level) + "!");
+    }
+    this->simd_level = level;
+}
+
+/**
+ * World::get_simd_level()
+ *
+ * Gets the instruction set used by Engine::SIMD.
+ *
+ * @return
+ *      The selected instruction set, which may be SimdLevel::AUTO.
+ */
+SimdLevel World::get_simd_level() const {
+    return this->simd_level;
+}
+
+/**
+ * World::set_rule(rule)
+ *
+ * Select the rule applied by World::step and World::advance. The current state is kept.
+ * Every engine supports every rule, and the specialised rules of RuleKind step as fast as Conway's.
+ *
+ * @example
+ *
+ *      // Run HighLife instead of Conway's Game of Life
+ *      World world(Zoo::load_ascii("replicator.gol"));
+ *      world.set_rule(Rule("B36/S23"));
+ *      world.advance(100);
+ *
+ * @param rule
+ *      The rule to step with.
+ */
+void World::set_rule(const Rule &rule) {
+    if (rule != this->rule) {
+        this->rule = rule;
+        // The stable tiles of the sparse engine were only stable under the old rule
+        this->tiles_valid = false;
+        if (this->cycle_mode != CycleMode::OFF) {
+            this->reset_cycle();
+        }
+    }
+}
+
+/**
+ * World::get_rule()
+ *
+ * Gets the rule applied by World::step and World::advance.
+ *
+ * @return
+ *      The selected rule, B3/S23 unless another was selected.
+ */
+const Rule &World::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * World::set_threads(threads)
+ *
+ * Select the number of threads used by World::step and World::advance. The threads are kept in a pool
+ * for the lifetime of the world rather than started for every step. Engine::REFERENCE always steps serially.
+ * The first banded step on the new threads copies the board into buffers each thread first touches its own
+ * band of, so on NUMA machines every thread steps rows held on its own memory node.
+ *
+ * @example
+ *
+ *      // Step a large world on 8 threads
+ *      World world(4096, 4096);
+ *      world.set_threads(8);
+ *      world.advance(100);
+ *
+ * @param threads
+ *      The number of threads, 0 selects one per hardware thread and 1 disables threading.
+ */
+void World::set_threads(const int threads) {
+    int count = threads;
+    if (count <= 0) {
+        count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    if (count != this->threads) {
+        this->threads = count;
+        this->pool.reset();
+        // The bands change with the thread count, so the rows of each are moved to their new thread
+        this->grids_placed = false;
+        this->packed_placed = false;
+    }
+}
+
+/**
+ * World::get_threads()
+ *
+ * Gets the number of threads used by World::step and World::advance.
+ *
+ * @return
+ *      The number of threads.
+ */
+int World::get_threads() const {
+    return this->threads;
+}
+
+/**
+ * World::set_temporal_depth(depth)
+ *
+ * Select how many generations World::advance takes per pass over a board stepped with Engine::BITPACKED.
+ * Stepping one generation at a time streams the whole board through memory every generation, which bounds
+ * boards larger than the caches by memory bandwidth. Deeper passes step each cache sized tile of rows that
+ * many generations before moving on, at the cost of recomputing depth rows either side of every tile.
+ *
+ * @example
+ *
+ *      // Step a board much larger than the caches 16 generations per pass
+ *      World world(Zoo::load_binary_packed("path/to/huge.bgol"));
+ *      world.set_temporal_depth(16);
+ *      world.advance(10000);
+ *
+ * @param depth
+ *      The generations per pass, 8 by default. 1 steps one generation at a time.
+ *
+ * @throws
+ *      std::runtime_error if the depth is not positive.
+ */
+void World::set_temporal_depth(const int depth) {
+    if (depth < 1) {
+        throw std::runtime_error(std::string("The temporal depth must be positive!"));
+    }
+    this->temporal_depth = depth;
+}
+
+/**
+ * World::get_temporal_depth()
+ *
+ * Gets the generations World::advance takes per pass over a bit-packed board.
+ *
+ * @return
+ *      The temporal depth.
+ */
+int World::get_temporal_depth() const {
+    return this->temporal_depth;
+}
+
+/**
+ * World::get_pool()
+ *
+ * Private helper function returning the thread pool, starting it with the selected number of threads
+ * the first time it is needed.
+ *
+ * @return
+ *      The pool shared by every parallel step.
+ */
+ThreadPool &World::get_pool() {
+    if (!this->pool || this->pool->get_thread_count() != this->threads) {
+        this->pool = std::make_shared<ThreadPool>(this->threads);
+    }
+    return *this->pool;
+}
+
+/**
+ * World::count_bands()
+ *
+ * Private helper function giving the number of bands World::run_bands(rows) splits the rows into, 1 if it
+ * runs them serially. The bands only change with the size of the world and the number of threads.
+ *
+ * @return
+ *      The number of bands.
+ */
+int World::count_bands() const {
+    const int bands = std::min(this->threads, this->get_height() / MIN_BAND_ROWS);
+    return this->get_total_cells() < MIN_PARALLEL_CELLS ? 1 : std::max(bands, 1);
+}
+
+/**
+ * World::run_bands(rows)
+ *
+ * Private helper function splitting the rows of the world into horizontal bands and invoking
+ * rows(y0, y1) for every band [y0, y1), in parallel on the thread pool.
+ *
+ * Bands are kept at least MIN_BAND_ROWS tall and boards with fewer than MIN_PARALLEL_CELLS cells are not
+ * split at all, since the cost of waking the pool would outweigh the step itself.
+ *
+ * @param rows
+ *      The function computing a band of rows.
+ */
+void World::run_bands(const std::function<void(int, int)> &rows) {
+    const int height = this->get_height();
+    const int bands = this->count_bands();
+    if (bands < 2) {
+        rows(0, height);
+        return;
+    }
+    this->get_pool().run(bands, [&rows, height, bands](const int band) {
+        rows(static_cast<int>(static_cast<long long>(height) * band / bands),
+             static_cast<int>(static_cast<long long>(height) * (band + 1) / bands));
+    });
+}
+
+/**
+ * World::place_grids()
+ *
+ * Private helper function making sure next is the size of current, and that when the rows are stepped in bands
+ * the pages of both grids were first written by the thread which steps them.
+ *
+ * Both grids are replaced by Grid::untouched copies filled in band by band on the thread pool. As the bands
+ * never change while the size and thread count stay the same, on NUMA machines every thread then reads and
+ * writes memory on its own node for every step after, instead of whichever node the board was loaded on.
+ */
+void World::place_grids() {
+    const int width = this->get_width();
+    const int height = this->get_height();
+    this->grids_placed = true;
+    if (this->count_bands() < 2) {
+        if (this->next.get_width() != width || this->next.get_height() != height) {
+            this->next.resize(width, height);
+        }
+        return;
+    }
+    Grid placed_current = Grid::untouched(width, height);
+    Grid placed_next = Grid::untouched(width, height);
+    const Grid &source = this->current;
+    this->run_bands([width, &source, &placed_current, &placed_next](const int y0, const int y1) {
+        const std::size_t cells = static_cast<std::size_t>(width) * (y1 - y0);
+        std::memcpy(placed_current.row(y0), source.row(y0), cells);
+        std::fill_n(placed_next.row(y0), cells, Cell::DEAD);
+    });
+    this->current = std::move(placed_current);
+    this->next = std::move(placed_next);
+    // next no longer holds the tiles of the previous state
+    this->tiles_valid = false;
+}
+
+/**
+ * World::place_packed()
+ *
+ * Private helper function doing for packed_current and packed_next what World::place_grids() does for the
+ * Grid buffers.
+ */
+void World::place_packed() {
+    const int width = this->packed_current.get_width();
+    const int height = this->packed_current.get_height();
+    this->packed_placed = true;
+    if (this->count_bands() < 2) {
+        if (this->packed_next.get_width() != width || this->packed_next.get_height() != height) {
+            this->packed_next = BitGrid(width, height);
+        }
+        return;
+    }
+    BitGrid placed_current = BitGrid::untouched(width, height);
+    BitGrid placed_next = BitGrid::untouched(width, height);
+    const BitGrid &source = this->packed_current;
+    const std::size_t words = static_cast<std::size_t>(source.get_words_per_row());
+    this->run_bands([words, &source, &placed_current, &placed_next](const int y0, const int y1) {
+        std::memcpy(placed_current.row(y0), source.row(y0), words * (y1 - y0) * sizeof(std::uint64_t));
+        std::fill_n(placed_next.row(y0), words * (y1 - y0), 0);
+    });
+    this->packed_current = std::move(placed_current);
+    this->packed_next = std::move(placed_next);
+}
+
+/**
+ * World::get_active_tiles()
+ *
+ * Gets the number of tiles recomputed by the last step taken with Engine::SPARSE, a measure of how much of
+ * the board is still active. Each tile is TILE_SIZE x TILE_SIZE cells.
+ *
+ * @example
+ *
+ *      World world(Zoo::load_ascii("soup.gol"));
+ *      world.set_engine(Engine::SPARSE);
+ *      world.advance(1000);
+ *      std::cout << world.get_active_tiles() << " tiles are still active" << std::endl;
+ *
+ * @return
+ *      The number of active tiles, 0 if the last step did not use Engine::SPARSE.
+ */
+int World::get_active_tiles() const {
+    return this->tiles_valid ? this->active_tiles : 0;
+}
+
+/**
+ * World::get_generation()
+ *
+ * Gets the number of steps taken since the world was constructed, or the generation it was resumed from
+ * plus the steps taken since.
+ *
+ * @example
+ *
+ *      World world(Zoo::glider());
+ *      world.advance(4);
+ *      std::cout << world.get_generation() << std::endl; // 4
+ *
+ * @return
+ *      The generation of the current state.
+ */
+std::uint64_t World::get_generation() const {
+    return this->generation;
+}
+
+/**
+ * World::set_generation(generation)
+ *
+ * Overrides the generation counter without touching the state, e.g. after loading a checkpoint.
+ *
+ * @param generation
+ *      The generation of the current state.
+ */
+void World::set_generation(const std::uint64_t generation) {
+    this->generation = generation;
+    if (this->cycle_mode != CycleMode::OFF) {
+        this->reset_cycle();
+    }
+}
+
+/**
+ * World::set_cycle_mode(mode)
+ *
+ * Select whether the World hashes every generation to find states it has been in before, and whether
+ * World::advance may skip whole periods once a cycle is known. Any cycle found so far is forgotten and
+ * the current state becomes the first one seen.
+ *
+ * Each tile of TILE_SIZE x TILE_SIZE cells is hashed on its own and the tile hashes are combined, so after a
+ * step with Engine::SPARSE only the tiles which changed are hashed again. States are compared by their 64 bit
+ * hash alone, a collision between two different states is possible but vanishingly unlikely.
+ *
+ * Editing the state through World::get_state, World::edit_state or World::write_rows, resizing it or selecting
+ * another rule or generation forgets the states seen so far, so a cycle is never skipped with a stale period.
+ *
+ * @example
+ *
+ *      // Run a soup until it settles, without simulating the periods of its final oscillators
+ *      World world(soup);
+ *      world.set_cycle_mode(CycleMode::SKIP);
+ *      world.advance(1000000);
+ *      std::cout << "Period " << world.get_cycle_period() << " from " << world.get_cycle_start() << std::endl;
+ *
+ * @param mode
+ *      CycleMode::OFF, CycleMode::DETECT or CycleMode::SKIP.
+ */
+void World::set_cycle_mode(const CycleMode mode) {
+    this->cycle_mode = mode;
+    if (mode == CycleMode::OFF) {
+        this->seen_states.clear();
+        this->tile_hashes.clear();
+        this->hashes_valid = false;
+        this->cycle_start = 0;
+        this->cycle_period = 0;
+    } else {
+        this->reset_cycle();
+    }
+}
+
+/**
+ * World::get_cycle_mode()
+ *
+ * @return
+ *      Whether states are hashed to find cycles.
+ */
+CycleMode World::get_cycle_mode() const {
+    return this->cycle_mode;
+}
+
+/**
+ * World::get_cycle_period()
+ *
+ * Gets the period of the first cycle found since the cycle mode was set: the number of generations after
+ * which the current state repeats. A still life, including an empty board, has period 1.
+ *
+ * @return
+ *      The period, or 0 if no state has recurred yet or the cycle mode is CycleMode::OFF.
+ */
+std::uint64_t World::get_cycle_period() const {
+    return this->cycle_period;
+}
+
+/**
+ * World::get_cycle_start()
+ *
+ * Gets the first generation of the cycle found, the generation at which the repeating state first appeared.
+ *
+ * @return
+ *      The generation, or 0 if no cycle was found.
+ */
+std::uint64_t World::get_cycle_start() const {
+    return this->cycle_start;
+}
+
+/**
+ * World::set_change_tracking(enabled)
+ *
+ * Select whether every step records the cells it gave birth to and killed, which is far less than the whole
+ * state when activity is sparse. The lists describe the last step only and are replaced by the next one.
+ *
+ * @example
+ *
+ *      // Stream only the cells which change
+ *      world.set_change_tracking(true);
+ *      world.step();
+ *      deltas.write_delta(world.get_generation(), world.get_births(), world.get_deaths());
+ *
+ * @param enabled
+ *      True to record the changes of every step.
+ */
+void World::set_change_tracking(const bool enabled) {
+    this->track_changes = enabled;
+    if (!enabled) {
+        this->births.clear();
+        this->deaths.clear();
+    }
+}
+
+/**
+ * World::get_change_tracking()
+ *
+ * @return
+ *      True if every step records its births and deaths.
+ */
+bool World::get_change_tracking() const {
+    return this->track_changes;
+}
+
+/**
+ * World::get_births()
+ *
+ * Gets the cells born by the last step, each as the index y * width + x, in ascending order.
+ * Empty unless World::set_change_tracking(true) was called before the step.
+ *
+ * @return
+ *      A reference to the indices, valid until the next step.
+ */
+const std::vector<int> &World::get_births() const {
+    return this->births;
+}
+
+/**
+ * World::get_deaths()
+ *
+ * Gets the cells killed by the last step, each as the index y * width + x, in ascending order.
+ * Empty unless World::set_change_tracking(true) was called before the step.
+ *
+ * @return
+ *      A reference to the indices, valid until the next step.
+ */
+const std::vector<int> &World::get_deaths() const {
+    return this->deaths;
+}
+
+/**
+ * World::set_population_mode(mode)
+ *
+ * Select how World::get_alive_cells and World::get_tile_alive_cells count. Keeping the counts up to date
+ * costs each step a count of the rows it writes, or of the tiles which changed with Engine::SPARSE, and
+ * only starts once a count is first asked for. PopulationMode::VALIDATE checks the kept counts against a
+ * full recount on every call, for testing the engines.
+ *
+ * @example
+ *
+ *      // Check the counts kept by the sparse engine while monitoring every step
+ *      World world(soup);
+ *      world.set_engine(Engine::SPARSE);
+ *      world.set_population_mode(PopulationMode::VALIDATE);
+ *      for (int i = 0; i < 1000; i++) {
+ *          world.step(true);
+ *          std::cout << world.get_alive_cells() << std::endl;
+ *      }
+ *
+ * @param mode
+ *      PopulationMode::RECOUNT, PopulationMode::INCREMENTAL or PopulationMode::VALIDATE.
+ */
+void World::set_population_mode(const PopulationMode mode) {
+    this->population_mode = mode;
+    if (mode == PopulationMode::RECOUNT) {
+        this->population_valid = false;
+        this->tile_population_valid = false;
+    }
+}
+
+/**
+ * World::get_population_mode()
+ *
+ * @return
+ *      How the alive cells are counted.
+ */
+PopulationMode World::get_population_mode() const {
+    return this->population_mode;
+}
+
+/**
+ * World::get_tile_alive_cells()
+ *
+ * Gets the alive cells of every tile of TILE_SIZE x TILE_SIZE cells, the tiles Engine::SPARSE steps, with
+ * the tiles along the right and bottom edges cut short by the edges of the board. The counts are kept up to
+ * date by the sparse engine, which only recounts the tiles which changed. After a step with any other engine
+ * the tiles are counted again on the next call.
+ *
+ * @example
+ *
+ *      // Find the busiest tile of the board
+ *      const std::vector<int> &tiles = world.get_tile_alive_cells();
+ *      const int busiest = std::max_element(tiles.begin(), tiles.end()) - tiles.begin();
+ *
+ * @return
+ *      The alive cells of each tile, in row major order.
+ *
+ * @throws
+ *      std::runtime_error in PopulationMode::VALIDATE if the kept counts do not match a recount.
+ */
+const std::vector<int> &World::get_tile_alive_cells() const {
+    World *self = const_cast<World *>(this);
+    if (this->tile_population_valid && this->population_mode == PopulationMode::VALIDATE) {
+        const std::vector<int> kept = this->tile_population;
+        self->count_tiles();
+        if (kept != this->tile_population) {
+            throw std::runtime_error(std::string("The tile populations kept by the steps do not match a recount!"));
+        }
+    } else if (!this->tile_population_valid || this->population_mode == PopulationMode::RECOUNT) {
+        self->count_tiles();
+    }
+    return this->tile_population;
+}
+
+/**
+ * World::count_tiles()
+ *
+ * Private helper function counting the alive cells of every tile of the current state into tile_population.
+ * A packed state is counted a word at a time, as each word of a row lies in exactly one tile.
+ */
+void World::count_tiles() {
+    static_assert(TILE_SIZE == BitGrid::WORD_BITS, "Each word of a packed row must lie in a single tile");
+    const int width = this->get_width(), height = this->get_height();
+    const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    this->tile_population.assign(static_cast<std::size_t>(tiles_x) * tiles_y, 0);
+    for (int y = 0; y < height; y++) {
+        int *counts = &this->tile_population[static_cast<std::size_t>(y / TILE_SIZE) * tiles_x];
+        if (this->packed_is_current) {
+            const std::uint64_t *row = this->packed_current.row(y);
+            for (int tx = 0; tx < tiles_x; tx++) {
+                counts[tx] += popcount64(row[tx]);
+            }
+        } else {
+            const Cell *row = this->current.row(y);
+            for (int tx = 0; tx < tiles_x; tx++) {
+                const int x0 = tx * TILE_SIZE, x1 = std::min(x0 + TILE_SIZE, width);
+                counts[tx] += static_cast<int>(std::count(row + x0, row + x1, Cell::ALIVE));
+            }
+        }
+    }
+    this->tile_population_valid = true;
+}
+
+/**
+ * World::hash_tile(tile)
+ *
+ * Private helper function hashing the cells of one tile of the current state, from whichever of the Grid
+ * and the BitGrid is authoritative. Both give the same hash, every row of the tile is packed into one word.
+ */
+std::uint64_t World::hash_tile(const int tile) const {
+    const int width = this->get_width();
+    const int height = this->get_height();
+    const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int x0 = (tile % tiles_x) * TILE_SIZE, y0 = (tile / tiles_x) * TILE_SIZE;
+    const int columns = std::min(TILE_SIZE, width - x0);
+    const std::uint64_t mask = columns == 64 ? ~static_cast<std::uint64_t>(0)
+                                             : (static_cast<std::uint64_t>(1) << columns) - 1;
+    std::uint64_t hash = static_cast<std::uint64_t>(tile) * 0x9e3779b97f4a7c15ULL;
+    for (int y = y0; y < std::min(y0 + TILE_SIZE, height); y++) {
+        std::uint64_t word = 0;
+        if (this->packed_is_current) {
+            word = this->packed_current.row(y)[x0 / 64];
+        } else {
+            // Alive cells are the only ones with bit 0 set, 8 of them are gathered into a byte at once
+            const Cell *row = this->current.row(y) + x0;
+            int x = 0;
+            for (; x + 8 <= columns; x += 8) {
+                std::uint64_t bytes;
+                std::memcpy(&bytes, row + x, sizeof(bytes));
+                word |= (((bytes & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56) << x;
+            }
+            for (; x < columns; x++) {
+                word |= static_cast<std::uint64_t>(row[x] == Cell::ALIVE) << x;
+            }
+        }
+        // A round of a 64 bit multiply-xorshift mix per row
+        hash = (hash ^ (word & mask)) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 32;
+    }
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * World::record_state(toroidal)
+ *
+ * Private helper function hashing the state after a step and looking it up among the states already seen.
+ * After a sparse step only the tiles it changed are hashed again, otherwise every tile is.
+ */
+void World::record_state(const bool toroidal) {
+    if (toroidal != this->cycle_toroidal) {
+        // The states seen so far were stepped on the other topology, so they say nothing about this one
+        this->cycle_toroidal = toroidal;
+        this->reset_cycle();
+        return;
+    }
+    const int tiles = ((this->get_width() + TILE_SIZE - 1) / TILE_SIZE) *
+                      ((this->get_height() + TILE_SIZE - 1) / TILE_SIZE);
+    if (this->engine == Engine::SPARSE && this->hashes_valid && static_cast<int>(this->tile_hashes.size()) == tiles) {
+        for (const int tile : this->changed_tiles) {
+            const std::uint64_t hash = this->hash_tile(tile);
+            this->state_hash ^= this->tile_hashes[tile] ^ hash;
+            this->tile_hashes[tile] = hash;
+        }
+    } else {
+        this->tile_hashes.resize(tiles);
+        this->state_hash = 0;
+        for (int tile = 0; tile < tiles; tile++) {
+            this->tile_hashes[tile] = this->hash_tile(tile);
+            this->state_hash ^= this->tile_hashes[tile];
+        }
+        this->hashes_valid = true;
+    }
+    const auto found = this->seen_states.emplace(this->state_hash, this->generation);
+    if (!found.second) {
+        this->cycle_start = found.first->second;
+        this->cycle_period = this->generation - this->cycle_start;
+        // The history is no longer needed once the cycle is known
+        this->seen_states.clear();
+    }
+}
+
+/**
+ * World::reset_cycle()
+ *
+ * Private helper function forgetting every state seen and any cycle found, then recording the current state
+ * as the first state of a new history.
+ */
+void World::reset_cycle() {
+    this->forget_cycle();
+    this->record_state(this->cycle_toroidal);
+}
+
+/**
+ * World::forget_cycle()
+ *
+ * Private helper function forgetting every state seen and any cycle found, leaving the next step to record
+ * the first state of a new history.
+ */
+void World::forget_cycle() {
+    this->seen_states.clear();
+    this->cycle_start = 0;
+    this->cycle_period = 0;
+    this->hashes_valid = false;
+}
+
+/**
+ * parse_cycle_mode(name)
+ *
+ * Parses the name of a cycle mode, as accepted by the --cycles command line option.
+ *
+ * @param name
+ *      One of "off", "detect" or "skip".
+ *
+ * @return
+ *      The named cycle mode.
+ *
+ * @throws
+ *      std::runtime_error if the name does not match a cycle mode.
+ */
+CycleMode parse_cycle_mode(const std::string &name) {
+    if (name == "off") return CycleMode::OFF;
+    if (name == "detect") return CycleMode::DETECT;
+    if (name == "skip") return CycleMode::SKIP;
+    throw std::runtime_error(std::string("Unknown cycle mode: ") + name);
+}
+
+/**
+ * parse_population_mode(name)
+ *
+ * Parses the name of a population mode, as accepted by the --population command line option.
+ *
+ * @param name
+ *      One of "recount", "incremental" or "validate".
+ *
+ * @return
+ *      The named population mode.
+ *
+ * @throws
+ *      std::runtime_error if the name does not match a population mode.
+ */
+PopulationMode parse_population_mode(const std::string &name) {
+    if (name == "recount") return PopulationMode::RECOUNT;
+    if (name == "incremental") return PopulationMode::INCREMENTAL;
+    if (name == "validate") return PopulationMode::VALIDATE;
+    throw std::runtime_error(std::string("Unknown population mode: ") + name);
+}
+
+/**
+ * World::pack_state()
+ *
+ * Private helper function which makes the packed buffers authoritative, repacking the Grid state if it
+ * was the last one written.
+ */
+void World::pack_state() {
+    if (!this->packed_is_current) {
+        this->packed_current.pack(this->current);
+        this->packed_is_current = true;
+    }
+}
+
+/**
+ * World::unpack_state()
+ *
+ * Private helper function which makes the Grid buffers authoritative, expanding the packed state if it
+ * was the last one written.
+ */
+void World::unpack_state() {
+    if (this->packed_is_current) {
+        this->packed_current.unpack(this->current);
+        this->packed_is_current = false;
+    }
+}
+
+/**
+ * Builds the words holding the west (x - 1) and east (x + 1) neighbour of every cell in a row.
+ * Cells past either edge are dead, or read from the opposite side of the row if toroidal.
+ */
+static inline void shift_row(const std::uint64_t *row, const int words, const int width, const bool toroidal,
+                             std::uint64_t *west, std::uint64_t *east) {
+    const int last_bit = (width - 1) % BitGrid::WORD_BITS;
+    for (int w = 0; w < words; w++) {
+        const std::uint64_t before = w > 0 ? row[w - 1] : (toroidal ? (row[words - 1] >> last_bit) << 63 : 0);
+        const std::uint64_t after = w + 1 < words ? row[w + 1] : 0;
+        west[w] = (row[w] << 1) | (before >> 63);
+        east[w] = (row[w] >> 1) | (after << 63);
+    }
+    if (toroidal) {
+        // The east neighbour of the last cell is the first cell of the row
+        east[words - 1] |= (row[0] & 1) << last_bit;
+    }
+}
+
+/**
+ * World::step_bitpacked(toroidal)
+ *
+ * Private helper function taking one step using the bit-packed engine.
+ *
+ * For every row the west and east shifted copies of the rows above, at and below are built, giving the
+ * eight neighbour words of 64 cells, which life_word(...) reduces to the next state of those cells.
+ * The rows are written by the instantiation of World::step_bitpacked_rows for the selected rule.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+void World::step_bitpacked(const bool toroidal) {
+    this->pack_state();
+    const int width = this->packed_current.get_width();
+    const int height = this->packed_current.get_height();
+    if (!this->packed_placed || this->packed_next.get_width() != width || this->packed_next.get_height() != height) {
+        this->place_packed();
+    }
+    void (World::*rows)(const int, const int, const bool) = &World::step_bitpacked_rows<TableRule>;
+    switch (this->rule.get_kind()) {
+        case RuleKind::CONWAY:
+            rows = &World::step_bitpacked_rows<ConwayRule>;
+            break;
+        case RuleKind::HIGHLIFE:
+            rows = &World::step_bitpacked_rows<HighLifeRule>;
+            break;
+        case RuleKind::SEEDS:
+            rows = &World::step_bitpacked_rows<SeedsRule>;
+            break;
+        case RuleKind::DAY_AND_NIGHT:
+            rows = &World::step_bitpacked_rows<DayAndNightRule>;
+            break;
+        case RuleKind::TABLE:
+            break;
+    }
+    if (!this->population_valid) {
+        this->run_bands([this, toroidal, rows](const int y0, const int y1) {
+            (this->*rows)(y0, y1, toroidal);
+        });
+        std::swap(this->packed_current, this->packed_next);
+        return;
+    }
+    // The rows are counted a few at a time, while they are still in cache
+    const int words = this->packed_current.get_words_per_row();
+    std::atomic<std::uint64_t> alive(0);
+    this->run_bands([this, toroidal, rows, words, &alive](const int y0, const int y1) {
+        std::uint64_t band = 0;
+        for (int y = y0; y < y1; y += COUNT_ROWS) {
+            const int end = std::min(y + COUNT_ROWS, y1);
+            (this->*rows)(y, end, toroidal);
+            for (int r = y; r < end; r++) {
+                const std::uint64_t *row = this->packed_next.row(r);
+                for (int w = 0; w < words; w++) {
+                    band += popcount64(row[w]);
+                }
+            }
+        }
+        alive += band;
+    });
+    std::swap(this->packed_current, this->packed_next);
+    this->population = alive;
+}
+
+/**
+ * World::advance_bitpacked(steps, toroidal)
+ *
+ * Private helper function taking several steps using the bit-packed engine in a single pass over the board,
+ * for World::advance. Each band of rows is split into tiles sized to stay in cache, which are stepped every
+ * generation before the next tile is read, see World::advance_bitpacked_rows. The state ends up the same as
+ * after steps calls to World::step_bitpacked, but the one it was stepped from is not kept.
+ *
+ * @param steps
+ *      The number of steps to take.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+void World::advance_bitpacked(const int steps, const bool toroidal) {
+    const Stats::Timer timer(Stats::Phase::STEP);
+    this->pack_state();
+    const int width = this->packed_current.get_width();
+    const int height = this->packed_current.get_height();
+    if (!this->packed_placed || this->packed_next.get_width() != width || this->packed_next.get_height() != height) {
+        this->place_packed();
+    }
+    std::uint64_t (World::*rows)(const int, const int, const int, const bool) =
+            &World::advance_bitpacked_rows<TableRule>;
+    switch (this->rule.get_kind()) {
+        case RuleKind::CONWAY:
+            rows = &World::advance_bitpacked_rows<ConwayRule>;
+            break;
+        case RuleKind::HIGHLIFE:
+            rows = &World::advance_bitpacked_rows<HighLifeRule>;
+            break;
+        case RuleKind::SEEDS:
+            rows = &World::advance_bitpacked_rows<SeedsRule>;
+            break;
+        case RuleKind::DAY_AND_NIGHT:
+            rows = &World::advance_bitpacked_rows<DayAndNightRule>;
+            break;
+        case RuleKind::TABLE:
+            break;
+    }
+    std::atomic<std::uint64_t> alive(0);
+    this->run_bands([this, steps, toroidal, rows, &alive](const int y0, const int y1) {
+        alive += (this->*rows)(y0, y1, steps, toroidal);
+    });
+    std::swap(this->packed_current, this->packed_next);
+    this->generation += steps;
+    this->tiles_valid = false;
+    this->tile_population_valid = false;
+    if (this->population_valid) {
+        this->population = alive;
+    }
+}
+
+/**
+ * World::step_bitpacked_rows<R>(y0, y1, toroidal)
+ *
+ * Private helper function writing the rows [y0, y1) of the next packed state from the current packed state,
+ * applying the rule R, a FixedRule or TableRule.
+ *
+ * @param y0
+ *      The first row to write.
+ *
+ * @param y1
+ *      One past the last row to write.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+template<class R>
+void World::step_bitpacked_rows(const int y0, const int y1, const bool toroidal) {
+    const unsigned birth = R::birth(this->rule), survive = R::survive(this->rule);
+    const int width = this->packed_current.get_width();
+    const int height = this->packed_current.get_height();
+    const int words = this->packed_current.get_words_per_row();
+    if (words == 0 || y0 >= y1) {
+        return;
+    }
+    const std::uint64_t tail = width % BitGrid::WORD_BITS;
+    const std::uint64_t row_mask = tail == 0 ? ~static_cast<std::uint64_t>(0)
+                                              : ((static_cast<std::uint64_t>(1) << tail) - 1);
+
+    // West and east shifted copies of the rows above (0), at (1) and below (2) the row being updated
+    std::vector<std::uint64_t> shifted(6 * static_cast<size_t>(words));
+    const std::vector<std::uint64_t> dead_row(words, 0);
+    for (int y = y0; y < y1; y++) {
+        const std::uint64_t *rows[3];
+        rows[1] = this->packed_current.row(y);
+        if (toroidal) {
+            rows[0] = this->packed_current.row((y + height - 1) % height);
+            rows[2] = this->packed_current.row((y + 1) % height);
+        } else {
+            rows[0] = y > 0 ? this->packed_current.row(y - 1) : dead_row.data();
+            rows[2] = y + 1 < height ? this->packed_current.row(y + 1) : dead_row.data();
+        }
+        for (int r = 0; r < 3; r++) {
+            shift_row(rows[r], words, width, toroidal, &shifted[(2 * r) * words], &shifted[(2 * r + 1) * words]);
+        }
+
+        std::uint64_t *out = this->packed_next.row(y);
+        for (int w = 0; w < words; w++) {
+            out[w] = life_word(shifted[w], rows[0][w], shifted[words + w],
+                               shifted[2 * words + w], rows[1][w], shifted[3 * words + w],
+                               shifted[4 * words + w], rows[2][w], shifted[5 * words + w], birth, survive);
+        }
+        // Shifting pushes bits into the row padding, which must stay dead
+        out[words - 1] &= row_mask;
+    }
+}
+
+/**
+ * World::advance_bitpacked_rows<R>(y0, y1, steps, toroidal)
+ *
+ * Private helper function writing the rows [y0, y1) of the packed state steps generations after the current
+ * packed state, applying the rule R, a FixedRule or TableRule.
+ *
+ * The rows are taken a tile at a time, copying the tile and steps rows either side of it into scratch rows
+ * which fit TEMPORAL_TILE_BYTES along with their shifted copies. Each generation of the tile only needs the
+ * rows next to it from the one before, so every generation stepped leaves one more row either side out of
+ * date, and after steps of them exactly the tile itself is. The edges of a flat board are dead rather than
+ * out of date and are kept.
+ *
+ * @param y0
+ *      The first row to write.
+ *
+ * @param y1
+ *      One past the last row to write.
+ *
+ * @param steps
+ *      The number of generations to step the rows.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ *
+ * @return
+ *      The alive cells of the rows written, counted as each tile is copied out.
+ */
+template<class R>
+std::uint64_t World::advance_bitpacked_rows(const int y0, const int y1, const int steps, const bool toroidal) {
+    const unsigned birth = R::birth(this->rule), survive = R::survive(this->rule);
+    const int width = this->packed_current.get_width();
+    const int height = this->packed_current.get_height();
+    const int words = this->packed_current.get_words_per_row();
+    if (words == 0 || y0 >= y1) {
+        return 0;
+    }
+    const std::uint64_t tail = width % BitGrid::WORD_BITS;
+    const std::uint64_t row_mask = tail == 0 ? ~static_cast<std::uint64_t>(0)
+                                              : ((static_cast<std::uint64_t>(1) << tail) - 1);
+    const std::size_t row_bytes = static_cast<std::size_t>(words) * sizeof(std::uint64_t);
+
+    // Tiles are kept at least twice as tall as their halo, so most of the rows stepped are kept
+    const int fitting = static_cast<int>(TEMPORAL_TILE_BYTES / (4 * row_bytes));
+    const int tile_rows = std::max(fitting - 2 * steps, 2 * steps);
+    // The tile rows, the rows being written, and the west and east shifted copies of the tile rows
+    const std::size_t scratch = static_cast<std::size_t>(tile_rows + 2 * steps) * words;
+    std::vector<std::uint64_t> source(scratch), target(scratch), west(scratch), east(scratch);
+    const std::vector<std::uint64_t> dead_row(words, 0);
+    std::uint64_t alive = 0;
+    for (int t0 = y0; t0 < y1; t0 += tile_rows) {
+        const int t1 = std::min(t0 + tile_rows, y1);
+        // The tile with steps rows either side, cut off at the edges of a flat board
+        const int lo = toroidal ? t0 - steps : std::max(t0 - steps, 0);
+        const int hi = toroidal ? t1 + steps : std::min(t1 + steps, height);
+        const int count = hi - lo;
+        for (int i = 0; i < count; i++) {
+            const int y = ((lo + i) % height + height) % height;
+            std::memcpy(&source[static_cast<std::size_t>(i) * words], this->packed_current.row(y), row_bytes);
+        }
+        for (int generation = 1; generation <= steps; generation++) {
+            const int first = toroidal || lo > 0 ? generation : 0;
+            const int last = toroidal || hi < height ? count - generation : count;
+            // Every row is shifted once and read by the three rows around it
+            for (int i = std::max(first - 1, 0); i < std::min(last + 1, count); i++) {
+                const std::size_t at = static_cast<std::size_t>(i) * words;
+                shift_row(&source[at], words, width, toroidal, &west[at], &east[at]);
+            }
+            for (int i = first; i < last; i++) {
+                const std::size_t at = static_cast<std::size_t>(i) * words;
+                const std::size_t above = at - words, below = at + words;
+                // Past the edges of a flat board the rows and both their shifts are dead
+                const bool top = i > 0, bottom = i + 1 < count;
+                const std::uint64_t *nw = top ? &west[above] : dead_row.data();
+                const std::uint64_t *n = top ? &source[above] : dead_row.data();
+                const std::uint64_t *ne = top ? &east[above] : dead_row.data();
+                const std::uint64_t *sw = bottom ? &west[below] : dead_row.data();
+                const std::uint64_t *s = bottom ? &source[below] : dead_row.data();
+                const std::uint64_t *se = bottom ? &east[below] : dead_row.data();
+                std::uint64_t *out = &target[at];
+                for (int w = 0; w < words; w++) {
+                    out[w] = life_word(nw[w], n[w], ne[w], west[at + w], source[at + w], east[at + w],
+                                       sw[w], s[w], se[w], birth, survive);
+                }
+                out[words - 1] &= row_mask;
+            }
+            std::swap(source, target);
+        }
+        const std::uint64_t *kept = &source[static_cast<std::size_t>(t0 - lo) * words];
+        std::memcpy(this->packed_next.row(t0), kept, row_bytes * (t1 - t0));
+        for (std::size_t i = 0; i < static_cast<std::size_t>(t1 - t0) * words; i++) {
+            alive += popcount64(kept[i]);
+        }
+    }
+    return alive;
+}
+
+/**
+ * parse_engine(name)
+ *
+ * Parses the name of an engine, as accepted by the --engine command line option.
+ *
+ * @example
+ *
+ *      world.set_engine(parse_engine("bitpacked"));
+ *
+ * @param name
+ *      One of "reference", "byte", "simd", "bitpacked" or "sparse".
+ *
+ * @return
+ *      The named engine.
+ *
+ * @throws
+ *      std::runtime_error if the name does not match an engine.
+ */
+Engine parse_engine(const std::string &name) {
+    if (name == "reference") return Engine::REFERENCE;
+    if (name == "byte") return Engine::BYTE;
+    if (name == "simd") return Engine::SIMD;
+    if (name == "bitpacked") return Engine::BITPACKED;
+    if (name == "sparse") return Engine::SPARSE;
+    throw std::runtime_error(std::string("Unknown engine: ") + name);
 }
@@ -9,13 +9,80 @@
  * @date March, 2020
  */
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "grid.h"
+#include "bitgrid.h"
+#include "rule.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+/**
+ * The stepping engines a World can use to apply the rules. Every engine produces identical results.
+ *      - Engine::REFERENCE is the original cell by cell implementation, kept for regression comparisons.
+ *      - Engine::BYTE steps the byte-per-cell Grid directly off its row buffers.
+ *      - Engine::SIMD is Engine::BYTE with the interior of each row vectorised for the selected SimdLevel.
+ *      - Engine::BITPACKED steps a BitGrid copy of the state, 64 cells at a time.
+ *      - Engine::SPARSE only recomputes the tiles of the board that changed, or border a tile that changed,
+ *        during the previous step.
+ */
+enum class Engine {
+    REFERENCE,
+    BYTE,
+    SIMD,
+    BITPACKED,
+    SPARSE
+};
+
+// Parses an engine name such as "byte" or "bitpacked"
+Engine parse_engine(const std::string &name);
+
+/**
+ * Whether a World watches for states it has been in before.
+ *      - CycleMode::DETECT hashes every generation and reports the first state to recur.
+ *      - CycleMode::SKIP also lets World::advance jump over whole periods once a cycle is known.
+ */
+enum class CycleMode {
+    OFF,
+    DETECT,
+    SKIP
+};
+
+// Parses a cycle mode name such as "off" or "skip"
+CycleMode parse_cycle_mode(const std::string &name);
+
+/**
+ * How a World answers World::get_alive_cells.
+ *      - PopulationMode::RECOUNT counts every cell of the state on every call.
+ *      - PopulationMode::INCREMENTAL counts the state once, then keeps the count up to date as it steps.
+ *      - PopulationMode::VALIDATE keeps the count up to date and also recounts on every call to check it.
+ * The engines keep the count as they write the next state.
+ * Edits through World::get_state or World::edit_state, and resizing, throw the count away, so it is counted
+ * again on the next call.
+ */
+enum class PopulationMode {
+    RECOUNT,
+    INCREMENTAL,
+    VALIDATE
+};
+
+// Parses a population mode name such as "incremental" or "validate"
+PopulationMode parse_population_mode(const std::string &name);
 
 /**
  * Declare the structure of the World class for representing a 2d grid world.
  *
  * A World holds two equally sized Grid objects for the current state and next state.
  *      - These buffers should be swapped using std::swap after each update step.
+ *
+ * When stepping with Engine::BITPACKED the World also holds two BitGrid buffers. Whichever pair was
+ * written last is authoritative, the other is only brought up to date when it is needed.
+ *
+ * When stepping with Engine::SPARSE the World tracks which TILE_SIZE x TILE_SIZE tiles changed in the last step.
  */
 class World {
 private:
@@ -23,15 +90,151 @@ private:
 
     Grid next;
 
+    BitGrid packed_current;
+
+    BitGrid packed_next;
+
+    Engine engine;
+
+    SimdLevel simd_level;
+
+    Rule rule;
+
+    std::uint64_t generation;                        // The number of steps taken since construction or resume
+
+    bool packed_is_current;                          // True if packed_current holds the latest state
+
+    int threads;
+
+    int temporal_depth;                              // Generations advanced per pass over a bit-packed board
+
+    std::shared_ptr<ThreadPool> pool;                // Started on the first parallel step
+
+    bool grids_placed;                               // True once current and next were first written band by band
+
+    bool packed_placed;                              // The same for packed_current and packed_next
+
+    static const int MIN_BAND_ROWS = 64;             // Bands are never split thinner than this
+
+    static const int MIN_PARALLEL_CELLS = 256 * 256; // Smaller boards always step serially
+
+    static const int COUNT_ROWS = 8;                 // Rows stepped before they are counted, while still in cache
+
+    static const int TEMPORAL_TILE_BYTES = 1024 * 1024; // Scratch of a temporally blocked tile, sized for L2
+
+    std::vector<int> changed_tiles;                  // Tiles which changed during the last sparse step
+
+    std::vector<int> active_list;                    // Tiles recomputed by the current sparse step
+
+    std::vector<char> tile_active;                   // Per tile flag, true while a tile is in active_list
+
+    std::vector<char> tile_changed;                  // Per entry of active_list, true if the tile changed
+
+    bool tiles_valid;                                // False once the state was changed outside a sparse step
+
+    bool tiles_toroidal;                             // The topology changed_tiles was computed with
+
+    int active_tiles;
+
+    CycleMode cycle_mode;
+
+    std::vector<std::uint64_t> tile_hashes;          // Hash of every tile of the current state
+
+    bool hashes_valid;                               // False once tile_hashes no longer match the state
+
+    std::uint64_t state_hash;                        // The tile hashes combined
+
+    std::unordered_map<std::uint64_t, std::uint64_t> seen_states; // First generation of every state hash
+
+    bool cycle_toroidal;                             // The topology the states in seen_states were stepped with
+
+    std::uint64_t cycle_start, cycle_period;         // The cycle found, cycle_period is 0 until one is
+
+    bool track_changes;
+
+    std::vector<int> births;                         // Cells born by the last step, as y * width + x
+
+    std::vector<int> deaths;                         // Cells killed by the last step, as y * width + x
+
+    PopulationMode population_mode;
+
+    std::uint64_t population;                        // The alive cells of the current state, once counted
+
+    bool population_valid;                           // False until counted, and once the state is edited
+
+    std::vector<int> tile_population;                // The alive cells of every tile, kept by Engine::SPARSE
+
+    bool tile_population_valid;                      // False once tile_population no longer matches the state
+
+    std::uint64_t hash_tile(const int tile) const;
+
+    void record_state(const bool toroidal);          // Hashes the current state and looks it up
+
+    void reset_cycle();                              // Forgets every state seen, keeping the current one
+
+    void forget_cycle();                             // Forgets every state seen, the next step records the first
+
+    bool steps_observed() const;                     // True while cycle detection, changes or Stats read every step
+
+    void count_step() const;                         // Feeds the cells, births and deaths of the last step to Stats
+
+    void collect_changes();                          // Fills births and deaths from the last step
+
+    std::uint64_t count_population() const;          // Counts every alive cell of the current state
+
+    void count_tiles();                              // Fills tile_population from the current state
+
+    ThreadPool &get_pool();                          // Starts the pool on first use
+
+    int count_bands() const;                         // The number of bands run_bands splits the rows into
+
+    void run_bands(const std::function<void(int, int)> &rows); // Invokes rows(y0, y1) for each band
+
+    void place_grids();                              // Spreads the pages of current and next over the bands
+
+    void place_packed();                             // Spreads the pages of the packed buffers over the bands
+
+    void pack_state();                               // Makes packed_current authoritative
+
+    void unpack_state();                             // Makes current authoritative
+
+    void step_reference(const bool toroidal);
+
+    void step_byte(const bool toroidal, const RowKernel interior);
+
+    // Writes the block [x0, x1) by [y0, y1) of next, using the row kernel for the interior columns
+    void step_byte_block(const int x0, const int x1, const int y0, const int y1, const bool toroidal,
+                         const RowKernel interior);
+
+    Cell next_border_cell(const int x, const int y, const bool toroidal) const;
+
+    void step_sparse(const bool toroidal);
+
+    bool step_tile(const int tile, const bool toroidal, const RowKernel interior); // True if the tile changed
+
+    void step_bitpacked(const bool toroidal);
+
+    template<class R>
+    void step_bitpacked_rows(const int y0, const int y1, const bool toroidal); // Instantiated per rule in world.cpp
+
+    void advance_bitpacked(const int steps, const bool toroidal); // Steps a packed board steps times in one pass
+
+    template<class R>
+    std::uint64_t advance_bitpacked_rows(const int y0, const int y1, const int steps, const bool toroidal);
+
     int count_alive_neighbours(const int x, const int y, const bool toroidal); // Alive cells wrapped in 3x3 square. Current cell - center
 
 public:
+    static const int TILE_SIZE = 64;                 // Edge length of the tiles tracked by Engine::SPARSE
+
     World(const int width,const  int height);
 
     explicit World(const int square_size);
 
     explicit World(const Grid &initial_state);
 
+    explicit World(BitGrid initial_state);           // Starts with Engine::BITPACKED and the packed state
+
     World();
 
     // Member functions
@@ -45,9 +248,21 @@ public:
 
     int get_dead_cells() const;
 
-    // A reference to the grid with current state
+    // A read-only reference to the grid with current state, which leaves the engines' tracking intact
+    const Grid &state() const;
+
+    // A reference to modify the current state, as edit_state does
     Grid &get_state() const;
 
+    // A reference to modify the current state, throwing away the engines' tracking of it
+    Grid &edit_state();
+
+    // Copies count whole rows from row y0 out of whichever copy of the state is current, without unpacking it
+    void read_rows(const int y0, const int count, Cell *cells) const;
+
+    // Overwrites count whole rows from row y0, keeping the engines' tracking of the other rows
+    void write_rows(const int y0, const int count, const Cell *cells);
+
     void resize(const int new_width, const int new_height);
 
     void resize(const int square_size);
@@ -61,4 +276,68 @@ public:
     void advance(const int steps, const bool toroidal);
 
     void advance(const int steps);
+
+    // Selects the engine used by step and advance
+    void set_engine(const Engine engine);
+
+    Engine get_engine() const;
+
+    // Selects the instruction set used by Engine::SIMD
+    void set_simd_level(const SimdLevel level);
+
+    SimdLevel get_simd_level() const;
+
+    // Selects the rule applied by step and advance, B3/S23 by default
+    void set_rule(const Rule &rule);
+
+    const Rule &get_rule() const;
+
+    // Selects the number of threads used by step and advance, 0 uses every hardware thread
+    void set_threads(const int threads);
+
+    int get_threads() const;
+
+    // Selects how many generations advance steps a bit-packed board per pass over memory, 1 disables blocking
+    void set_temporal_depth(const int depth);
+
+    int get_temporal_depth() const;
+
+    // The number of tiles recomputed by the last step with Engine::SPARSE
+    int get_active_tiles() const;
+
+    std::uint64_t get_generation() const;
+
+    // Overrides the generation counter, e.g. when resuming from a checkpoint
+    void set_generation(const std::uint64_t generation);
+
+    // Selects whether states are hashed to find cycles, forgetting any cycle found so far
+    void set_cycle_mode(const CycleMode mode);
+
+    CycleMode get_cycle_mode() const;
+
+    // The period of the cycle found, 1 for a still life, or 0 if no state has recurred yet
+    std::uint64_t get_cycle_period() const;
+
+    // The generation the cycle found first appeared at
+    std::uint64_t get_cycle_start() const;
+
+    // Selects whether each step records the cells it gave birth to and killed, off by default
+    void set_change_tracking(const bool enabled);
+
+    bool get_change_tracking() const;
+
+    // Cells born by the last step while tracking changes, as y * width + x in ascending order
+    const std::vector<int> &get_births() const;
+
+    // Cells killed by the last step while tracking changes, as y * width + x in ascending order
+    const std::vector<int> &get_deaths() const;
+
+    // Selects how get_alive_cells counts, PopulationMode::INCREMENTAL by default
+    void set_population_mode(const PopulationMode mode);
+
+    PopulationMode get_population_mode() const;
+
+    // The alive cells of every TILE_SIZE x TILE_SIZE tile in row major order, the tiles Engine::SPARSE steps
+    // Only Engine::SPARSE keeps these counts as it steps, after any other engine every tile is recounted
+    const std::vector<int> &get_tile_alive_cells() const;
 };
\ No newline at end of file
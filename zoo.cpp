@@ -9,6 +9,7 @@
  *              - followed by (height) number of lines, each containing (width) number of characters,
  *                terminated by a newline character.
  *              - (space) ' ' is Cell::DEAD, (hash) '#' is Cell::ALIVE.
+ *          - Ascii files are read and written in large blocks, from a path or any stream such as a pipe.
  *
  *      - Grids can be loaded from and saved to an binary file format.
  *          - Binary files are composed of:
@@ -16,17 +17,44 @@
  *              - a 4 byte int representing the grid height
  *              - followed by (width * height) number of individual bits in C-style row/column format,
  *                padded with zero or more 0 bits.
+ *                  - bit 0 of each byte is the first of its 8 cells, and there are (width * height + 7) / 8 bytes.
  *              - a 0 bit should be considered Cell::DEAD, a 1 bit should be considered Cell::ALIVE.
+ *          - Binary files are loaded through a memory mapping and decoded in place, either to a Grid or to
+ *            the BitGrid used by Engine::BITPACKED.
+ *          - The binary loaders also accept the chunked and compressed snapshot format of snapshot.cpp,
+ *            told apart by its magic number.
+ *
+ *      - Patterns can be loaded from and saved to the rle and macrocell formats used by the wider Life community.
+ *          - Rle files are streamed run by run straight into a Grid, an InfiniteWorld or the quadtree of a
+ *            HashWorld, so a large sparse pattern never has to be expanded into a dense grid.
+ *          - Macrocell files store the quadtree of a HashWorld, each distinct node written once.
  *
  * @author 965217
  * @date March, 2020
  */
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <fstream>
-#include <bitset>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 #include "grid.h"
+#include "mapped_file.h"
+#include "snapshot.h"
+#include "stats.h"
 #include "zoo.h"
 
+// Binary files are written in blocks of this many bytes
+static const std::size_t BINARY_BLOCK_BYTES = 1 << 20;
+
 /**
  * Zoo::glider()
  *
@@ -128,11 +156,111 @@ Grid Zoo::light_weight_spaceship() {
     return g;
 }
 
+// Text files such as ascii, rle and macrocell are read and written in blocks of this many bytes
+static const std::size_t TEXT_BLOCK_BYTES = 1 << 20;
+
+/**
+ * Reads a text stream in large blocks, so rows can be scanned in place instead of through one std::getline per row.
+ */
+class TextReader {
+private:
+    std::istream &in;
+
+    std::vector<char> buffer;
+
+    std::size_t begin, end;                          // The unread bytes are buffer[begin, end)
+
+    // Move the unread bytes to the front and read more behind them, false if nothing more could be read
+    bool fill() {
+        if (this->begin > 0) {
+            std::memmove(this->buffer.data(), this->buffer.data() + this->begin, this->end - this->begin);
+            this->end -= this->begin;
+            this->begin = 0;
+        }
+        if (this->end == this->buffer.size()) {
+            this->buffer.resize(this->buffer.size() * 2);
+        }
+        this->in.read(this->buffer.data() + this->end, static_cast<std::streamsize>(this->buffer.size() - this->end));
+        const std::size_t count = static_cast<std::size_t>(this->in.gcount());
+        this->end += count;
+        Stats::add(Stats::Counter::BYTES_READ, count);
+        return count > 0;
+    }
+
+public:
+    explicit TextReader(std::istream &in) : in(in), buffer(TEXT_BLOCK_BYTES), begin(0), end(0) {}
+
+    // The next byte without consuming it, EOF at the end of the stream
+    int peek() {
+        if (this->begin == this->end && !this->fill()) {
+            return EOF;
+        }
+        return static_cast<unsigned char>(this->buffer[this->begin]);
+    }
+
+    int get() {
+        const int c = this->peek();
+        if (c != EOF) {
+            this->begin++;
+        }
+        return c;
+    }
+
+    // Makes at least count bytes readable through data(), returning how many are available at most count
+    std::size_t request(const std::size_t count) {
+        while (this->end - this->begin < count && this->fill()) {
+        }
+        return std::min(count, this->end - this->begin);
+    }
+
+    const char *data() const {
+        return this->buffer.data() + this->begin;
+    }
+
+    // Reads up to the next newline, dropping it and any carriage return before it, false at the end of the stream
+    bool line(std::string &text) {
+        text.clear();
+        int c = this->get();
+        if (c == EOF) {
+            return false;
+        }
+        while (c != EOF && c != '\n') {
+            text.push_back(static_cast<char>(c));
+            c = this->get();
+        }
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        return true;
+    }
+
+    void skip(const std::size_t count) {
+        this->begin += count;
+    }
+
+    // Skips whitespace, then reads characters up to the next whitespace, like operator>> on a std::string
+    std::string token(const bool digits_only) {
+        while (std::isspace(this->peek())) {
+            this->get();
+        }
+        std::string token;
+        int c = this->peek();
+        while (c != EOF && !std::isspace(c)) {
+            if (digits_only && !std::isdigit(c) && !(token.empty() && (c == '-' || c == '+'))) {
+                break;
+            }
+            token.push_back(static_cast<char>(this->get()));
+            c = this->peek();
+        }
+        return token;
+    }
+};
+
 /**
  * Zoo::load_ascii(path)
  *
  * Load an ascii file and parse it as a grid of cells.
- * Should be implemented using std::ifstream.
+ * The file is read in large blocks and each row is scanned in place, so loading is linear in the size of the file.
  *
  * @example
  *
@@ -155,19 +283,46 @@ Grid Zoo::light_weight_spaceship() {
  */
 
 Grid Zoo::load_ascii(const std::string &path) {
-    std::string data;
-    std::ifstream file;
-    file.open(path);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
 
     // Throw an exception if the file cannot be opened.
     if (!file.good()) {
         throw std::runtime_error(std::string("Error Opening file"));
     }
+    return Zoo::load_ascii(file);
+}
+
+/**
+ * Zoo::load_ascii(in)
+ *
+ * Parse an ascii .gol file from any input stream, such as std::cin or a pipe.
+ *
+ * @example
+ *
+ *      // Read a grid piped into the program
+ *      Grid grid = Zoo::load_ascii(std::cin);
+ *
+ * @param in
+ *      The stream to read from. It is read in blocks, so bytes after the last row may be consumed.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class in the same cases as Zoo::load_ascii(path).
+ */
+
+Grid Zoo::load_ascii(std::istream &in) {
+    TextReader reader(in);
 
     int width = 0, height = 0;
-    if (file >> data) {
-        width = stoi(data);
-        file >> height;
+    const std::string width_token = reader.token(false);
+    if (!width_token.empty()) {
+        width = stoi(width_token);
+        const std::string height_token = reader.token(true);
+        if (!height_token.empty() && height_token != "-" && height_token != "+") {
+            height = stoi(height_token);
+        }
     }
     // Throw an exception if width or height are non-positive
     if (width <= 0 || height <= 0) {
@@ -175,26 +330,34 @@ Grid Zoo::load_ascii(const std::string &path) {
     }
 
     Grid g(width, height);
-    //Skipping the first line before the loop
-    std::getline(file, data);
+    // Skip the rest of the header line
+    for (int c = reader.get(); c != EOF && c != '\n'; c = reader.get()) {
+    }
+    const std::size_t row_bytes = static_cast<std::size_t>(width);
     // Throw an exception if a cell is neither DEAD or ALIVE or if newline char is missing
     for (int i = 0; i < height; i++) {
-        std::getline(file, data);
-        for (int j = 0; j < width; j++) {
-            if (data[0] == '#') {
-                g(j, i) = Cell::ALIVE;
-            } else if (data[0] != ' ') {
-                throw std::runtime_error(std::string("Corrupted ASCII file!"));
-            }
-            // Delete first element of the line
-            data.erase(0, 1);
+        // A short row, or a missing one, ends on a character that is not a cell
+        if (reader.request(row_bytes) < row_bytes) {
+            throw std::runtime_error(std::string("Corrupted ASCII file!"));
+        }
+        const char *data = reader.data();
+        Cell *row = g.row(i);
+        bool corrupted = false;
+        for (std::size_t j = 0; j < row_bytes; j++) {
+            const char c = data[j];
+            row[j] = c == '#' ? Cell::ALIVE : Cell::DEAD;
+            corrupted |= c != '#' && c != ' ';
+        }
+        if (corrupted) {
+            throw std::runtime_error(std::string("Corrupted ASCII file!"));
         }
-        // Throws an exception if \n is missing. For some reason if (data[0] != '\n') does not work, so had to use 0
-        if (data[0] != 0) {
+        reader.skip(row_bytes);
+        // The last row may end the file without a newline
+        const int c = reader.get();
+        if (c != '\n' && c != EOF) {
             throw std::runtime_error(std::string("Missing newline character!"));
         }
     }
-    file.close();
     return g;
 }
 
@@ -203,7 +366,7 @@ Grid Zoo::load_ascii(const std::string &path) {
  * Zoo::save_ascii(path, grid)
  *
  * Save a grid as an ascii .gol file according to the specified file format.
- * Should be implemented using std::ofstream.
+ * Whole rows are built in a buffer which is written out in large blocks, with a single flush at the end.
  *
  * @example
  *
@@ -225,40 +388,130 @@ Grid Zoo::load_ascii(const std::string &path) {
  *      The grid to be written out to file.
  *
  * @throws
- *      Throws std::runtime_error or sub-class if the file cannot be opened.
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
  */
 
 void Zoo::save_ascii(const std::string &path, const Grid &grid) {
-    std::ofstream file;
-    file.open(path);
+    std::ofstream file(path, std::ios::out | std::ios::binary);
     // Throw an exception if a file cannot be opened
     if (!file) {
         throw std::runtime_error(std::string("Can't open the file!"));
     }
+    Zoo::save_ascii(file, grid);
+}
+
+/**
+ * Zoo::save_ascii(out, grid)
+ *
+ * Write a grid as an ascii .gol file to any output stream, such as std::cout.
+ *
+ * @example
+ *
+ *      // Print a glider in the file format
+ *      Zoo::save_ascii(std::cout, Zoo::glider());
+ *
+ * @param out
+ *      The stream to write to, flushed once the whole grid is written.
+ *
+ * @param grid
+ *      The grid to be written out.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the stream cannot be written.
+ */
+
+void Zoo::save_ascii(std::ostream &out, const Grid &grid) {
     const int width = grid.get_width();
     const int height = grid.get_height();
-    // Write width and height to a file
-    file << width << " " << height << std::endl;
-    // Write every cell to a file
+    // Write width and height
+    const std::string header = std::to_string(width) + " " + std::to_string(height) + '\n';
+    out << header;
+    std::uint64_t written = header.size();
+
+    // Cells are stored as their own characters, so rows are copied as they are
+    const std::size_t row_bytes = static_cast<std::size_t>(width) + 1;
+    std::vector<char> block;
+    block.reserve(std::max(TEXT_BLOCK_BYTES, row_bytes));
     for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            if (grid(j, i) == Cell::ALIVE) {
-                file << '#';
-            } else {
-                file << ' ';
+        if (block.size() + row_bytes > block.capacity()) {
+            out.write(block.data(), static_cast<std::streamsize>(block.size()));
+            written += block.size();
+            block.clear();
+        }
+        const char *row = reinterpret_cast<const char *>(grid.row(i));
+        block.insert(block.end(), row, row + width);
+        block.push_back('\n');
+    }
+    out.write(block.data(), static_cast<std::streamsize>(block.size()));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error(std::string("Can't write the file!"));
+    }
+    Stats::add(Stats::Counter::BYTES_WRITTEN, written + block.size());
+}
+
+
+/**
+ * The decoded cells of every possible byte of a binary file, bit 0 first.
+ */
+struct ByteCells {
+    Cell cells[256][8];
+
+    ByteCells() {
+        for (int byte = 0; byte < 256; byte++) {
+            for (int bit = 0; bit < 8; bit++) {
+                this->cells[byte][bit] = ((byte >> bit) & 1) ? Cell::ALIVE : Cell::DEAD;
             }
         }
-        file << std::endl;
     }
-    file.close();
+};
+
+/**
+ * Reads and checks the header of a mapped binary file, leaving the width, height and the start and size of the bits.
+ * The bits are checked to be long enough for width * height cells, a trailing partial byte included.
+ */
+static void read_binary_header(const MappedFile &file, int &width, int &height,
+                               const unsigned char *&bits, std::size_t &bytes) {
+    if (file.size() < 2 * sizeof(int)) {
+        throw std::runtime_error(std::string("File Ends unexpectedly!"));
+    }
+    std::memcpy(&width, file.data(), sizeof(int));
+    std::memcpy(&height, file.data() + sizeof(int), sizeof(int));
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Wrong width or height"));
+    }
+    const std::uint64_t cells = static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height);
+    bytes = static_cast<std::size_t>((cells + 7) / 8);
+    if (file.size() - 2 * sizeof(int) < bytes) {
+        throw std::runtime_error(std::string("File Ends unexpectedly!"));
+    }
+    bits = file.data() + 2 * sizeof(int);
 }
 
+/**
+ * Reads 64 bits starting at any bit offset of a bit stream, without reading past its end.
+ */
+static std::uint64_t read_bits(const unsigned char *bits, const std::size_t bytes, const std::uint64_t offset) {
+    const std::size_t first = static_cast<std::size_t>(offset / 8);
+    const int shift = static_cast<int>(offset % 8);
+    std::uint64_t word = 0;
+    for (std::size_t i = 0; i < 8 && first + i < bytes; i++) {
+        word |= static_cast<std::uint64_t>(bits[first + i]) << (8 * i);
+    }
+    word >>= shift;
+    if (shift > 0 && first + 8 < bytes) {
+        word |= static_cast<std::uint64_t>(bits[first + 8]) << (64 - shift);
+    }
+    return word;
+}
 
 /**
  * Zoo::load_binary(path)
  *
  * Load a binary file and parse it as a grid of cells.
- * Should be implemented using std::ifstream.
+ *
+ * The file is memory mapped and decoded a byte at a time straight into the storage of the grid, 8 cells per
+ * byte from a lookup table, so no intermediate copy of the file or the cells is made.
  *
  * @example
  *
@@ -275,81 +528,99 @@ void Zoo::save_ascii(const std::string &path, const Grid &grid) {
  *      Throws std::runtime_error or sub-class if:
  *          - The file cannot be opened.
  *          - The file ends unexpectedly.
+ *          - The width or height is negative.
+ *          - The file is a snapshot Snapshot::load(path) cannot read.
  */
 Grid Zoo::load_binary(const std::string &path) {
-    std::ifstream bFile;
-    bFile.open(path, std::ios::in | std::ios::binary);
-    if (!bFile.good()) {
-        throw std::runtime_error(std::string("Error Opening file"));
+    const MappedFile file(path);
+    if (Snapshot::is_snapshot(file.data(), file.size())) {
+        return Snapshot::load(path);
     }
-
-    // Traversing to the end of the file to fetch the size
-    bFile.seekg(0, std::ios::end);
-    unsigned int size = (int) bFile.tellg();
-    // Getting back to the beginning of the file to start reading
-    bFile.seekg(0, std::ios::beg);
-    // Reading the size of a grid and constructing it
+    Stats::add(Stats::Counter::BYTES_READ, file.size());
     int width, height;
-    bFile.read(reinterpret_cast<char *>(&width), sizeof(int));
-    bFile.read(reinterpret_cast<char *>(&height), sizeof(int));
-
-    // The size of file should be 2*sizeof(int) for w and h +
-    // number of bytes to store w*h bits + number of padding bytes
+    const unsigned char *bits;
+    std::size_t bytes;
+    read_binary_header(file, width, height, bits, bytes);
 
     Grid g(width, height);
-
-    // Calculating padding value
-    int padding = 0;
-    int loopValue;
-    if (width * height % 8 != 0) {
-        // padding indicates a number of bits needed to finish the byte
-        padding = width * height % 8;
-        // loopValue makes sure we loop on every byte which might contain the information
-        loopValue = (width * height + padding) / 8;
-    } else {
-        loopValue = width * height / 8;
+    if (width == 0 || height == 0) {
+        return g;
     }
+    static const ByteCells decoded;
+    // The rows of a grid are stored back to back, the same order the bits are in
+    Cell *cells = g.row(0);
+    const std::size_t total = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    const std::size_t whole_bytes = total / 8;
+    for (std::size_t i = 0; i < whole_bytes; i++) {
+        std::memcpy(cells + 8 * i, decoded.cells[bits[i]], 8 * sizeof(Cell));
+    }
+    for (std::size_t i = whole_bytes * 8; i < total; i++) {
+        cells[i] = decoded.cells[bits[whole_bytes]][i % 8];
+    }
+    return g;
+}
 
-    //Checking rather the file ends unexpectedly or no
-    unsigned int minimal_expected_file_size = (2 * sizeof(int)) + ((width * height + padding) / 8);
-    if (size < minimal_expected_file_size) {
-        throw std::runtime_error(std::string("File Ends unexpectedly!"));
-
+/**
+ * Zoo::load_binary_packed(path)
+ *
+ * Load a binary file straight into a bit-packed grid, as stepped by Engine::BITPACKED, without ever expanding
+ * it to a byte per cell.
+ *
+ * When the width is a multiple of 64 on a little endian machine, the bits of the file already are the words
+ * of a BitGrid and are copied across in one block. Other widths are realigned 64 bits at a time.
+ *
+ * @example
+ *
+ *      // Step a huge binary file without ever building a Grid for it
+ *      World world(Zoo::load_binary_packed("path/to/file.bgol"));
+ *      world.advance(100);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The file ends unexpectedly.
+ *          - The width or height is negative.
+ */
+BitGrid Zoo::load_binary_packed(const std::string &path) {
+    const MappedFile file(path);
+    if (Snapshot::is_snapshot(file.data(), file.size())) {
+        return BitGrid(Snapshot::load(path));
     }
+    Stats::add(Stats::Counter::BYTES_READ, file.size());
+    int width, height;
+    const unsigned char *bits;
+    std::size_t bytes;
+    read_binary_header(file, width, height, bits, bytes);
 
-    // A container for every byte, initialized with empty strings
-    std::vector<std::string> bytes(loopValue, "");
-    // Reading bytes corresponding to the grid (without the padding)
-    for (int i = 0; i < loopValue; i++) {
-        unsigned char currVal;
-        bFile.read(reinterpret_cast<char *>(&currVal), sizeof(char));
-        // A current byte we are reading
-        std::string currentByte;
-        for (unsigned int bit = 0; bit < 8; bit++) {
-            // += syntax will create our current byte by adding each bit separately
-            currentByte += std::to_string(((currVal >> bit) & 0x1));
-        }
-        bytes[i] = currentByte;
-    }
-    // Append all bytes into one string
-    std::string byte;
-    for (const auto &i : bytes) {
-        byte += i;
-    }
-
-    // Write the data to the Grid structure
-    for (unsigned int i = 0; i < byte.size(); i++) {
-        if (byte[i] == '1') {
-            // Get x, y using the idx
-            const int x = i % width;
-            const int y = (i - x) / width;
-            // Assertion to not go outside the bounds of the grid
-            if (!(x == width || y == height)) {
-                g(x, y) = Cell::ALIVE;
-            }
+    BitGrid g(width, height);
+    const int words = g.get_words_per_row();
+    if (words == 0 || height == 0) {
+        return g;
+    }
+    const std::uint16_t probe = 1;
+    const bool little_endian = *reinterpret_cast<const unsigned char *>(&probe) == 1;
+    if (width % BitGrid::WORD_BITS == 0 && little_endian) {
+        std::memcpy(g.row(0), bits, bytes);
+        return g;
+    }
+    const int tail = width % BitGrid::WORD_BITS;
+    const std::uint64_t row_mask = tail == 0 ? ~static_cast<std::uint64_t>(0)
+                                             : ((static_cast<std::uint64_t>(1) << tail) - 1);
+    for (int y = 0; y < height; y++) {
+        std::uint64_t *row = g.row(y);
+        const std::uint64_t offset = static_cast<std::uint64_t>(y) * static_cast<std::uint64_t>(width);
+        for (int w = 0; w < words; w++) {
+            row[w] = read_bits(bits, bytes, offset + static_cast<std::uint64_t>(w) * BitGrid::WORD_BITS);
         }
+        // The bits past the end of the row belong to the next row
+        row[words - 1] &= row_mask;
     }
-    bFile.close();
     return g;
 }
 
@@ -357,7 +628,7 @@ Grid Zoo::load_binary(const std::string &path) {
  * Zoo::save_binary(path, grid)
  *
  * Save a grid as an binary .bgol file according to the specified file format.
- * Should be implemented using std::ofstream.
+ * The bits are packed into a large buffer which is written out in a few big blocks.
  *
  * @example
  *
@@ -379,9 +650,8 @@ Grid Zoo::load_binary(const std::string &path) {
  *      The grid to be written out to file.
  *
  * @throws
- *      Throws std::runtime_error or sub-class if the file cannot be opened.
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
  */
-
 void Zoo::save_binary(const std::string &path, const Grid &grid) {
     std::ofstream file;
     file.open(path, std::ios::out | std::ios::binary);
@@ -391,38 +661,989 @@ void Zoo::save_binary(const std::string &path, const Grid &grid) {
     }
     const int width = grid.get_width();
     const int height = grid.get_height();
-    std::bitset<8> bitset; // A convenient container for 8 bit values
 
     // Write width and height to a file
-    file.write((char *) &width, sizeof(int));
-    file.write((char *) &height, sizeof(int));
-    // A counter which keeps track of bit we are currently focusing on
-    int bitset_count = 0;
-    const int padding = width * height % 8;
-    unsigned const int content_bytes = (width * height + padding) / 8;
-    unsigned int current_bytes = 0;
+    file.write(reinterpret_cast<const char *>(&width), sizeof(int));
+    file.write(reinterpret_cast<const char *>(&height), sizeof(int));
 
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            if (grid(j, i) == Cell::ALIVE) {
-                bitset[bitset_count] = 1;
-            } else {
-                bitset[bitset_count] = 0;
+    const std::size_t total = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    const Cell *cells = total > 0 ? grid.row(0) : nullptr;
+    std::vector<char> block(std::min<std::size_t>(BINARY_BLOCK_BYTES, (total + 7) / 8));
+    std::size_t used = 0;
+    for (std::size_t i = 0; i < total; i += 8) {
+        const std::size_t count = std::min<std::size_t>(8, total - i);
+        unsigned char byte = 0;
+        for (std::size_t bit = 0; bit < count; bit++) {
+            byte |= static_cast<unsigned char>(cells[i + bit] == Cell::ALIVE) << bit;
+        }
+        block[used++] = static_cast<char>(byte);
+        if (used == block.size()) {
+            file.write(block.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+    }
+    file.write(block.data(), static_cast<std::streamsize>(used));
+    if (!file) {
+        throw std::runtime_error(std::string("Can't write the file!"));
+    }
+    file.close();
+    Stats::add(Stats::Counter::BYTES_WRITTEN, 2 * sizeof(int) + (total + 7) / 8);
+}
+
+
+// Lines of rle files are wrapped at this many characters
+static const std::size_t RLE_LINE_LENGTH = 70;
+
+// Rle patterns are built into a HashWorld in strips of 2^RLE_STRIP_LOG2 rows
+static const int RLE_STRIP_LOG2 = 6;
+
+/**
+ * Trims spaces and tabs from both ends of a string.
+ */
+static std::string trim(const std::string &text) {
+    const std::size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * Parses a whole string as an integer, throwing the given message if it is not one.
+ */
+static std::int64_t parse_integer(const std::string &text, const char *message) {
+    std::size_t used = 0;
+    std::int64_t value = 0;
+    try {
+        value = std::stoll(text, &used);
+    }
+    catch (const std::exception &) {
+        throw std::runtime_error(std::string(message));
+    }
+    if (used != text.size()) {
+        throw std::runtime_error(std::string(message));
+    }
+    return value;
+}
+
+/**
+ * Parses the rule of an rle or macrocell file, dropping any bounded grid suffix such as ":T100,100".
+ */
+static Rule parse_file_rule(const std::string &text) {
+    return Rule(trim(text.substr(0, text.find(':'))));
+}
+
+/**
+ * Builds the node for the 2^level square with its top left corner at x, y of a block of up to 64 rows
+ * of 64 bits, bit x of rows[y] being the cell at x, y.
+ */
+static HashWorld::Node *bits_to_node(HashWorld &world, const std::uint64_t *rows, const int x, const int y,
+                                     const int level) {
+    const int size = 1 << level;
+    const std::uint64_t mask = (~static_cast<std::uint64_t>(0) >> (64 - size)) << x;
+    bool empty = true;
+    for (int row = y; row < y + size && empty; row++) {
+        empty = (rows[row] & mask) == 0;
+    }
+    if (empty) {
+        return world.make_empty(level);
+    }
+    if (level == 0) {
+        return world.make_cell(true);
+    }
+    const int half = size / 2;
+    return world.make_node(bits_to_node(world, rows, x, y, level - 1),
+                           bits_to_node(world, rows, x + half, y, level - 1),
+                           bits_to_node(world, rows, x, y + half, level - 1),
+                           bits_to_node(world, rows, x + half, y + half, level - 1));
+}
+
+/**
+ * Appends the x coordinate of every alive cell in row y of a node to alive, in increasing order.
+ * The node has its top left corner at x0, y0 and only the non-empty nodes crossing the row are visited.
+ */
+static void collect_row(const HashWorld::Node *node, const std::int64_t x0, const std::int64_t y0,
+                        const std::int64_t y, std::vector<std::int64_t> &alive) {
+    if (node->population == 0) {
+        return;
+    }
+    if (node->level == 0) {
+        alive.push_back(x0);
+        return;
+    }
+    const std::int64_t half = static_cast<std::int64_t>(1) << (node->level - 1);
+    if (y < y0 + half) {
+        collect_row(node->nw, x0, y0, y, alive);
+        collect_row(node->ne, x0 + half, y0, y, alive);
+    } else {
+        collect_row(node->sw, x0, y0 + half, y, alive);
+        collect_row(node->se, x0 + half, y0 + half, y, alive);
+    }
+}
+
+/**
+ * Parses the cells of an rle file from a stream, handing every run of alive cells to a sink as it is read,
+ * so the pattern never has to exist as a dense grid unless the sink builds one.
+ *
+ * A sink provides:
+ *      - begin(x0, y0, width, height, rule), the bounding box from the header, offset by any #CXRLE Pos.
+ *      - run(x, y, length), a run of alive cells in row y starting at x, in row-major order.
+ *      - end(), once the whole pattern has been read.
+ *
+ * @throws
+ *      std::runtime_error if the header is missing or malformed, a cell lies outside the bounding box,
+ *      or the data holds anything but runs of b, o and $.
+ */
+template<class Sink>
+static void parse_rle(std::istream &in, Sink &sink) {
+    TextReader reader(in);
+    std::string text;
+    std::int64_t x0 = 0, y0 = 0;
+    Rule rule;
+
+    // Comments come first, of which only the rule and the position of the pattern are used
+    bool header = false;
+    while (!header && reader.line(text)) {
+        text = trim(text);
+        if (text.compare(0, 2, "#r") == 0) {
+            rule = parse_file_rule(text.substr(2));
+        } else if (text.compare(0, 6, "#CXRLE") == 0) {
+            const std::size_t pos = text.find("Pos=");
+            if (pos != std::string::npos) {
+                const std::size_t comma = text.find(',', pos);
+                const std::size_t stop = text.find_first_of(" \t", pos);
+                if (comma == std::string::npos) {
+                    throw std::runtime_error(std::string("Corrupted RLE file!"));
+                }
+                x0 = parse_integer(text.substr(pos + 4, comma - pos - 4), "Corrupted RLE file!");
+                y0 = parse_integer(text.substr(comma + 1, stop == std::string::npos ? std::string::npos
+                                                                                      : stop - comma - 1),
+                                   "Corrupted RLE file!");
+            }
+        } else if (!text.empty() && text[0] != '#') {
+            header = true;
+        }
+    }
+    if (!header) {
+        throw std::runtime_error(std::string("Corrupted RLE file!"));
+    }
+
+    // The header is a list of key = value pairs, of which x and y are required
+    std::int64_t width = -1, height = -1;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t stop = text.find(',', start);
+        if (stop == std::string::npos) {
+            stop = text.size();
+        }
+        const std::string pair = text.substr(start, stop - start);
+        start = stop + 1;
+        if (trim(pair).empty()) {
+            continue;
+        }
+        const std::size_t equals = pair.find('=');
+        if (equals == std::string::npos) {
+            throw std::runtime_error(std::string("Corrupted RLE file!"));
+        }
+        const std::string key = trim(pair.substr(0, equals));
+        const std::string value = trim(pair.substr(equals + 1));
+        if (key == "x") {
+            width = parse_integer(value, "Wrong width or height");
+        } else if (key == "y") {
+            height = parse_integer(value, "Wrong width or height");
+        } else if (key == "rule") {
+            rule = parse_file_rule(value);
+        }
+    }
+    if (width < 0 || height < 0) {
+        throw std::runtime_error(std::string("Wrong width or height"));
+    }
+    sink.begin(x0, y0, width, height, rule);
+
+    // Runs are an optional count followed by b for dead cells, o for alive cells or $ for the end of a row
+    const std::int64_t max_count = std::numeric_limits<std::int64_t>::max() / 16;
+    std::int64_t x = 0, y = 0, count = 0;
+    for (int c = reader.get(); c != EOF && c != '!'; c = reader.get()) {
+        if (c >= '0' && c <= '9') {
+            count = count * 10 + (c - '0');
+            if (count > max_count) {
+                throw std::runtime_error(std::string("Corrupted RLE file!"));
             }
-            bitset_count++;
-            if (bitset_count == 8 || (content_bytes - current_bytes == 1)) {
-                // Counting the byte size of content. When the difference between the actual size and a current one
-                // will be 1, it will mean that only padding is left to be written to a file.
-                if (bitset_count == 8) {
-                    current_bytes++;
+            continue;
+        }
+        if (std::isspace(c)) {
+            continue;
+        }
+        const std::int64_t length = count > 0 ? count : 1;
+        count = 0;
+        if (c == 'b' || c == '.') {
+            x += length;
+        } else if (c == 'o') {
+            if (x + length > width || y >= height) {
+                throw std::runtime_error(std::string("Corrupted RLE file!"));
+            }
+            sink.run(x0 + x, y0 + y, length);
+            x += length;
+        } else if (c == '$') {
+            y += length;
+            x = 0;
+        } else {
+            throw std::runtime_error(std::string("Corrupted RLE file!"));
+        }
+    }
+    sink.end();
+}
+
+/**
+ * Collects an rle pattern into a Grid the size of its bounding box, ignoring its position.
+ */
+class GridRleSink {
+private:
+    std::int64_t x0 = 0, y0 = 0;
+
+public:
+    Grid grid;
+
+    void begin(const std::int64_t x0, const std::int64_t y0, const std::int64_t width, const std::int64_t height,
+               const Rule &) {
+        if (width > std::numeric_limits<int>::max() || height > std::numeric_limits<int>::max()) {
+            throw std::runtime_error(std::string("Wrong width or height"));
+        }
+        this->x0 = x0;
+        this->y0 = y0;
+        this->grid = Grid(static_cast<int>(width), static_cast<int>(height));
+    }
+
+    void run(const std::int64_t x, const std::int64_t y, const std::int64_t length) {
+        Cell *row = this->grid.row(static_cast<int>(y - this->y0));
+        std::fill(row + (x - this->x0), row + (x - this->x0 + length), Cell::ALIVE);
+    }
+
+    void end() {
+    }
+};
+
+/**
+ * Writes an rle pattern straight into the chunks of an InfiniteWorld.
+ */
+class InfiniteRleSink {
+public:
+    explicit InfiniteRleSink(InfiniteWorld &world) : world(world) {}
+
+    void begin(const std::int64_t, const std::int64_t, const std::int64_t, const std::int64_t, const Rule &rule) {
+        this->world = InfiniteWorld();
+        this->world.set_rule(rule);
+    }
+
+    void run(const std::int64_t x, const std::int64_t y, const std::int64_t length) {
+        this->world.fill_row(x, x + length, y);
+    }
+
+    void end() {
+    }
+
+private:
+    InfiniteWorld &world;
+};
+
+/**
+ * Builds an rle pattern into the quadtree of a HashWorld from the bottom up.
+ *
+ * Cells are collected in strips of 64 rows, made of 64x64 blocks that only exist where a run touched them.
+ * Each finished strip becomes a row of level 6 nodes, and rows of nodes are paired up level by level
+ * as soon as both halves are known, so at most one row of nodes per level is ever held.
+ * The tree is laid out on the root from the start, so rows and columns are counted from its top left corner.
+ */
+class HashRleSink {
+public:
+    explicit HashRleSink(HashWorld &world) : world(world), root_level(0), origin(0), strip(-1), result(nullptr) {}
+
+    void begin(const std::int64_t x0, const std::int64_t y0, const std::int64_t width, const std::int64_t height,
+               const Rule &rule) {
+        this->world = HashWorld();
+        this->world.set_rule(rule);
+        // The smallest root centred on the origin holding the whole bounding box
+        const std::int64_t reach = std::max(std::max(-x0, x0 + width), std::max(-y0, y0 + height));
+        this->root_level = RLE_STRIP_LOG2;
+        while ((static_cast<std::int64_t>(1) << (this->root_level - 1)) < reach) {
+            if (++this->root_level > HashWorld::MAX_LEVEL) {
+                throw std::runtime_error(std::string("Wrong width or height"));
+            }
+        }
+        this->origin = static_cast<std::int64_t>(1) << (this->root_level - 1);
+        this->pending.assign(this->root_level, Pending());
+    }
+
+    void run(const std::int64_t x, const std::int64_t y, const std::int64_t length) {
+        const std::int64_t u = x + this->origin, v = y + this->origin;
+        if ((v >> RLE_STRIP_LOG2) != this->strip) {
+            this->finish_strip();
+            this->strip = v >> RLE_STRIP_LOG2;
+        }
+        const int row = static_cast<int>(v & 63);
+        for (std::int64_t first = u; first < u + length;) {
+            const std::int64_t column = first >> 6;
+            const std::int64_t last = std::min(u + length, (column + 1) << 6);
+            const int low = static_cast<int>(first & 63), count = static_cast<int>(last - first);
+            const std::uint64_t bits = count == 64 ? ~static_cast<std::uint64_t>(0)
+                                                   : ((static_cast<std::uint64_t>(1) << count) - 1) << low;
+            std::vector<std::uint64_t> &block = this->blocks[column];
+            if (block.empty()) {
+                block.assign(64, 0);
+            }
+            block[row] |= bits;
+            first = last;
+        }
+    }
+
+    void end() {
+        this->finish_strip();
+        for (int level = RLE_STRIP_LOG2; level < this->root_level; level++) {
+            this->flush(level);
+        }
+        this->world.set_root(this->result != nullptr ? this->result : this->world.make_empty(this->root_level));
+    }
+
+private:
+    typedef std::map<std::int64_t, HashWorld::Node *> NodeRow; // Nodes by column, missing ones are empty
+
+    struct Pending {
+        bool used = false;
+
+        std::int64_t index = 0;                      // Always even, its partner below has not been seen yet
+
+        NodeRow row;
+    };
+
+    HashWorld &world;
+
+    int root_level;
+
+    std::int64_t origin;                             // Offset from plane coordinates to root coordinates
+
+    std::int64_t strip;                              // The strip being collected, -1 before the first run
+
+    std::map<std::int64_t, std::vector<std::uint64_t> > blocks; // The blocks of the strip by column
+
+    std::vector<Pending> pending;                    // The row of nodes waiting for its partner, per level
+
+    HashWorld::Node *result;
+
+    void finish_strip() {
+        if (this->blocks.empty()) {
+            return;
+        }
+        NodeRow row;
+        for (const auto &block : this->blocks) {
+            row[block.first] = bits_to_node(this->world, block.second.data(), 0, 0, RLE_STRIP_LOG2);
+        }
+        this->blocks.clear();
+        this->push(RLE_STRIP_LOG2, this->strip, row);
+    }
+
+    // Joins a row of nodes with the row below it into the row of their parents
+    NodeRow combine(const NodeRow &top, const NodeRow &bottom, const int level) {
+        std::map<std::int64_t, std::array<HashWorld::Node *, 4> > parents;
+        for (const auto &node : top) {
+            parents[node.first >> 1][node.first & 1] = node.second;
+        }
+        for (const auto &node : bottom) {
+            parents[node.first >> 1][2 + (node.first & 1)] = node.second;
+        }
+        HashWorld::Node *empty = this->world.make_empty(level);
+        NodeRow row;
+        for (auto &parent : parents) {
+            std::array<HashWorld::Node *, 4> &children = parent.second;
+            for (HashWorld::Node *&child : children) {
+                if (child == nullptr) {
+                    child = empty;
                 }
-                file.write((char *) &bitset, sizeof(char));
-                bitset_count = 0;
             }
+            row[parent.first] = this->world.make_node(children[0], children[1], children[2], children[3]);
+        }
+        return row;
+    }
+
+    void push(const int level, const std::int64_t index, const NodeRow &row) {
+        if (level == this->root_level) {
+            this->result = row.empty() ? nullptr : row.begin()->second;
+            return;
+        }
+        Pending &waiting = this->pending[level];
+        if (waiting.used && waiting.index + 1 == index) {
+            const NodeRow parents = this->combine(waiting.row, row, level);
+            waiting.used = false;
+            waiting.row.clear();
+            this->push(level + 1, index >> 1, parents);
+            return;
+        }
+        this->flush(level);
+        if (index % 2 == 0) {
+            waiting.used = true;
+            waiting.index = index;
+            waiting.row = row;
+        } else {
+            this->push(level + 1, index >> 1, this->combine(NodeRow(), row, level));
+        }
+    }
+
+    // Sends the waiting row of a level up without a partner below it
+    void flush(const int level) {
+        Pending &waiting = this->pending[level];
+        if (waiting.used) {
+            const NodeRow parents = this->combine(waiting.row, NodeRow(), level);
+            const std::int64_t index = waiting.index;
+            waiting.used = false;
+            waiting.row.clear();
+            this->push(level + 1, index >> 1, parents);
+        }
+    }
+};
+
+/**
+ * Opens a text file for reading, throwing the usual message if it cannot be opened.
+ */
+static void open_text(std::ifstream &file, const std::string &path) {
+    file.open(path, std::ios::in | std::ios::binary);
+    if (!file.good()) {
+        throw std::runtime_error(std::string("Error Opening file"));
+    }
+}
+
+/**
+ * Zoo::load_rle(path)
+ *
+ * Load a run length encoded .rle pattern into a grid the size of its bounding box.
+ * https://www.conwaylife.com/wiki/Run_Length_Encoded
+ *
+ * @example
+ *
+ *      // Load a pattern downloaded from the LifeWiki
+ *      Grid grid = Zoo::load_rle("path/to/gosperglidergun.rle");
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      Returns the parsed grid. The rule and position of the pattern are not kept.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The header is missing, or its width or height is not a non-negative integer.
+ *          - A cell lies outside the width and height given in the header.
+ *          - The data contains anything but counts, b, o, $ and !.
+ */
+Grid Zoo::load_rle(const std::string &path) {
+    std::ifstream file;
+    open_text(file, path);
+    GridRleSink sink;
+    parse_rle(file, sink);
+    return std::move(sink.grid);
+}
+
+/**
+ * Zoo::load_rle(path, world)
+ *
+ * Load an .rle pattern straight into the chunks of an InfiniteWorld, replacing its contents and rule.
+ * The pattern is placed at the position given by a #CXRLE Pos line, or with its top left corner at (0, 0).
+ *
+ * @example
+ *
+ *      InfiniteWorld world;
+ *      Zoo::load_rle("path/to/pattern.rle", world);
+ *      world.advance(1000);
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class in the same cases as Zoo::load_rle(path), or if the rule
+ *      contains B0.
+ */
+void Zoo::load_rle(const std::string &path, InfiniteWorld &world) {
+    std::ifstream file;
+    open_text(file, path);
+    InfiniteRleSink sink(world);
+    parse_rle(file, sink);
+}
+
+/**
+ * Zoo::load_rle(path, world)
+ *
+ * Load an .rle pattern straight into the quadtree of a HashWorld, replacing its contents and rule.
+ * The pattern is placed at the position given by a #CXRLE Pos line, or with its top left corner at (0, 0).
+ * Memory use is bounded by the distinct nodes of the pattern plus one strip of 64 rows.
+ *
+ * @example
+ *
+ *      // Jump a huge pattern far into the future without ever expanding it into a grid
+ *      HashWorld world;
+ *      Zoo::load_rle("path/to/huge.rle", world);
+ *      world.advance(1 << 30);
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class in the same cases as Zoo::load_rle(path), or if the rule
+ *      contains B0.
+ */
+void Zoo::load_rle(const std::string &path, HashWorld &world) {
+    std::ifstream file;
+    open_text(file, path);
+    HashRleSink sink(world);
+    parse_rle(file, sink);
+}
+
+/**
+ * Encodes rows of cells as rle runs, wrapping lines at RLE_LINE_LENGTH characters.
+ * Dead cells at the end of a row and empty rows at the end of the pattern are left out.
+ */
+class RleWriter {
+private:
+    std::ostream &out;
+
+    std::string line;
+
+    std::int64_t run_length, rows_ended;
+
+    bool run_alive;
+
+    void token(const std::int64_t count, const char tag) {
+        std::string text = count > 1 ? std::to_string(count) : std::string();
+        text.push_back(tag);
+        if (this->line.size() + text.size() > RLE_LINE_LENGTH) {
+            this->out << this->line << '\n';
+            this->line.clear();
+        }
+        this->line += text;
+    }
+
+    void end_run() {
+        if (this->run_length > 0) {
+            this->token(this->run_length, this->run_alive ? 'o' : 'b');
+            this->run_length = 0;
+        }
+    }
+
+public:
+    explicit RleWriter(std::ostream &out) : out(out), run_length(0), rows_ended(0), run_alive(false) {}
+
+    void cells(const std::int64_t count, const bool alive) {
+        if (count <= 0) {
+            return;
+        }
+        // Dead cells only count once alive ones follow them, so empty rows at the end are never written
+        if (alive && this->rows_ended > 0) {
+            this->token(this->rows_ended, '$');
+            this->rows_ended = 0;
+        }
+        if (this->run_length > 0 && this->run_alive != alive) {
+            this->end_run();
         }
+        this->run_alive = alive;
+        this->run_length += count;
+    }
+
+    void end_row() {
+        if (this->run_alive) {
+            this->end_run();
+        }
+        this->run_length = 0;
+        this->rows_ended++;
+    }
+
+    void finish() {
+        if (this->run_alive) {
+            this->end_run();
+        }
+        this->token(1, '!');
+        this->out << this->line << '\n';
+        this->line.clear();
+    }
+};
+
+/**
+ * Writes the header of an rle file, with a #CXRLE line if the pattern is not at the origin.
+ */
+static void write_rle_header(std::ostream &out, const std::int64_t x0, const std::int64_t y0,
+                             const std::int64_t width, const std::int64_t height, const Rule &rule) {
+    if (x0 != 0 || y0 != 0) {
+        out << "#CXRLE Pos=" << x0 << ',' << y0 << '\n';
+    }
+    out << "x = " << width << ", y = " << height << ", rule = " << rule.to_string() << '\n';
+}
+
+/**
+ * Writes the alive cells of a row, given as increasing x coordinates, relative to the left edge x0.
+ */
+static void write_rle_row(RleWriter &writer, const std::vector<std::int64_t> &alive, const std::int64_t x0) {
+    std::int64_t x = x0;
+    for (const std::int64_t cell : alive) {
+        writer.cells(cell - x, false);
+        writer.cells(1, true);
+        x = cell + 1;
     }
+    writer.end_row();
+}
 
+/**
+ * Opens a text file for writing, throwing the usual message if it cannot be opened.
+ */
+static void create_text(std::ofstream &file, const std::string &path) {
+    file.open(path, std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error(std::string("Can't open the file!"));
+    }
+}
+
+/**
+ * Flushes and closes a text file, throwing if any write failed.
+ */
+static void close_text(std::ofstream &file) {
+    file.flush();
+    if (!file) {
+        throw std::runtime_error(std::string("Can't write the file!"));
+    }
+    Stats::add(Stats::Counter::BYTES_WRITTEN, static_cast<std::uint64_t>(file.tellp()));
     file.close();
 }
 
+/**
+ * Zoo::save_rle(path, grid, rule)
+ *
+ * Save a grid as a run length encoded .rle file, with its top left corner at (0, 0).
+ *
+ * @example
+ *
+ *      Zoo::save_rle("path/to/glider.rle", Zoo::glider());
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param grid
+ *      The grid to be written out to file.
+ *
+ * @param rule
+ *      The rule recorded in the header, B3/S23 by default.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
+ */
+void Zoo::save_rle(const std::string &path, const Grid &grid, const Rule &rule) {
+    std::ofstream file;
+    create_text(file, path);
+    const int width = grid.get_width();
+    const int height = grid.get_height();
+    write_rle_header(file, 0, 0, width, height, rule);
+    RleWriter writer(file);
+    for (int y = 0; y < height; y++) {
+        const Cell *row = grid.row(y);
+        int x = 0;
+        while (x < width) {
+            const Cell cell = row[x];
+            int end = x + 1;
+            while (end < width && row[end] == cell) {
+                end++;
+            }
+            writer.cells(end - x, cell == Cell::ALIVE);
+            x = end;
+        }
+        writer.end_row();
+    }
+    writer.finish();
+    close_text(file);
+}
+
+/**
+ * Zoo::save_rle(path, world)
+ *
+ * Save the bounding box of the alive cells of an InfiniteWorld as an .rle file, with its position and rule.
+ * The plane is read back in strips of 64 rows, so only one strip is ever held as a grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
+ */
+void Zoo::save_rle(const std::string &path, const InfiniteWorld &world) {
+    std::ofstream file;
+    create_text(file, path);
+    std::int64_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    world.get_bounds(x0, y0, x1, y1);
+    write_rle_header(file, x0, y0, x1 - x0, y1 - y0, world.get_rule());
+    RleWriter writer(file);
+    std::vector<std::int64_t> alive;
+    for (std::int64_t top = y0; top < y1; top += InfiniteWorld::CHUNK_SIZE) {
+        const Grid strip = world.to_grid(x0, top, x1, std::min(y1, top + InfiniteWorld::CHUNK_SIZE));
+        for (int y = 0; y < strip.get_height(); y++) {
+            alive.clear();
+            const Cell *row = strip.row(y);
+            for (int x = 0; x < strip.get_width(); x++) {
+                if (row[x] == Cell::ALIVE) {
+                    alive.push_back(x0 + x);
+                }
+            }
+            write_rle_row(writer, alive, x0);
+        }
+    }
+    writer.finish();
+    close_text(file);
+}
+
+/**
+ * Zoo::save_rle(path, world)
+ *
+ * Save the bounding box of the alive cells of a HashWorld as an .rle file, with its position and rule.
+ * Each row is read straight from the quadtree, visiting only the nodes with alive cells in that row.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
+ */
+void Zoo::save_rle(const std::string &path, const HashWorld &world) {
+    std::ofstream file;
+    create_text(file, path);
+    std::int64_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    world.get_bounds(x0, y0, x1, y1);
+    write_rle_header(file, x0, y0, x1 - x0, y1 - y0, world.get_rule());
+    const HashWorld::Node *root = world.get_root();
+    const std::int64_t half = static_cast<std::int64_t>(1) << (root->level - 1);
+    RleWriter writer(file);
+    std::vector<std::int64_t> alive;
+    for (std::int64_t y = y0; y < y1; y++) {
+        alive.clear();
+        collect_row(root, -half, -half, y, alive);
+        write_rle_row(writer, alive, x0);
+    }
+    writer.finish();
+    close_text(file);
+}
 
+/**
+ * Reads a macrocell file into a HashWorld, replacing its contents, rule and generation.
+ */
+static void parse_macrocell(std::istream &in, HashWorld &world) {
+    TextReader reader(in);
+    std::string text;
+    if (!reader.line(text) || text.compare(0, 4, "[M2]") != 0) {
+        throw std::runtime_error(std::string("Not a macrocell file!"));
+    }
+    world = HashWorld();
+    Rule rule;
+    std::uint64_t generation = 0;
+    // Node i is the i-th node line, node 0 stands for the empty node of whichever level is needed
+    std::vector<HashWorld::Node *> nodes(1, nullptr);
+    while (reader.line(text)) {
+        if (text.empty()) {
+            continue;
+        }
+        if (text[0] == '#') {
+            if (text.compare(0, 2, "#R") == 0) {
+                rule = parse_file_rule(text.substr(2));
+            } else if (text.compare(0, 2, "#G") == 0) {
+                generation = static_cast<std::uint64_t>(parse_integer(trim(text.substr(2)),
+                                                                       "Corrupted macrocell file!"));
+            }
+            continue;
+        }
+        if (text[0] == '.' || text[0] == '*' || text[0] == '$') {
+            // An 8x8 leaf, rows of . and * each ended by $
+            std::uint64_t rows[8] = {0};
+            int x = 0, y = 0;
+            for (const char c : text) {
+                if (c == '$') {
+                    x = 0;
+                    y++;
+                } else if ((c != '.' && c != '*') || x >= 8 || y >= 8) {
+                    throw std::runtime_error(std::string("Corrupted macrocell file!"));
+                } else {
+                    rows[y] |= static_cast<std::uint64_t>(c == '*') << x;
+                    x++;
+                }
+            }
+            nodes.push_back(bits_to_node(world, rows, 0, 0, 3));
+            continue;
+        }
+        // A node of level k and the indices of its four children, which are cells when k is 1
+        std::int64_t fields[5];
+        std::size_t start = 0;
+        for (int i = 0; i < 5; i++) {
+            start = text.find_first_not_of(" \t", start);
+            const std::size_t stop = start == std::string::npos ? std::string::npos : text.find_first_of(" \t", start);
+            if (start == std::string::npos) {
+                throw std::runtime_error(std::string("Corrupted macrocell file!"));
+            }
+            fields[i] = parse_integer(text.substr(start, stop == std::string::npos ? std::string::npos : stop - start),
+                                      "Corrupted macrocell file!");
+            start = stop;
+        }
+        const std::int64_t level = fields[0];
+        if (level < 1 || level > HashWorld::MAX_LEVEL) {
+            throw std::runtime_error(std::string("Corrupted macrocell file!"));
+        }
+        HashWorld::Node *children[4];
+        for (int i = 0; i < 4; i++) {
+            const std::int64_t index = fields[i + 1];
+            if (level == 1) {
+                if (index != 0 && index != 1) {
+                    throw std::runtime_error(std::string("Corrupted macrocell file!"));
+                }
+                children[i] = world.make_cell(index == 1);
+            } else if (index == 0) {
+                children[i] = world.make_empty(static_cast<int>(level - 1));
+            } else if (index < 0 || index >= static_cast<std::int64_t>(nodes.size()) ||
+                       nodes[index]->level != level - 1) {
+                throw std::runtime_error(std::string("Corrupted macrocell file!"));
+            } else {
+                children[i] = nodes[index];
+            }
+        }
+        nodes.push_back(world.make_node(children[0], children[1], children[2], children[3]));
+    }
+    world.set_rule(rule);
+    world.set_root(nodes.size() > 1 ? nodes.back() : world.make_empty(3), generation);
+}
+
+/**
+ * Zoo::load_macrocell(path, world)
+ *
+ * Load a HashLife macrocell .mc file, replacing the contents, rule and generation of a HashWorld.
+ * The nodes of the file become nodes of the plane directly, so even astronomically large patterns load
+ * in time proportional to the size of the file.
+ * https://www.conwaylife.com/wiki/Macrocell
+ *
+ * @example
+ *
+ *      HashWorld world;
+ *      Zoo::load_macrocell("path/to/metapixel.mc", world);
+ *      world.advance(1 << 20);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param world
+ *      The plane to load the pattern into. The root of the file is centred on the origin, as in Golly.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The file does not start with [M2].
+ *          - A leaf is larger than 8x8, or a node refers to a later node or to one of the wrong level.
+ *          - The rule contains B0.
+ */
+void Zoo::load_macrocell(const std::string &path, HashWorld &world) {
+    std::ifstream file;
+    open_text(file, path);
+    parse_macrocell(file, world);
+}
+
+/**
+ * Zoo::load_macrocell(path, world)
+ *
+ * Load a macrocell .mc file into an InfiniteWorld, replacing its contents and rule. The quadtree is read
+ * into a HashWorld first and copied out row by row, never as a dense grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class in the same cases as Zoo::load_macrocell(path, world).
+ */
+void Zoo::load_macrocell(const std::string &path, InfiniteWorld &world) {
+    HashWorld plane;
+    Zoo::load_macrocell(path, plane);
+    world = InfiniteWorld();
+    world.set_rule(plane.get_rule());
+    std::int64_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (!plane.get_bounds(x0, y0, x1, y1)) {
+        return;
+    }
+    const HashWorld::Node *root = plane.get_root();
+    const std::int64_t half = static_cast<std::int64_t>(1) << (root->level - 1);
+    std::vector<std::int64_t> alive;
+    for (std::int64_t y = y0; y < y1; y++) {
+        alive.clear();
+        collect_row(root, -half, -half, y, alive);
+        for (std::size_t i = 0; i < alive.size();) {
+            std::size_t end = i + 1;
+            while (end < alive.size() && alive[end] == alive[end - 1] + 1) {
+                end++;
+            }
+            world.fill_row(alive[i], alive[end - 1] + 1, y);
+            i = end;
+        }
+    }
+}
+
+/**
+ * Writes every node below and including a node of level 3 or more in post-order, numbering them from 1.
+ * Empty nodes are never written and are referred to as 0.
+ */
+static std::uint64_t write_macrocell_node(std::ostream &out, const HashWorld::Node *node,
+                                          std::unordered_map<const HashWorld::Node *, std::uint64_t> &written) {
+    if (node->population == 0) {
+        return 0;
+    }
+    const auto found = written.find(node);
+    if (found != written.end()) {
+        return found->second;
+    }
+    if (node->level == 3) {
+        // Rows of the leaf, dropping dead cells at the end of a row and empty rows at the end
+        std::string text, rows;
+        for (int y = 0; y < 8; y++) {
+            std::string row;
+            for (int x = 0; x < 8; x++) {
+                const HashWorld::Node *quadrant = y < 4 ? (x < 4 ? node->nw : node->ne) : (x < 4 ? node->sw : node->se);
+                const HashWorld::Node *pair = (y & 2) ? ((x & 2) ? quadrant->se : quadrant->sw)
+                                                      : ((x & 2) ? quadrant->ne : quadrant->nw);
+                const HashWorld::Node *cell = (y & 1) ? ((x & 1) ? pair->se : pair->sw)
+                                                      : ((x & 1) ? pair->ne : pair->nw);
+                row.push_back(cell->population ? '*' : '.');
+            }
+            row.erase(row.find_last_not_of('.') + 1);
+            rows += row + "$";
+            if (!row.empty()) {
+                text += rows;
+                rows.clear();
+            }
+        }
+        out << text << '\n';
+    } else {
+        const std::uint64_t nw = write_macrocell_node(out, node->nw, written);
+        const std::uint64_t ne = write_macrocell_node(out, node->ne, written);
+        const std::uint64_t sw = write_macrocell_node(out, node->sw, written);
+        const std::uint64_t se = write_macrocell_node(out, node->se, written);
+        out << node->level << ' ' << nw << ' ' << ne << ' ' << sw << ' ' << se << '\n';
+    }
+    const std::uint64_t index = written.size() + 1;
+    written.emplace(node, index);
+    return index;
+}
+
+/**
+ * Zoo::save_macrocell(path, world)
+ *
+ * Save a HashWorld as a macrocell .mc file, writing each distinct node once along with the rule and generation.
+ *
+ * @example
+ *
+ *      HashWorld world(Zoo::r_pentomino());
+ *      world.advance(1000000);
+ *      Zoo::save_macrocell("path/to/r_pentomino.mc", world);
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param world
+ *      The plane to be written out to file.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
+ */
+void Zoo::save_macrocell(const std::string &path, const HashWorld &world) {
+    std::ofstream file;
+    create_text(file, path);
+    file << "[M2] (Game_of_Life)\n";
+    file << "#R " << world.get_rule().to_string() << '\n';
+    if (world.get_generation() > 0) {
+        file << "#G " << world.get_generation() << '\n';
+    }
+    std::unordered_map<const HashWorld::Node *, std::uint64_t> written;
+    const HashWorld::Node *root = world.get_root();
+    if (root->population > 0) {
+        write_macrocell_node(file, root, written);
+    }
+    close_text(file);
+}
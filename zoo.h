@@ -11,7 +11,12 @@
 #pragma once
 #include <string>
 #include <algorithm>
+#include <iostream>
 #include "grid.h"
+#include "bitgrid.h"
+#include "hashlife.h"
+#include "infinite_world.h"
+#include "rule.h"
 
 /**
  * Declare the interface of the Zoo namespace for constructing lifeforms and saving and loading them from file.
@@ -25,9 +30,33 @@ namespace Zoo {
 
     Grid load_ascii(const std::string &path); // Reads a .gol ascii-encoded file containing the grid
 
+    Grid load_ascii(std::istream &in); // Reads a .gol ascii-encoded grid from a stream, such as std::cin
+
     void save_ascii(const std::string &path, const Grid &grid); // Saves a grid in a .gol ascii-encoded file
 
+    void save_ascii(std::ostream &out, const Grid &grid); // Writes a .gol ascii-encoded grid to a stream
+
     void save_binary(const std::string &path, const Grid &grid); //Saves a grid in a .bgol binary-encoded file
 
     Grid load_binary(const std::string &path); // Reads a .bgol file containing binary-encoded grid
+
+    BitGrid load_binary_packed(const std::string &path); // Reads a .bgol file into a bit-packed grid
+
+    Grid load_rle(const std::string &path); // Reads an .rle run length encoded pattern into a grid
+
+    void load_rle(const std::string &path, InfiniteWorld &world); // Streams an .rle pattern into the chunks
+
+    void load_rle(const std::string &path, HashWorld &world); // Streams an .rle pattern into the quadtree
+
+    void save_rle(const std::string &path, const Grid &grid, const Rule &rule = Rule()); // Saves an .rle file
+
+    void save_rle(const std::string &path, const InfiniteWorld &world);
+
+    void save_rle(const std::string &path, const HashWorld &world);
+
+    void load_macrocell(const std::string &path, HashWorld &world); // Reads an .mc HashLife macrocell file
+
+    void load_macrocell(const std::string &path, InfiniteWorld &world);
+
+    void save_macrocell(const std::string &path, const HashWorld &world); // Saves an .mc macrocell file
 };
\ No newline at end of file